@@ -0,0 +1,134 @@
+package com.digimobile.app
+
+import android.content.Context
+import com.digimobile.node.BlockBundleFeeder
+import java.io.File
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+
+/**
+ * Imports a block bundle left on the device (exported from another node with
+ * scripts/make-block-bundle.sh and copied to the app's external files directory or to
+ * files/bootstrap) instead of downloading those blocks from peers.
+ *
+ * [prepare] runs before the node starts and returns the pipe to pass as -loadblock; [feed] runs
+ * once the node is up. A bundle is imported once: a marker next to it records its size and
+ * modification time after it was fed completely or rejected.
+ */
+class BlockBundleImporter(private val context: Context) {
+
+    class Prepared(val feeder: BlockBundleFeeder, val bundle: File, val pipe: File)
+
+    /**
+     * Pick the newest bundle not imported yet, check its headers and create its pipe in
+     * [dataDir].
+     *
+     * @return `null` if there is nothing to import.
+     */
+    fun prepare(dataDir: File, onLog: (String) -> Unit): Prepared? {
+        val bundle = findBundles().firstOrNull { !isImported(it) } ?: return null
+        val feeder = runCatching {
+            BlockBundleFeeder(bundle.absolutePath, headersFile(bundle).absolutePath)
+        }.getOrElse {
+            onLog("Block bundle ${bundle.name} skipped: ${it.message}")
+            return null
+        }
+        // digibyted validates every block it imports, so the bundle needs no pin: a bundle
+        // from the wrong chain costs the time to read it and nothing else.
+        val rejected = feeder.verify(null, null)
+        if (rejected != null) {
+            onLog("Block bundle ${bundle.name} rejected: $rejected")
+            feeder.close()
+            markImported(bundle)
+            return null
+        }
+        val pipe = File(dataDir, PIPE_NAME)
+        val pipeError = feeder.openPipe(pipe.absolutePath)
+        if (pipeError != null) {
+            onLog("Block bundle ${bundle.name} skipped: $pipeError")
+            feeder.close()
+            return null
+        }
+        val first = feeder.startHeight()
+        onLog(
+            "Importing block bundle ${bundle.name}: heights $first-${first + feeder.blockCount() - 1} " +
+                "(${feeder.totalBytes() shr 20} MiB)"
+        )
+        return Prepared(feeder, bundle, pipe)
+    }
+
+    /**
+     * Hand the bundle to the running node, logging progress. Cancelling interrupts the feed; the
+     * bundle is then offered again at the next start. The caller closes the feeder afterwards.
+     */
+    suspend fun feed(prepared: Prepared, onLog: (String) -> Unit): Boolean = coroutineScope {
+        val feeder = prepared.feeder
+        val reporter = launch {
+            var reported = 0L
+            while (true) {
+                delay(PROGRESS_INTERVAL_MS)
+                val total = feeder.totalBytes()
+                val percent = if (total > 0) feeder.fedBytes() * 100 / total else 0L
+                if (percent >= reported + PROGRESS_STEP_PERCENT) {
+                    reported = percent - percent % PROGRESS_STEP_PERCENT
+                    onLog("Block bundle: ${feeder.fedBlocks()} blocks handed to the node ($percent%)")
+                }
+            }
+        }
+        val work = async(Dispatchers.IO) { feeder.feed() }
+        val error = try {
+            work.await()
+        } catch (e: CancellationException) {
+            feeder.interrupt()
+            throw e
+        } finally {
+            reporter.cancel()
+        }
+        if (error == null) {
+            onLog("Block bundle ${prepared.bundle.name} imported (${feeder.fedBlocks()} blocks).")
+            markImported(prepared.bundle)
+            return@coroutineScope true
+        }
+        onLog("Block bundle ${prepared.bundle.name} stopped after ${feeder.fedBlocks()} blocks: $error")
+        if (error != INTERRUPTED) {
+            // A block that does not match its header will not match next time either.
+            markImported(prepared.bundle)
+        }
+        false
+    }
+
+    private fun findBundles(): List<File> {
+        val dirs = listOfNotNull(context.getExternalFilesDir(null), File(context.filesDir, "bootstrap"))
+        return dirs
+            .flatMap { dir -> dir.listFiles()?.toList().orEmpty() }
+            .filter { it.isFile && it.name.endsWith(BUNDLE_SUFFIX) && headersFile(it).isFile }
+            .sortedByDescending { it.lastModified() }
+    }
+
+    private fun headersFile(bundle: File): File = File(bundle.parentFile, "${bundle.name}.headers")
+
+    private fun importedMarker(bundle: File): File = File(bundle.parentFile, "${bundle.name}.imported")
+
+    private fun importedStamp(bundle: File): String = "${bundle.length()} ${bundle.lastModified()}"
+
+    private fun isImported(bundle: File): Boolean {
+        val marker = importedMarker(bundle)
+        return marker.exists() && runCatching { marker.readText() }.getOrNull() == importedStamp(bundle)
+    }
+
+    private fun markImported(bundle: File) {
+        runCatching { importedMarker(bundle).writeText(importedStamp(bundle)) }
+    }
+
+    companion object {
+        const val BUNDLE_SUFFIX = ".dgbblocks"
+        private const val PIPE_NAME = "bundle-import.fifo"
+        private const val INTERRUPTED = "interrupted"
+        private const val PROGRESS_INTERVAL_MS = 5_000L
+        private const val PROGRESS_STEP_PERCENT = 10L
+    }
+}
@@ -2,13 +2,22 @@ package com.digimobile.app
 
 import android.content.Context
 import android.content.SharedPreferences
+import com.digimobile.node.DigiMobileNodeController
+import com.digimobile.node.Sha256Hasher
+import com.digimobile.node.SnapshotContainerApplier
 import java.io.BufferedInputStream
 import java.io.File
 import java.io.FileInputStream
 import java.io.FileOutputStream
+import java.io.IOException
 import java.net.HttpURLConnection
 import java.net.URL
-import java.security.MessageDigest
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.ensureActive
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.withContext
 import org.apache.commons.compress.archivers.tar.TarArchiveInputStream
 import org.apache.commons.compress.compressors.gzip.GzipCompressorInputStream
 
@@ -48,12 +57,17 @@ class ChainstateBootstrapper(private val context: Context) {
         val snapshotFile = getSnapshotFile()
 
         if (snapshotFile.exists()) {
+            if (isVerified(snapshotFile)) {
+                return snapshotFile
+            }
             val existingChecksum = computeSha256(snapshotFile)
             if (existingChecksum.equals(SNAPSHOT_SHA256, ignoreCase = true)) {
+                markVerified(snapshotFile)
                 return snapshotFile
             } else {
                 onLog("Snapshot checksum mismatch, deleting file")
                 snapshotFile.delete()
+                verifiedMarker(snapshotFile).delete()
             }
         }
 
@@ -63,6 +77,42 @@ class ChainstateBootstrapper(private val context: Context) {
         onLog("Starting snapshot download...")
         onProgress(0)
 
+        // Parallel ranged download first. It keeps finished chunks across failures, so an
+        // interrupted transfer resumes instead of starting over. The whole-file hash is
+        // checked by extractSnapshotInto while it reads the archive.
+        val downloader = SnapshotDownloader(SNAPSHOT_URL, tempFile)
+        val progressLock = Any()
+        var lastParallelProgress = -1
+        val parallel = try {
+            downloader.download(
+                onProgress = { done, total ->
+                    val percent = ((done * 100) / total.coerceAtLeast(1L)).toInt().coerceIn(0, 100)
+                    synchronized(progressLock) {
+                        if (percent != lastParallelProgress) {
+                            lastParallelProgress = percent
+                            onProgress(percent)
+                        }
+                    }
+                },
+                onLog = onLog
+            )
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: Exception) {
+            onLog("Snapshot download interrupted: ${e.message}; finished chunks are kept for the next attempt")
+            return null
+        }
+        if (parallel == SnapshotDownloader.Result.COMPLETE) {
+            onProgress(100)
+            onLog("Snapshot download complete")
+            if (!tempFile.renameTo(snapshotFile)) {
+                tempFile.copyTo(snapshotFile, overwrite = true)
+                tempFile.delete()
+            }
+            return snapshotFile
+        }
+        onLog("Server does not support ranged downloads; using a single connection")
+
         return runCatching {
             val urlConnection = URL(SNAPSHOT_URL).openConnection() as HttpURLConnection
             urlConnection.connectTimeout = 15_000
@@ -71,40 +121,45 @@ class ChainstateBootstrapper(private val context: Context) {
 
             val contentLength = urlConnection.contentLengthLong.takeIf { it > 0 } ?: -1L
 
-            BufferedInputStream(urlConnection.inputStream).use { input ->
-                FileOutputStream(tempFile).use { output ->
-                    val buffer = ByteArray(DEFAULT_BUFFER_SIZE)
-                    var bytesRead = 0L
-                    var read = input.read(buffer)
-                    var lastProgress = -1
-                    while (read != -1) {
-                        output.write(buffer, 0, read)
-                        bytesRead += read
-                        if (contentLength > 0) {
-                            val percent = ((bytesRead * 100) / contentLength).toInt().coerceIn(0, 100)
-                            if (percent != lastProgress) {
-                                lastProgress = percent
-                                onProgress(percent)
+            // Hash while downloading so the multi-GB file is not read back just to verify it.
+            val checksum = Sha256Hasher().use { hasher ->
+                BufferedInputStream(urlConnection.inputStream).use { input ->
+                    FileOutputStream(tempFile).use { output ->
+                        val buffer = ByteArray(DEFAULT_BUFFER_SIZE)
+                        var bytesRead = 0L
+                        var read = input.read(buffer)
+                        var lastProgress = -1
+                        while (read != -1) {
+                            output.write(buffer, 0, read)
+                            hasher.update(buffer, 0, read)
+                            bytesRead += read
+                            if (contentLength > 0) {
+                                val percent = ((bytesRead * 100) / contentLength).toInt().coerceIn(0, 100)
+                                if (percent != lastProgress) {
+                                    lastProgress = percent
+                                    onProgress(percent)
+                                }
                             }
+                            read = input.read(buffer)
                         }
-                        read = input.read(buffer)
+                        onProgress(100)
                     }
-                    onProgress(100)
                 }
+                hasher.finishHex()
             }
 
             onLog("Snapshot download complete")
 
-            val checksum = computeSha256(tempFile)
             if (!checksum.equals(SNAPSHOT_SHA256, ignoreCase = true)) {
                 onLog("Snapshot checksum mismatch, deleting file")
                 tempFile.delete()
                 null
-            } else if (tempFile.renameTo(snapshotFile)) {
-                snapshotFile
             } else {
-                tempFile.copyTo(snapshotFile, overwrite = true)
-                tempFile.delete()
+                if (!tempFile.renameTo(snapshotFile)) {
+                    tempFile.copyTo(snapshotFile, overwrite = true)
+                    tempFile.delete()
+                }
+                markVerified(snapshotFile)
                 snapshotFile
             }
         }.getOrElse {
@@ -131,13 +186,9 @@ class ChainstateBootstrapper(private val context: Context) {
             return true
         }
 
-        val checksum = computeSha256(snapshotFile)
-        if (!checksum.equals(SNAPSHOT_SHA256, ignoreCase = true)) {
-            onLog(
-                "Checksum mismatch for ${snapshotFile.name}: expected $SNAPSHOT_SHA256, found $checksum"
-            )
-            return false
-        }
+        // An unverified snapshot is hashed by the native extractor as it is read, so
+        // verification and extraction share one pass over the file.
+        val verified = isVerified(snapshotFile)
 
         val totalSize = snapshotFile.length().coerceAtLeast(1L)
         var bytesRead = 0L
@@ -157,46 +208,35 @@ class ChainstateBootstrapper(private val context: Context) {
             tempRoot.mkdirs()
 
             try {
-                FileInputStream(snapshotFile).use { fis ->
-                    GzipCompressorInputStream(BufferedInputStream(fis)).use { gzip ->
-                        TarArchiveInputStream(gzip).use { tar ->
-                            var entry = tar.nextTarEntry
-                            val buffer = ByteArray(DEFAULT_BUFFER_SIZE)
-                            while (entry != null) {
-                                val relativePath = entry.name
-                                    .trimStart('/')
-                                    .split('/')
-                                    .drop(1)
-                                    .joinToString("/")
-
-                                if (relativePath.isNotEmpty()) {
-                                    val outputFile = File(tempRoot, relativePath)
-                                    if (entry.isDirectory) {
-                                        outputFile.mkdirs()
-                                    } else {
-                                        outputFile.parentFile?.mkdirs()
-                                        FileOutputStream(outputFile).use { output ->
-                                            var read = tar.read(buffer)
-                                            while (read != -1) {
-                                                output.write(buffer, 0, read)
-                                                bytesRead += read
-                                                updateProgress()
-                                                read = tar.read(buffer)
-                                            }
-                                        }
-                                    }
-                                } else {
-                                    var read = tar.read(buffer)
-                                    while (read != -1) {
-                                        bytesRead += read
-                                        updateProgress()
-                                        read = tar.read(buffer)
-                                    }
-                                }
-
-                                entry = tar.nextTarEntry
-                            }
+                val expectedSha256 = if (verified) null else SNAPSHOT_SHA256
+                val nativeError = extractNative(snapshotFile, tempRoot, expectedSha256) { done, _ ->
+                    bytesRead = done
+                    updateProgress()
+                }
+                if (nativeError != null && nativeError.startsWith(CHECKSUM_MISMATCH_PREFIX)) {
+                    onLog("Checksum mismatch for ${snapshotFile.name}: $nativeError")
+                    return false
+                }
+                if (nativeError == null) {
+                    if (!verified) markVerified(snapshotFile)
+                } else {
+                    onLog("Native extraction failed ($nativeError); retrying with the fallback extractor.")
+                    if (!verified) {
+                        val checksum = computeSha256(snapshotFile)
+                        if (!checksum.equals(SNAPSHOT_SHA256, ignoreCase = true)) {
+                            onLog(
+                                "Checksum mismatch for ${snapshotFile.name}: expected $SNAPSHOT_SHA256, found $checksum"
+                            )
+                            return false
                         }
+                        markVerified(snapshotFile)
+                    }
+                    deleteRecursively(tempRoot)
+                    tempRoot.mkdirs()
+                    bytesRead = 0L
+                    extractWithCommonsCompress(snapshotFile, tempRoot) { read ->
+                        bytesRead += read
+                        updateProgress()
                     }
                 }
 
@@ -233,25 +273,202 @@ class ChainstateBootstrapper(private val context: Context) {
         }.getOrElse { false }
     }
 
+    /**
+     * Pipelined native gunzip/untar (see snapshot_extractor.cpp). Returns null on success or the
+     * reason it could not be used, in which case [tempRoot] may hold a partial tree.
+     */
+    /** Whether a seekable snapshot container (DGBSNAP1) is published for this release. */
+    fun hasSnapshotContainer(): Boolean =
+        CONTAINER_URL.isNotBlank() && CONTAINER_FILENAME.isNotBlank() && CONTAINER_INDEX_SHA256.isNotBlank()
+
+    /**
+     * Download the snapshot container and apply it into [datadir] at the same time. Each chunk is
+     * verified and written to its final path in `chainstate/` and `blocks/` as soon as its bytes
+     * arrive, so there is no separate verify, extract or move pass. On failure, the partially
+     * written directories are removed. Downloaded chunks are kept so a retry resumes.
+     */
+    suspend fun applySnapshotContainer(
+        datadir: File,
+        onProgress: (Int) -> Unit,
+        onLog: (String) -> Unit
+    ): Boolean = withContext(Dispatchers.IO) {
+        if (!hasSnapshotContainer()) return@withContext false
+        if (prefs.getBoolean(KEY_SNAPSHOT_APPLIED, false)) return@withContext true
+
+        val bootstrapDir = getSnapshotFile().parentFile ?: context.filesDir
+        val containerFile = File(bootstrapDir, CONTAINER_FILENAME)
+        val downloadFile = File(bootstrapDir, "$CONTAINER_FILENAME.download")
+        val targets = listOf(File(datadir, "chainstate"), File(datadir, "blocks"))
+        // Chunks are written in place, so start from empty directories.
+        targets.forEach { if (it.exists()) deleteRecursively(it) }
+        datadir.mkdirs()
+
+        val downloaded = containerFile.exists()
+        val source = if (downloaded) containerFile else downloadFile
+        val applier = try {
+            SnapshotContainerApplier(source.absolutePath, datadir.absolutePath, CONTAINER_INDEX_SHA256)
+        } catch (e: IllegalStateException) {
+            onLog("Snapshot container unavailable: ${e.message}")
+            return@withContext false
+        }
+
+        var lastProgress = -1
+        val applied = try {
+            coroutineScope {
+                val download = if (downloaded) {
+                    applier.markAvailable(0, containerFile.length())
+                    null
+                } else {
+                    launch {
+                        try {
+                            val result = SnapshotDownloader(CONTAINER_URL, downloadFile).download(
+                                onProgress = { _, _ -> },
+                                onLog = onLog,
+                                onChunk = { start, length -> applier.markAvailable(start, length) }
+                            )
+                            if (result != SnapshotDownloader.Result.COMPLETE) {
+                                throw IOException("server does not support ranged downloads")
+                            }
+                        } finally {
+                            applier.interrupt()
+                        }
+                    }
+                }
+
+                var downloadFinished = download == null
+                while (!applier.isComplete()) {
+                    ensureActive()
+                    applier.applyAvailable(APPLY_POLL_MS, APPLY_THREADS)?.let { error ->
+                        download?.cancel()
+                        throw IOException(error)
+                    }
+                    val total = applier.totalBytes()
+                    if (total > 0) {
+                        val percent = ((applier.appliedBytes() * 100) / total).toInt().coerceIn(0, 100)
+                        if (percent != lastProgress) {
+                            lastProgress = percent
+                            onProgress(percent)
+                        }
+                    }
+                    // Every range was marked before the download finished; one more pass
+                    // after seeing that applies the last of them.
+                    if (downloadFinished && !applier.isComplete()) {
+                        throw IOException("snapshot container ended before all chunks arrived")
+                    }
+                    downloadFinished = download == null || download.isCompleted
+                }
+                applier.finish()?.let { throw IOException(it) }
+            }
+            true
+        } catch (e: CancellationException) {
+            targets.forEach { if (it.exists()) deleteRecursively(it) }
+            throw e
+        } catch (e: Exception) {
+            onLog("Applying snapshot container failed: ${e.message}")
+            targets.forEach { if (it.exists()) deleteRecursively(it) }
+            false
+        } finally {
+            applier.close()
+        }
+
+        if (applied) {
+            // The chainstate now lives in the datadir; the container is only dead weight.
+            downloadFile.delete()
+            containerFile.delete()
+            prefs.edit().putBoolean(KEY_SNAPSHOT_APPLIED, true).apply()
+            onLog("Snapshot container applied")
+        }
+        applied
+    }
+
+    private fun extractNative(
+        snapshotFile: File,
+        tempRoot: File,
+        expectedSha256: String?,
+        onBytes: (Long, Long) -> Unit
+    ): String? = runCatching {
+        DigiMobileNodeController().extractTarGz(
+            snapshotFile.absolutePath,
+            tempRoot.absolutePath,
+            1,
+            expectedSha256
+        ) { done, total ->
+            onBytes(done, total)
+            true
+        }
+    }.getOrElse { it.message ?: it.javaClass.simpleName }
+
+    private fun extractWithCommonsCompress(
+        snapshotFile: File,
+        tempRoot: File,
+        onBytes: (Int) -> Unit
+    ) {
+        FileInputStream(snapshotFile).use { fis ->
+            GzipCompressorInputStream(BufferedInputStream(fis)).use { gzip ->
+                TarArchiveInputStream(gzip).use { tar ->
+                    var entry = tar.nextTarEntry
+                    val buffer = ByteArray(DEFAULT_BUFFER_SIZE)
+                    while (entry != null) {
+                        val relativePath = entry.name
+                            .trimStart('/')
+                            .split('/')
+                            .drop(1)
+                            .joinToString("/")
+
+                        if (relativePath.isNotEmpty()) {
+                            val outputFile = File(tempRoot, relativePath)
+                            if (entry.isDirectory) {
+                                outputFile.mkdirs()
+                            } else {
+                                outputFile.parentFile?.mkdirs()
+                                FileOutputStream(outputFile).use { output ->
+                                    var read = tar.read(buffer)
+                                    while (read != -1) {
+                                        output.write(buffer, 0, read)
+                                        onBytes(read)
+                                        read = tar.read(buffer)
+                                    }
+                                }
+                            }
+                        } else {
+                            var read = tar.read(buffer)
+                            while (read != -1) {
+                                onBytes(read)
+                                read = tar.read(buffer)
+                            }
+                        }
+
+                        entry = tar.nextTarEntry
+                    }
+                }
+            }
+        }
+    }
+
     private fun getSnapshotFile(): File {
         val dir = File(context.filesDir, "bootstrap")
         if (!dir.exists()) dir.mkdirs()
         return File(dir, SNAPSHOT_FILENAME)
     }
 
-    private fun computeSha256(file: File): String {
-        val digest = MessageDigest.getInstance("SHA-256")
-        FileInputStream(file).use { input ->
-            val buffer = ByteArray(DEFAULT_BUFFER_SIZE)
-            var read = input.read(buffer)
-            while (read != -1) {
-                digest.update(buffer, 0, read)
-                read = input.read(buffer)
-            }
-        }
-        return digest.digest().joinToString(separator = "") { byte ->
-            String.format("%02x", byte)
-        }
+    private fun computeSha256(file: File): String = Sha256Hasher.hashFile(file)
+
+    /**
+     * A snapshot that has passed verification gets a marker recording the expected hash plus
+     * the file's size and mtime. While those still match, the file is not hashed again.
+     */
+    private fun verifiedMarker(file: File): File = File(file.parentFile, "${file.name}.verified")
+
+    private fun verifiedStamp(file: File): String =
+        "$SNAPSHOT_SHA256 ${file.length()} ${file.lastModified()}"
+
+    private fun isVerified(file: File): Boolean {
+        val marker = verifiedMarker(file)
+        return marker.exists() && runCatching { marker.readText() }.getOrNull() == verifiedStamp(file)
+    }
+
+    private fun markVerified(file: File) {
+        runCatching { verifiedMarker(file).writeText(verifiedStamp(file)) }
     }
 
     private fun deleteRecursively(target: File) {
@@ -279,7 +496,19 @@ class ChainstateBootstrapper(private val context: Context) {
         const val SNAPSHOT_HASH: String =
             "c9ee30e68b378a7919aae79eb8ff21725dab382cdac573700efd37e0f92a8c8d"
 
+        // Seekable snapshot container (scripts/make-snapshot-container.sh). Empty until one is
+        // published; the tar.gz snapshot above is used meanwhile. It must hold the chainstate at
+        // SNAPSHOT_HEIGHT, which the post-start header check still verifies.
+        const val CONTAINER_URL: String = ""
+        const val CONTAINER_FILENAME: String = ""
+        const val CONTAINER_INDEX_SHA256: String = ""
+
+        private const val APPLY_POLL_MS = 500
+        private const val APPLY_THREADS = 2
+
         private const val PREFS_NAME = "digimobile_prefs"
         private const val KEY_SNAPSHOT_APPLIED = "snapshot_applied"
+        // Prefix of the native extractor's error when the archive hash is wrong.
+        private const val CHECKSUM_MISMATCH_PREFIX = "checksum mismatch"
     }
 }
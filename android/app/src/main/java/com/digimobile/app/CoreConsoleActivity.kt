@@ -10,26 +10,33 @@ import androidx.lifecycle.Lifecycle
 import androidx.lifecycle.lifecycleScope
 import androidx.lifecycle.repeatOnLifecycle
 import com.digimobile.app.databinding.ActivityCoreConsoleBinding
+import com.digimobile.node.DigiMobileNodeController
 import com.digimobile.node.NodeManager
 import com.digimobile.node.NodeManagerProvider
 import com.digimobile.node.NodeState
 import com.digimobile.node.toUserMessage
 import java.util.ArrayDeque
-import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.channels.trySendBlocking
 import kotlinx.coroutines.launch
-import kotlinx.coroutines.withContext
 
 class CoreConsoleActivity : AppCompatActivity() {
 
     private lateinit var binding: ActivityCoreConsoleBinding
     private lateinit var nodeManager: NodeManager
 
-    private val consoleEntries = mutableListOf<String>()
     private val commandHistory = ArrayDeque<String>()
     private var cliAvailable: Boolean = true
+    private var entryCount = 0
+    private var runningCommand: Job? = null
+    @Volatile
+    private var cancelRequested = false
 
     companion object {
         private const val HISTORY_LIMIT = 20
+        // Output chunks waiting for the UI; when full, the native reader waits too.
+        private const val OUTPUT_BACKLOG_CHUNKS = 4
     }
 
     override fun onCreate(savedInstanceState: Bundle?) {
@@ -58,6 +65,13 @@ class CoreConsoleActivity : AppCompatActivity() {
         observeNodeState()
     }
 
+    override fun onDestroy() {
+        if (runningCommand != null) {
+            nodeManager.cancelConsoleCommand()
+        }
+        super.onDestroy()
+    }
+
     private fun observeNodeState() {
         lifecycleScope.launch {
             repeatOnLifecycle(Lifecycle.State.STARTED) {
@@ -83,6 +97,11 @@ class CoreConsoleActivity : AppCompatActivity() {
     }
 
     private fun onSendCommand() {
+        if (runningCommand != null) {
+            cancelRequested = true
+            nodeManager.cancelConsoleCommand()
+            return
+        }
         val commandText = binding.inputCommand.text.toString().trim()
         if (commandText.isEmpty()) {
             showWarning("Please enter a command to send.")
@@ -95,20 +114,47 @@ class CoreConsoleActivity : AppCompatActivity() {
         }
 
         hideWarning()
-        binding.buttonSend.isEnabled = false
-
-        lifecycleScope.launch {
+        binding.buttonSend.text = "Cancel"
+        binding.inputCommand.isEnabled = false
+        cancelRequested = false
+        beginConsoleEntry(commandText)
+
+        runningCommand = lifecycleScope.launch {
+            // Output is appended as it arrives; the bounded channel holds the reader back while
+            // the TextView catches up instead of queueing the whole reply.
+            val chunks = Channel<String>(OUTPUT_BACKLOG_CHUNKS)
+            var endsWithNewline = true
+            val renderer = launch {
+                try {
+                    for (chunk in chunks) {
+                        binding.textConsole.append(chunk)
+                        endsWithNewline = chunk.endsWith('\n')
+                        scrollToBottom()
+                    }
+                } finally {
+                    chunks.cancel()
+                }
+            }
             try {
                 val args = parseCommand(commandText)
-                val result = withContext(Dispatchers.IO) { nodeManager.executeCliCommand(args) }
+                val result = try {
+                    nodeManager.executeConsoleCommand(args) { chunk ->
+                        !cancelRequested && chunks.trySendBlocking(chunk).isSuccess
+                    }
+                } finally {
+                    chunks.close()
+                }
+                renderer.join()
                 cliAvailable = nodeManager.cliAvailable
                 if (!cliAvailable) {
                     showCliUnavailableMessage()
                     return@launch
                 }
-                appendConsoleEntry(commandText, result)
+                finishConsoleEntry(result, endsWithNewline)
             } finally {
-                binding.buttonSend.isEnabled = true
+                runningCommand = null
+                binding.buttonSend.text = "Send"
+                binding.inputCommand.isEnabled = true
                 binding.inputCommand.text?.clear()
             }
         }
@@ -122,21 +168,32 @@ class CoreConsoleActivity : AppCompatActivity() {
         }.toList()
     }
 
-    private fun appendConsoleEntry(command: String, result: NodeManager.CliResult) {
+    private fun beginConsoleEntry(command: String) {
         if (commandHistory.size >= HISTORY_LIMIT) {
             commandHistory.removeFirst()
         }
         commandHistory.addLast(command)
 
+        if (entryCount++ == 0) {
+            binding.textConsole.text = ""
+        } else {
+            binding.textConsole.append("\n\n")
+        }
+        binding.textConsole.append(">$ $command\n")
+        scrollToBottom()
+    }
+
+    private fun finishConsoleEntry(result: NodeManager.CliResult, outputEndsWithNewline: Boolean) {
         val entryBuilder = StringBuilder()
-        entryBuilder.appendLine(">$ $command")
-        if (result.stdout.isNotEmpty()) {
-            entryBuilder.appendLine(result.stdout)
+        if (!outputEndsWithNewline) {
+            entryBuilder.appendLine()
         }
-        if (result.stderr.isNotEmpty()) {
+        if (result.stderr.isNotEmpty() && result.exitCode != DigiMobileNodeController.CONSOLE_CANCELLED) {
             entryBuilder.appendLine("[stderr] ${result.stderr}")
         }
-        if (result.exitCode != 0) {
+        if (result.exitCode == DigiMobileNodeController.CONSOLE_CANCELLED) {
+            entryBuilder.append("[cancelled]")
+        } else if (result.exitCode != 0) {
             val errorMessage = buildString {
                 append("[error] digibyte-cli exited with code ${result.exitCode}")
                 if (result.stderr.isNotEmpty()) {
@@ -148,8 +205,7 @@ class CoreConsoleActivity : AppCompatActivity() {
             entryBuilder.append("(exit ${result.exitCode})")
         }
 
-        consoleEntries.add(entryBuilder.toString())
-        binding.textConsole.text = consoleEntries.joinToString(separator = "\n\n")
+        binding.textConsole.append(entryBuilder)
         scrollToBottom()
     }
 
@@ -6,6 +6,7 @@ import android.os.Build
 import android.util.Log
 import com.digimobile.node.DigiConfigTemplate
 import com.digimobile.node.NodeEnvironment
+import com.digimobile.node.ResourceTuning
 import com.digimobile.node.RpcCredentials
 import java.io.File
 import java.io.FileOutputStream
@@ -28,7 +29,8 @@ class NodeBootstrapper(private val context: Context) {
 
     fun isFirstRun(): Boolean = !prefs.getBoolean(KEY_BOOTSTRAP_COMPLETE, false)
 
-    fun ensureBootstrap(): NodePaths {
+    /** @param tuning limits from the resource governor to write into digibyte.conf, if any. */
+    fun ensureBootstrap(tuning: ResourceTuning? = null): NodePaths {
         val dataDir = File(context.filesDir, "digibyte")
         val binDir = File(dataDir.parentFile, "bin")
 
@@ -42,7 +44,7 @@ class NodeBootstrapper(private val context: Context) {
 
         ensureCliBinary()
 
-        val credentials = ensureConfig(dataDir)
+        val credentials = ensureConfig(dataDir, tuning)
 
         prefs.edit().putBoolean(KEY_BOOTSTRAP_COMPLETE, true).apply()
         val paths = NodePaths(configFile, dataDir, debugLogFile)
@@ -156,9 +158,11 @@ class NodeBootstrapper(private val context: Context) {
         }
     }
 
-    private fun ensureConfig(dataDir: File): RpcCredentials {
+    private fun ensureConfig(dataDir: File, tuning: ResourceTuning?): RpcCredentials {
         val options = configStore.load()
-        return DigiConfigTemplate.ensureConfig(dataDir, options)
+        // The app's own node is instance 0; nodes from DigiMobileNodeController.newNode() take the
+        // instances after it so their RPC ports don't collide with this one.
+        return DigiConfigTemplate.ensureConfig(dataDir, options, tuning, instance = 0)
     }
 
     companion object {
@@ -3,6 +3,7 @@ package com.digimobile.app
 import android.content.Context
 import android.content.SharedPreferences
 import com.digimobile.node.NodeConfigOptions
+import com.digimobile.node.NodeNetwork
 import com.digimobile.node.NodeSetupPreset
 
 class NodeConfigStore(context: Context) {
@@ -22,6 +23,7 @@ class NodeConfigStore(context: Context) {
             .putBoolean(KEY_TELEMETRY_CONSENT, options.telemetryConsent)
             .putBoolean(KEY_WIFI_ONLY, options.wifiOnlyPreference)
             .putBoolean(KEY_USE_SNAPSHOT, options.useSnapshot)
+            .putString(KEY_NETWORK, options.network.name)
             .apply()
 
         currentConfig = options
@@ -41,6 +43,7 @@ class NodeConfigStore(context: Context) {
             telemetryConsent = prefs.getBoolean(KEY_TELEMETRY_CONSENT, false),
             wifiOnlyPreference = prefs.getBoolean(KEY_WIFI_ONLY, true),
             useSnapshot = prefs.getBoolean(KEY_USE_SNAPSHOT, true),
+            network = NodeNetwork.fromName(prefs.getString(KEY_NETWORK, null)),
         )
 
         currentConfig = options
@@ -89,5 +92,6 @@ class NodeConfigStore(context: Context) {
         private const val KEY_TELEMETRY_CONSENT = "telemetry_consent"
         private const val KEY_WIFI_ONLY = "wifi_only"
         private const val KEY_USE_SNAPSHOT = "use_snapshot"
+        private const val KEY_NETWORK = "config_network"
     }
 }
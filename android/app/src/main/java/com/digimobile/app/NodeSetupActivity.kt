@@ -190,6 +190,7 @@ class NodeSetupActivity : AppCompatActivity() {
             DebugLogStatus.Missing -> "absent"
         }
         binding.textDeveloperDebugLog.text = "debug.log: $debugLogLabel"
+        binding.textDeveloperProcess.text = "digibyted: ${snapshot.process ?: "status unavailable"}"
     }
 
     private fun updateProgress(state: NodeState) {
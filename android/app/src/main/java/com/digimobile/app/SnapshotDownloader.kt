@@ -0,0 +1,281 @@
+package com.digimobile.app
+
+import com.digimobile.node.DigiMobileNodeController
+import com.digimobile.node.Sha256Hasher
+import java.io.File
+import java.io.IOException
+import java.io.RandomAccessFile
+import java.net.HttpURLConnection
+import java.net.URL
+import java.nio.ByteBuffer
+import java.nio.channels.FileChannel
+import java.util.concurrent.atomic.AtomicInteger
+import java.util.concurrent.atomic.AtomicLong
+import kotlin.coroutines.coroutineContext
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.ensureActive
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.withContext
+
+/**
+ * Resumable, parallel download of a large file using HTTP Range requests.
+ *
+ * The file is split into fixed-size chunks that several connections fetch concurrently into a
+ * preallocated [target]. A chunk is fsync'd before it is recorded, with its SHA-256, in a
+ * `<target>.chunks` manifest, so an interrupted download resumes with only the missing chunks.
+ * If the server also publishes `<url>.chunks` (see scripts/make-snapshot-chunk-manifest.sh), each
+ * chunk is checked against it as it arrives and a corrupt chunk is re-fetched on its own.
+ *
+ * [download] returns [Result.RANGES_UNSUPPORTED] when the server ignores Range requests; callers
+ * then fall back to a plain sequential download.
+ */
+class SnapshotDownloader(
+    private val url: String,
+    private val target: File,
+    private val connections: Int = DEFAULT_CONNECTIONS,
+    private val chunkSize: Long = DEFAULT_CHUNK_SIZE
+) {
+    enum class Result { COMPLETE, RANGES_UNSUPPORTED }
+
+    private val manifestFile = File(target.parentFile, "${target.name}.chunks")
+
+    /**
+     * @param onChunk called with the byte range of every chunk present in [target], including
+     *                chunks kept from an earlier attempt. It may run on several threads at once.
+     */
+    suspend fun download(
+        onProgress: (Long, Long) -> Unit,
+        onLog: (String) -> Unit,
+        onChunk: (Long, Long) -> Unit = { _, _ -> }
+    ): Result = withContext(Dispatchers.IO) {
+        val remote = probe() ?: return@withContext Result.RANGES_UNSUPPORTED
+        val expected = fetchRemoteChunkHashes(remote.length)
+        if (expected != null) {
+            onLog("Verifying snapshot chunks against ${expected.size} published hashes")
+        }
+
+        val done = loadManifest(remote)
+        if (expected != null) {
+            done.entries.removeAll { (index, hash) ->
+                !hash.equals(expected.getOrNull(index), ignoreCase = true)
+            }
+        }
+        val chunkCount = ((remote.length + chunkSize - 1) / chunkSize).toInt()
+        if (done.isEmpty()) {
+            writeManifestHeader(remote)
+            preallocate(remote.length)
+        } else {
+            onLog("Resuming snapshot download: ${done.size}/$chunkCount chunks already present")
+        }
+
+        val pending = (0 until chunkCount).filter { it !in done }
+        val next = AtomicInteger(0)
+        val received = AtomicLong(done.keys.sumOf { chunkLength(it, remote.length) })
+        onProgress(received.get(), remote.length)
+        for (index in done.keys) {
+            onChunk(index * chunkSize, chunkLength(index, remote.length))
+        }
+
+        RandomAccessFile(target, "rw").use { file ->
+            val channel = file.channel
+            coroutineScope {
+                repeat(connections.coerceIn(1, pending.size.coerceAtLeast(1))) {
+                    launch {
+                        while (true) {
+                            val slot = next.getAndIncrement()
+                            if (slot >= pending.size) break
+                            val index = pending[slot]
+                            val hash = fetchChunkWithRetry(channel, index, remote, expected?.get(index)) { bytes ->
+                                onProgress(received.addAndGet(bytes), remote.length)
+                            }
+                            recordChunk(index, hash)
+                            onChunk(index * chunkSize, chunkLength(index, remote.length))
+                        }
+                    }
+                }
+            }
+        }
+        manifestFile.delete()
+        Result.COMPLETE
+    }
+
+    /** Discard any partial download so the next attempt starts over. */
+    fun reset() {
+        target.delete()
+        manifestFile.delete()
+    }
+
+    private data class Remote(val length: Long, val validator: String)
+
+    // One-byte Range request: a 206 answer tells us ranges work and carries the total length.
+    private fun probe(): Remote? {
+        val connection = open(0, 0)
+        try {
+            if (connection.responseCode != HttpURLConnection.HTTP_PARTIAL) return null
+            val total = connection.getHeaderField("Content-Range")
+                ?.substringAfterLast('/')
+                ?.toLongOrNull()
+                ?: return null
+            val validator = connection.getHeaderField("ETag")
+                ?: connection.getHeaderField("Last-Modified")
+                ?: "-"
+            return Remote(total, validator)
+        } finally {
+            connection.disconnect()
+        }
+    }
+
+    // "<chunk size>" on the first line, then one hex SHA-256 per chunk.
+    private fun fetchRemoteChunkHashes(length: Long): List<String>? = runCatching {
+        val connection = URL("$url.chunks").openConnection() as HttpURLConnection
+        connection.connectTimeout = TIMEOUT_MS
+        connection.readTimeout = TIMEOUT_MS
+        try {
+            if (connection.responseCode != HttpURLConnection.HTTP_OK) return@runCatching null
+            val lines = connection.inputStream.bufferedReader().readLines().map { it.trim() }
+                .filter { it.isNotEmpty() }
+            val size = lines.firstOrNull()?.toLongOrNull()
+            val hashes = lines.drop(1)
+            if (size != chunkSize || hashes.size.toLong() != (length + chunkSize - 1) / chunkSize) {
+                null
+            } else {
+                hashes
+            }
+        } finally {
+            connection.disconnect()
+        }
+    }.getOrNull()
+
+    private suspend fun fetchChunkWithRetry(
+        channel: FileChannel,
+        index: Int,
+        remote: Remote,
+        expectedHash: String?,
+        onBytes: (Long) -> Unit
+    ): String {
+        var attempt = 0
+        while (true) {
+            coroutineContext.ensureActive()
+            var counted = 0L
+            try {
+                val hash = fetchChunk(channel, index, remote) { bytes ->
+                    counted += bytes
+                    onBytes(bytes)
+                }
+                if (expectedHash == null || hash.equals(expectedHash, ignoreCase = true)) {
+                    return hash
+                }
+                throw IOException("chunk $index hash mismatch")
+            } catch (e: IOException) {
+                onBytes(-counted)
+                if (++attempt >= MAX_ATTEMPTS) throw e
+                delay(RETRY_BACKOFF_MS * attempt)
+            }
+        }
+    }
+
+    private fun fetchChunk(
+        channel: FileChannel,
+        index: Int,
+        remote: Remote,
+        onBytes: (Long) -> Unit
+    ): String {
+        val start = index * chunkSize
+        val length = chunkLength(index, remote.length)
+        val connection = open(start, start + length - 1)
+        try {
+            if (remote.validator != "-") {
+                // The server answers 200 with the whole file if it changed underneath us.
+                connection.setRequestProperty("If-Range", remote.validator)
+            }
+            if (connection.responseCode != HttpURLConnection.HTTP_PARTIAL) {
+                throw IOException("chunk $index: HTTP ${connection.responseCode}")
+            }
+            Sha256Hasher().use { hasher ->
+                val buffer = ByteArray(BUFFER_SIZE)
+                var position = start
+                connection.inputStream.use { input ->
+                    while (position < start + length) {
+                        val read = input.read(buffer, 0, minOf(buffer.size.toLong(), start + length - position).toInt())
+                        if (read == -1) throw IOException("chunk $index truncated")
+                        hasher.update(buffer, 0, read)
+                        val data = ByteBuffer.wrap(buffer, 0, read)
+                        while (data.hasRemaining()) {
+                            position += channel.write(data, position)
+                        }
+                        onBytes(read.toLong())
+                    }
+                }
+                channel.force(false)
+                return hasher.finishHex()
+            }
+        } finally {
+            connection.disconnect()
+        }
+    }
+
+    private fun open(first: Long, last: Long): HttpURLConnection {
+        val connection = URL(url).openConnection() as HttpURLConnection
+        connection.connectTimeout = TIMEOUT_MS
+        connection.readTimeout = TIMEOUT_MS
+        connection.setRequestProperty("Range", "bytes=$first-$last")
+        // Ranges must refer to the stored bytes, not a re-encoded stream.
+        connection.setRequestProperty("Accept-Encoding", "identity")
+        return connection
+    }
+
+    private fun chunkLength(index: Int, total: Long): Long =
+        minOf(chunkSize, total - index * chunkSize)
+
+    // Manifest: "<length> <chunk size>", the URL, the ETag or Last-Modified validator, then
+    // "<index> <sha256>" per finished chunk.
+    private fun loadManifest(remote: Remote): MutableMap<Int, String> {
+        val done = mutableMapOf<Int, String>()
+        if (!manifestFile.exists() || !target.exists()) return done
+        val lines = runCatching { manifestFile.readLines() }.getOrNull() ?: return done
+        if (lines.size < 3 ||
+            lines[0] != "${remote.length} $chunkSize" ||
+            lines[1] != url ||
+            lines[2] != remote.validator
+        ) {
+            return done
+        }
+        for (line in lines.drop(3)) {
+            val parts = line.split(' ')
+            val index = parts.getOrNull(0)?.toIntOrNull() ?: continue
+            val hash = parts.getOrNull(1)?.takeIf { it.length == 64 } ?: continue
+            done[index] = hash
+        }
+        return done
+    }
+
+    private fun writeManifestHeader(remote: Remote) {
+        manifestFile.writeText("${remote.length} $chunkSize\n$url\n${remote.validator}\n")
+    }
+
+    @Synchronized
+    private fun recordChunk(index: Int, hash: String) {
+        manifestFile.appendText("$index $hash\n")
+    }
+
+    private fun preallocate(length: Long) {
+        target.parentFile?.mkdirs()
+        val allocated = runCatching {
+            DigiMobileNodeController().preallocateFile(target.absolutePath, length)
+        }.getOrDefault(false)
+        if (!allocated) {
+            RandomAccessFile(target, "rw").use { it.setLength(length) }
+        }
+    }
+
+    companion object {
+        const val DEFAULT_CONNECTIONS = 4
+        const val DEFAULT_CHUNK_SIZE = 16L * 1024 * 1024
+        private const val BUFFER_SIZE = 256 * 1024
+        private const val TIMEOUT_MS = 15_000
+        private const val MAX_ATTEMPTS = 5
+        private const val RETRY_BACKOFF_MS = 2_000L
+    }
+}
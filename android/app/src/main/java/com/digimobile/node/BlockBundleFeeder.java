@@ -0,0 +1,106 @@
+package com.digimobile.node;
+
+import java.io.Closeable;
+
+/**
+ * Streams a block bundle (see {@code android/jni/block_bundle.h}) into the node through a named
+ * pipe that the daemon reads as {@code -loadblock}.
+ *
+ * Before the node starts, {@link #verify} checks that the bundle's headers form one chain and
+ * {@link #openPipe} creates the pipe, whose path goes to
+ * {@link DigiMobileNodeController#setBlockImport}. Once the node runs, a background thread calls
+ * {@link #feed}, which checks every block against its header as it hands it over. The daemon
+ * validates each block fully either way.
+ */
+public final class BlockBundleFeeder implements Closeable {
+    private long handle;
+
+    /**
+     * @param headersPath the {@code .headers} file written next to the bundle.
+     * @throws IllegalStateException if the native library is unavailable.
+     */
+    public BlockBundleFeeder(String blocksPath, String headersPath) {
+        if (!DigiMobileNodeController.isNativeLoaded()) {
+            throw new IllegalStateException("Native library digimobile_jni is missing");
+        }
+        handle = nativeCreate(blocksPath, headersPath);
+    }
+
+    /**
+     * @param expectedSha256 hex SHA-256 of the headers file, or {@code null} to accept any.
+     * @param expectedPrevHash hash of the block the bundle must extend, as RPC prints it, or
+     *                         {@code null}.
+     * @return {@code null}, or the reason the bundle was rejected.
+     */
+    public String verify(String expectedSha256, String expectedPrevHash) {
+        return nativeVerify(requireHandle(), expectedSha256, expectedPrevHash);
+    }
+
+    /** Height of the first block, once verified. */
+    public long startHeight() {
+        return nativeInfo(requireHandle())[0];
+    }
+
+    public long blockCount() {
+        return nativeInfo(requireHandle())[1];
+    }
+
+    /** @return {@code null}, or the reason the pipe could not be created. */
+    public String openPipe(String pipePath) {
+        return nativeOpenPipe(requireHandle(), pipePath);
+    }
+
+    /**
+     * Hand every block to the daemon. Blocks until it has read them all, {@link #interrupt} is
+     * called or a block does not match its header. The pipe is removed when this returns.
+     *
+     * @return {@code null} on success, otherwise the reason.
+     */
+    public String feed() {
+        return nativeFeed(requireHandle());
+    }
+
+    /** Make {@link #feed} return, from any thread. */
+    public synchronized void interrupt() {
+        if (handle != 0) {
+            nativeInterrupt(handle);
+        }
+    }
+
+    public long fedBlocks() {
+        return nativeProgress(requireHandle())[0];
+    }
+
+    public long fedBytes() {
+        return nativeProgress(requireHandle())[1];
+    }
+
+    /** Size of the bundle file, once verified. */
+    public long totalBytes() {
+        return nativeProgress(requireHandle())[2];
+    }
+
+    @Override
+    public synchronized void close() {
+        if (handle != 0) {
+            nativeDestroy(handle);
+            handle = 0;
+        }
+    }
+
+    private synchronized long requireHandle() {
+        if (handle == 0) {
+            throw new IllegalStateException("BlockBundleFeeder is closed");
+        }
+        return handle;
+    }
+
+    private static native long nativeCreate(String blocksPath, String headersPath);
+    private static native String nativeVerify(long handle, String expectedSha256, String expectedPrevHash);
+    private static native long[] nativeInfo(long handle);
+    private static native String nativeOpenPipe(long handle, String pipePath);
+    private static native String nativeFeed(long handle);
+    private static native void nativeInterrupt(long handle);
+    private static native long[] nativeProgress(long handle);
+    private static native void nativeDestroy(long handle);
+}
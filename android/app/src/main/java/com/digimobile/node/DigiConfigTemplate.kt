@@ -10,14 +10,27 @@ import java.util.UUID
 // - NodeBootstrapper.ensureBootstrap(): calls this helper and records the resulting RPC credentials.
 // - DigiMobileNodeController.startNode() / nativeStartNode(): consume the paths ensured here via -conf/-datadir.
 
-data class RpcCredentials(val user: String, val password: String)
+/** How the app reaches a node's RPC server: the login and the port written to its digibyte.conf. */
+data class RpcCredentials(val user: String, val password: String, val port: Int)
 
 object DigiConfigTemplate {
 
     private const val TAG = "DigiConfigTemplate"
     private const val RPC_USER_DEFAULT = "digiuser"
 
-    fun ensureConfig(datadir: File, options: NodeConfigOptions): RpcCredentials {
+    /**
+     * @param tuning limits from [ResourceGovernor]. They replace the preset's cache and peer
+     *               counts unless the user chose [NodeSetupPreset.CUSTOM]; LIGHT keeps its values
+     *               as a ceiling.
+     * @param instance which node of the process this is (see [NodeNetwork.rpcPort]); the RPC
+     *                 port written for it is returned with the credentials.
+     */
+    fun ensureConfig(
+        datadir: File,
+        options: NodeConfigOptions,
+        tuning: ResourceTuning? = null,
+        instance: Int = 0
+    ): RpcCredentials {
         if (!datadir.exists()) {
             datadir.mkdirs()
         }
@@ -28,23 +41,47 @@ object DigiConfigTemplate {
         }
         val parsedUser = parseValue(content, "rpcuser") ?: RPC_USER_DEFAULT
         val parsedPassword = parseValue(content, "rpcpassword")
-        val credentials = RpcCredentials(parsedUser, parsedPassword ?: generatePassword())
+        val credentials = RpcCredentials(
+            parsedUser,
+            parsedPassword ?: generatePassword(),
+            options.network.rpcPort(instance)
+        )
 
-        configFile.writeText(buildTemplate(credentials, options))
+        configFile.writeText(buildTemplate(credentials, options, tuning))
         return credentials
     }
 
-    private fun buildTemplate(credentials: RpcCredentials, options: NodeConfigOptions): String {
+    private fun buildTemplate(
+        credentials: RpcCredentials,
+        options: NodeConfigOptions,
+        tuning: ResourceTuning?
+    ): String {
+        val governed = tuning?.takeIf { options.preset != NodeSetupPreset.CUSTOM }
+        var maxConnections = governed?.maxConnections ?: options.maxConnections
+        var dbCacheMb = governed?.dbcacheMb ?: options.dbCacheMb
+        if (governed != null && options.preset == NodeSetupPreset.LIGHT) {
+            maxConnections = maxConnections.coerceAtMost(options.maxConnections)
+            dbCacheMb = dbCacheMb.coerceAtMost(options.dbCacheMb)
+        }
+
         val builder = StringBuilder()
         builder.appendLine("# DigiByte mobile configuration")
         builder.appendLine("# Profile: ${options.preset}")
+        if (governed != null) {
+            builder.appendLine("# Resource profile: ${governed.profileName()}")
+        }
+        options.network.selectOption?.let { builder.appendLine("$it=1") }
         builder.appendLine("server=1")
         builder.appendLine("listen=1")
         builder.appendLine("dns=1")
         builder.appendLine("discover=1")
-        builder.appendLine("maxconnections=${options.maxConnections}")
+        builder.appendLine("maxconnections=$maxConnections")
         builder.appendLine("prune=${options.pruneTargetMb}")
-        builder.appendLine("dbcache=${options.dbCacheMb}")
+        builder.appendLine("dbcache=$dbCacheMb")
+        if (governed != null) {
+            builder.appendLine("par=${governed.par}")
+            builder.appendLine("maxmempool=${governed.maxMempoolMb}")
+        }
         builder.appendLine("txindex=0")
         if (options.blocksonly) {
             builder.appendLine("blocksonly=1")
@@ -53,7 +90,10 @@ object DigiConfigTemplate {
         builder.appendLine("rpcuser=${credentials.user}")
         builder.appendLine("rpcpassword=${credentials.password}")
         builder.appendLine("rpcallowip=127.0.0.1")
+        builder.appendLine()
+        builder.appendLine("[${options.network.section}]")
         builder.appendLine("rpcbind=127.0.0.1")
+        builder.appendLine("rpcport=${credentials.port}")
         return builder.toString()
     }
 
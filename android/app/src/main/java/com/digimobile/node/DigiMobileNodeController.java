@@ -1,7 +1,10 @@
 package com.digimobile.node;
 
 import android.content.Context;
+import android.content.pm.PackageInfo;
+import android.content.pm.PackageManager;
 import android.content.res.AssetManager;
+import android.os.Build;
 import android.util.Log;
 import java.io.File;
 
@@ -12,6 +15,11 @@ import java.io.File;
  * the DigiByte daemon as a child process. Callers should provide configuration
  * and data directory paths that reside within the app's private storage.
  *
+ * Each controller drives one node through an opaque native handle. Controllers made with
+ * the public constructor share the app's default node; {@link #newNode()} registers another
+ * one, so several daemons with separate data directories, ports and scheduling can run side
+ * by side. All nodes share the binaries staged into {@code filesDir/bin}.
+ *
  * Threading: starting and stopping the node may perform blocking work (process
  * creation and IPC). Callers should invoke these methods on a background
  * executor rather than the main/UI thread.
@@ -19,6 +27,58 @@ import java.io.File;
 public class DigiMobileNodeController {
     private static final String TAG = "DigiMobileNode";
     private static final boolean nativeLoaded;
+    private static final long defaultNode;
+    /** Grace period for a SIGTERM shutdown before the daemon is killed. */
+    public static final int DEFAULT_STOP_TIMEOUT_MS = 60_000;
+
+    /** Core sets for {@link #setSchedulingPolicy}. */
+    public static final int CORES_ALL = 0;
+    public static final int CORES_LITTLE = 1;
+    public static final int CORES_BIG = 2;
+    /** I/O priority classes for {@link #setSchedulingPolicy}; {@code IO_CLASS_INHERIT} leaves it alone. */
+    public static final int IO_CLASS_INHERIT = 0;
+    public static final int IO_CLASS_BEST_EFFORT = 2;
+    public static final int IO_CLASS_IDLE = 3;
+
+    /** Record kinds reported by {@link #pollLogRecords}. */
+    public static final int LOG_RECORD_PEER_CONNECTED = 0;
+    public static final int LOG_RECORD_PEER_DISCONNECTED = 1;
+    public static final int LOG_RECORD_WARNING = 2;
+    public static final int LOG_RECORD_ERROR = 3;
+
+    /** Exit codes returned by {@link #consoleExecute}, matching digibyte-cli where it has one. */
+    public static final int CONSOLE_OK = 0;
+    public static final int CONSOLE_RPC_ERROR = 1;
+    public static final int CONSOLE_UNREACHABLE = -2;
+    public static final int CONSOLE_CANCELLED = -3;
+
+    /** Results of {@link #pollSyncMetrics}. */
+    public static final int SYNC_METRICS_CHANGED = 1;
+    public static final int SYNC_METRICS_UNCHANGED = 0;
+    public static final int SYNC_METRICS_RPC_ERROR = -1;
+    public static final int SYNC_METRICS_UNREACHABLE = -2;
+
+    /** Receives the output of {@link #consoleExecute} on the calling thread. */
+    public interface ConsoleSink {
+        /**
+         * @param text next piece of the pretty-printed result.
+         * @return {@code false} to cancel the command.
+         */
+        boolean onOutput(String text);
+
+        /** @param text error text shaped like digibyte-cli's stderr. */
+        void onError(String text);
+    }
+
+    /** Progress callback for {@link #extractTarGz}. */
+    public interface ExtractProgressListener {
+        /**
+         * @param bytesDone  compressed bytes consumed so far.
+         * @param bytesTotal size of the archive.
+         * @return {@code false} to cancel the extraction.
+         */
+        boolean onProgress(long bytesDone, long bytesTotal);
+    }
 
     static {
         boolean loaded;
@@ -30,11 +90,68 @@ public class DigiMobileNodeController {
             loaded = false;
         }
         nativeLoaded = loaded;
+        defaultNode = loaded ? nativeDefaultNode() : 0;
+    }
+
+    /** Whether libdigimobile_jni.so loaded; other classes in this package share the library. */
+    static boolean isNativeLoaded() {
+        return nativeLoaded;
+    }
+
+    /** Native handle of this controller's node; 0 once released. */
+    private volatile long node;
+
+    /** Create a controller for the app's default node. */
+    public DigiMobileNodeController() {
+        this(defaultNode);
+    }
+
+    private DigiMobileNodeController(long node) {
+        this.node = node;
+    }
+
+    /**
+     * Register an additional node with its own lifecycle, RPC client and debug.log follower.
+     * Start it with a config and data directory no other node uses, with a distinct P2P port
+     * and the RPC port {@code DigiConfigTemplate.ensureConfig(..., instance)} derives for an
+     * instance above 0, and {@link #release} it when done. Only the first node to start can run
+     * in-process; the others always run as {@code digibyted} children.
+     */
+    public static DigiMobileNodeController newNode() {
+        if (!nativeLoaded) {
+            throw new IllegalStateException("Native library digimobile_jni is not available");
+        }
+        return new DigiMobileNodeController(nativeCreateNode());
+    }
+
+    /** Whether this controller drives the default node shared by every plain controller. */
+    public boolean isDefaultNode() {
+        return node == defaultNode;
+    }
+
+    /** Release a node created by {@link #newNode()} with {@link #DEFAULT_STOP_TIMEOUT_MS}. */
+    public void release() {
+        release(DEFAULT_STOP_TIMEOUT_MS);
+    }
+
+    /**
+     * Stop a node created by {@link #newNode()}, waiting up to {@code timeoutMs} before it is
+     * killed, and free its native state. The controller cannot be used afterwards. Does
+     * nothing for the default node, which lives as long as the process.
+     */
+    public void release(int timeoutMs) {
+        long handle = node;
+        if (!nativeLoaded || handle == defaultNode || handle == 0) {
+            return;
+        }
+        node = 0;
+        nativeReleaseNode(handle, timeoutMs);
     }
 
     /**
      * Start the Digi-Mobile node using the provided configuration and data paths.
-     * The daemon binary is unpacked from assets into {@code filesDir/bin} before execution.
+     * The daemon binary is unpacked from assets into {@code filesDir/bin} before execution;
+     * it is only rewritten when its content changed since the last install.
      *
      * @param context    application or service context for asset access.
      * @param configPath absolute path to the node configuration file.
@@ -47,9 +164,9 @@ public class DigiMobileNodeController {
         String daemonPath = new File(context.getFilesDir(), "bin/digibyted").getAbsolutePath();
         Log.i(TAG,
                 "Launching digibyted at " + daemonPath + " with datadir=" + dataDir + " and conf=" + configPath);
-        nativeStartNode(assets, configPath, dataDir, filesDir);
+        nativeStartNode(node, assets, configPath, dataDir, filesDir, assetStamp(context));
 
-        String status = nativeGetStatus();
+        String status = nativeGetStatus(node);
         if ("BINARY_MISSING".equals(status)) {
             throw new IllegalStateException(
                     "Missing digibyted asset. Rebuild with scripts/build-android.sh to stage assets/bin/digibyted-arm64.");
@@ -60,32 +177,469 @@ public class DigiMobileNodeController {
     }
 
     /**
-     * Attempt to terminate the Digi-Mobile node process.
+     * Attempt to terminate the Digi-Mobile node process, waiting up to
+     * {@link #DEFAULT_STOP_TIMEOUT_MS} for a graceful exit.
      */
     public void stopNode() {
+        stopNode(DEFAULT_STOP_TIMEOUT_MS);
+    }
+
+    /**
+     * Send SIGTERM to the node and block until it exits. If it is still alive after
+     * {@code timeoutMs} it is killed with SIGKILL. A pending crash restart is cancelled.
+     *
+     * @param timeoutMs grace period for the graceful shutdown.
+     */
+    public void stopNode(int timeoutMs) {
         ensureNativeLoaded();
-        nativeStopNode();
+        nativeStopNode(node, timeoutMs);
+    }
+
+    /**
+     * Configure automatic restarts after the daemon crashes (non-zero exit or fatal signal).
+     * Clean exits, such as an RPC {@code stop}, are never restarted. The backoff doubles after
+     * every attempt up to {@code maxBackoffMs}; the budget resets once the node stays up for
+     * five minutes.
+     */
+    public void setRestartPolicy(boolean enabled, int maxRestarts, int initialBackoffMs, int maxBackoffMs) {
+        if (!nativeLoaded) {
+            return;
+        }
+        nativeSetRestartPolicy(node, enabled, maxRestarts, initialBackoffMs, maxBackoffMs);
+    }
+
+    /**
+     * Configure warm restarts of the daemon child. While enabled, a start that follows a clean
+     * shutdown (the supervisor leaves a marker in the data directory whenever digibyted exits
+     * with status 0) passes {@code -checkblocks=1 -checklevel=0}, skipping most of the start-up
+     * block verification; after a crash or a forced kill the daemon runs its full checks. Every
+     * start also reads the newest chainstate and block index files into the page cache first.
+     *
+     * @param prewarmBudgetMb upper bound for that read-ahead, further capped at a quarter of
+     *                        available memory; 0 disables it.
+     */
+    public void setWarmRestart(boolean enabled, int prewarmBudgetMb) {
+        if (!nativeLoaded) {
+            return;
+        }
+        nativeSetWarmRestart(node, enabled, prewarmBudgetMb);
+    }
+
+    /**
+     * Size the node to the device's storage. Every start picks a prune target that fits the
+     * block files into the space that is free then, less a reserve, and passes it as
+     * {@code -prune}; the daemon cannot change it while running. While the throttle is on, the
+     * supervisor also watches the datadir's device and pauses the daemon child whenever its
+     * writes push request latency above the threshold. The throttle has no effect on an
+     * in-process node.
+     *
+     * @param maxPruneMb the user's prune setting, which the chosen target never exceeds; 0 leaves
+     *                   pruning to {@code digibyte.conf}.
+     * @param reserveMb space to keep free for the rest of the device (at least 10% of it is kept
+     *                  either way); -1 for the default.
+     * @param latencyThresholdMs average time per request that counts as the device being slow;
+     *                           0 for the default.
+     * @param maxWriteMbPerSec ceiling for the daemon's writes, 0 for none. It is the only limit
+     *                         where the device's latency cannot be read.
+     */
+    public void setStoragePolicy(int maxPruneMb, int reserveMb, boolean throttle, int latencyThresholdMs,
+            int maxWriteMbPerSec) {
+        if (!nativeLoaded) {
+            return;
+        }
+        nativeSetStoragePolicy(node, maxPruneMb, reserveMb, throttle, latencyThresholdMs, maxWriteMbPerSec);
+    }
+
+    /**
+     * Free space, the prune target in effect and the state of the write throttle.
+     *
+     * @return the current snapshot, or {@code null} if the native library is unavailable.
+     */
+    public StorageStatus getStorageStatus() {
+        if (!nativeLoaded) {
+            return null;
+        }
+        long[] packed = new long[StorageStatus.FIELD_COUNT];
+        if (!nativeGetStorageStatus(node, packed)) {
+            return null;
+        }
+        return new StorageStatus(packed);
+    }
+
+    /**
+     * Have the next start import blocks from {@code path} ({@code -loadblock}), typically the
+     * pipe of a {@link BlockBundleFeeder}. Applies to that one start; {@code null} clears it.
+     */
+    public void setBlockImport(String path) {
+        if (!nativeLoaded) {
+            return;
+        }
+        nativeSetBlockImport(node, path);
+    }
+
+    /**
+     * Configure how the daemon child is scheduled. The policy is applied in the child before
+     * {@code exec}, so every daemon thread inherits it, and to all threads of a running child
+     * right away. It has no effect on an in-process node, which shares the app's threads.
+     *
+     * @param cores one of {@code CORES_*}; little and big cores are told apart by max frequency.
+     * @param nice nice value, -20..19. Values below the app's own usually need privileges.
+     * @param batch run under {@code SCHED_BATCH} so the daemon never preempts UI wakeups.
+     * @param ioClass one of {@code IO_CLASS_*}.
+     * @param ioLevel 0 (highest) to 7 within the best-effort class.
+     * @param dutyPercent share of every {@code dutyPeriodMs} the daemon may run; below 100 the
+     *                    supervisor pauses it with SIGSTOP/SIGCONT for the rest of the period.
+     * @return {@code false} if a running child could not be fully rescheduled.
+     */
+    public boolean setSchedulingPolicy(int cores, int nice, boolean batch, int ioClass, int ioLevel,
+            int dutyPercent, int dutyPeriodMs) {
+        if (!nativeLoaded) {
+            return false;
+        }
+        return nativeSetSchedulingPolicy(node, cores, nice, batch, ioClass, ioLevel, dutyPercent, dutyPeriodMs);
+    }
+
+    /**
+     * Whether the current node runs inside the app process via {@code libdigibyted.so} rather
+     * than as a {@code digibyted} child process. In-process nodes answer {@link #rpcCall} and
+     * {@link #rpcBatch} without going through the RPC socket.
+     */
+    public boolean isEmbedded() {
+        if (!nativeLoaded) {
+            return false;
+        }
+        return nativeIsEmbedded(node);
     }
 
     /**
      * Return a coarse-grained lifecycle status for the node.
      *
-     * @return one of "NOT_RUNNING", "RUNNING", "BINARY_MISSING", or "ERROR".
+     * @return one of "NOT_RUNNING", "RUNNING", "RESTARTING", "BINARY_MISSING", or "ERROR".
      */
     public String getStatus() {
         if (!nativeLoaded) {
             return "JNI missing";
         }
-        return nativeGetStatus();
+        return nativeGetStatus(node);
+    }
+
+    /**
+     * Sample the node child process: lifecycle phase, RSS, CPU time, storage I/O, open file
+     * descriptors and thread count from {@code /proc/<pid>}, plus the exit code or signal once
+     * the child has died.
+     *
+     * @return the current snapshot, or {@code null} if the native library is unavailable.
+     */
+    public NodeProcessStatus getProcessStatus() {
+        if (!nativeLoaded) {
+            return null;
+        }
+        long[] packed = new long[NodeProcessStatus.FIELD_COUNT];
+        if (!nativeGetProcessStatus(node, packed)) {
+            return null;
+        }
+        return new NodeProcessStatus(packed);
+    }
+
+    /**
+     * Sample memory, cores, thermal zones and power supplies and derive node limits from them.
+     * The framework's view of the battery and thermal state is passed in because sysfs is often
+     * hidden from apps; pass {@code -1} for anything unknown.
+     *
+     * @param batteryPercent battery level, or -1.
+     * @param charging 1 on external power, 0 on battery, or -1.
+     * @param thermalStatus a {@code PowerManager.THERMAL_STATUS_*} value, or -1.
+     * @param unmetered 1 on Wi-Fi or Ethernet, 0 on a metered network, or -1.
+     * @return the derived tuning, or {@code null} if the native library is unavailable.
+     */
+    public ResourceTuning sampleResourceTuning(int batteryPercent, int charging, int thermalStatus, int unmetered) {
+        if (!nativeLoaded) {
+            return null;
+        }
+        long[] packed = new long[ResourceTuning.FIELD_COUNT];
+        if (!nativeSampleResourceTuning(batteryPercent, charging, thermalStatus, unmetered, packed)) {
+            return null;
+        }
+        return new ResourceTuning(packed);
+    }
+
+    /**
+     * Point the in-process JSON-RPC client at the node's RPC endpoint. The client keeps one
+     * keep-alive connection open so status polls do not fork {@code digibyte-cli}.
+     *
+     * @param host     RPC host, normally {@code 127.0.0.1}.
+     * @param port     RPC port configured in digibyte.conf.
+     * @param user     rpcuser from digibyte.conf.
+     * @param password rpcpassword from digibyte.conf.
+     */
+    public void configureRpc(String host, int port, String user, String password) {
+        ensureNativeLoaded();
+        nativeConfigureRpc(node, host, port, user, password);
+    }
+
+    /**
+     * Issue a single JSON-RPC call over the persistent connection.
+     *
+     * @param method     RPC method name, e.g. {@code getblockchaininfo}.
+     * @param paramsJson JSON array of positional parameters, e.g. {@code "[]"}.
+     * @return the raw JSON-RPC reply object, or {@code null} if the node was unreachable.
+     */
+    public String rpcCall(String method, String paramsJson) {
+        if (!nativeLoaded) {
+            return null;
+        }
+        return nativeRpcCall(node, method, paramsJson);
+    }
+
+    /**
+     * Issue several JSON-RPC calls in a single batch round trip.
+     *
+     * @param methods    RPC method names.
+     * @param paramsJson JSON parameter arrays matching {@code methods}; entries may be null.
+     * @return the raw JSON reply array (reply {@code id} equals the request index), or
+     *         {@code null} if the node was unreachable.
+     */
+    public String rpcBatch(String[] methods, String[] paramsJson) {
+        if (!nativeLoaded) {
+            return null;
+        }
+        return nativeRpcBatch(node, methods, paramsJson);
+    }
+
+    /**
+     * Poll chain, peer, mempool and traffic figures in one batched RPC round trip. The reply is
+     * read natively, and block and byte rates and the time to catch up are derived from the
+     * previous poll, so nothing is parsed or allocated on the Java side. The arrays are only
+     * written when something the app shows has changed since the last {@code CHANGED} result,
+     * and then decode into a {@link SyncMetrics}.
+     *
+     * @param values at least {@link SyncMetrics#VALUE_COUNT} entries.
+     * @param rates  at least {@link SyncMetrics#RATE_COUNT} entries.
+     * @param error  receives digibyte-cli style error text in {@code error[0]} for
+     *               {@code SYNC_METRICS_RPC_ERROR}, e.g. while the node is warming up.
+     * @return one of the {@code SYNC_METRICS_*} results.
+     */
+    public int pollSyncMetrics(long[] values, double[] rates, String[] error) {
+        if (!nativeLoaded) {
+            return SYNC_METRICS_UNREACHABLE;
+        }
+        return nativePollSyncMetrics(node, values, rates, error);
+    }
+
+    /**
+     * Run a console command over a dedicated RPC connection, streaming its result to
+     * {@code sink} while the reply is still arriving. Output is formatted like digibyte-cli
+     * (objects indented, string results unquoted) and delivered in pieces of about 16 KiB. Blocks
+     * until the command finishes, is cancelled or reaches {@code maxOutputBytes}, after which the
+     * rest of the reply is dropped.
+     *
+     * @param method         RPC method name.
+     * @param paramsJson     JSON array of positional parameters.
+     * @param maxOutputBytes output limit; {@code 0} for the native default of 1 MiB.
+     * @param sink           receives output and error text.
+     * @return one of the {@code CONSOLE_*} exit codes.
+     */
+    public int consoleExecute(String method, String paramsJson, int maxOutputBytes, ConsoleSink sink) {
+        if (!nativeLoaded) {
+            sink.onError("Native library digimobile_jni is missing");
+            return CONSOLE_UNREACHABLE;
+        }
+        return nativeConsoleExecute(node, method, paramsJson, maxOutputBytes, sink);
+    }
+
+    /** Cancel the {@link #consoleExecute} in progress on another thread. */
+    public void consoleCancel() {
+        if (nativeLoaded) {
+            nativeConsoleCancel(node);
+        }
+    }
+
+    /**
+     * Start following the node's debug.log on a native thread. UpdateTip lines are turned into
+     * compact sync events that {@link #pollSyncEvents} drains, replacing periodic polling; peer
+     * and error lines become records for {@link #pollLogRecords}, and the last lines are kept
+     * for {@link #recentLogLines}.
+     *
+     * @param debugLogPath absolute path of the node's debug.log (it may not exist yet).
+     * @return {@code true} if the follower is running.
+     */
+    public boolean startSyncEvents(String debugLogPath) {
+        if (!nativeLoaded) {
+            return false;
+        }
+        return nativeStartSyncEvents(node, debugLogPath);
+    }
+
+    /** Stop the debug.log follower started by {@link #startSyncEvents}. */
+    public void stopSyncEvents() {
+        if (nativeLoaded) {
+            nativeStopSyncEvents(node);
+        }
+    }
+
+    /**
+     * Drain queued sync events, oldest first, blocking up to {@code timeoutMs} for the first one.
+     * The three arrays are filled in parallel and must be at least as long as {@code heights}.
+     *
+     * @return the number of events written.
+     */
+    public int pollSyncEvents(long[] heights, double[] progress, long[] blockTimes, int timeoutMs) {
+        if (!nativeLoaded) {
+            return 0;
+        }
+        return nativePollSyncEvents(node, heights, progress, blockTimes, timeoutMs);
+    }
+
+    /**
+     * Drain queued peer and error records, oldest first, blocking up to {@code timeoutMs} for the
+     * first one. All arrays must be at least as long as {@code kinds}.
+     *
+     * @return the number of records written, each a {@code LOG_RECORD_*} kind, the peer id (or
+     *         -1), the wall-clock time it was read and the line without its timestamp.
+     */
+    public int pollLogRecords(int[] kinds, long[] peerIds, long[] times, String[] messages, int timeoutMs) {
+        if (!nativeLoaded) {
+            return 0;
+        }
+        return nativePollLogRecords(node, kinds, peerIds, times, messages, timeoutMs);
+    }
+
+    /**
+     * The last {@code maxLines} lines of {@code debugLogPath}, oldest first, from the follower's
+     * memory rather than the file.
+     *
+     * @return {@code null} if the follower is not running on that file.
+     */
+    public String[] recentLogLines(String debugLogPath, int maxLines) {
+        if (!nativeLoaded) {
+            return null;
+        }
+        return nativeRecentLogLines(node, debugLogPath, maxLines);
+    }
+
+    /**
+     * Extract a {@code .tar.gz} into {@code destDir} natively. Reading, inflating and writing run
+     * on separate threads and every file is fsync'd before this returns. Blocks the calling
+     * thread, which also receives the progress callbacks.
+     *
+     * @param stripComponents leading path components dropped from each entry.
+     * @param expectedSha256  if non-null, the archive's SHA-256 (hex). It is computed while the
+     *                        archive is read, and a mismatch fails the extraction.
+     * @return {@code null} on success, otherwise the reason extraction failed; {@code destDir}
+     *         may then hold a partial tree.
+     */
+    public String extractTarGz(String archivePath, String destDir, int stripComponents,
+            String expectedSha256, ExtractProgressListener listener) {
+        if (!nativeLoaded) {
+            return "native library unavailable";
+        }
+        return nativeExtractTarGz(archivePath, destDir, stripComponents, expectedSha256, listener);
+    }
+
+    /**
+     * Create or resize {@code path} to {@code length} bytes with the blocks allocated up front
+     * ({@code posix_fallocate}), so a download can write chunks at any offset.
+     *
+     * @return {@code false} if the space could not be reserved.
+     */
+    public boolean preallocateFile(String path, long length) {
+        if (!nativeLoaded) {
+            return false;
+        }
+        return nativePreallocateFile(path, length);
+    }
+
+    /**
+     * Start or stop recording native trace spans: asset staging, fork/exec, RPC round trips,
+     * extraction blocks and child exits. While off, recording costs one atomic load per span.
+     *
+     * @param clear drop the events recorded so far.
+     */
+    public void setTracingEnabled(boolean enabled, boolean clear) {
+        if (nativeLoaded) {
+            nativeSetTracingEnabled(enabled, clear);
+        }
+    }
+
+    /**
+     * Write the recorded spans to {@code path} in Chrome trace JSON, which Perfetto
+     * (ui.perfetto.dev) and chrome://tracing open directly. Each thread keeps its most recent
+     * 1024 events.
+     *
+     * @return {@code false} if the native library is unavailable or the file could not be written.
+     */
+    public boolean dumpTrace(String path) {
+        if (!nativeLoaded) {
+            return false;
+        }
+        return nativeDumpTrace(path);
+    }
+
+    /**
+     * Version stamp for the staged binaries. While it matches the stamp stored next to
+     * a staged file the asset is not even read; when it changes the asset is hashed and
+     * only rewritten if its content differs.
+     */
+    @SuppressWarnings("deprecation")
+    private static String assetStamp(Context context) {
+        try {
+            PackageInfo info = context.getPackageManager().getPackageInfo(context.getPackageName(), 0);
+            long versionCode = Build.VERSION.SDK_INT >= Build.VERSION_CODES.P
+                    ? info.getLongVersionCode()
+                    : info.versionCode;
+            return versionCode + ":" + info.lastUpdateTime;
+        } catch (PackageManager.NameNotFoundException e) {
+            // An empty stamp never matches, so staging falls back to a content hash.
+            return "";
+        }
     }
 
     private void ensureNativeLoaded() {
         if (!nativeLoaded) {
             throw new IllegalStateException("Native library digimobile_jni is not available");
         }
+        if (node == 0) {
+            throw new IllegalStateException("Node controller has been released");
+        }
     }
 
-    private native void nativeStartNode(AssetManager assetManager, String configPath, String dataDir, String filesDir);
-    private native void nativeStopNode();
-    private native String nativeGetStatus();
+    private static native long nativeDefaultNode();
+    private static native long nativeCreateNode();
+    private static native void nativeReleaseNode(long node, int timeoutMs);
+    private native void nativeStartNode(long node, AssetManager assetManager, String configPath, String dataDir,
+            String filesDir, String assetStamp);
+    private native void nativeStopNode(long node, int timeoutMs);
+    private native void nativeSetRestartPolicy(long node, boolean enabled, int maxRestarts, int initialBackoffMs,
+            int maxBackoffMs);
+    private native void nativeSetWarmRestart(long node, boolean enabled, int prewarmBudgetMb);
+    private native void nativeSetStoragePolicy(long node, int maxPruneMb, int reserveMb, boolean throttle,
+            int latencyThresholdMs, int maxWriteMbPerSec);
+    private native boolean nativeGetStorageStatus(long node, long[] out);
+    private native void nativeSetBlockImport(long node, String path);
+    private native boolean nativeSetSchedulingPolicy(long node, int cores, int nice, boolean batch, int ioClass,
+            int ioLevel, int dutyPercent, int dutyPeriodMs);
+    private native String nativeGetStatus(long node);
+    private native boolean nativeIsEmbedded(long node);
+    private native boolean nativeGetProcessStatus(long node, long[] out);
+    private native boolean nativeSampleResourceTuning(int batteryPercent, int charging, int thermalStatus,
+            int unmetered, long[] out);
+    private native void nativeConfigureRpc(long node, String host, int port, String user, String password);
+    private native String nativeRpcCall(long node, String method, String paramsJson);
+    private native String nativeRpcBatch(long node, String[] methods, String[] paramsJson);
+    private native int nativePollSyncMetrics(long node, long[] values, double[] rates, String[] error);
+    private native int nativeConsoleExecute(long node, String method, String paramsJson, int maxOutputBytes,
+                                            ConsoleSink sink);
+    private native void nativeConsoleCancel(long node);
+    private native boolean nativeStartSyncEvents(long node, String debugLogPath);
+    private native void nativeStopSyncEvents(long node);
+    private native int nativePollLogRecords(long node, int[] kinds, long[] peerIds, long[] times, String[] messages,
+            int timeoutMs);
+    private native String[] nativeRecentLogLines(long node, String debugLogPath, int maxLines);
+    private native int nativePollSyncEvents(long node, long[] heights, double[] progress, long[] blockTimes,
+            int timeoutMs);
+    private native String nativeExtractTarGz(String archivePath, String destDir, int stripComponents,
+            String expectedSha256, ExtractProgressListener listener);
+    private native boolean nativePreallocateFile(String path, long length);
+    private native void nativeSetTracingEnabled(boolean enabled, boolean clear);
+    private native boolean nativeDumpTrace(String path);
 }
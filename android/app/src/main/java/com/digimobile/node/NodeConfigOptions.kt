@@ -9,6 +9,7 @@ data class NodeConfigOptions(
     val telemetryConsent: Boolean = false,
     val wifiOnlyPreference: Boolean = true,
     val useSnapshot: Boolean = true,
+    val network: NodeNetwork = NodeNetwork.MAIN,
 )
 
 enum class NodeSetupPreset {
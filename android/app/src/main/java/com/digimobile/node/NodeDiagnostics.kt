@@ -1,6 +1,7 @@
 package com.digimobile.node
 
 import java.io.File
+import java.io.RandomAccessFile
 
 enum class DebugLogStatus { Disabled, Missing, Present }
 
@@ -11,6 +12,20 @@ data class DebugLogInsight(
 
 object NodeDiagnostics {
 
+    // Logging settings parsed from digibyte.conf, reused while the file is unchanged.
+    private data class LogSettings(
+        val configPath: String,
+        val lastModified: Long,
+        val length: Long,
+        val nodeBugLog: String?,
+        val debugLogFile: String?,
+    )
+
+    @Volatile
+    private var cachedLogSettings: LogSettings? = null
+
+    private val controller by lazy { DigiMobileNodeController() }
+
     fun hasConfig(): Boolean {
         val paths = NodeEnvironment.paths ?: return false
         return paths.configFile.exists()
@@ -21,10 +36,9 @@ object NodeDiagnostics {
     fun getDebugLogFile(datadir: File): File = debugLogConfig(datadir).file ?: File(datadir, "debug.log")
 
     fun debugLogConfig(datadir: File): DebugLogInsight {
-        val configFile = File(datadir, "digibyte.conf")
-        val contents = runCatching { configFile.readText() }.getOrNull()
-        val nodeBugLogValue = parseConfigValue(contents, "nodebuglogfile")?.lowercase()
-        val debugLogValue = parseConfigValue(contents, "debuglogfile")
+        val settings = logSettings(File(datadir, "digibyte.conf"))
+        val nodeBugLogValue = settings.nodeBugLog?.lowercase()
+        val debugLogValue = settings.debugLogFile
 
         val loggingDisabled = nodeBugLogValue == "1" || nodeBugLogValue == "true"
         if (loggingDisabled) {
@@ -48,20 +62,59 @@ object NodeDiagnostics {
         val debugLog = insight.file ?: return emptyList()
         if (insight.status == DebugLogStatus.Disabled) return emptyList()
 
+        // While the node runs, the native follower already holds the newest lines.
+        runCatching { controller.recentLogLines(debugLog.absolutePath, maxLines) }.getOrNull()?.let {
+            return it.toList()
+        }
+
         return runCatching {
             if (!debugLog.exists() || !debugLog.canRead()) return emptyList()
+            readLastLines(debugLog, maxLines)
+        }.getOrElse { emptyList() }
+    }
 
-            debugLog.bufferedReader().useLines { lines ->
-                val buffer = ArrayDeque<String>()
-                lines.forEach { line ->
-                    if (buffer.size == maxLines) {
-                        buffer.removeFirst()
-                    }
-                    buffer.addLast(line)
+    // Read backwards from the end in growing windows until maxLines lines are found, so a
+    // large debug.log costs a few KiB instead of a full scan.
+    private fun readLastLines(file: File, maxLines: Int): List<String> {
+        RandomAccessFile(file, "r").use { raf ->
+            val length = raf.length()
+            var window = (maxLines.toLong() * TAIL_BYTES_PER_LINE).coerceAtLeast(TAIL_MIN_WINDOW)
+            while (true) {
+                val start = (length - window).coerceAtLeast(0L)
+                val bytes = ByteArray((length - start).toInt())
+                raf.seek(start)
+                raf.readFully(bytes)
+                var lines = String(bytes, Charsets.UTF_8).split('\n')
+                if (start > 0) lines = lines.drop(1)  // partial first line
+                if (lines.lastOrNull()?.isEmpty() == true) lines = lines.dropLast(1)
+                if (lines.size >= maxLines || start == 0L || window >= TAIL_MAX_WINDOW) {
+                    return lines.takeLast(maxLines)
                 }
-                buffer.toList()
+                window *= 4
             }
-        }.getOrElse { emptyList() }
+        }
+    }
+
+    private fun logSettings(configFile: File): LogSettings {
+        val lastModified = configFile.lastModified()
+        val length = configFile.length()
+        cachedLogSettings?.let { cached ->
+            if (cached.configPath == configFile.path && cached.lastModified == lastModified &&
+                cached.length == length
+            ) {
+                return cached
+            }
+        }
+        val contents = runCatching { configFile.readText() }.getOrNull()
+        val settings = LogSettings(
+            configPath = configFile.path,
+            lastModified = lastModified,
+            length = length,
+            nodeBugLog = parseConfigValue(contents, "nodebuglogfile"),
+            debugLogFile = parseConfigValue(contents, "debuglogfile"),
+        )
+        cachedLogSettings = settings
+        return settings
     }
 
     fun tailDebugLog(maxLines: Int = 100): List<String> {
@@ -69,6 +122,10 @@ object NodeDiagnostics {
         return tailDebugLog(paths.dataDir, maxLines)
     }
 
+    private const val TAIL_BYTES_PER_LINE = 256L
+    private const val TAIL_MIN_WINDOW = 16L * 1024
+    private const val TAIL_MAX_WINDOW = 4L * 1024 * 1024
+
     private fun parseConfigValue(contents: String?, key: String): String? {
         val normalized = contents ?: return null
         return normalized.lineSequence()
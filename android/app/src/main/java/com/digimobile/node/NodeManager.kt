@@ -1,6 +1,7 @@
 package com.digimobile.node
 
 import android.content.Context
+import com.digimobile.app.BlockBundleImporter
 import com.digimobile.app.NodeBootstrapper
 import com.digimobile.app.ChainstateBootstrapper
 import com.digimobile.app.NodeConfigStore
@@ -8,16 +9,19 @@ import java.io.File
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.Job
+import kotlinx.coroutines.cancelAndJoin
 import kotlinx.coroutines.delay
 import kotlinx.coroutines.flow.MutableSharedFlow
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.SharedFlow
 import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asSharedFlow
+import kotlinx.coroutines.isActive
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
 import kotlinx.coroutines.sync.Mutex
 import kotlinx.coroutines.sync.withLock
+import org.json.JSONArray
 import org.json.JSONObject
 
 class NodeManager(
@@ -29,6 +33,12 @@ class NodeManager(
 
     private val configStore = NodeConfigStore(context)
     private val chainstateBootstrapper = ChainstateBootstrapper(context)
+    private val resourceGovernor = ResourceGovernor(context, controller)
+    private val blockBundleImporter = BlockBundleImporter(context)
+
+    // A block bundle waiting for the node to start, then the job feeding it.
+    private var blockImport: BlockBundleImporter.Prepared? = null
+    private var blockImportJob: Job? = null
 
     private val _nodeState = MutableStateFlow<NodeState>(NodeState.Idle)
     val nodeState: StateFlow<NodeState> get() = _nodeState
@@ -41,6 +51,31 @@ class NodeManager(
     private var lastSyncProgress: SyncProgress = SyncProgress(fraction = 0f, isInitialDownload = true)
     private var lastSyncSample: SyncSample? = null
 
+    private val _syncMetrics = MutableStateFlow<SyncMetrics?>(null)
+    /** Chain, peer, mempool and traffic figures from the latest poll that changed any of them. */
+    val syncMetrics: StateFlow<SyncMetrics?> get() = _syncMetrics
+
+    // Reused by every poll; the native side only writes them when something changed.
+    private val syncMetricValues = LongArray(SyncMetrics.VALUE_COUNT)
+    private val syncMetricRates = DoubleArray(SyncMetrics.RATE_COUNT)
+    private val syncMetricsError = arrayOfNulls<String>(1)
+
+    private var rpcCredentialsInUse: RpcCredentials? = null
+    private var syncEventsActive: Boolean = false
+
+    // Limits the running daemon was started with, and a profile change waiting to be confirmed.
+    private var appliedTuning: ResourceTuning? = null
+    private var tuningAppliedAtMs: Long = 0L
+    private var lastGovernorSampleMs: Long = 0L
+    private var pendingProfile: Int = -1
+    private var pendingProfileSamples: Int = 0
+    private var scheduledProfile: Int = -1
+
+    private val logRecordKinds = IntArray(LOG_RECORD_BATCH)
+    private val logRecordPeers = LongArray(LOG_RECORD_BATCH)
+    private val logRecordTimes = LongArray(LOG_RECORD_BATCH)
+    private val logRecordMessages = arrayOfNulls<String>(LOG_RECORD_BATCH)
+
     private var cliWarningLogged: Boolean = false
     private var cliSyncErrorLogged: Boolean = false
 
@@ -78,6 +113,11 @@ class NodeManager(
 
         if (!canStart) return@launch
 
+        if (File(context.filesDir, TRACE_MARKER).exists()) {
+            controller.setTracingEnabled(true, true)
+            appendLog("Native tracing enabled by files/$TRACE_MARKER; dump it with `trace dump`.")
+        }
+
         try {
             val binariesReady = bootstrapper.downloadOrUpdateBinaries { appendLog(it) }
             if (!binariesReady) {
@@ -85,10 +125,40 @@ class NodeManager(
                 return@launch
             }
 
-            val paths = bootstrapper.ensureBootstrap()
+            val tuning = resourceGovernor.sample()
+            val paths = bootstrapper.ensureBootstrap(tuning)
             lastNodePaths = paths
+            recordAppliedTuning(tuning)
+            tuning?.let { appendLog("Resource profile $it") }
+            applySchedulingPolicy(tuning?.profile ?: ResourceTuning.PROFILE_BALANCED)
 
-            if (configStore.shouldUseSnapshot()) {
+            var containerApplied = false
+            if (configStore.shouldUseSnapshot() && chainstateBootstrapper.hasSnapshotContainer()) {
+                updateState(
+                    NodeState.ApplyingSnapshot(phase = SnapshotPhase.Extract, progress = 0),
+                    "Downloading and applying snapshot..."
+                )
+                containerApplied = chainstateBootstrapper.applySnapshotContainer(
+                    datadir = paths.dataDir,
+                    onProgress = { percent ->
+                        updateState(
+                            NodeState.ApplyingSnapshot(
+                                phase = SnapshotPhase.Extract,
+                                progress = percent
+                            ),
+                            "Applying snapshot ($percent%)"
+                        )
+                    },
+                    onLog = { message -> appendLog(message) }
+                )
+                if (containerApplied) {
+                    appendLog("Snapshot applied successfully at height ${ChainstateBootstrapper.SNAPSHOT_HEIGHT}.")
+                } else {
+                    appendLog("Snapshot container failed, trying the tar.gz snapshot.")
+                }
+            }
+
+            if (configStore.shouldUseSnapshot() && !containerApplied) {
                 updateState(
                     NodeState.ApplyingSnapshot(phase = SnapshotPhase.Download, progress = null),
                     "Downloading snapshot..."
@@ -148,6 +218,28 @@ class NodeManager(
             updateState(NodeState.StartingDaemon, "Starting DigiByte daemon…")
 
             try {
+                // The native supervisor respawns digibyted after a crash; a clean exit
+                // (RPC stop, shutdown request) is never restarted.
+                controller.setRestartPolicy(
+                    true,
+                    CRASH_RESTART_MAX_ATTEMPTS,
+                    CRASH_RESTART_INITIAL_BACKOFF_MS,
+                    CRASH_RESTART_MAX_BACKOFF_MS
+                )
+                // After a clean shutdown (config change, app update, profile switch) skip most of
+                // the start-up block verification; every start pre-reads the chainstate.
+                controller.setWarmRestart(true, PREWARM_BUDGET_MB)
+                // The configured prune size is an upper bound: on a fuller device the daemon is
+                // started with a smaller target, and its writes are throttled while they slow
+                // the device down.
+                controller.setStoragePolicy(
+                    configStore.load().pruneTargetMb,
+                    STORAGE_RESERVE_MB,
+                    true,
+                    IO_LATENCY_THRESHOLD_MS,
+                    0
+                )
+                prepareBlockImport(paths)
                 // -conf and -datadir are forwarded to digibyted via nativeStartNode.
                 controller.startNode(
                     context.applicationContext,
@@ -168,6 +260,10 @@ class NodeManager(
                 _nodeState.value = NodeState.Error(message)
                 return@launch
             }
+            if (controller.isEmbedded()) {
+                appendLog("DigiByte Core is running in-process (libdigibyted.so).")
+            }
+            startBlockImport()
 
             if (configStore.shouldUseSnapshot()) {
                 val ok = verifySnapshotHeader(
@@ -182,6 +278,7 @@ class NodeManager(
             }
 
             updateState(NodeState.ConnectingToPeers, "Connecting to peers…")
+            startSyncEvents(paths)
             monitorSyncState()
         } catch (e: Exception) {
             val message = e.message ?: "Unknown error starting node"
@@ -192,6 +289,7 @@ class NodeManager(
 
     suspend fun stopNode() = withContext(Dispatchers.IO) {
         try {
+            stopBlockImport()
             val cliAvailable = evaluateCliAvailability()
             if (cliAvailable) {
                 stopWithCli()
@@ -208,7 +306,7 @@ class NodeManager(
 
     private suspend fun stopWithCli() {
         appendLog("Stopping DigiByte daemon…")
-        val result = runCliCommand(listOf("stop"))
+        val result = runNodeCommand(listOf("stop"))
         if (result.exitCode != 0) {
             appendLog("digibyte-cli stop failed with exit ${result.exitCode}: ${result.stderr.ifEmpty { result.stdout }}")
             stopWithController()
@@ -223,7 +321,7 @@ class NodeManager(
     }
 
     private suspend fun stopWithController() {
-        runCatching { controller.stopNode() }
+        runCatching { controller.stopNode(STOP_TIMEOUT_MS.toInt()) }
             .onFailure { error ->
                 val message = error.message ?: "Failed to stop node via controller"
                 appendLog("Error: $message")
@@ -237,20 +335,35 @@ class NodeManager(
     private suspend fun waitForShutdown() {
         val deadline = System.currentTimeMillis() + STOP_TIMEOUT_MS
         while (System.currentTimeMillis() < deadline) {
-            val status = runCatching { controller.getStatus() }.getOrNull()
-            val isRunning = status?.equals("RUNNING", ignoreCase = true) == true
-            if (!isRunning) {
+            if (!isNodeAlive()) {
+                stopSyncEvents()
                 updateState(NodeState.Idle, "Node stopped")
                 return
             }
             delay(STOP_POLL_DELAY_MS)
         }
 
+        // The RPC stop was accepted but the daemon is still up: let the native supervisor
+        // send SIGTERM and, if that is ignored too, SIGKILL.
+        appendLog("Node did not stop within ${STOP_TIMEOUT_MS / 1000} seconds; terminating the process.")
+        runCatching { controller.stopNode(STOP_ESCALATION_TIMEOUT_MS) }
+        if (!isNodeAlive()) {
+            stopSyncEvents()
+            updateState(NodeState.Idle, "Node stopped")
+            return
+        }
+
         val message = "Node did not stop within ${STOP_TIMEOUT_MS / 1000} seconds"
         appendLog("Error: $message")
         _nodeState.value = NodeState.Error("Failed to stop node")
     }
 
+    private fun isNodeAlive(): Boolean {
+        val status = runCatching { controller.getStatus() }.getOrNull()
+        return status?.equals("RUNNING", ignoreCase = true) == true ||
+            status?.equals("RESTARTING", ignoreCase = true) == true
+    }
+
     private suspend fun monitorSyncState() {
         val paths = lastNodePaths
         if (paths == null) {
@@ -270,16 +383,37 @@ class NodeManager(
                         updateState(NodeState.Error(message), message)
                         return
                     }
+                    status.equals("RESTARTING", ignoreCase = true) -> {
+                        val exitReason = runCatching { controller.getProcessStatus()?.describeExit() }.getOrNull()
+                        val reasonText = exitReason?.let { " (digibyted $it)" } ?: ""
+                        val message = "DigiByte node crashed$reasonText; restarting…"
+                        updateState(NodeState.StartingUp(message), message)
+                        warmupAttempts = 0
+                        delay(WARMUP_RETRY_DELAY_MS)
+                        continue
+                    }
                     status.equals("NOT_RUNNING", ignoreCase = true) -> {
-                        val message = "DigiByte node stopped unexpectedly. It may not be supported on this device/emulator."
+                        val exitReason = runCatching { controller.getProcessStatus()?.describeExit() }.getOrNull()
+                        val reasonText = exitReason?.let { " (digibyted $it)" } ?: ""
+                        val message = "DigiByte node stopped unexpectedly$reasonText. It may not be supported on this device/emulator."
                         updateState(NodeState.Error(message), message)
                         return
                     }
                 }
             }
 
+            when (retuneIfProfileChanged(paths)) {
+                Retune.None -> Unit
+                Retune.Restarted -> {
+                    warmupAttempts = 0
+                    continue
+                }
+                Retune.Failed -> return
+            }
+
             cliAvailable = evaluateCliAvailability()
-            if (!cliAvailable) {
+            val rpcReady = ensureRpcClient()
+            if (!cliAvailable && !rpcReady) {
                 warmupAttempts = 0
                 val message = "Node is running; waiting for sync details (digibyte-cli not available in this build)."
                 updateState(NodeState.StartingUp(message), message)
@@ -287,7 +421,20 @@ class NodeManager(
                 continue
             }
 
-            val blockchainResult = queryBlockchainInfo(paths)
+            // One batched round trip over the native keep-alive connection, read natively. Unless
+            // something changed nothing crosses JNI and there is nothing to update; each query
+            // falls back to its own call if the batch could not be issued.
+            val poll = if (rpcReady) pollSyncMetrics() else null
+            if (poll is MetricsPoll.Unchanged) {
+                awaitNextSyncPoll()
+                continue
+            }
+            val metrics = (poll as? MetricsPoll.Changed)?.metrics
+            val blockchainResult = when (poll) {
+                is MetricsPoll.Changed -> QueryOutcome.Success(poll.metrics.toBlockchainInfo())
+                is MetricsPoll.Error -> queryBlockchainInfo(paths, poll.result)
+                else -> queryBlockchainInfo(paths)
+            }
 
             val blockchainInfo = when (blockchainResult) {
                 is QueryOutcome.Success -> blockchainResult.value
@@ -313,7 +460,11 @@ class NodeManager(
             }
             warmupAttempts = 0
 
-            val networkInfo = if (cliAvailable) queryNetworkInfo() else null
+            val networkInfo = when {
+                metrics != null -> NetworkInfo(metrics.peers.takeIf { it >= 0 })
+                cliAvailable || rpcReady -> queryNetworkInfo()
+                else -> null
+            }
             val headerHeight = blockchainInfo?.headers
             val currentHeight = blockchainInfo?.blocks
             val syncProgress = blockchainInfo?.syncProgress(lastSyncProgress) ?: lastSyncProgress
@@ -321,7 +472,9 @@ class NodeManager(
             val peerCount = blockchainInfo?.connections ?: networkInfo?.connections
 
             val now = System.currentTimeMillis()
-            val downloadRate = if (currentHeight != null) {
+            // The native poller derives the rate between its own polls.
+            val nativeRate = metrics?.blocksPerSecond?.takeIf { it >= 0 }
+            val downloadRate = nativeRate ?: if (currentHeight != null) {
                 lastSyncSample?.let { sample ->
                     val heightDelta = currentHeight - sample.height
                     val elapsedSeconds = (now - sample.timestampMs) / 1000.0
@@ -366,12 +519,245 @@ class NodeManager(
                 }
             }
 
-            delay(5_000)
+            awaitNextSyncPoll()
+        }
+    }
+
+    private suspend fun awaitNextSyncPoll() {
+        drainLogRecords()
+        if (syncEventsActive && _nodeState.value is NodeState.Syncing) {
+            // Tip updates stream in from debug.log; RPC is only needed for headers and peers.
+            followSyncEvents(SYNC_EVENT_POLL_INTERVAL_MS)
+        } else {
+            delay(SYNC_POLL_INTERVAL_MS)
+        }
+    }
+
+    /**
+     * Re-sample device conditions and restart digibyted with new limits once a different resource
+     * profile has held for [GOVERNOR_CONFIRM_SAMPLES] samples. digibyted cannot resize its caches
+     * at runtime (SIGHUP only reopens debug.log), so a restart is the only way to apply them.
+     */
+    private suspend fun retuneIfProfileChanged(paths: NodeBootstrapper.NodePaths): Retune {
+        val applied = appliedTuning ?: return Retune.None
+        // In-process Core initializes once per process; a restart would drop to the child daemon.
+        if (controller.isEmbedded()) return Retune.None
+        val now = System.currentTimeMillis()
+        if (now - lastGovernorSampleMs < GOVERNOR_SAMPLE_INTERVAL_MS) return Retune.None
+        lastGovernorSampleMs = now
+
+        val sample = resourceGovernor.sample() ?: return Retune.None
+        // Scheduling can change under a running daemon, so it follows every sample; only the
+        // cache and peer limits wait for a confirmed change and a restart.
+        applySchedulingPolicy(sample.profile)
+        if (sample.profile == applied.profile) {
+            pendingProfileSamples = 0
+            return Retune.None
+        }
+        pendingProfileSamples = if (sample.profile == pendingProfile) pendingProfileSamples + 1 else 1
+        pendingProfile = sample.profile
+        if (pendingProfileSamples < GOVERNOR_CONFIRM_SAMPLES) return Retune.None
+
+        // Throttle as soon as the change is confirmed. Speeding up costs a dbcache flush, so it
+        // only pays off during initial sync and not more often than every few minutes.
+        if (sample.profile > applied.profile &&
+            (_nodeState.value is NodeState.Ready || now - tuningAppliedAtMs < GOVERNOR_MIN_SPEEDUP_INTERVAL_MS)
+        ) {
+            return Retune.None
+        }
+        return if (restartWithTuning(paths, sample)) Retune.Restarted else Retune.Failed
+    }
+
+    private suspend fun restartWithTuning(paths: NodeBootstrapper.NodePaths, tuning: ResourceTuning): Boolean {
+        val message = "Switching to the ${tuning.profileName()} resource profile; restarting DigiByte daemon…"
+        updateState(NodeState.StartingUp(message), message)
+        appendLog("Resource profile $tuning")
+        // An unfinished bundle is offered to the restarted daemon again; blocks it already has
+        // are skipped quickly.
+        stopBlockImport()
+
+        // SIGTERM lets digibyted flush its caches; the supervisor escalates to SIGKILL on timeout
+        // and does not respawn a requested stop.
+        runCatching { controller.stopNode(STOP_TIMEOUT_MS.toInt()) }
+        if (isNodeAlive()) {
+            val failure = "DigiByte daemon did not stop for the resource profile change"
+            updateState(NodeState.Error(failure), failure)
+            return false
+        }
+
+        return try {
+            bootstrapper.ensureBootstrap(tuning)
+            recordAppliedTuning(tuning)
+            prepareBlockImport(paths)
+            controller.startNode(
+                context.applicationContext,
+                paths.configFile.absolutePath,
+                paths.dataDir.absolutePath
+            )
+            val status = waitForRunningStatus()
+            if (!status.equals("RUNNING", ignoreCase = true)) {
+                val failure = "DigiByte node failed to restart (status: ${status ?: "unknown"}). Check logs for details."
+                updateState(NodeState.Error(failure), failure)
+                false
+            } else {
+                startBlockImport()
+                true
+            }
+        } catch (e: Exception) {
+            val failure = "Native startNode failed: ${e.message ?: "Unknown native start error"}"
+            updateState(NodeState.Error(failure), failure)
+            false
+        }
+    }
+
+    /**
+     * Look for a block bundle to import and hand its pipe to the next start; see
+     * [BlockBundleImporter].
+     */
+    private fun prepareBlockImport(paths: NodeBootstrapper.NodePaths) {
+        blockImport?.feeder?.close()
+        blockImport = blockBundleImporter.prepare(paths.dataDir) { appendLog(it) }
+        controller.setBlockImport(blockImport?.pipe?.absolutePath)
+    }
+
+    /** Feed the prepared bundle to the daemon that has just started, in the background. */
+    private fun startBlockImport() {
+        val prepared = blockImport ?: return
+        blockImport = null
+        blockImportJob = scope.launch(Dispatchers.IO) {
+            try {
+                blockBundleImporter.feed(prepared) { appendLog(it) }
+            } finally {
+                prepared.feeder.close()
+            }
         }
     }
 
-    private suspend fun queryBlockchainInfo(paths: NodeBootstrapper.NodePaths): QueryOutcome<BlockchainInfo> {
-        val result = runCliCommand(listOf("getblockchaininfo"))
+    private suspend fun stopBlockImport() {
+        blockImportJob?.cancelAndJoin()
+        blockImportJob = null
+        blockImport?.feeder?.close()
+        blockImport = null
+    }
+
+    /**
+     * Keep the daemon off the UI's toes: SCHED_BATCH throughout, little cores unless charging on
+     * Wi-Fi, and a SIGSTOP/SIGCONT duty cycle with idle I/O priority when hot or low on battery.
+     */
+    private fun applySchedulingPolicy(profile: Int) {
+        if (profile == scheduledProfile) return
+        scheduledProfile = profile
+        val applied = runCatching {
+            when (profile) {
+                ResourceTuning.PROFILE_FULL -> controller.setSchedulingPolicy(
+                    DigiMobileNodeController.CORES_ALL, 5, true,
+                    DigiMobileNodeController.IO_CLASS_BEST_EFFORT, 4, 100, DUTY_PERIOD_MS
+                )
+                ResourceTuning.PROFILE_THROTTLED -> controller.setSchedulingPolicy(
+                    DigiMobileNodeController.CORES_LITTLE, 19, true,
+                    DigiMobileNodeController.IO_CLASS_IDLE, 0, THROTTLED_DUTY_PERCENT, DUTY_PERIOD_MS
+                )
+                else -> controller.setSchedulingPolicy(
+                    DigiMobileNodeController.CORES_LITTLE, 10, true,
+                    DigiMobileNodeController.IO_CLASS_BEST_EFFORT, 6, 100, DUTY_PERIOD_MS
+                )
+            }
+        }.getOrDefault(false)
+        if (!applied && isNodeAlive()) {
+            // Typically raising priority back up, which needs privileges; the next restart applies it.
+            appendLog("Scheduling for the running node was only partly updated.")
+        }
+    }
+
+    private fun recordAppliedTuning(tuning: ResourceTuning?) {
+        appliedTuning = tuning
+        tuningAppliedAtMs = System.currentTimeMillis()
+        lastGovernorSampleMs = tuningAppliedAtMs
+        pendingProfile = -1
+        pendingProfileSamples = 0
+    }
+
+    private fun startSyncEvents(paths: NodeBootstrapper.NodePaths) {
+        val insight = NodeDiagnostics.debugLogConfig(paths.dataDir)
+        val logFile = insight.file
+        syncEventsActive = insight.status != DebugLogStatus.Disabled && logFile != null &&
+            runCatching { controller.startSyncEvents(logFile.absolutePath) }.getOrDefault(false)
+        if (!syncEventsActive) {
+            appendLog("debug.log follower unavailable; polling sync progress every ${SYNC_POLL_INTERVAL_MS / 1000}s.")
+        }
+    }
+
+    private fun stopSyncEvents() {
+        if (syncEventsActive) {
+            runCatching { controller.stopSyncEvents() }
+            syncEventsActive = false
+        }
+    }
+
+    /**
+     * Apply UpdateTip events from the native debug.log follower for up to [windowMs]. Each event
+     * refreshes height and progress immediately without an RPC round trip.
+     */
+    private suspend fun followSyncEvents(windowMs: Long) {
+        val heights = LongArray(SYNC_EVENT_BATCH)
+        val progress = DoubleArray(SYNC_EVENT_BATCH)
+        val blockTimes = LongArray(SYNC_EVENT_BATCH)
+        val deadline = System.currentTimeMillis() + windowMs
+
+        while (true) {
+            val remaining = deadline - System.currentTimeMillis()
+            if (remaining <= 0) return
+            // Short slices keep the coroutine responsive to cancellation.
+            val timeout = remaining.coerceAtMost(SYNC_EVENT_SLICE_MS).toInt()
+            val count = withContext(Dispatchers.IO) {
+                controller.pollSyncEvents(heights, progress, blockTimes, timeout)
+            }
+            drainLogRecords()
+            if (count <= 0) continue
+
+            val current = _nodeState.value as? NodeState.Syncing ?: return
+            val latest = count - 1
+            val height = heights[latest]
+            val now = System.currentTimeMillis()
+            val rate = lastSyncSample?.let { sample ->
+                val elapsedSeconds = (now - sample.timestampMs) / 1000.0
+                if (height >= sample.height && elapsedSeconds > 0) (height - sample.height) / elapsedSeconds else null
+            } ?: current.downloadRate
+            val syncProgress = SyncProgress(progress[latest].coerceIn(0.0, 1.0).toFloat(), isInitialDownload = true)
+            lastSyncProgress = syncProgress
+            // State only: logging every tip would flood the console during IBD.
+            _nodeState.value = current.copy(
+                currentHeight = height,
+                progress = syncProgress,
+                downloadRate = rate
+            )
+        }
+    }
+
+    /**
+     * Forward peer connects/disconnects and ERROR/Warning lines picked out of debug.log by the
+     * native follower to the console log. Never blocks.
+     */
+    private fun drainLogRecords() {
+        if (!syncEventsActive) return
+        val messages = logRecordMessages
+        while (true) {
+            val count = runCatching {
+                controller.pollLogRecords(logRecordKinds, logRecordPeers, logRecordTimes, messages, 0)
+            }.getOrDefault(0)
+            for (i in 0 until count) {
+                appendLog("digibyted: ${messages[i]}")
+                messages[i] = null
+            }
+            if (count < messages.size) return
+        }
+    }
+
+    private suspend fun queryBlockchainInfo(
+        paths: NodeBootstrapper.NodePaths,
+        prefetched: CliResult? = null
+    ): QueryOutcome<BlockchainInfo> {
+        val result = prefetched ?: runNodeCommand(listOf("getblockchaininfo"))
         if (result.exitCode != 0) {
             val warmupMessage = result.toWarmupMessage()
             if (warmupMessage != null) {
@@ -397,8 +783,8 @@ class NodeManager(
         }
     }
 
-    private suspend fun queryNetworkInfo(): NetworkInfo? {
-        val result = runCliCommand(listOf("getnetworkinfo"))
+    private suspend fun queryNetworkInfo(prefetched: CliResult? = null): NetworkInfo? {
+        val result = prefetched ?: runNodeCommand(listOf("getnetworkinfo"))
         if (result.exitCode != 0) {
             val warmupMessage = result.toWarmupMessage()
             if (warmupMessage == null) {
@@ -417,7 +803,150 @@ class NodeManager(
         }
     }
 
-    suspend fun executeCliCommand(args: List<String>): CliResult = runCliCommand(args)
+    suspend fun executeCliCommand(args: List<String>): CliResult {
+        if (args.firstOrNull() == TRACE_COMMAND) {
+            return runTraceCommand(args.drop(1))
+        }
+        return runCliCommand(args)
+    }
+
+    /**
+     * Run a Core console command, handing its output to [onOutput] piece by piece while the reply
+     * is still arriving, so large results (`getrawmempool true`, `getblock <hash> 2`) neither stall
+     * the UI nor sit in memory whole. Uses the native console connection when RPC is configured;
+     * `trace` commands and nodes without RPC credentials go through [executeCliCommand] and
+     * deliver their output in one piece. Output stops at [CONSOLE_OUTPUT_LIMIT_BYTES]. [onOutput]
+     * runs on an I/O thread and returns `false` to cancel; [cancelConsoleCommand] also interrupts
+     * a command that has not answered yet. The returned stdout is always empty.
+     */
+    suspend fun executeConsoleCommand(args: List<String>, onOutput: (String) -> Boolean): CliResult {
+        if (args.isEmpty() || args.first() == TRACE_COMMAND || !ensureRpcClient()) {
+            val result = executeCliCommand(args)
+            if (result.stdout.isNotEmpty()) {
+                onOutput(result.stdout)
+            }
+            return result.copy(stdout = "")
+        }
+        return withContext(Dispatchers.IO) {
+            val stderr = StringBuilder()
+            val deliver = onOutput
+            val sink = object : DigiMobileNodeController.ConsoleSink {
+                override fun onOutput(text: String): Boolean = isActive && deliver(text)
+
+                override fun onError(text: String) {
+                    stderr.append(text)
+                }
+            }
+            val exitCode = controller.consoleExecute(
+                args.first(),
+                RpcParamConversions.toParams(args.first(), args.drop(1)),
+                CONSOLE_OUTPUT_LIMIT_BYTES,
+                sink
+            )
+            CliResult(exitCode, "", stderr.toString())
+        }
+    }
+
+    fun cancelConsoleCommand() {
+        controller.consoleCancel()
+    }
+
+    /**
+     * `trace on|off|dump`, handled here rather than by the node. Tracing can also be switched on
+     * before a start by creating `files/trace-on` (`adb shell run-as <package> touch files/trace-on`).
+     */
+    private suspend fun runTraceCommand(args: List<String>): CliResult = withContext(Dispatchers.IO) {
+        when (args.firstOrNull()) {
+            "on" -> {
+                controller.setTracingEnabled(true, true)
+                CliResult(0, "Native tracing on", "")
+            }
+            "off" -> {
+                controller.setTracingEnabled(false, false)
+                CliResult(0, "Native tracing off; recorded events are kept for `trace dump`", "")
+            }
+            "dump" -> {
+                val dir = File(context.getExternalFilesDir(null) ?: context.filesDir, "traces")
+                val file = File(dir, "digimobile-trace-${System.currentTimeMillis()}.json")
+                if (dir.mkdirs() || dir.isDirectory) {
+                    if (controller.dumpTrace(file.absolutePath)) {
+                        return@withContext CliResult(0, "Trace written to ${file.absolutePath}", "")
+                    }
+                }
+                CliResult(RPC_ERROR_EXIT, "", "Could not write ${file.absolutePath}")
+            }
+            else -> CliResult(RPC_ERROR_EXIT, "", "usage: trace on|off|dump")
+        }
+    }
+
+    /**
+     * Run an RPC through the native keep-alive client when it is configured, falling back to
+     * forking digibyte-cli otherwise. Results are shaped like CLI output so callers and warm-up
+     * detection do not care which transport answered.
+     */
+    private suspend fun runNodeCommand(args: List<String>): CliResult {
+        if (args.isEmpty() || !ensureRpcClient()) {
+            return runCliCommand(args)
+        }
+        return withContext(Dispatchers.IO) {
+            val params = RpcParamConversions.toParams(args.first(), args.drop(1))
+            val reply = runCatching { controller.rpcCall(args.first(), params) }.getOrNull()
+                ?: return@withContext CliResult(RPC_UNREACHABLE_EXIT, "", "couldn't connect to server")
+            runCatching { JSONObject(reply).toCliResult() }.getOrElse { error ->
+                CliResult(RPC_UNREACHABLE_EXIT, "", "Malformed RPC reply: ${error.message}")
+            }
+        }
+    }
+
+    private suspend fun pollSyncMetrics(): MetricsPoll = withContext(Dispatchers.IO) {
+        val error = syncMetricsError
+        error[0] = null
+        val result = runCatching {
+            controller.pollSyncMetrics(syncMetricValues, syncMetricRates, error)
+        }.getOrDefault(DigiMobileNodeController.SYNC_METRICS_UNREACHABLE)
+        when (result) {
+            DigiMobileNodeController.SYNC_METRICS_CHANGED -> {
+                val metrics = SyncMetrics(syncMetricValues, syncMetricRates)
+                _syncMetrics.value = metrics
+                MetricsPoll.Changed(metrics)
+            }
+            DigiMobileNodeController.SYNC_METRICS_UNCHANGED -> MetricsPoll.Unchanged
+            DigiMobileNodeController.SYNC_METRICS_RPC_ERROR ->
+                MetricsPoll.Error(CliResult(RPC_ERROR_EXIT, "", error[0] ?: ""))
+            else -> MetricsPoll.Unreachable
+        }
+    }
+
+    private fun ensureRpcClient(): Boolean {
+        // An in-process node dispatches RPC directly once it is up; the socket client is still
+        // configured when possible because it reports warm-up progress before that.
+        val embedded = runCatching { controller.isEmbedded() }.getOrDefault(false)
+        val credentials = NodeEnvironment.rpcCredentials ?: return embedded
+        if (credentials == rpcCredentialsInUse) return true
+
+        return runCatching {
+            controller.configureRpc(RPC_HOST, credentials.port, credentials.user, credentials.password)
+            rpcCredentialsInUse = credentials
+            true
+        }.getOrElse { embedded }
+    }
+
+    private fun JSONObject.toCliResult(): CliResult {
+        val error = optJSONObject("error")
+        if (error != null) {
+            // Mirror digibyte-cli's error formatting so warm-up detection keeps working.
+            val code = error.optInt("code")
+            val message = error.optString("message")
+            return CliResult(RPC_ERROR_EXIT, "", "error code: $code\nerror message:\n$message")
+        }
+        val stdout = when (val result = opt("result")) {
+            null, JSONObject.NULL -> ""
+            is JSONObject -> result.toString(2)
+            is JSONArray -> result.toString(2)
+            else -> result.toString()
+        }
+        return CliResult(0, stdout, "")
+    }
 
     private suspend fun runCliCommand(args: List<String>): CliResult = withContext(Dispatchers.IO) {
         val paths = NodeEnvironment.paths ?: lastNodePaths
@@ -431,6 +960,7 @@ class NodeManager(
         val command = mutableListOf(
             cliBinary.absolutePath,
             "-datadir=${paths.dataDir.absolutePath}",
+            "-rpcport=${credentials.port}",
             "-rpcuser=${credentials.user}",
             "-rpcpassword=${credentials.password}"
         )
@@ -492,7 +1022,7 @@ class NodeManager(
         height: Long,
         expectedHash: String
     ): Boolean {
-        val result = runCliCommand(listOf("getblockhash", height.toString()))
+        val result = runNodeCommand(listOf("getblockhash", height.toString()))
         if (result.exitCode != 0) {
             appendLog("Snapshot header verification failed: ${result.stderr.ifEmpty { result.stdout }}")
             return false
@@ -565,6 +1095,14 @@ class NodeManager(
         }
     }
 
+    private fun SyncMetrics.toBlockchainInfo() = BlockchainInfo(
+        blocks.takeIf { it >= 0 },
+        headers.takeIf { it >= 0 },
+        verificationProgress.takeIf { it >= 0 },
+        initialBlockDownload.takeIf { it >= 0 }?.let { it == 1 },
+        null,
+    )
+
     private data class NetworkInfo(
         val connections: Int?,
     )
@@ -586,6 +1124,19 @@ class NodeManager(
         data class Failure(val message: String) : QueryOutcome<Nothing>()
     }
 
+    private sealed class MetricsPoll {
+        data class Changed(val metrics: SyncMetrics) : MetricsPoll()
+        object Unchanged : MetricsPoll()
+        data class Error(val result: CliResult) : MetricsPoll()
+        object Unreachable : MetricsPoll()
+    }
+
+    private enum class Retune {
+        None,
+        Restarted,
+        Failed
+    }
+
     private enum class CliAvailability {
         Unknown,
         Available,
@@ -597,11 +1148,34 @@ class NodeManager(
         private const val READY_THRESHOLD_FRACTION = 0.999
         private const val STOP_TIMEOUT_MS = 30_000L
         private const val STOP_POLL_DELAY_MS = 1_000L
+        private const val STOP_ESCALATION_TIMEOUT_MS = 10_000
+        private const val CRASH_RESTART_MAX_ATTEMPTS = 3
+        private const val CRASH_RESTART_INITIAL_BACKOFF_MS = 2_000
+        private const val CRASH_RESTART_MAX_BACKOFF_MS = 30_000
+        private const val PREWARM_BUDGET_MB = 256
+        private const val STORAGE_RESERVE_MB = 1_024
+        private const val IO_LATENCY_THRESHOLD_MS = 40
         private const val START_STATUS_RETRY_DELAY_MS = 1_000L
         private const val START_STATUS_MAX_ATTEMPTS = 30
         private const val WARMUP_RETRY_DELAY_MS = 5_000L
         private const val START_WARMUP_MAX_ATTEMPTS = 12
         private const val CLI_UNAVAILABLE_EXIT = -1
+        private const val SYNC_POLL_INTERVAL_MS = 5_000L
+        private const val GOVERNOR_SAMPLE_INTERVAL_MS = 60_000L
+        private const val GOVERNOR_CONFIRM_SAMPLES = 2
+        private const val GOVERNOR_MIN_SPEEDUP_INTERVAL_MS = 10 * 60_000L
+        private const val THROTTLED_DUTY_PERCENT = 50
+        private const val DUTY_PERIOD_MS = 1_000
+        private const val SYNC_EVENT_POLL_INTERVAL_MS = 30_000L
+        private const val SYNC_EVENT_SLICE_MS = 1_000L
+        private const val SYNC_EVENT_BATCH = 64
+        private const val LOG_RECORD_BATCH = 32
+        private const val RPC_ERROR_EXIT = 1
+        private const val RPC_UNREACHABLE_EXIT = -2
+        private const val CONSOLE_OUTPUT_LIMIT_BYTES = 1 shl 20
+        private const val RPC_HOST = "127.0.0.1"
+        private const val TRACE_COMMAND = "trace"
+        private const val TRACE_MARKER = "trace-on"
     }
 
     fun getStatusSnapshot(): NodeStatusSnapshot {
@@ -613,7 +1187,8 @@ class NodeManager(
         return NodeStatusSnapshot(
             datadir = dataDir,
             confExists = configFile.exists(),
-            debugLogInsight = debugLogInsight
+            debugLogInsight = debugLogInsight,
+            process = runCatching { controller.getProcessStatus() }.getOrNull()
         )
     }
 
@@ -654,4 +1229,5 @@ data class NodeStatusSnapshot(
     val datadir: File,
     val confExists: Boolean,
     val debugLogInsight: DebugLogInsight,
+    val process: NodeProcessStatus? = null,
 )
@@ -0,0 +1,33 @@
+package com.digimobile.node
+
+/**
+ * Chains digibyted can run. Core reads rpcport and rpcbind only from the chain's own section of
+ * digibyte.conf (a top-level value counts for mainnet alone), so [DigiConfigTemplate] writes them
+ * under [section].
+ *
+ * @param selectOption top-level option that selects the chain; mainnet needs none.
+ * @param defaultRpcPort digibyted's own default RPC port for the chain.
+ */
+enum class NodeNetwork(val section: String, val selectOption: String?, val defaultRpcPort: Int) {
+    MAIN("main", null, 14022),
+    TESTNET("test", "testnet", 14023),
+    REGTEST("regtest", "regtest", 18443);
+
+    /**
+     * RPC port for node [instance] of this chain: 0 is the app's default node, further nodes
+     * registered with DigiMobileNodeController.newNode() count up from 1. Ports step by
+     * [INSTANCE_PORT_STRIDE], which keeps every chain and instance apart.
+     */
+    fun rpcPort(instance: Int): Int {
+        require(instance in 0 until MAX_INSTANCES) { "node instance $instance out of range" }
+        return defaultRpcPort + instance * INSTANCE_PORT_STRIDE
+    }
+
+    companion object {
+        const val INSTANCE_PORT_STRIDE = 10
+        const val MAX_INSTANCES = 100
+
+        fun fromName(name: String?): NodeNetwork =
+            values().firstOrNull { it.name == name } ?: MAIN
+    }
+}
@@ -0,0 +1,96 @@
+package com.digimobile.node;
+
+/**
+ * Snapshot of the node child process as seen by the native controller.
+ *
+ * Values are decoded from a packed {@code long[]} filled by the JNI layer in a
+ * single call, so sampling does not allocate per field or cross JNI repeatedly.
+ * Resource fields come from {@code /proc/<pid>} and are {@code -1} when the
+ * process is not running or the kernel refused the read.
+ */
+public final class NodeProcessStatus {
+    public static final int PHASE_NOT_RUNNING = 0;
+    public static final int PHASE_STAGING = 1;
+    public static final int PHASE_RUNNING = 2;
+    public static final int PHASE_EXITED = 3;
+    public static final int PHASE_FAILED = 4;
+    /** SIGTERM sent; waiting for a graceful exit before escalating to SIGKILL. */
+    public static final int PHASE_STOPPING = 5;
+    /** The child crashed and the supervisor will respawn it after a backoff. */
+    public static final int PHASE_RESTART_BACKOFF = 6;
+
+    // Indices into the packed array; must match ProcessStatusField in digimobile_jni.cpp.
+    static final int FIELD_PHASE = 0;
+    static final int FIELD_PID = 1;
+    static final int FIELD_UPTIME_MS = 2;
+    static final int FIELD_RSS_BYTES = 3;
+    static final int FIELD_CPU_USER_MS = 4;
+    static final int FIELD_CPU_SYSTEM_MS = 5;
+    static final int FIELD_IO_READ_BYTES = 6;
+    static final int FIELD_IO_WRITE_BYTES = 7;
+    static final int FIELD_OPEN_FDS = 8;
+    static final int FIELD_THREADS = 9;
+    static final int FIELD_EXIT_CODE = 10;
+    static final int FIELD_EXIT_SIGNAL = 11;
+    static final int FIELD_COUNT = 12;
+
+    public final int phase;
+    public final int pid;
+    public final long uptimeMs;
+    public final long rssBytes;
+    public final long cpuUserMs;
+    public final long cpuSystemMs;
+    public final long ioReadBytes;
+    public final long ioWriteBytes;
+    public final long openFds;
+    public final long threads;
+    /** Exit code of the last child that exited normally, or -1. */
+    public final int exitCode;
+    /** Signal that terminated the last child, or 0. */
+    public final int exitSignal;
+
+    NodeProcessStatus(long[] packed) {
+        phase = (int) packed[FIELD_PHASE];
+        pid = (int) packed[FIELD_PID];
+        uptimeMs = packed[FIELD_UPTIME_MS];
+        rssBytes = packed[FIELD_RSS_BYTES];
+        cpuUserMs = packed[FIELD_CPU_USER_MS];
+        cpuSystemMs = packed[FIELD_CPU_SYSTEM_MS];
+        ioReadBytes = packed[FIELD_IO_READ_BYTES];
+        ioWriteBytes = packed[FIELD_IO_WRITE_BYTES];
+        openFds = packed[FIELD_OPEN_FDS];
+        threads = packed[FIELD_THREADS];
+        exitCode = (int) packed[FIELD_EXIT_CODE];
+        exitSignal = (int) packed[FIELD_EXIT_SIGNAL];
+    }
+
+    public boolean isRunning() {
+        return (phase == PHASE_RUNNING || phase == PHASE_STOPPING) && pid > 0;
+    }
+
+    /** Human-readable exit reason, or {@code null} if no exit has been observed. */
+    public String describeExit() {
+        if (exitSignal > 0) {
+            return "killed by signal " + exitSignal;
+        }
+        if (exitCode >= 0) {
+            return "exited with code " + exitCode;
+        }
+        return null;
+    }
+
+    @Override
+    public String toString() {
+        if (!isRunning()) {
+            String exit = describeExit();
+            return exit != null ? "not running (" + exit + ")" : "not running";
+        }
+        return "pid " + pid
+                + ", up " + (uptimeMs / 1000) + "s"
+                + ", rss " + (rssBytes / (1024 * 1024)) + " MiB"
+                + ", cpu " + ((cpuUserMs + cpuSystemMs) / 1000) + "s"
+                + ", io r/w " + (ioReadBytes / (1024 * 1024)) + "/" + (ioWriteBytes / (1024 * 1024)) + " MiB"
+                + ", fds " + openFds
+                + ", threads " + threads;
+    }
+}
@@ -0,0 +1,50 @@
+package com.digimobile.node
+
+import android.content.Context
+import android.net.ConnectivityManager
+import android.net.NetworkCapabilities
+import android.os.BatteryManager
+import android.os.Build
+import android.os.PowerManager
+
+/**
+ * Picks dbcache, par, maxconnections and maxmempool for the device it runs on.
+ *
+ * Memory, cores and thermal zones are read natively; battery, charging, thermal status and
+ * whether the network is metered come from the framework, which sees them even where sysfs is
+ * hidden from the app. [sample] returns `null` without the native library, in which case the
+ * preset's values are written unchanged.
+ */
+class ResourceGovernor(
+    private val context: Context,
+    private val controller: DigiMobileNodeController = DigiMobileNodeController()
+) {
+
+    fun sample(): ResourceTuning? = runCatching {
+        controller.sampleResourceTuning(batteryPercent(), charging(), thermalStatus(), unmetered())
+    }.getOrNull()
+
+    private fun batteryPercent(): Int {
+        val battery = context.getSystemService(Context.BATTERY_SERVICE) as? BatteryManager ?: return -1
+        val capacity = battery.getIntProperty(BatteryManager.BATTERY_PROPERTY_CAPACITY)
+        return if (capacity in 0..100) capacity else -1
+    }
+
+    private fun charging(): Int {
+        val battery = context.getSystemService(Context.BATTERY_SERVICE) as? BatteryManager ?: return -1
+        return if (battery.isCharging) 1 else 0
+    }
+
+    private fun thermalStatus(): Int {
+        if (Build.VERSION.SDK_INT < Build.VERSION_CODES.Q) return -1
+        val power = context.getSystemService(Context.POWER_SERVICE) as? PowerManager ?: return -1
+        return power.currentThermalStatus
+    }
+
+    private fun unmetered(): Int {
+        val connectivity =
+            context.getSystemService(Context.CONNECTIVITY_SERVICE) as? ConnectivityManager ?: return -1
+        val capabilities = connectivity.getNetworkCapabilities(connectivity.activeNetwork) ?: return 0
+        return if (capabilities.hasCapability(NetworkCapabilities.NET_CAPABILITY_NOT_METERED)) 1 else 0
+    }
+}
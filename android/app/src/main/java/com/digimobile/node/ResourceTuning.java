@@ -0,0 +1,80 @@
+package com.digimobile.node;
+
+/**
+ * Node limits derived by the native resource governor, with the device state they were derived
+ * from.
+ *
+ * Values are decoded from a packed {@code long[]} filled by the JNI layer in a single call.
+ * Device fields are {@code -1} when neither sysfs nor the framework could provide them.
+ */
+public final class ResourceTuning {
+    /** Hot, or on a low battery: one script thread, few peers, a small cache. */
+    public static final int PROFILE_THROTTLED = 0;
+    public static final int PROFILE_BALANCED = 1;
+    /** Charging on an unmetered network: size everything for a fast initial sync. */
+    public static final int PROFILE_FULL = 2;
+
+    // Indices into the packed array; must match ResourceTuningField in digimobile_jni.cpp.
+    static final int FIELD_PROFILE = 0;
+    static final int FIELD_DBCACHE_MB = 1;
+    static final int FIELD_PAR = 2;
+    static final int FIELD_MAX_CONNECTIONS = 3;
+    static final int FIELD_MAX_MEMPOOL_MB = 4;
+    static final int FIELD_MEM_TOTAL_KB = 5;
+    static final int FIELD_MEM_AVAILABLE_KB = 6;
+    static final int FIELD_CPU_CORES = 7;
+    static final int FIELD_THERMAL_MILLICELSIUS = 8;
+    static final int FIELD_BATTERY_PERCENT = 9;
+    static final int FIELD_CHARGING = 10;
+    static final int FIELD_COUNT = 11;
+
+    public final int profile;
+    public final int dbcacheMb;
+    public final int par;
+    public final int maxConnections;
+    public final int maxMempoolMb;
+    public final long memTotalKb;
+    public final long memAvailableKb;
+    public final int cpuCores;
+    /** Hottest thermal zone readable from the app sandbox. */
+    public final int thermalMilliCelsius;
+    public final int batteryPercent;
+    /** 1 on external power, 0 on battery. */
+    public final int charging;
+
+    ResourceTuning(long[] packed) {
+        profile = (int) packed[FIELD_PROFILE];
+        dbcacheMb = (int) packed[FIELD_DBCACHE_MB];
+        par = (int) packed[FIELD_PAR];
+        maxConnections = (int) packed[FIELD_MAX_CONNECTIONS];
+        maxMempoolMb = (int) packed[FIELD_MAX_MEMPOOL_MB];
+        memTotalKb = packed[FIELD_MEM_TOTAL_KB];
+        memAvailableKb = packed[FIELD_MEM_AVAILABLE_KB];
+        cpuCores = (int) packed[FIELD_CPU_CORES];
+        thermalMilliCelsius = (int) packed[FIELD_THERMAL_MILLICELSIUS];
+        batteryPercent = (int) packed[FIELD_BATTERY_PERCENT];
+        charging = (int) packed[FIELD_CHARGING];
+    }
+
+    public String profileName() {
+        switch (profile) {
+            case PROFILE_THROTTLED:
+                return "throttled";
+            case PROFILE_FULL:
+                return "full";
+            default:
+                return "balanced";
+        }
+    }
+
+    @Override
+    public String toString() {
+        return profileName()
+                + ": dbcache " + dbcacheMb + " MiB"
+                + ", par " + par
+                + ", maxconnections " + maxConnections
+                + ", maxmempool " + maxMempoolMb + " MiB"
+                + " (ram " + (memTotalKb / 1024) + " MiB, cores " + cpuCores
+                + ", battery " + batteryPercent + "%" + (charging == 1 ? " charging" : "") + ")";
+    }
+}
@@ -0,0 +1,137 @@
+package com.digimobile.node
+
+import org.json.JSONArray
+import org.json.JSONTokener
+
+/**
+ * Builds JSON-RPC params from console-style arguments the way digibyte-cli does: every argument
+ * is a string unless the method takes JSON at that position, so a label "123", a comment "true"
+ * or a wallet named "null" reach the node as the strings they are.
+ *
+ * The table is digibyte-cli's vRPCConvertParams (src/rpc/client.cpp in Core v8.26), positional
+ * entries only; named-only entries do not apply to positional arguments.
+ */
+object RpcParamConversions {
+
+    /** JSON array literal of [args] for [method]. */
+    fun toParams(method: String, args: List<String>): String {
+        val positions = CONVERT[method].orEmpty()
+        val params = JSONArray()
+        args.forEachIndexed { index, arg ->
+            // Unparseable JSON stays a string, so the node reports the type error for it.
+            val value = if (index in positions) parseJson(arg) else null
+            params.put(value ?: arg)
+        }
+        return params.toString()
+    }
+
+    private fun parseJson(arg: String): Any? {
+        val text = arg.trim()
+        val tokener = JSONTokener(text)
+        val value = runCatching { tokener.nextValue() }.getOrNull() ?: return null
+        // JSONTokener is lenient and stops at the first value; anything left over, or a bare
+        // word it took for an unquoted string, is not JSON.
+        val bareWord = value is String && !text.startsWith("\"")
+        return if (tokener.more() || bareWord) null else value
+    }
+
+    private val CONVERT: Map<String, Set<Int>> = mapOf(
+        "setmocktime" to setOf(0),
+        "mockscheduler" to setOf(0),
+        "utxoupdatepsbt" to setOf(1),
+        "generatetoaddress" to setOf(0, 2),
+        "generatetodescriptor" to setOf(0, 2),
+        "generateblock" to setOf(1, 2),
+        "getnetworkhashps" to setOf(0, 1),
+        "sendtoaddress" to setOf(1, 4, 5, 6, 8, 9, 10),
+        "settxfee" to setOf(0),
+        "sethdseed" to setOf(0),
+        "getreceivedbyaddress" to setOf(1, 2),
+        "getreceivedbylabel" to setOf(1, 2),
+        "listreceivedbyaddress" to setOf(0, 1, 2, 4),
+        "listreceivedbylabel" to setOf(0, 1, 2, 3),
+        "getbalance" to setOf(1, 2, 3),
+        "getblockfrompeer" to setOf(1),
+        "getblockhash" to setOf(0),
+        "waitforblockheight" to setOf(0, 1),
+        "waitforblock" to setOf(1),
+        "waitfornewblock" to setOf(0),
+        "listtransactions" to setOf(1, 2, 3),
+        "walletpassphrase" to setOf(1),
+        "getblocktemplate" to setOf(0),
+        "listsinceblock" to setOf(1, 2, 3, 4),
+        "sendmany" to setOf(1, 2, 4, 5, 6, 8, 9),
+        "deriveaddresses" to setOf(1),
+        "scanblocks" to setOf(1, 2, 3, 5),
+        "scantxoutset" to setOf(1),
+        "addmultisigaddress" to setOf(0, 1),
+        "createmultisig" to setOf(0, 1),
+        "listunspent" to setOf(0, 1, 2, 3, 4),
+        "getblock" to setOf(1),
+        "getblockheader" to setOf(1),
+        "getchaintxstats" to setOf(0),
+        "gettransaction" to setOf(1, 2),
+        "getrawtransaction" to setOf(1),
+        "createrawtransaction" to setOf(0, 1, 2, 3),
+        "decoderawtransaction" to setOf(1),
+        "signrawtransactionwithkey" to setOf(1, 2),
+        "signrawtransactionwithwallet" to setOf(1),
+        "sendrawtransaction" to setOf(1, 2),
+        "testmempoolaccept" to setOf(0, 1),
+        "submitpackage" to setOf(0),
+        "combinerawtransaction" to setOf(0),
+        "fundrawtransaction" to setOf(1, 2),
+        "walletcreatefundedpsbt" to setOf(0, 1, 2, 3, 4),
+        "walletprocesspsbt" to setOf(1, 3, 4),
+        "descriptorprocesspsbt" to setOf(1, 3, 4),
+        "createpsbt" to setOf(0, 1, 2, 3),
+        "combinepsbt" to setOf(0),
+        "joinpsbts" to setOf(0),
+        "finalizepsbt" to setOf(1),
+        "converttopsbt" to setOf(1, 2),
+        "gettxout" to setOf(1, 2),
+        "gettxoutproof" to setOf(0),
+        "gettxoutsetinfo" to setOf(1, 2),
+        "lockunspent" to setOf(0, 1, 2),
+        "send" to setOf(0, 1, 3, 4),
+        "sendall" to setOf(0, 1, 3, 4),
+        "simulaterawtransaction" to setOf(0, 1),
+        "importprivkey" to setOf(2),
+        "importaddress" to setOf(2, 3),
+        "importpubkey" to setOf(2),
+        "importmulti" to setOf(0, 1),
+        "importdescriptors" to setOf(0),
+        "listdescriptors" to setOf(0),
+        "verifychain" to setOf(0, 1),
+        "getblockstats" to setOf(0, 1),
+        "pruneblockchain" to setOf(0),
+        "keypoolrefill" to setOf(0),
+        "getrawmempool" to setOf(0, 1),
+        "estimatesmartfee" to setOf(0),
+        "estimaterawfee" to setOf(0, 1),
+        "prioritisetransaction" to setOf(1, 2),
+        "setban" to setOf(2, 3),
+        "setnetworkactive" to setOf(0),
+        "setwalletflag" to setOf(1),
+        "getmempoolancestors" to setOf(1),
+        "getmempooldescendants" to setOf(1),
+        "gettxspendingprevout" to setOf(0),
+        "bumpfee" to setOf(1),
+        "psbtbumpfee" to setOf(1),
+        "logging" to setOf(0, 1),
+        "disconnectnode" to setOf(1),
+        "upgradewallet" to setOf(0),
+        "echojson" to (0..9).toSet(),
+        "rescanblockchain" to setOf(0, 1),
+        "createwallet" to setOf(1, 2, 4, 5, 6, 7),
+        "restorewallet" to setOf(2),
+        "loadwallet" to setOf(1),
+        "unloadwallet" to setOf(1),
+        "getnodeaddresses" to setOf(0),
+        "addpeeraddress" to setOf(1, 2),
+        "sendmsgtopeer" to setOf(0),
+        "stop" to setOf(0),
+        "addnode" to setOf(2),
+        "addconnection" to setOf(2),
+    )
+}
@@ -0,0 +1,110 @@
+package com.digimobile.node;
+
+import java.io.Closeable;
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.IOException;
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
+
+/**
+ * Incremental SHA-256 backed by the JNI library, which uses the ARMv8 SHA2 instructions
+ * when the CPU has them. Lets a download or copy hash bytes as they stream through instead
+ * of re-reading the file afterwards. Falls back to {@link MessageDigest} when the native
+ * library is unavailable.
+ *
+ * Not thread-safe; {@link #close()} releases the native state.
+ */
+public final class Sha256Hasher implements Closeable {
+    private static final boolean nativeAvailable = DigiMobileNodeController.isNativeLoaded();
+
+    private long handle;
+    private final MessageDigest fallback;
+
+    public Sha256Hasher() {
+        if (nativeAvailable) {
+            handle = nativeCreate();
+            fallback = null;
+        } else {
+            fallback = newMessageDigest();
+        }
+    }
+
+    public void update(byte[] data, int offset, int length) {
+        if (fallback != null) {
+            fallback.update(data, offset, length);
+        } else if (handle != 0) {
+            nativeUpdate(handle, data, offset, length);
+        } else {
+            throw new IllegalStateException("Sha256Hasher is closed");
+        }
+    }
+
+    /** Lowercase hex digest of everything passed to {@link #update}; the hasher is then reset. */
+    public String finishHex() {
+        if (fallback != null) {
+            return toHex(fallback.digest());
+        }
+        if (handle == 0) {
+            throw new IllegalStateException("Sha256Hasher is closed");
+        }
+        return nativeFinish(handle);
+    }
+
+    @Override
+    public void close() {
+        if (handle != 0) {
+            nativeDestroy(handle);
+            handle = 0;
+        }
+    }
+
+    /** Lowercase hex SHA-256 of a whole file, read natively in large sequential chunks. */
+    public static String hashFile(File file) throws IOException {
+        if (nativeAvailable) {
+            String hex = nativeHashFile(file.getAbsolutePath());
+            if (hex == null) {
+                throw new IOException("Unable to hash " + file);
+            }
+            return hex;
+        }
+        MessageDigest digest = newMessageDigest();
+        byte[] buffer = new byte[1 << 16];
+        try (FileInputStream input = new FileInputStream(file)) {
+            int read;
+            while ((read = input.read(buffer)) != -1) {
+                digest.update(buffer, 0, read);
+            }
+        }
+        return toHex(digest.digest());
+    }
+
+    /** Which compression routine is in use: "armv8-sha2", "x86-shani", "scalar" or "java". */
+    public static String implementation() {
+        return nativeAvailable ? nativeImplementation() : "java";
+    }
+
+    private static MessageDigest newMessageDigest() {
+        try {
+            return MessageDigest.getInstance("SHA-256");
+        } catch (NoSuchAlgorithmException e) {
+            throw new IllegalStateException(e);
+        }
+    }
+
+    private static String toHex(byte[] digest) {
+        StringBuilder hex = new StringBuilder(digest.length * 2);
+        for (byte b : digest) {
+            hex.append(Character.forDigit((b >> 4) & 0xf, 16));
+            hex.append(Character.forDigit(b & 0xf, 16));
+        }
+        return hex.toString();
+    }
+
+    private static native long nativeCreate();
+    private static native void nativeUpdate(long handle, byte[] data, int offset, int length);
+    private static native String nativeFinish(long handle);
+    private static native void nativeDestroy(long handle);
+    private static native String nativeHashFile(String path);
+    private static native String nativeImplementation();
+}
@@ -0,0 +1,95 @@
+package com.digimobile.node;
+
+import java.io.Closeable;
+
+/**
+ * Applies a DGBSNAP1 snapshot container (see {@code android/jni/snapshot_container.h}) straight
+ * into the node datadir while the container is still downloading.
+ *
+ * The downloader reports finished byte ranges through {@link #markAvailable}, from any thread.
+ * A single consumer thread loops on {@link #applyAvailable}, which verifies each chunk whose bytes
+ * have all arrived against the pinned index, then inflates it and writes it at its final path.
+ * Chunks may arrive in any order.
+ */
+public final class SnapshotContainerApplier implements Closeable {
+    private long handle;
+
+    /**
+     * @param expectedIndexSha256 hex SHA-256 of the container index; the container is rejected
+     *                            if it differs. Every chunk is then checked against the index.
+     * @throws IllegalStateException if the native library is unavailable.
+     */
+    public SnapshotContainerApplier(String containerPath, String destDir, String expectedIndexSha256) {
+        if (!DigiMobileNodeController.isNativeLoaded()) {
+            throw new IllegalStateException("Native library digimobile_jni is missing");
+        }
+        handle = nativeCreate(containerPath, destDir, expectedIndexSha256);
+    }
+
+    public synchronized void markAvailable(long offset, long length) {
+        if (handle != 0) {
+            nativeMarkAvailable(handle, offset, length);
+        }
+    }
+
+    /** Wake {@link #applyAvailable} early, e.g. after the download failed. */
+    public synchronized void interrupt() {
+        if (handle != 0) {
+            nativeInterrupt(handle);
+        }
+    }
+
+    /**
+     * Apply every chunk that is ready, waiting up to {@code timeoutMs} for more bytes when none is.
+     *
+     * @return {@code null}, or the reason the container was rejected (this is permanent).
+     */
+    public String applyAvailable(int timeoutMs, int threads) {
+        return nativeApplyAvailable(requireHandle(), timeoutMs, threads);
+    }
+
+    public long appliedBytes() {
+        return nativeProgress(requireHandle())[0];
+    }
+
+    /** Uncompressed size of the snapshot, or 0 until the index has arrived. */
+    public long totalBytes() {
+        return nativeProgress(requireHandle())[1];
+    }
+
+    public boolean isComplete() {
+        return nativeProgress(requireHandle())[2] != 0;
+    }
+
+    /**
+     * Sync the written directories once {@link #isComplete()}.
+     *
+     * @return {@code null} on success, otherwise the reason.
+     */
+    public String finish() {
+        return nativeFinish(requireHandle());
+    }
+
+    @Override
+    public synchronized void close() {
+        if (handle != 0) {
+            nativeDestroy(handle);
+            handle = 0;
+        }
+    }
+
+    private synchronized long requireHandle() {
+        if (handle == 0) {
+            throw new IllegalStateException("SnapshotContainerApplier is closed");
+        }
+        return handle;
+    }
+
+    private static native long nativeCreate(String containerPath, String destDir, String expectedIndexSha256);
+    private static native void nativeMarkAvailable(long handle, long offset, long length);
+    private static native void nativeInterrupt(long handle);
+    private static native String nativeApplyAvailable(long handle, int timeoutMs, int threads);
+    private static native long[] nativeProgress(long handle);
+    private static native String nativeFinish(long handle);
+    private static native void nativeDestroy(long handle);
+}
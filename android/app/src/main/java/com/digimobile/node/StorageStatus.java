@@ -0,0 +1,63 @@
+package com.digimobile.node;
+
+/**
+ * Storage on the node's data directory, the prune target chosen from it and the state of the
+ * write throttle.
+ *
+ * Values are decoded from a packed {@code long[]} filled by the JNI layer in a single call.
+ * Sizes and rates are {@code -1} when they could not be read.
+ */
+public final class StorageStatus {
+    // Indices into the packed array; must match StorageStatusField in digimobile_jni.cpp.
+    static final int FIELD_TOTAL_BYTES = 0;
+    static final int FIELD_FREE_BYTES = 1;
+    static final int FIELD_BLOCKS_BYTES = 2;
+    static final int FIELD_PRUNE_TARGET_MB = 3;
+    static final int FIELD_NEXT_PRUNE_TARGET_MB = 4;
+    static final int FIELD_WRITE_LIMIT_BYTES_PER_SEC = 5;
+    static final int FIELD_WRITE_BYTES_PER_SEC = 6;
+    static final int FIELD_LATENCY_MS = 7;
+    static final int FIELD_THROTTLE_PAUSES = 8;
+    static final int FIELD_THROTTLE_PAUSED_MS = 9;
+    static final int FIELD_COUNT = 10;
+
+    public final long totalBytes;
+    public final long freeBytes;
+    /** Block and undo files of every network in the data directory. */
+    public final long blocksBytes;
+    /** Passed as {@code -prune} at the last start; 0 when left to {@code digibyte.conf}. */
+    public final int pruneTargetMb;
+    /** What the next start would choose given the space free now. */
+    public final int nextPruneTargetMb;
+    /** Current limit on the daemon's writes; 0 while unlimited. */
+    public final long writeLimitBytesPerSec;
+    public final long writeBytesPerSec;
+    /** Average time per request on the data directory's device over the last sample. */
+    public final int latencyMs;
+    public final long throttlePauses;
+    public final long throttlePausedMs;
+
+    StorageStatus(long[] packed) {
+        totalBytes = packed[FIELD_TOTAL_BYTES];
+        freeBytes = packed[FIELD_FREE_BYTES];
+        blocksBytes = packed[FIELD_BLOCKS_BYTES];
+        pruneTargetMb = (int) packed[FIELD_PRUNE_TARGET_MB];
+        nextPruneTargetMb = (int) packed[FIELD_NEXT_PRUNE_TARGET_MB];
+        writeLimitBytesPerSec = packed[FIELD_WRITE_LIMIT_BYTES_PER_SEC];
+        writeBytesPerSec = packed[FIELD_WRITE_BYTES_PER_SEC];
+        latencyMs = (int) packed[FIELD_LATENCY_MS];
+        throttlePauses = packed[FIELD_THROTTLE_PAUSES];
+        throttlePausedMs = packed[FIELD_THROTTLE_PAUSED_MS];
+    }
+
+    @Override
+    public String toString() {
+        return "free " + (freeBytes >> 20) + " of " + (totalBytes >> 20) + " MiB"
+                + ", blocks " + (blocksBytes >> 20) + " MiB"
+                + ", prune " + pruneTargetMb + " MiB (next " + nextPruneTargetMb + ")"
+                + ", writes " + (writeBytesPerSec >> 10) + " KiB/s"
+                + (writeLimitBytesPerSec > 0 ? " of " + (writeLimitBytesPerSec >> 10) + " KiB/s" : "")
+                + ", latency " + latencyMs + " ms"
+                + ", paused " + throttlePausedMs + " ms in " + throttlePauses + " pauses";
+    }
+}
@@ -0,0 +1,76 @@
+package com.digimobile.node;
+
+import java.util.Locale;
+
+/**
+ * Sync figures gathered natively from one batched RPC poll: chain tip and headers, peers, mempool
+ * and network traffic, with rates derived from the previous poll.
+ *
+ * Values are decoded from the packed arrays filled by the JNI layer in a single call. Fields are
+ * {@code -1} when the node did not report them; rates are {@code -1} until two polls are known.
+ */
+public final class SyncMetrics {
+    // Indices into the packed arrays; must match SyncMetricsField and SyncRateField in
+    // digimobile_jni.cpp.
+    static final int FIELD_BLOCKS = 0;
+    static final int FIELD_HEADERS = 1;
+    static final int FIELD_INITIAL_BLOCK_DOWNLOAD = 2;
+    static final int FIELD_PEERS = 3;
+    static final int FIELD_PEERS_INBOUND = 4;
+    static final int FIELD_MEMPOOL_TX = 5;
+    static final int FIELD_MEMPOOL_BYTES = 6;
+    static final int FIELD_BYTES_RECV = 7;
+    static final int FIELD_BYTES_SENT = 8;
+    static final int FIELD_ETA_SECONDS = 9;
+    static final int VALUE_COUNT = 10;
+
+    static final int RATE_VERIFICATION_PROGRESS = 0;
+    static final int RATE_BLOCKS_PER_SECOND = 1;
+    static final int RATE_RECV_BYTES_PER_SECOND = 2;
+    static final int RATE_SENT_BYTES_PER_SECOND = 3;
+    static final int RATE_COUNT = 4;
+
+    public final long blocks;
+    public final long headers;
+    /** 1 during initial block download, 0 after it. */
+    public final int initialBlockDownload;
+    public final int peers;
+    public final int peersInbound;
+    public final long mempoolTx;
+    public final long mempoolBytes;
+    public final long bytesRecv;
+    public final long bytesSent;
+    /** Seconds until the best header is reached at the current block rate. */
+    public final long etaSeconds;
+    public final double verificationProgress;
+    public final double blocksPerSecond;
+    public final double recvBytesPerSecond;
+    public final double sentBytesPerSecond;
+
+    SyncMetrics(long[] values, double[] rates) {
+        blocks = values[FIELD_BLOCKS];
+        headers = values[FIELD_HEADERS];
+        initialBlockDownload = (int) values[FIELD_INITIAL_BLOCK_DOWNLOAD];
+        peers = (int) values[FIELD_PEERS];
+        peersInbound = (int) values[FIELD_PEERS_INBOUND];
+        mempoolTx = values[FIELD_MEMPOOL_TX];
+        mempoolBytes = values[FIELD_MEMPOOL_BYTES];
+        bytesRecv = values[FIELD_BYTES_RECV];
+        bytesSent = values[FIELD_BYTES_SENT];
+        etaSeconds = values[FIELD_ETA_SECONDS];
+        verificationProgress = rates[RATE_VERIFICATION_PROGRESS];
+        blocksPerSecond = rates[RATE_BLOCKS_PER_SECOND];
+        recvBytesPerSecond = rates[RATE_RECV_BYTES_PER_SECOND];
+        sentBytesPerSecond = rates[RATE_SENT_BYTES_PER_SECOND];
+    }
+
+    @Override
+    public String toString() {
+        return "blocks " + blocks + "/" + headers
+                + ", peers " + peers + " (" + peersInbound + " in)"
+                + ", mempool " + mempoolTx + " tx"
+                + ", " + String.format(Locale.US, "%.2f blk/s", blocksPerSecond)
+                + ", rx " + ((long) recvBytesPerSecond >> 10) + " KiB/s"
+                + ", eta " + etaSeconds + " s";
+    }
+}
@@ -0,0 +1,196 @@
+package com.digimobile.app
+
+import com.sun.net.httpserver.HttpExchange
+import com.sun.net.httpserver.HttpServer
+import java.io.File
+import java.net.InetAddress
+import java.net.InetSocketAddress
+import java.nio.file.Files
+import java.security.MessageDigest
+import java.util.Collections
+import java.util.concurrent.Executors
+import kotlin.random.Random
+import kotlinx.coroutines.runBlocking
+import org.junit.After
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Assert.fail
+import org.junit.Before
+import org.junit.Test
+
+/**
+ * Runs [SnapshotDownloader] against a local HTTP server that serves Range requests. On the JVM the
+ * native library is absent, so hashing uses MessageDigest and preallocation uses setLength.
+ */
+class SnapshotDownloaderTest {
+    private val chunkSize = 64L * 1024
+    private val content = Random(7).nextBytes((5 * chunkSize + 1234).toInt())
+    private val chunkCount = 6
+
+    private lateinit var server: HttpServer
+    private lateinit var dir: File
+    private lateinit var target: File
+
+    @Volatile private var rangesSupported = true
+    @Volatile private var etag = "\"v1\""
+    @Volatile private var publishChunkHashes = false
+    /** Chunk indexes whose next response has one byte flipped. */
+    private val corruptOnce: MutableSet<Int> = Collections.synchronizedSet(mutableSetOf())
+    /** Start offset of every chunk request, excluding the one-byte probe. */
+    private val chunkRequests: MutableList<Long> = Collections.synchronizedList(mutableListOf())
+
+    @Before
+    fun setUp() {
+        dir = Files.createTempDirectory("snapshot-downloader").toFile()
+        target = File(dir, "snapshot.tar.gz")
+        server = HttpServer.create(InetSocketAddress(InetAddress.getLoopbackAddress(), 0), 0)
+        server.executor = Executors.newFixedThreadPool(8)
+        server.createContext("/snapshot.tar.gz") { exchange -> serve(exchange) }
+        server.start()
+    }
+
+    @After
+    fun tearDown() {
+        server.stop(0)
+        dir.deleteRecursively()
+    }
+
+    private val url: String
+        get() = "http://127.0.0.1:${server.address.port}/snapshot.tar.gz"
+
+    private fun serve(exchange: HttpExchange) {
+        exchange.use {
+            if (exchange.requestURI.path.endsWith(".chunks")) {
+                if (!publishChunkHashes) {
+                    exchange.sendResponseHeaders(404, -1)
+                    return
+                }
+                val body = buildString {
+                    append("$chunkSize\n")
+                    for (index in 0 until chunkCount) {
+                        append(sha256(slice(index * chunkSize, chunkLength(index)))).append('\n')
+                    }
+                }.toByteArray()
+                exchange.sendResponseHeaders(200, body.size.toLong())
+                exchange.responseBody.write(body)
+                return
+            }
+            exchange.responseHeaders.add("ETag", etag)
+            val range = exchange.requestHeaders.getFirst("Range")
+            val ifRange = exchange.requestHeaders.getFirst("If-Range")
+            if (!rangesSupported || range == null || (ifRange != null && ifRange != etag)) {
+                exchange.sendResponseHeaders(200, content.size.toLong())
+                exchange.responseBody.write(content)
+                return
+            }
+            val (first, last) = range.removePrefix("bytes=").split('-').map { it.toLong() }
+            if (last > first) {
+                chunkRequests.add(first)
+            }
+            val body = slice(first, last - first + 1)
+            if (corruptOnce.remove((first / chunkSize).toInt())) {
+                body[body.size / 2] = (body[body.size / 2].toInt() xor 1).toByte()
+            }
+            exchange.responseHeaders.add("Content-Range", "bytes $first-$last/${content.size}")
+            exchange.sendResponseHeaders(206, body.size.toLong())
+            exchange.responseBody.write(body)
+        }
+    }
+
+    private fun slice(start: Long, length: Long) =
+        content.copyOfRange(start.toInt(), (start + length).toInt())
+
+    private fun chunkLength(index: Int) = minOf(chunkSize, content.size - index * chunkSize)
+
+    private fun sha256(data: ByteArray) =
+        MessageDigest.getInstance("SHA-256").digest(data).joinToString("") { "%02x".format(it) }
+
+    private fun downloader() = SnapshotDownloader(url, target, connections = 3, chunkSize = chunkSize)
+
+    private val manifest: File
+        get() = File(dir, "snapshot.tar.gz.chunks")
+
+    /** Download, failing on purpose once [stopAfter] chunks have been reported. */
+    private fun interruptedDownload(stopAfter: Int) {
+        var reported = 0
+        try {
+            runBlocking {
+                downloader().download({ _, _ -> }, {}) { _, _ ->
+                    synchronized(this@SnapshotDownloaderTest) {
+                        if (++reported >= stopAfter) throw IllegalStateException("interrupted")
+                    }
+                }
+            }
+            fail("download should have been interrupted")
+        } catch (expected: IllegalStateException) {
+        }
+    }
+
+    @Test
+    fun downloadsEveryChunk() = runBlocking {
+        val ranges = Collections.synchronizedList(mutableListOf<Pair<Long, Long>>())
+        var last = 0L to 0L
+        val result = downloader().download(
+            onProgress = { done, total -> synchronized(this@SnapshotDownloaderTest) { last = done to total } },
+            onLog = {},
+            onChunk = { offset, length -> ranges.add(offset to length) }
+        )
+        assertEquals(SnapshotDownloader.Result.COMPLETE, result)
+        assertArrayEquals(content, target.readBytes())
+        assertFalse(manifest.exists())
+        assertEquals((0 until chunkCount).map { it * chunkSize to chunkLength(it) }, ranges.sortedBy { it.first })
+        assertEquals(content.size.toLong() to content.size.toLong(), last)
+        assertEquals(chunkCount, chunkRequests.size)
+    }
+
+    @Test
+    fun resumesWithOnlyTheMissingChunks() {
+        interruptedDownload(stopAfter = 2)
+        val kept = manifest.readLines().drop(3).filter { it.isNotBlank() }.size
+        assertTrue(kept in 2 until chunkCount)
+        chunkRequests.clear()
+
+        var first = -1L
+        val result = runBlocking {
+            downloader().download({ done, _ -> if (first < 0) first = done }, {})
+        }
+        assertEquals(SnapshotDownloader.Result.COMPLETE, result)
+        assertArrayEquals(content, target.readBytes())
+        assertEquals(chunkCount - kept, chunkRequests.size)
+        assertTrue(first >= (kept - 1) * chunkSize)
+    }
+
+    @Test
+    fun startsOverWhenTheFileChanged() {
+        interruptedDownload(stopAfter = 2)
+        chunkRequests.clear()
+        etag = "\"v2\""
+        val result = runBlocking { downloader().download({ _, _ -> }, {}) }
+        assertEquals(SnapshotDownloader.Result.COMPLETE, result)
+        assertArrayEquals(content, target.readBytes())
+        assertEquals(chunkCount, chunkRequests.size)
+    }
+
+    @Test
+    fun refetchesAChunkThatFailsItsPublishedHash() = runBlocking {
+        publishChunkHashes = true
+        corruptOnce.add(2)
+        val logs = mutableListOf<String>()
+        val result = downloader().download({ _, _ -> }, { logs.add(it) })
+        assertEquals(SnapshotDownloader.Result.COMPLETE, result)
+        assertArrayEquals(content, target.readBytes())
+        assertEquals(2, chunkRequests.count { it == 2 * chunkSize })
+        assertEquals(chunkCount + 1, chunkRequests.size)
+        assertTrue(logs.any { it.contains("$chunkCount published hashes") })
+    }
+
+    @Test
+    fun reportsServersThatIgnoreRanges() = runBlocking {
+        rangesSupported = false
+        val result = downloader().download({ _, _ -> }, {})
+        assertEquals(SnapshotDownloader.Result.RANGES_UNSUPPORTED, result)
+        assertFalse(manifest.exists())
+    }
+}
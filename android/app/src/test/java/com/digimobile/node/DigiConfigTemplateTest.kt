@@ -0,0 +1,83 @@
+package com.digimobile.node
+
+import java.io.File
+import java.nio.file.Files
+import org.junit.After
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertNotEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+
+/** Checks where [DigiConfigTemplate] puts the RPC port for each network and node instance. */
+class DigiConfigTemplateTest {
+    private val root: File = Files.createTempDirectory("digiconfig").toFile()
+
+    @After
+    fun tearDown() {
+        root.deleteRecursively()
+    }
+
+    private fun write(name: String, network: NodeNetwork, instance: Int): Pair<RpcCredentials, List<String>> {
+        val datadir = File(root, name)
+        val credentials = DigiConfigTemplate.ensureConfig(
+            datadir, NodeConfigOptions(network = network), instance = instance
+        )
+        return credentials to File(datadir, "digibyte.conf").readLines()
+    }
+
+    /** Lines of [section], or the top-level lines before any section when it is null. */
+    private fun section(lines: List<String>, section: String?): List<String> {
+        var current: String? = null
+        return lines.filter { line ->
+            if (line.startsWith("[")) {
+                current = line.trim('[', ']')
+                false
+            } else {
+                current == section
+            }
+        }
+    }
+
+    @Test
+    fun mainnetPortGoesUnderTheMainSection() {
+        val (credentials, lines) = write("main", NodeNetwork.MAIN, 0)
+        assertEquals(14022, credentials.port)
+        assertTrue(section(lines, "main").contains("rpcport=14022"))
+        assertTrue(section(lines, "main").contains("rpcbind=127.0.0.1"))
+        assertFalse(section(lines, null).any { it.startsWith("rpcport=") || it.startsWith("rpcbind=") })
+        assertFalse(lines.any { it == "testnet=1" || it == "regtest=1" })
+    }
+
+    @Test
+    fun otherNetworksAreSelectedAtTopLevel() {
+        val (testnet, testLines) = write("test", NodeNetwork.TESTNET, 0)
+        assertEquals(14023, testnet.port)
+        assertTrue(section(testLines, null).contains("testnet=1"))
+        assertTrue(section(testLines, "test").contains("rpcport=14023"))
+
+        val (regtest, regLines) = write("regtest", NodeNetwork.REGTEST, 0)
+        assertEquals(18443, regtest.port)
+        assertTrue(section(regLines, null).contains("regtest=1"))
+        assertTrue(section(regLines, "regtest").contains("rpcport=18443"))
+    }
+
+    @Test
+    fun instancesGetDistinctPorts() {
+        val ports = NodeNetwork.values().flatMap { network ->
+            (0 until 3).map { instance -> write("${network.name}-$instance", network, instance).first.port }
+        }
+        assertEquals(ports.size, ports.toSet().size)
+        assertNotEquals(NodeNetwork.MAIN.rpcPort(0), NodeNetwork.MAIN.rpcPort(1))
+    }
+
+    @Test
+    fun rewriteKeepsTheLoginAndTakesTheNewPort() {
+        val (first, _) = write("node", NodeNetwork.MAIN, 0)
+        val (second, lines) = write("node", NodeNetwork.MAIN, 2)
+        assertEquals(first.user, second.user)
+        assertEquals(first.password, second.password)
+        assertEquals(NodeNetwork.MAIN.rpcPort(2), second.port)
+        assertEquals(listOf("rpcport=${second.port}"), lines.filter { it.startsWith("rpcport=") })
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+// C API of libdigibyted.so, DigiByte Core linked as a shared library so the
+// app can run the node in-process instead of fork/exec'ing an extracted
+// binary. The JNI bridge dlopen()s the library and falls back to the
+// supervised child process when it is not packaged.
+//
+// Core keeps its state in process-wide globals, so one process can host the
+// node once: after dgbd_shutdown() a new dgbd_init() fails and the caller has
+// to run the daemon out of process (or restart the app process).
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DGBD_EXPORT __attribute__((visibility("default")))
+
+// Bumped whenever a signature below changes.
+#define DGBD_API_VERSION 1
+
+enum dgbd_state {
+    DGBD_STATE_IDLE = 0,
+    DGBD_STATE_STARTING = 1,   // parsing config, loading block index
+    DGBD_STATE_RUNNING = 2,    // init finished, RPC dispatch available
+    DGBD_STATE_STOPPING = 3,
+    DGBD_STATE_STOPPED = 4,
+    DGBD_STATE_FAILED = 5,     // init failed; see dgbd_exit_status()
+};
+
+DGBD_EXPORT int dgbd_api_version(void);
+
+// Start the node on a background thread with digibyted-style arguments
+// (argv[0] is the program name). Returns 0 once the init thread is running;
+// start-up continues asynchronously and is observable via dgbd_get_state().
+// On failure returns -1 and writes a NUL-terminated message into error.
+DGBD_EXPORT int dgbd_init(int argc, const char *const *argv, char *error, size_t error_len);
+
+// Request shutdown without waiting, like SIGTERM to digibyted.
+DGBD_EXPORT void dgbd_interrupt(void);
+
+// Request shutdown and wait up to timeout_ms for it to complete. Returns the
+// node's exit status, or -1 if it is still shutting down.
+DGBD_EXPORT int dgbd_shutdown(int timeout_ms);
+
+DGBD_EXPORT int dgbd_get_state(void);
+DGBD_EXPORT int dgbd_exit_status(void);
+
+// Dispatch a JSON-RPC request object or batch array directly to the RPC table,
+// bypassing HTTP and authentication. Returns a malloc'd reply to be released
+// with dgbd_free(), or NULL if the node is not accepting RPC.
+DGBD_EXPORT char *dgbd_rpc(const char *request_json);
+DGBD_EXPORT void dgbd_free(char *ptr);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,323 @@
+// In-process entry points for DigiByte Core (v8.26, Bitcoin Core 26 init API).
+// Mirrors src/digibyted.cpp: the same AppInit* sequence, minus daemonizing and
+// the process-wide parts of the basic setup, driven from a dedicated init
+// thread.
+
+#if defined(HAVE_CONFIG_H)
+#include <config/digibyte-config.h>
+#endif
+
+#include "digibyted_api.h"
+
+#include <common/args.h>
+#include <common/init.h>
+#include <common/system.h>
+#include <common/url.h>
+#include <init.h>
+#include <interfaces/chain.h>
+#include <interfaces/init.h>
+#include <kernel/context.h>
+#include <node/context.h>
+#include <node/interface_ui.h>
+#include <noui.h>
+#include <rpc/protocol.h>
+#include <rpc/request.h>
+#include <rpc/server.h>
+#include <shutdown.h>
+#include <tinyformat.h>
+#include <univalue.h>
+#include <util/check.h>
+#include <util/exception.h>
+#include <util/threadnames.h>
+#include <util/translation.h>
+#ifdef ENABLE_WALLET
+#include <interfaces/wallet.h>
+#endif
+
+#include <signal.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// Normally provided by digibyted.cpp, which is not part of this library.
+const std::function<std::string(const char *)> G_TRANSLATION_FUN = nullptr;
+UrlDecodeFn *const URL_DECODE = urlDecode;
+
+namespace {
+
+// interfaces::Init for the embedded node; equivalent of init/digibyted.cpp.
+class EmbeddedInit : public interfaces::Init {
+public:
+    explicit EmbeddedInit(node::NodeContext &node) : m_node(node) {
+        InitContext(m_node);
+        m_node.init = this;
+    }
+    std::unique_ptr<interfaces::Chain> makeChain() override { return interfaces::MakeChain(m_node); }
+#ifdef ENABLE_WALLET
+    std::unique_ptr<interfaces::WalletLoader> makeWalletLoader(interfaces::Chain &chain) override {
+        return interfaces::MakeWalletLoader(chain, *Assert(m_node.args));
+    }
+#endif
+    node::NodeContext &m_node;
+};
+
+std::mutex g_mutex;
+std::condition_variable g_changed;
+std::thread g_thread;
+std::atomic<int> g_state{DGBD_STATE_IDLE};
+// RPC calls currently executing against g_node; Shutdown() waits for them.
+int g_rpc_in_flight = 0;
+bool g_accept_rpc = false;
+
+// Core globals are not re-initializable, so the context lives for the whole
+// process and is only ever used by one dgbd_init().
+node::NodeContext &Node() {
+    static node::NodeContext *node = new node::NodeContext();
+    return *node;
+}
+
+void SetState(int state) {
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_state.store(state);
+        g_accept_rpc = state == DGBD_STATE_RUNNING;
+    }
+    g_changed.notify_all();
+}
+
+void CopyError(const std::string &message, char *error, size_t error_len) {
+    if (error == nullptr || error_len == 0) {
+        return;
+    }
+    const size_t length = std::min(message.size(), error_len - 1);
+    memcpy(error, message.data(), length);
+    error[length] = '\0';
+}
+
+// The parts of AppInitBasicSetup() that only concern Core. The rest acts on
+// the whole process, which here is the app: SIGTERM/SIGINT/SIGHUP handlers,
+// SIGPIPE set to SIG_IGN, umask(077) and std::set_new_handler would change
+// how ART and every other library in it behave. Shutdown goes through
+// dgbd_shutdown() instead of signals, app processes already run with umask
+// 077, and SIGPIPE is blocked on the node's threads only (NodeThread).
+bool AppInitBasicSetupEmbedded(node::NodeContext &node) {
+    if (!InitShutdownState(node.exit_status)) {
+        return InitError(Untranslated("Initializing wait-for-shutdown state failed."));
+    }
+    if (!SetupNetworking()) {
+        return InitError(Untranslated("Initializing networking failed."));
+    }
+    return true;
+}
+
+// The body of digibyted's AppInit() without the -daemon fork.
+bool AppInitEmbedded(node::NodeContext &node, std::vector<std::string> args_storage) {
+    ArgsManager &args = *Assert(node.args);
+    std::vector<const char *> argv;
+    argv.reserve(args_storage.size());
+    for (const std::string &arg : args_storage) {
+        argv.push_back(arg.c_str());
+    }
+
+    SetupServerArgs(args);
+    std::string error;
+    if (!args.ParseParameters(static_cast<int>(argv.size()), argv.data(), error)) {
+        return InitError(Untranslated(strprintf("Error parsing command line arguments: %s", error)));
+    }
+    if (auto config_error = common::InitConfig(args)) {
+        return InitError(config_error->message, config_error->details);
+    }
+
+    bool ok = false;
+    try {
+        args.SoftSetBoolArg("-server", true);
+        // Nobody reads the app's stdout; debug.log is the only sink.
+        args.SoftSetBoolArg("-printtoconsole", false);
+        InitLogging(args);
+        InitParameterInteraction(args);
+        if (!AppInitBasicSetupEmbedded(node)) {
+            return false;
+        }
+        if (!AppInitParameterInteraction(args)) {
+            return false;
+        }
+        node.kernel = std::make_unique<kernel::Context>();
+        if (!AppInitSanityChecks(*node.kernel)) {
+            return false;
+        }
+        if (!AppInitLockDataDirectory()) {
+            return false;
+        }
+        ok = AppInitInterfaces(node) && AppInitMain(node);
+    } catch (const std::exception &e) {
+        PrintExceptionContinue(&e, "AppInitEmbedded()");
+    } catch (...) {
+        PrintExceptionContinue(nullptr, "AppInitEmbedded()");
+    }
+    return ok;
+}
+
+void NodeThread(std::vector<std::string> args) {
+    util::ThreadSetInternalName("init");
+    // Every Core thread is started from this one and inherits its signal
+    // mask: a write to a peer that hung up then fails with EPIPE on that
+    // thread rather than raising SIGPIPE, which would kill the app.
+    sigset_t sigpipe;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, nullptr);
+
+    node::NodeContext &node = Node();
+    EmbeddedInit init(node);
+
+    SetupEnvironment();
+    noui_connect();
+
+    if (AppInitEmbedded(node, std::move(args))) {
+        SetState(DGBD_STATE_RUNNING);
+        WaitForShutdown();
+    } else {
+        node.exit_status = EXIT_FAILURE;
+        SetState(DGBD_STATE_FAILED);
+    }
+
+    {
+        // Stop dispatching new in-process RPC and let running calls finish
+        // before the chainstate they use is torn down.
+        std::unique_lock<std::mutex> lock(g_mutex);
+        g_accept_rpc = false;
+        if (g_state.load() != DGBD_STATE_FAILED) {
+            g_state.store(DGBD_STATE_STOPPING);
+        }
+        g_changed.wait(lock, [] { return g_rpc_in_flight == 0; });
+    }
+    Interrupt(node);
+    Shutdown(node);
+    if (g_state.load() != DGBD_STATE_FAILED) {
+        SetState(DGBD_STATE_STOPPED);
+    } else {
+        g_changed.notify_all();
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+int dgbd_api_version(void) { return DGBD_API_VERSION; }
+
+int dgbd_init(int argc, const char *const *argv, char *error, size_t error_len) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_state.load() != DGBD_STATE_IDLE) {
+        CopyError("node was already started in this process", error, error_len);
+        return -1;
+    }
+    if (argc < 1 || argv == nullptr) {
+        CopyError("argv must contain at least the program name", error, error_len);
+        return -1;
+    }
+
+    std::vector<std::string> args(argv, argv + argc);
+    g_state.store(DGBD_STATE_STARTING);
+    try {
+        g_thread = std::thread(NodeThread, std::move(args));
+    } catch (const std::system_error &e) {
+        g_state.store(DGBD_STATE_FAILED);
+        CopyError(std::string("cannot start node thread: ") + e.what(), error, error_len);
+        return -1;
+    }
+    return 0;
+}
+
+void dgbd_interrupt(void) {
+    if (g_state.load() != DGBD_STATE_IDLE) {
+        StartShutdown();
+    }
+}
+
+int dgbd_shutdown(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    if (!g_thread.joinable()) {
+        return Node().exit_status.load();
+    }
+    StartShutdown();
+    const bool done = g_changed.wait_for(lock, std::chrono::milliseconds(timeout_ms > 0 ? timeout_ms : 0), [] {
+        const int state = g_state.load();
+        return state == DGBD_STATE_STOPPED || state == DGBD_STATE_FAILED;
+    });
+    if (!done) {
+        return -1;
+    }
+    std::thread finished = std::move(g_thread);
+    lock.unlock();
+    finished.join();
+    return Node().exit_status.load();
+}
+
+int dgbd_get_state(void) { return g_state.load(); }
+
+int dgbd_exit_status(void) { return Node().exit_status.load(); }
+
+char *dgbd_rpc(const char *request_json) {
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (!g_accept_rpc || request_json == nullptr) {
+            return nullptr;
+        }
+        ++g_rpc_in_flight;
+    }
+
+    // Same dispatch as the HTTP handler in httprpc.cpp, without auth.
+    JSONRPCRequest jreq;
+    jreq.context = &Node();
+    jreq.URI = "/";
+    jreq.authUser = "embedded";
+    jreq.peerAddr = "in-process";
+    std::string reply;
+    try {
+        UniValue request;
+        if (!request.read(request_json)) {
+            throw JSONRPCError(RPC_PARSE_ERROR, "Parse error");
+        }
+        if (request.isObject()) {
+            jreq.parse(request);
+            const UniValue result = tableRPC.execute(jreq);
+            reply = JSONRPCReply(result, NullUniValue, jreq.id);
+        } else if (request.isArray()) {
+            reply = JSONRPCExecBatch(jreq, request.get_array());
+        } else {
+            throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
+        }
+    } catch (const UniValue &error) {
+        reply = JSONRPCReply(NullUniValue, error, jreq.id);
+    } catch (const std::exception &e) {
+        reply = JSONRPCReply(NullUniValue, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        --g_rpc_in_flight;
+    }
+    g_changed.notify_all();
+
+    char *out = static_cast<char *>(malloc(reply.size() + 1));
+    if (out != nullptr) {
+        memcpy(out, reply.c_str(), reply.size() + 1);
+    }
+    return out;
+}
+
+void dgbd_free(char *ptr) { free(ptr); }
+
+} // extern "C"
@@ -0,0 +1,403 @@
+#include "asset_stager.h"
+
+#include "trace_recorder.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <vector>
+
+#if defined(__ANDROID__)
+#include <android/api-level.h>
+#endif
+
+#ifndef __NR_copy_file_range
+#if defined(__aarch64__)
+#define __NR_copy_file_range 285
+#elif defined(__x86_64__)
+#define __NR_copy_file_range 326
+#endif
+#endif
+
+namespace digimobile {
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+// Fallback copy buffer; large enough that syscall overhead is negligible.
+constexpr size_t kCopyBufferSize = 1 << 20;
+// sendfile() transfers at most ~2 GiB per call.
+constexpr int64_t kMaxSendfileChunk = 1 << 30;
+
+inline uint64_t Rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t Load64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t Round(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = Rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+inline uint64_t MergeRound(uint64_t acc, uint64_t lane) {
+    acc ^= Round(0, lane);
+    return acc * kPrime1 + kPrime4;
+}
+
+bool CopyFileRangeAllowed() {
+#if !defined(__NR_copy_file_range)
+    return false;
+#elif defined(__ANDROID__)
+    // Only on the app seccomp allowlist from Android 14; earlier it is SIGSYS.
+#if __ANDROID_API__ >= 29
+    return android_get_device_api_level() >= 34;
+#else
+    return false;
+#endif
+#else
+    return true;
+#endif
+}
+
+bool IsFallbackErrno(int err) {
+    return err == EXDEV || err == ENOSYS || err == EINVAL || err == EOPNOTSUPP || err == EBADF;
+}
+
+std::string ErrnoString(const std::string &what) {
+    return what + " failed: " + strerror(errno);
+}
+
+bool WriteAll(int fd, const unsigned char *data, int64_t length, std::string *error) {
+    int64_t done = 0;
+    while (done < length) {
+        const ssize_t n = write(fd, data + done, static_cast<size_t>(length - done));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            *error = ErrnoString("write");
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+// Copy [offset, offset + length) of src to the current position of dst,
+// preferring in-kernel copies that never touch a user-space buffer.
+bool CopyRange(int src, off_t offset, int64_t length, int dst, std::string *error) {
+    int64_t done = 0;
+
+#if defined(__NR_copy_file_range)
+    if (CopyFileRangeAllowed()) {
+        loff_t in = offset;
+        while (done < length) {
+            const long n = syscall(__NR_copy_file_range, src, &in, dst, nullptr,
+                                   static_cast<size_t>(length - done), 0u);
+            if (n > 0) {
+                done += n;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n == 0 || (done == 0 && IsFallbackErrno(errno))) {
+                break;
+            } else {
+                *error = ErrnoString("copy_file_range");
+                return false;
+            }
+        }
+    }
+#endif
+
+    if (done < length) {
+        off_t in = offset + done;
+        const int64_t before = done;
+        while (done < length) {
+            const ssize_t n = sendfile(dst, src, &in,
+                                       static_cast<size_t>(std::min(length - done, kMaxSendfileChunk)));
+            if (n > 0) {
+                done += n;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n == 0) {
+                *error = "source ended early";
+                return false;
+            } else if (done == before && IsFallbackErrno(errno)) {
+                break;
+            } else {
+                *error = ErrnoString("sendfile");
+                return false;
+            }
+        }
+    }
+
+    if (done < length) {
+        std::vector<unsigned char> buffer(kCopyBufferSize);
+        while (done < length) {
+            const size_t want = static_cast<size_t>(std::min<int64_t>(length - done, buffer.size()));
+            const ssize_t n = pread(src, buffer.data(), want, offset + done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                *error = n == 0 ? std::string("source ended early") : ErrnoString("pread");
+                return false;
+            }
+            if (!WriteAll(dst, buffer.data(), n, error)) {
+                return false;
+            }
+            done += n;
+        }
+    }
+    return true;
+}
+
+bool HashSource(const StageSource &source, uint64_t *out, std::string *error) {
+    if (source.data != nullptr) {
+        *out = HashBytes64(source.data, static_cast<size_t>(source.length));
+        return true;
+    }
+    if (source.length == 0) {
+        *out = HashBytes64(nullptr, 0);
+        return true;
+    }
+    // Touching a mapped page past the end of the file is SIGBUS, not an error.
+    struct stat info {};
+    if (fstat(source.fd, &info) != 0) {
+        *error = ErrnoString("fstat");
+        return false;
+    }
+    if (source.offset < 0 || source.offset + source.length > info.st_size) {
+        *error = "source ended early";
+        return false;
+    }
+    // Map the range read-only: for a stored APK entry this hashes straight out
+    // of the page cache without copying.
+    const long page = sysconf(_SC_PAGESIZE);
+    const off_t aligned = source.offset - (source.offset % page);
+    const size_t delta = static_cast<size_t>(source.offset - aligned);
+    const size_t map_length = delta + static_cast<size_t>(source.length);
+    void *mapped = mmap(nullptr, map_length, PROT_READ, MAP_PRIVATE, source.fd, aligned);
+    if (mapped == MAP_FAILED) {
+        *error = ErrnoString("mmap");
+        return false;
+    }
+    madvise(mapped, map_length, MADV_SEQUENTIAL);
+    *out = HashBytes64(static_cast<unsigned char *>(mapped) + delta, static_cast<size_t>(source.length));
+    munmap(mapped, map_length);
+    return true;
+}
+
+bool WriteStageStamp(const std::string &path, const StageStamp &stamp) {
+    const std::string tmp = path + ".tmp";
+    FILE *file = fopen(tmp.c_str(), "we");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool written = fprintf(file, "version=%s\nsize=%" PRId64 "\nhash=%016" PRIx64 "\n",
+                                 stamp.version.c_str(), stamp.size, stamp.hash) > 0;
+    if (fclose(file) != 0 || !written) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+void SyncParentDir(const std::string &path) {
+    const size_t slash = path.rfind('/');
+    const std::string dir = slash == std::string::npos ? "." : path.substr(0, std::max<size_t>(slash, 1));
+    const int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+} // namespace
+
+uint64_t HashBytes64(const void *data, size_t length, uint64_t seed) {
+    // XXH64-style: four independent lanes over 32-byte stripes, then a tail.
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    const unsigned char *const end = p + length;
+    uint64_t h;
+
+    if (length >= 32) {
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kPrime1;
+        const unsigned char *const limit = end - 32;
+        do {
+            v1 = Round(v1, Load64(p));
+            v2 = Round(v2, Load64(p + 8));
+            v3 = Round(v3, Load64(p + 16));
+            v4 = Round(v4, Load64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = Rotl(v1, 1) + Rotl(v2, 7) + Rotl(v3, 12) + Rotl(v4, 18);
+        h = MergeRound(h, v1);
+        h = MergeRound(h, v2);
+        h = MergeRound(h, v3);
+        h = MergeRound(h, v4);
+    } else {
+        h = seed + kPrime5;
+    }
+    h += static_cast<uint64_t>(length);
+
+    while (p + 8 <= end) {
+        h ^= Round(0, Load64(p));
+        h = Rotl(h, 27) * kPrime1 + kPrime4;
+        p += 8;
+    }
+    while (p < end) {
+        h ^= (*p) * kPrime5;
+        h = Rotl(h, 11) * kPrime1;
+        ++p;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+bool ReadStageStamp(const std::string &path, StageStamp *out) {
+    FILE *file = fopen(path.c_str(), "re");
+    if (file == nullptr) {
+        return false;
+    }
+    StageStamp stamp;
+    bool have_size = false;
+    bool have_hash = false;
+    char line[512];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        std::string text(line);
+        while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) {
+            text.pop_back();
+        }
+        if (text.rfind("version=", 0) == 0) {
+            stamp.version = text.substr(8);
+        } else if (text.rfind("size=", 0) == 0) {
+            stamp.size = strtoll(text.c_str() + 5, nullptr, 10);
+            have_size = true;
+        } else if (text.rfind("hash=", 0) == 0) {
+            stamp.hash = strtoull(text.c_str() + 5, nullptr, 16);
+            have_hash = true;
+        }
+    }
+    fclose(file);
+    if (!have_size || !have_hash) {
+        return false;
+    }
+    *out = std::move(stamp);
+    return true;
+}
+
+StageResult StageFile(const StageSource &source, const std::string &dest,
+                      const std::string &version, std::string *error) {
+    if (source.length < 0 || (source.data == nullptr && source.fd < 0)) {
+        *error = "invalid source";
+        return StageResult::kFailed;
+    }
+    TraceSpan span("stage", "StageFile", source.length);
+
+    const std::string stamp_path = dest + ".stamp";
+    StageStamp stamp;
+    const bool have_stamp = ReadStageStamp(stamp_path, &stamp);
+    struct stat info {};
+    const bool dest_intact = stat(dest.c_str(), &info) == 0 && S_ISREG(info.st_mode) &&
+                             info.st_size == source.length && have_stamp &&
+                             stamp.size == source.length && access(dest.c_str(), X_OK) == 0;
+
+    if (dest_intact && !version.empty() && stamp.version == version) {
+        return StageResult::kUpToDate;
+    }
+
+    uint64_t hash = 0;
+    {
+        TraceSpan hash_span("stage", "hash", source.length);
+        if (!HashSource(source, &hash, error)) {
+            return StageResult::kFailed;
+        }
+    }
+    const StageStamp fresh {version, source.length, hash};
+
+    if (dest_intact && stamp.hash == hash) {
+        if (!WriteStageStamp(stamp_path, fresh)) {
+            *error = ErrnoString("write stamp");
+            return StageResult::kFailed;
+        }
+        return StageResult::kStampRefreshed;
+    }
+
+    const std::string tmp = dest + ".tmp";
+    const int out = open(tmp.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0700);
+    if (out < 0) {
+        *error = ErrnoString("open " + tmp);
+        return StageResult::kFailed;
+    }
+    // Reserve the space up front: fails fast on a full disk and keeps the
+    // binary contiguous.
+    if (source.length > 0) {
+        posix_fallocate(out, 0, source.length);
+    }
+    bool ok;
+    {
+        TraceSpan copy_span("stage", "copy", source.length);
+        ok = source.data != nullptr
+                ? WriteAll(out, static_cast<const unsigned char *>(source.data), source.length, error)
+                : CopyRange(source.fd, source.offset, source.length, out, error);
+    }
+    if (ok && fchmod(out, 0700) != 0) {
+        *error = ErrnoString("fchmod");
+        ok = false;
+    }
+    if (ok) {
+        TraceSpan fsync_span("stage", "fsync");
+        if (fsync(out) != 0) {
+            *error = ErrnoString("fsync");
+            ok = false;
+        }
+    }
+    if (close(out) != 0 && ok) {
+        *error = ErrnoString("close");
+        ok = false;
+    }
+    if (ok && rename(tmp.c_str(), dest.c_str()) != 0) {
+        *error = ErrnoString("rename");
+        ok = false;
+    }
+    if (!ok) {
+        unlink(tmp.c_str());
+        return StageResult::kFailed;
+    }
+    SyncParentDir(dest);
+
+    if (!WriteStageStamp(stamp_path, fresh)) {
+        // The binary is in place; without a stamp the next start just re-hashes.
+        unlink(stamp_path.c_str());
+    }
+    return StageResult::kCopied;
+}
+
+} // namespace digimobile
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+
+namespace digimobile {
+
+// Bytes to stage. Either a file range (an uncompressed APK asset opened with
+// AAsset_openFileDescriptor64, or any regular file) or a memory buffer.
+struct StageSource {
+    int fd = -1;
+    off_t offset = 0;
+    const void *data = nullptr;
+    int64_t length = 0;
+};
+
+// Recorded next to a staged file as "<dest>.stamp".
+struct StageStamp {
+    std::string version;  // caller-supplied, e.g. app versionCode + install time
+    int64_t size = -1;
+    uint64_t hash = 0;    // HashBytes64 of the content
+};
+
+enum class StageResult {
+    kUpToDate,        // same version stamp, nothing read or written
+    kStampRefreshed,  // new version but identical content; only the stamp changed
+    kCopied,          // content (re)written
+    kFailed,
+};
+
+// Fast non-cryptographic 64-bit content hash (change detection only).
+uint64_t HashBytes64(const void *data, size_t length, uint64_t seed = 0);
+
+bool ReadStageStamp(const std::string &path, StageStamp *out);
+
+// Make dest an executable copy of source. Unchanged content is never
+// rewritten and changed content always is: when the version differs from the
+// stamp the source is hashed and compared. Copies go kernel-side
+// (copy_file_range, then sendfile) into "<dest>.tmp", which is fsync'd and
+// renamed over dest, so a crash never leaves a truncated binary behind.
+StageResult StageFile(const StageSource &source, const std::string &dest,
+                      const std::string &version, std::string *error);
+
+} // namespace digimobile
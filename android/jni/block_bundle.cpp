@@ -0,0 +1,438 @@
+#include "block_bundle.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "sha256.h"
+#include "trace_recorder.h"
+
+namespace digimobile {
+namespace {
+
+// Headers are checked and fed in runs of this many, so neither pass holds more
+// than a few hundred KiB of a file that grows by 80 bytes a block.
+constexpr size_t kHeadersPerRead = 4096;
+// How long a blocked write or a wait for the daemon sleeps before looking at
+// Interrupt() again.
+constexpr int kPollIntervalMs = 200;
+
+void PutU32(std::string *out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out->push_back(static_cast<char>(v >> (8 * i)));
+    }
+}
+
+uint32_t GetU32(const unsigned char *p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+std::string ErrnoString(const std::string &what) {
+    return what + ": " + strerror(errno);
+}
+
+int HexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Reads exactly the requested number of bytes from the current position.
+// Returns 0 on success, the number of bytes missing at end of file, or -1 on
+// an I/O error.
+ssize_t ReadExact(int fd, unsigned char *out, size_t length) {
+    while (length > 0) {
+        const ssize_t n = read(fd, out, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        if (n == 0) {
+            return static_cast<ssize_t>(length);
+        }
+        out += n;
+        length -= static_cast<size_t>(n);
+    }
+    return 0;
+}
+
+// The prev-block field of a header.
+const unsigned char *PrevHash(const unsigned char *header) {
+    return header + 4;
+}
+
+} // namespace
+
+std::string SerializeHeadersPreamble(const BundleHeadersInfo &info) {
+    std::string out(kHeadersMagic, sizeof(kHeadersMagic));
+    out.append(reinterpret_cast<const char *>(info.network_magic), sizeof(info.network_magic));
+    PutU32(&out, info.start_height);
+    PutU32(&out, info.count);
+    out.append(reinterpret_cast<const char *>(info.prev_hash), sizeof(info.prev_hash));
+    return out;
+}
+
+bool ParseHeadersPreamble(const unsigned char *data, size_t length, BundleHeadersInfo *out,
+                          std::string *error) {
+    if (length < kHeadersPreambleSize) {
+        *error = "truncated headers preamble";
+        return false;
+    }
+    if (memcmp(data, kHeadersMagic, sizeof(kHeadersMagic)) != 0) {
+        *error = "not a bundle headers file";
+        return false;
+    }
+    const unsigned char *p = data + sizeof(kHeadersMagic);
+    BundleHeadersInfo info;
+    memcpy(info.network_magic, p, sizeof(info.network_magic));
+    p += sizeof(info.network_magic);
+    info.start_height = GetU32(p);
+    info.count = GetU32(p + 4);
+    memcpy(info.prev_hash, p + 8, sizeof(info.prev_hash));
+    *out = info;
+    return true;
+}
+
+void BlockHeaderHash(const unsigned char *header, unsigned char out[32]) {
+    Sha256 hasher;
+    unsigned char first[Sha256::kDigestSize];
+    hasher.Update(header, kBlockHeaderSize);
+    hasher.Finish(first);
+    hasher.Update(first, sizeof(first));
+    hasher.Finish(out);
+}
+
+std::string BlockHashToHex(const unsigned char hash[32]) {
+    unsigned char reversed[32];
+    for (size_t i = 0; i < 32; ++i) {
+        reversed[i] = hash[31 - i];
+    }
+    return HexDigest(reversed, sizeof(reversed));
+}
+
+bool BlockHashFromHex(const std::string &hex, unsigned char out[32]) {
+    if (hex.size() != 64) {
+        return false;
+    }
+    for (size_t i = 0; i < 32; ++i) {
+        const int high = HexValue(hex[2 * i]);
+        const int low = HexValue(hex[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        out[31 - i] = static_cast<unsigned char>(high << 4 | low);
+    }
+    return true;
+}
+
+BlockBundleFeeder::BlockBundleFeeder(std::string blocks_path, std::string headers_path)
+    : blocks_path_(std::move(blocks_path)), headers_path_(std::move(headers_path)) {}
+
+BlockBundleFeeder::~BlockBundleFeeder() {
+    ClosePipe();
+}
+
+bool BlockBundleFeeder::Verify(const std::string &expected_sha256,
+                               const std::string &expected_prev_hash, std::string *error) {
+    TraceSpan span("bootstrap", "VerifyBundleHeaders");
+    verified_ = false;
+    unsigned char expected_prev[32];
+    if (!expected_prev_hash.empty() && !BlockHashFromHex(expected_prev_hash, expected_prev)) {
+        *error = "bad expected previous block hash";
+        return false;
+    }
+
+    const int fd = open(headers_path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        *error = ErrnoString("open " + headers_path_);
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        *error = ErrnoString("stat " + headers_path_);
+        close(fd);
+        return false;
+    }
+#if defined(POSIX_FADV_SEQUENTIAL)
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    Sha256 file_hash;
+    unsigned char preamble[kHeadersPreambleSize];
+    BundleHeadersInfo info;
+    if (ReadExact(fd, preamble, sizeof(preamble)) != 0) {
+        *error = "truncated headers preamble";
+        close(fd);
+        return false;
+    }
+    if (!ParseHeadersPreamble(preamble, sizeof(preamble), &info, error)) {
+        close(fd);
+        return false;
+    }
+    file_hash.Update(preamble, sizeof(preamble));
+    if (info.count == 0 ||
+        static_cast<uint64_t>(st.st_size) !=
+                kHeadersPreambleSize + static_cast<uint64_t>(info.count) * kBlockHeaderSize) {
+        *error = "headers file size does not match its count of " + std::to_string(info.count);
+        close(fd);
+        return false;
+    }
+    if (!expected_prev_hash.empty() && memcmp(info.prev_hash, expected_prev, 32) != 0) {
+        *error = "bundle extends " + BlockHashToHex(info.prev_hash) + ", not " +
+                 expected_prev_hash;
+        close(fd);
+        return false;
+    }
+
+    std::vector<unsigned char> buffer(kHeadersPerRead * kBlockHeaderSize);
+    unsigned char prev[32];
+    memcpy(prev, info.prev_hash, sizeof(prev));
+    uint32_t checked = 0;
+    while (checked < info.count) {
+        const size_t run = std::min<size_t>(kHeadersPerRead, info.count - checked);
+        if (ReadExact(fd, buffer.data(), run * kBlockHeaderSize) != 0) {
+            *error = ErrnoString("read " + headers_path_);
+            close(fd);
+            return false;
+        }
+        file_hash.Update(buffer.data(), run * kBlockHeaderSize);
+        for (size_t i = 0; i < run; ++i) {
+            const unsigned char *header = buffer.data() + i * kBlockHeaderSize;
+            if (memcmp(PrevHash(header), prev, sizeof(prev)) != 0) {
+                *error = "header at height " +
+                         std::to_string(info.start_height + checked + i) +
+                         " does not link to the one before it";
+                close(fd);
+                return false;
+            }
+            BlockHeaderHash(header, prev);
+        }
+        checked += static_cast<uint32_t>(run);
+    }
+    close(fd);
+
+    if (!expected_sha256.empty()) {
+        const std::string actual = file_hash.FinishHex();
+        if (actual != expected_sha256) {
+            *error = "headers sha256 " + actual + " does not match " + expected_sha256;
+            return false;
+        }
+    }
+
+    struct stat blocks_st {};
+    if (stat(blocks_path_.c_str(), &blocks_st) != 0) {
+        *error = ErrnoString("stat " + blocks_path_);
+        return false;
+    }
+    if (static_cast<uint64_t>(blocks_st.st_size) <
+        static_cast<uint64_t>(info.count) * (8 + kBlockHeaderSize)) {
+        *error = "blocks file is too small for " + std::to_string(info.count) + " blocks";
+        return false;
+    }
+    info_ = info;
+    total_bytes_ = static_cast<uint64_t>(blocks_st.st_size);
+    verified_ = true;
+    return true;
+}
+
+bool BlockBundleFeeder::OpenPipe(const std::string &pipe_path, std::string *error) {
+    ClosePipe();
+    // A pipe left by a feed that was killed would hold stale state; start over.
+    unlink(pipe_path.c_str());
+    if (mkfifo(pipe_path.c_str(), 0600) != 0) {
+        *error = ErrnoString("mkfifo " + pipe_path);
+        return false;
+    }
+    // Opening for reading and writing never blocks, and while this end is
+    // open the daemon's open of the pipe returns at once and its reads wait
+    // for data rather than seeing the end of the file.
+    pipe_fd_ = open(pipe_path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (pipe_fd_ < 0) {
+        *error = ErrnoString("open " + pipe_path);
+        unlink(pipe_path.c_str());
+        return false;
+    }
+    pipe_path_ = pipe_path;
+    return true;
+}
+
+bool BlockBundleFeeder::Feed(std::string *error) {
+    TraceSpan span("bootstrap", "FeedBlockBundle");
+    if (!verified_) {
+        *error = "bundle has not been verified";
+        return false;
+    }
+    if (pipe_fd_ < 0) {
+        *error = "pipe is not open";
+        return false;
+    }
+    const int blocks_fd = open(blocks_path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (blocks_fd < 0) {
+        *error = ErrnoString("open " + blocks_path_);
+        ClosePipe();
+        return false;
+    }
+    const int headers_fd = open(headers_path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (headers_fd < 0) {
+        *error = ErrnoString("open " + headers_path_);
+        close(blocks_fd);
+        ClosePipe();
+        return false;
+    }
+#if defined(POSIX_FADV_SEQUENTIAL)
+    posix_fadvise(blocks_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    posix_fadvise(headers_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    std::vector<unsigned char> headers(kHeadersPerRead * kBlockHeaderSize);
+    size_t headers_left = 0;
+    const unsigned char *header = nullptr;
+    std::vector<unsigned char> record;
+    bool ok = lseek(headers_fd, kHeadersPreambleSize, SEEK_SET) >= 0;
+    if (!ok) {
+        *error = ErrnoString("seek " + headers_path_);
+    }
+    for (uint32_t i = 0; ok && i < info_.count; ++i) {
+        if (interrupted_.load()) {
+            *error = "interrupted";
+            ok = false;
+            break;
+        }
+        const std::string height = std::to_string(info_.start_height + i);
+        if (headers_left == 0) {
+            const size_t run = std::min<size_t>(kHeadersPerRead, info_.count - i);
+            if (ReadExact(headers_fd, headers.data(), run * kBlockHeaderSize) != 0) {
+                *error = ErrnoString("read " + headers_path_);
+                ok = false;
+                break;
+            }
+            headers_left = run;
+            header = headers.data();
+        }
+
+        unsigned char prefix[8];
+        const ssize_t missing = ReadExact(blocks_fd, prefix, sizeof(prefix));
+        if (missing != 0) {
+            *error = missing < 0 ? ErrnoString("read " + blocks_path_)
+                                 : "bundle ends before block " + height;
+            ok = false;
+            break;
+        }
+        const uint32_t size = GetU32(prefix + 4);
+        if (memcmp(prefix, info_.network_magic, sizeof(info_.network_magic)) != 0 ||
+            size < kBlockHeaderSize || size > kMaxBundleBlockSize) {
+            *error = "bad record for block " + height;
+            ok = false;
+            break;
+        }
+        record.resize(sizeof(prefix) + size);
+        memcpy(record.data(), prefix, sizeof(prefix));
+        if (ReadExact(blocks_fd, record.data() + sizeof(prefix), size) != 0) {
+            *error = "bundle ends inside block " + height;
+            ok = false;
+            break;
+        }
+        if (memcmp(record.data() + sizeof(prefix), header, kBlockHeaderSize) != 0) {
+            *error = "block " + height + " does not match its header";
+            ok = false;
+            break;
+        }
+        header += kBlockHeaderSize;
+        --headers_left;
+
+        if (!WriteAll(record.data(), record.size(), error)) {
+            ok = false;
+            break;
+        }
+        fed_blocks_.fetch_add(1);
+        fed_bytes_.fetch_add(record.size());
+    }
+    close(headers_fd);
+    close(blocks_fd);
+
+    if (ok) {
+        ok = WaitDrained(error);
+    }
+    ClosePipe();
+    return ok;
+}
+
+void BlockBundleFeeder::Interrupt() {
+    interrupted_.store(true);
+}
+
+bool BlockBundleFeeder::WriteAll(const unsigned char *data, size_t length, std::string *error) {
+    while (length > 0) {
+        const ssize_t n = write(pipe_fd_, data, length);
+        if (n > 0) {
+            data += n;
+            length -= static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EINTR) {
+            *error = ErrnoString("write " + pipe_path_);
+            return false;
+        }
+        if (interrupted_.load()) {
+            *error = "interrupted";
+            return false;
+        }
+        // The pipe is full until the daemon reads; it may not have opened it yet.
+        pollfd pfd{pipe_fd_, POLLOUT, 0};
+        poll(&pfd, 1, kPollIntervalMs);
+    }
+    return true;
+}
+
+bool BlockBundleFeeder::WaitDrained(std::string *error) {
+    // Closing the pipe while blocks are still buffered in it would drop them,
+    // so the tail of the bundle waits for the daemon to read it.
+    for (;;) {
+        int pending = 0;
+        if (ioctl(pipe_fd_, FIONREAD, &pending) != 0) {
+            *error = ErrnoString("ioctl " + pipe_path_);
+            return false;
+        }
+        if (pending == 0) {
+            return true;
+        }
+        if (interrupted_.load()) {
+            *error = "interrupted";
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(kPollIntervalMs / 4));
+    }
+}
+
+void BlockBundleFeeder::ClosePipe() {
+    if (pipe_fd_ >= 0) {
+        close(pipe_fd_);
+        pipe_fd_ = -1;
+    }
+    if (!pipe_path_.empty()) {
+        unlink(pipe_path_.c_str());
+        pipe_path_.clear();
+    }
+}
+
+} // namespace digimobile
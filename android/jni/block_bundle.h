@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace digimobile {
+
+// Block bundle: a stretch of the chain exported by another node (a desktop
+// node on the LAN, a USB drive), so a device can import it instead of fetching
+// every block from peers. Two files, written by tools/block_bundle.cpp:
+//
+//   <bundle>          the blocks in height order, each as u8[4] network magic,
+//                     u32 size, serialized block: the blk?????.dat layout that
+//                     digibyted reads with -loadblock
+//   <bundle>.headers  "DGBHDRS1", u8[4] network magic, u32 start height,
+//                     u32 count, u8[32] hash of the block before the first,
+//                     then count 80-byte block headers
+//
+// Integers are little endian and hashes in internal byte order (reversed from
+// how RPC prints them). The headers file is the small, checkable part: its
+// SHA-256 can be pinned and every header must link to the one before it, so
+// the blocks are known to form one chain before any of them is read.
+constexpr char kHeadersMagic[8] = {'D', 'G', 'B', 'H', 'D', 'R', 'S', '1'};
+constexpr size_t kHeadersPreambleSize = sizeof(kHeadersMagic) + 4 + 4 + 4 + 32;
+constexpr size_t kBlockHeaderSize = 80;
+// Far above any DigiByte block; only guards against a corrupt size field.
+constexpr uint32_t kMaxBundleBlockSize = 32u << 20;
+
+struct BundleHeadersInfo {
+    unsigned char network_magic[4] = {};
+    uint32_t start_height = 0;
+    uint32_t count = 0;
+    unsigned char prev_hash[32] = {};
+};
+
+std::string SerializeHeadersPreamble(const BundleHeadersInfo &info);
+bool ParseHeadersPreamble(const unsigned char *data, size_t length, BundleHeadersInfo *out,
+                          std::string *error);
+
+// Double SHA-256 of a block header, which is the block hash.
+void BlockHeaderHash(const unsigned char *header, unsigned char out[32]);
+// Between internal byte order and the reversed hex RPC uses.
+std::string BlockHashToHex(const unsigned char hash[32]);
+bool BlockHashFromHex(const std::string &hex, unsigned char out[32]);
+
+// Streams a bundle into digibyted through a named pipe passed as
+// -loadblock=<pipe>, so the blocks go from the source file into the daemon's
+// own block files without another copy on the device. Each block is checked
+// against its verified header on the way; digibyted still validates it fully.
+//
+// Verify() and OpenPipe() run before the node starts, Feed() while it runs, on
+// one thread. Interrupt() and the progress counters may be used from any.
+class BlockBundleFeeder {
+public:
+    BlockBundleFeeder(std::string blocks_path, std::string headers_path);
+    ~BlockBundleFeeder();
+    BlockBundleFeeder(const BlockBundleFeeder &) = delete;
+    BlockBundleFeeder &operator=(const BlockBundleFeeder &) = delete;
+
+    // Read the headers file and check that it forms one chain. A non-empty
+    // expected_sha256 (hex) pins the file, a non-empty expected_prev_hash (RPC
+    // hex) the block the bundle extends.
+    bool Verify(const std::string &expected_sha256, const std::string &expected_prev_hash,
+                std::string *error);
+
+    // Create the pipe and hold it open, so the daemon's open neither blocks
+    // nor fails however its start and Feed() interleave.
+    bool OpenPipe(const std::string &pipe_path, std::string *error);
+
+    // Hand every block to the daemon, returning once it has read them all.
+    // Stops at the first block that does not match its header, or on
+    // Interrupt(). The pipe is closed and removed either way, which the daemon
+    // sees as the end of the file.
+    bool Feed(std::string *error);
+
+    void Interrupt();
+
+    const BundleHeadersInfo &info() const { return info_; }
+    uint64_t fed_blocks() const { return fed_blocks_.load(); }
+    uint64_t fed_bytes() const { return fed_bytes_.load(); }
+    uint64_t total_bytes() const { return total_bytes_; }
+
+private:
+    bool WriteAll(const unsigned char *data, size_t length, std::string *error);
+    bool WaitDrained(std::string *error);
+    void ClosePipe();
+
+    const std::string blocks_path_;
+    const std::string headers_path_;
+    std::string pipe_path_;
+    int pipe_fd_ = -1;
+    bool verified_ = false;
+    BundleHeadersInfo info_;
+    uint64_t total_bytes_ = 0;
+    std::atomic<bool> interrupted_{false};
+    std::atomic<uint64_t> fed_blocks_{0};
+    std::atomic<uint64_t> fed_bytes_{0};
+};
+
+} // namespace digimobile
@@ -0,0 +1,161 @@
+#include "datadir_cache.h"
+
+#include "node_supervisor.h"
+#include "resource_governor.h"
+#include "trace_recorder.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace digimobile {
+namespace {
+
+struct DbFile {
+    std::string path;
+    int64_t size;
+    int64_t mtime;
+};
+
+bool IsDir(const std::string &path) {
+    struct stat info {};
+    return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+void AddDbFiles(const std::string &dir, std::vector<DbFile> *out) {
+    DIR *handle = opendir(dir.c_str());
+    if (!handle) {
+        return;
+    }
+    while (dirent *entry = readdir(handle)) {
+        // LOCK is empty and held by the daemon; everything else (tables, the
+        // write-ahead log, MANIFEST, CURRENT) is read while opening the DB.
+        if (entry->d_name[0] == '.' || strcmp(entry->d_name, "LOCK") == 0) {
+            continue;
+        }
+        std::string path = dir + "/" + entry->d_name;
+        struct stat info {};
+        if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            out->push_back({std::move(path), static_cast<int64_t>(info.st_size),
+                            static_cast<int64_t>(info.st_mtime)});
+        }
+    }
+    closedir(handle);
+}
+
+// Mainnet keeps its databases in data_dir itself; testnet and regtest in a
+// subdirectory named after the network.
+std::vector<DbFile> ListDbFiles(const std::string &data_dir) {
+    std::vector<std::string> roots{data_dir};
+    if (DIR *handle = opendir(data_dir.c_str())) {
+        while (dirent *entry = readdir(handle)) {
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            const std::string sub = data_dir + "/" + entry->d_name;
+            if (IsDir(sub + "/chainstate")) {
+                roots.push_back(sub);
+            }
+        }
+        closedir(handle);
+    }
+    std::vector<DbFile> files;
+    for (const std::string &root : roots) {
+        AddDbFiles(root + "/chainstate", &files);
+        AddDbFiles(root + "/blocks/index", &files);
+    }
+    return files;
+}
+
+} // namespace
+
+PrewarmStats PrewarmDatadir(const std::string &data_dir, const PrewarmOptions &options) {
+    TraceSpan span("node", "PrewarmDatadir");
+    const int64_t started_ms = MonotonicMillis();
+    PrewarmStats stats;
+
+    int64_t budget = options.budget_bytes;
+    DeviceState device;
+    ReadDeviceState(&device);
+    if (device.mem_available_kb > 0) {
+        budget = std::min(budget, device.mem_available_kb * 1024 / 4);
+    }
+
+    // Recently written tables hold the most recent coins and the tip's block
+    // index, which start-up touches first; old, compacted levels come last.
+    std::vector<DbFile> files = ListDbFiles(data_dir);
+    std::sort(files.begin(), files.end(),
+              [](const DbFile &a, const DbFile &b) { return a.mtime > b.mtime; });
+    // A file that does not fit (typically a large table of an old level) is
+    // passed over, so the smaller ones after it still get the rest.
+    std::vector<DbFile> chosen;
+    int64_t used = 0;
+    for (DbFile &file : files) {
+        if (used + file.size > budget) {
+            continue;
+        }
+        used += file.size;
+        chosen.push_back(std::move(file));
+    }
+    files.swap(chosen);
+
+    std::atomic<size_t> next{0};
+    std::atomic<int> warmed{0};
+    std::atomic<int64_t> bytes{0};
+    auto worker = [&] {
+        for (size_t i = next++; i < files.size(); i = next++) {
+            const int fd = open(files[i].path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                continue;
+            }
+            // readahead() blocks until the pages are read; fall back to the
+            // asynchronous hint where it is not allowed.
+            if (readahead(fd, 0, static_cast<size_t>(files[i].size)) == 0 ||
+                posix_fadvise(fd, 0, files[i].size, POSIX_FADV_WILLNEED) == 0) {
+                ++warmed;
+                bytes += files[i].size;
+            }
+            close(fd);
+        }
+    };
+    const int threads = std::max(1, std::min<int>(options.threads, static_cast<int>(files.size())));
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+
+    stats.files = warmed.load();
+    stats.bytes = bytes.load();
+    stats.elapsed_ms = MonotonicMillis() - started_ms;
+    span.set_arg(stats.bytes);
+    return stats;
+}
+
+int64_t EvictDatadir(const std::string &data_dir) {
+    int64_t bytes = 0;
+    for (const DbFile &file : ListDbFiles(data_dir)) {
+        const int fd = open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        if (posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0) {
+            bytes += file.size;
+        }
+        close(fd);
+    }
+    return bytes;
+}
+
+} // namespace digimobile
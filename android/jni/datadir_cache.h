@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace digimobile {
+
+struct PrewarmOptions {
+    int threads = 4;
+    // Upper bound on what is pulled into the page cache; further capped at a
+    // quarter of MemAvailable so prewarming never pushes the app out.
+    int64_t budget_bytes = 256ll << 20;
+};
+
+struct PrewarmStats {
+    int files = 0;
+    int64_t bytes = 0;
+    int64_t elapsed_ms = 0;
+};
+
+// Read the LevelDB files digibyted opens first at start-up (chainstate/ and
+// blocks/index/, for every network under data_dir) into the page cache with
+// readahead(), newest first, on several threads. Blocks until done, so the
+// daemon execs against a warm cache instead of faulting them in one by one.
+PrewarmStats PrewarmDatadir(const std::string &data_dir, const PrewarmOptions &options);
+
+// Drop the same files from the page cache (POSIX_FADV_DONTNEED), so host
+// benchmarks can time a start-up from cold storage. Returns the bytes advised.
+int64_t EvictDatadir(const std::string &data_dir);
+
+} // namespace digimobile
@@ -0,0 +1,342 @@
+#include "debug_log_tailer.h"
+
+#include "trace_recorder.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace digimobile {
+namespace {
+
+constexpr size_t kReadChunkSize = 64 * 1024;
+// On start, look back this far so the most recent tip is reported at once.
+constexpr off_t kStartBacklogBytes = 64 * 1024;
+// Safety net for missed inotify events (e.g. the directory watch was lost).
+constexpr int kIdleRecheckMs = 2000;
+// Lines longer than this are not log lines we care about; drop them.
+constexpr size_t kMaxLineLength = 16 * 1024;
+// Log records carry at most this much of their line.
+constexpr size_t kMaxRecordMessage = 512;
+
+int64_t NowMillis() {
+    timespec ts {};
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Return the text following key up to the next space, or an empty view.
+std::string_view FieldValue(std::string_view line, std::string_view key) {
+    const size_t pos = line.find(key);
+    if (pos == std::string_view::npos) {
+        return {};
+    }
+    const size_t start = pos + key.size();
+    const size_t end = line.find(' ', start);
+    return line.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+}
+
+int64_t ParseIsoTime(std::string_view value) {
+    // 2024-05-01T12:34:56Z
+    if (value.size() < 19) {
+        return 0;
+    }
+    std::string text(value.substr(0, 19));
+    tm parts {};
+    if (sscanf(text.c_str(), "%4d-%2d-%2dT%2d:%2d:%2d", &parts.tm_year, &parts.tm_mon,
+               &parts.tm_mday, &parts.tm_hour, &parts.tm_min, &parts.tm_sec) != 6) {
+        return 0;
+    }
+    parts.tm_year -= 1900;
+    parts.tm_mon -= 1;
+    return static_cast<int64_t>(timegm(&parts));
+}
+
+// Drop the "2024-05-01T12:34:56Z " (or microsecond) timestamp prefix.
+std::string_view StripTimestamp(std::string_view line) {
+    if (line.size() > 20 && line[4] == '-' && line[10] == 'T') {
+        const size_t space = line.find(' ');
+        if (space != std::string_view::npos && line[space - 1] == 'Z') {
+            return line.substr(space + 1);
+        }
+    }
+    return line;
+}
+
+// "peer=12", "Peer=12" or "peer 12"; -1 if the line names no peer.
+int64_t PeerId(std::string_view line) {
+    for (std::string_view key : {"peer=", "Peer=", "peer "}) {
+        const size_t pos = line.find(key);
+        if (pos != std::string_view::npos) {
+            const size_t digits = pos + key.size();
+            if (digits < line.size() && line[digits] >= '0' && line[digits] <= '9') {
+                return strtoll(std::string(line.substr(digits, 20)).c_str(), nullptr, 10);
+            }
+        }
+    }
+    return -1;
+}
+
+bool Contains(std::string_view line, std::string_view text) {
+    return line.find(text) != std::string_view::npos;
+}
+
+} // namespace
+
+bool ParseLogRecordLine(std::string_view line, LogRecord *out) {
+    const std::string_view message = StripTimestamp(line);
+    LogRecord record;
+    if (Contains(message, "New outbound peer connected:")) {
+        record.kind = LogRecordKind::kPeerConnected;
+        record.peer_id = PeerId(message);
+    } else if (Contains(message, "disconnecting") || Contains(message, "Disconnecting")) {
+        // Stalling, timeouts and misbehavior are logged without -debug=net.
+        record.kind = LogRecordKind::kPeerDisconnected;
+        record.peer_id = PeerId(message);
+    } else if (Contains(message, "ERROR: ") || Contains(message, "Error: ") ||
+               Contains(message, "EXCEPTION: ")) {
+        record.kind = LogRecordKind::kError;
+    } else if (Contains(message, "Warning: ") || Contains(message, "WARNING: ")) {
+        record.kind = LogRecordKind::kWarning;
+    } else {
+        return false;
+    }
+    record.observed_ms = NowMillis();
+    record.message.assign(message.substr(0, kMaxRecordMessage));
+    *out = std::move(record);
+    return true;
+}
+
+bool ParseUpdateTipLine(std::string_view line, TipEvent *out) {
+    if (line.find("UpdateTip: new best=") == std::string_view::npos) {
+        return false;
+    }
+    const std::string_view height = FieldValue(line, " height=");
+    if (height.empty()) {
+        return false;
+    }
+    TipEvent event;
+    event.height = strtoll(std::string(height).c_str(), nullptr, 10);
+    const std::string_view progress = FieldValue(line, " progress=");
+    if (!progress.empty()) {
+        event.progress = strtod(std::string(progress).c_str(), nullptr);
+    }
+    std::string_view date = FieldValue(line, " date='");
+    if (!date.empty()) {
+        event.block_time = ParseIsoTime(date);
+    }
+    event.observed_ms = NowMillis();
+    *out = event;
+    return event.height >= 0;
+}
+
+DebugLogTailer::DebugLogTailer(size_t capacity, size_t recent_lines)
+    : tip_events_(capacity), records_(capacity), recent_lines_(recent_lines) {}
+
+DebugLogTailer::~DebugLogTailer() { Stop(); }
+
+bool DebugLogTailer::Start(const std::string &log_path, std::string *error) {
+    Stop();
+
+    const size_t slash = log_path.rfind('/');
+    if (slash == std::string::npos || slash + 1 == log_path.size()) {
+        *error = "log path must be absolute: " + log_path;
+        return false;
+    }
+    log_path_ = log_path;
+    log_dir_ = log_path.substr(0, slash);
+    log_name_ = log_path.substr(slash + 1);
+
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        *error = std::string("inotify_init1 failed: ") + strerror(errno);
+        return false;
+    }
+    // Watch the directory rather than the file so creation and rotation of
+    // debug.log are seen even before the daemon has written its first line.
+    if (inotify_add_watch(inotify_fd_, log_dir_.c_str(),
+                          IN_MODIFY | IN_CREATE | IN_MOVED_TO | IN_CLOSE_WRITE) < 0) {
+        *error = std::string("inotify_add_watch failed: ") + strerror(errno);
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+        return false;
+    }
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        *error = std::string("eventfd failed: ") + strerror(errno);
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+        return false;
+    }
+
+    // Start near the end of an existing file; only recent lines matter.
+    recent_lines_.Clear();
+    file_fd_ = open(log_path_.c_str(), O_RDONLY | O_CLOEXEC);
+    partial_line_.clear();
+    offset_ = 0;
+    if (file_fd_ >= 0) {
+        struct stat info {};
+        if (fstat(file_fd_, &info) == 0) {
+            file_inode_ = info.st_ino;
+            if (info.st_size > kStartBacklogBytes) {
+                offset_ = info.st_size - kStartBacklogBytes;
+                // The first line read from the middle of the file is partial;
+                // mark it so ConsumeLine never sees it.
+                partial_line_.assign(1, '\0');
+            }
+        }
+    }
+
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&DebugLogTailer::Run, this);
+    return true;
+}
+
+void DebugLogTailer::Stop() {
+    if (thread_.joinable()) {
+        running_.store(false, std::memory_order_release);
+        const uint64_t one = 1;
+        (void)write(wake_fd_, &one, sizeof(one));
+        thread_.join();
+    }
+    running_.store(false, std::memory_order_release);
+    tip_events_.Wake();
+    records_.Wake();
+    for (int *fd : {&inotify_fd_, &wake_fd_, &file_fd_}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    file_inode_ = 0;
+    offset_ = 0;
+    partial_line_.clear();
+}
+
+void DebugLogTailer::Run() {
+    TraceSetThreadName("debug.log tailer");
+    ReadAppended();
+
+    alignas(inotify_event) char events[4096];
+    while (running_.load(std::memory_order_acquire)) {
+        pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+        const int ready = poll(fds, 2, kIdleRecheckMs);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+
+        bool relevant = ready == 0;
+        if (fds[0].revents & POLLIN) {
+            ssize_t n;
+            while ((n = read(inotify_fd_, events, sizeof(events))) > 0) {
+                for (char *ptr = events; ptr < events + n;) {
+                    const auto *event = reinterpret_cast<const inotify_event *>(ptr);
+                    if (event->len > 0 && log_name_ == event->name) {
+                        relevant = true;
+                    }
+                    ptr += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+        if (relevant) {
+            ReadAppended();
+        }
+    }
+}
+
+void DebugLogTailer::ReadAppended() {
+    // Detect rotation: the path now names a different file (or none yet).
+    struct stat path_info {};
+    if (stat(log_path_.c_str(), &path_info) != 0) {
+        return;
+    }
+    if (file_fd_ < 0 || path_info.st_ino != file_inode_) {
+        if (file_fd_ >= 0) {
+            close(file_fd_);
+        }
+        file_fd_ = open(log_path_.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file_fd_ < 0) {
+            return;
+        }
+        file_inode_ = path_info.st_ino;
+        offset_ = 0;
+        partial_line_.clear();
+    }
+
+    struct stat info {};
+    if (fstat(file_fd_, &info) != 0) {
+        return;
+    }
+    if (info.st_size < offset_) {
+        // Truncated in place (shrinkdebugfile on restart): start over.
+        offset_ = 0;
+        partial_line_.clear();
+    }
+
+    char buffer[kReadChunkSize];
+    while (offset_ < info.st_size) {
+        const ssize_t n = pread(file_fd_, buffer, sizeof(buffer), offset_);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        offset_ += n;
+
+        std::string_view chunk(buffer, static_cast<size_t>(n));
+        size_t line_start = 0;
+        for (size_t eol = chunk.find('\n'); eol != std::string_view::npos;
+             eol = chunk.find('\n', line_start)) {
+            std::string_view piece = chunk.substr(line_start, eol - line_start);
+            if (partial_line_.empty()) {
+                if (piece.size() <= kMaxLineLength) {
+                    ConsumeLine(piece);
+                }
+            } else {
+                if (partial_line_[0] != '\0' &&
+                    partial_line_.size() + piece.size() <= kMaxLineLength) {
+                    partial_line_.append(piece);
+                    ConsumeLine(partial_line_);
+                }
+                partial_line_.clear();
+            }
+            line_start = eol + 1;
+        }
+        if (line_start < chunk.size()) {
+            if (partial_line_.size() + (chunk.size() - line_start) <= kMaxLineLength) {
+                partial_line_.append(chunk.substr(line_start));
+            } else {
+                partial_line_.assign(1, '\0');
+            }
+        }
+    }
+}
+
+void DebugLogTailer::ConsumeLine(std::string_view line) {
+    recent_lines_.Push(line);
+    TipEvent event;
+    if (ParseUpdateTipLine(line, &event)) {
+        TraceInstant("node", "UpdateTip", event.height);
+        tip_events_.Push(event);
+        return;
+    }
+    LogRecord record;
+    if (ParseLogRecordLine(line, &record)) {
+        records_.Push(record);
+    }
+}
+
+} // namespace digimobile
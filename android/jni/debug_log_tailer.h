@@ -0,0 +1,197 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <thread>
+#include <vector>
+
+namespace digimobile {
+
+// Compact chain-tip update extracted from a debug.log "UpdateTip:" line.
+struct TipEvent {
+    int64_t height = -1;
+    double progress = 0.0;     // verificationprogress reported by the node
+    int64_t block_time = 0;    // block timestamp (seconds since epoch)
+    int64_t observed_ms = 0;   // CLOCK_REALTIME when the line was read
+};
+
+// Parse "UpdateTip: new best=<hash> height=N ... date='YYYY-MM-DDTHH:MM:SSZ'
+// progress=0.123 ..." into out. Returns false for any other line.
+bool ParseUpdateTipLine(std::string_view line, TipEvent *out);
+
+// Values are part of the Java contract (DigiMobileNodeController.LOG_RECORD_*).
+enum class LogRecordKind : int {
+    kPeerConnected = 0,
+    kPeerDisconnected = 1,
+    kWarning = 2,
+    kError = 3,
+};
+
+// A peer or error line worth surfacing without reading the log.
+struct LogRecord {
+    LogRecordKind kind = LogRecordKind::kError;
+    int64_t peer_id = -1;     // for peer records, -1 if the line names none
+    int64_t observed_ms = 0;  // CLOCK_REALTIME when the line was read
+    std::string message;      // the line without its timestamp, truncated
+};
+
+// Recognizes outbound peer connections, the disconnects the node logs without
+// -debug=net, and ERROR/Warning lines. Returns false for any other line.
+bool ParseLogRecordLine(std::string_view line, LogRecord *out);
+
+// The most recent raw lines, for the console. Unlike EventRing, reading does
+// not consume: every viewer sees the same tail.
+class LineRing {
+public:
+    explicit LineRing(size_t capacity) : lines_(capacity ? capacity : 1) {}
+
+    void Push(std::string_view line) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lines_[(head_ + size_) % lines_.size()].assign(line.data(), line.size());
+        if (size_ == lines_.size()) {
+            head_ = (head_ + 1) % lines_.size();
+        } else {
+            ++size_;
+        }
+    }
+
+    void Clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        head_ = 0;
+        size_ = 0;
+    }
+
+    // The newest min(max, size) lines, oldest first.
+    std::vector<std::string> Tail(size_t max) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const size_t count = max < size_ ? max : size_;
+        std::vector<std::string> out;
+        out.reserve(count);
+        for (size_t i = size_ - count; i < size_; ++i) {
+            out.push_back(lines_[(head_ + i) % lines_.size()]);
+        }
+        return out;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::string> lines_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+};
+
+// Bounded multi-producer/multi-consumer ring. When full, the oldest entry is
+// dropped: consumers only care about recent progress, never about history.
+template <typename T>
+class EventRing {
+public:
+    explicit EventRing(size_t capacity) : slots_(capacity ? capacity : 1) {}
+
+    void Push(const T &value) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slots_[(head_ + size_) % slots_.size()] = value;
+            if (size_ == slots_.size()) {
+                head_ = (head_ + 1) % slots_.size();
+            } else {
+                ++size_;
+            }
+        }
+        ready_.notify_all();
+    }
+
+    // Copy up to max entries (oldest first) into out, waiting up to timeout_ms
+    // for at least one entry. Returns the number copied.
+    size_t PopMany(T *out, size_t max, int timeout_ms) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (size_ == 0 && timeout_ms > 0) {
+            ready_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                            [this] { return size_ > 0 || woken_; });
+        }
+        woken_ = false;
+        size_t count = 0;
+        while (count < max && size_ > 0) {
+            out[count++] = slots_[head_];
+            head_ = (head_ + 1) % slots_.size();
+            --size_;
+        }
+        return count;
+    }
+
+    // Release any thread blocked in PopMany.
+    void Wake() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            woken_ = true;
+        }
+        ready_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::vector<T> slots_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+    bool woken_ = false;
+};
+
+// Follows debug.log on a native thread using inotify, reading only bytes
+// appended since the last wake-up. Truncation (shrinkdebugfile) and rotation
+// (file replaced or recreated) restart reading from the beginning of the new
+// file. UpdateTip lines and peer/error records are pushed into rings for the
+// Java side to drain, and the last lines are kept for the console, so viewing
+// the log costs no file I/O at all.
+class DebugLogTailer {
+public:
+    explicit DebugLogTailer(size_t capacity = 256, size_t recent_lines = 256);
+    ~DebugLogTailer();
+
+    DebugLogTailer(const DebugLogTailer &) = delete;
+    DebugLogTailer &operator=(const DebugLogTailer &) = delete;
+
+    bool Start(const std::string &log_path, std::string *error);
+    void Stop();
+    bool running() const { return running_.load(std::memory_order_acquire); }
+    const std::string &path() const { return log_path_; }
+
+    size_t PollTipEvents(TipEvent *out, size_t max, int timeout_ms) {
+        return tip_events_.PopMany(out, max, timeout_ms);
+    }
+    size_t PollLogRecords(LogRecord *out, size_t max, int timeout_ms) {
+        return records_.PopMany(out, max, timeout_ms);
+    }
+    std::vector<std::string> RecentLines(size_t max) const { return recent_lines_.Tail(max); }
+
+private:
+    void Run();
+    void ReadAppended();
+    void ConsumeLine(std::string_view line);
+
+    std::string log_path_;
+    std::string log_dir_;
+    std::string log_name_;
+    int inotify_fd_ = -1;
+    int wake_fd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // Reader state, owned by the tailer thread.
+    int file_fd_ = -1;
+    ino_t file_inode_ = 0;
+    off_t offset_ = 0;
+    std::string partial_line_;
+
+    EventRing<TipEvent> tip_events_;
+    EventRing<LogRecord> records_;
+    LineRing recent_lines_;
+};
+
+} // namespace digimobile
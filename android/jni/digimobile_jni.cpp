@@ -1,37 +1,142 @@
 #include <jni.h>
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
-#include <android/log.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <errno.h>
 #include <fcntl.h>
-#include <signal.h>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
-#include <sys/wait.h>
 #include <unistd.h>
 #include <vector>
 
+#include "asset_stager.h"
+#include "block_bundle.h"
+#include "debug_log_tailer.h"
+#include "node_controller.h"
+#include "node_registry.h"
+#include "node_supervisor.h"
+#include "platform_android.h"
+#include "proc_stats.h"
+#include "resource_governor.h"
+#include "rpc_client.h"
+#include "rpc_console.h"
+#include "sha256.h"
+#include "snapshot_container.h"
+#include "snapshot_extractor.h"
+#include "sync_metrics.h"
+#include "trace_recorder.h"
+
 // Experimental JNI bridge to control the Digi-Mobile node process from Android.
+// The node lifecycle lives in NodeController (platform-neutral, also built for
+// Linux hosts); this file converts between Java and it. When libdigibyted.so
+// is packaged, DigiByte Core runs in-process and RPC is dispatched directly;
+// otherwise the digibyted asset is extracted and spawned as a child process.
 // NOTE: Spawning a child process from within an Android app is discouraged for
-// Play Store-distributed binaries. This harness is intended for internal and
-// sideloaded testing. A future iteration is expected to embed DigiByte Core as
-// a library and expose richer control and status APIs.
+// Play Store-distributed binaries. That path is intended for internal and
+// sideloaded testing.
 namespace {
 
-constexpr const char *kLogTag = "DigiMobileJNI";
+// Layout of the packed status array shared with NodeProcessStatus.java.
+enum ProcessStatusField {
+    kFieldPhase = 0,
+    kFieldPid,
+    kFieldUptimeMs,
+    kFieldRssBytes,
+    kFieldCpuUserMs,
+    kFieldCpuSystemMs,
+    kFieldIoReadBytes,
+    kFieldIoWriteBytes,
+    kFieldOpenFds,
+    kFieldThreads,
+    kFieldExitCode,
+    kFieldExitSignal,
+    kProcessStatusFieldCount,
+};
+
+// Layout of the packed array shared with ResourceTuning.java.
+enum ResourceTuningField {
+    kTuningProfile = 0,
+    kTuningDbcacheMb,
+    kTuningPar,
+    kTuningMaxConnections,
+    kTuningMaxMempoolMb,
+    kTuningMemTotalKb,
+    kTuningMemAvailableKb,
+    kTuningCpuCores,
+    kTuningThermalMilliCelsius,
+    kTuningBatteryPercent,
+    kTuningCharging,
+    kResourceTuningFieldCount,
+};
+
+// Layout of the packed array shared with StorageStatus.java.
+enum StorageStatusField {
+    kStorageTotalBytes = 0,
+    kStorageFreeBytes,
+    kStorageBlocksBytes,
+    kStoragePruneTargetMb,
+    kStorageNextPruneTargetMb,
+    kStorageWriteLimitBytesPerSec,
+    kStorageWriteBytesPerSec,
+    kStorageLatencyMs,
+    kStorageThrottlePauses,
+    kStorageThrottlePausedMs,
+    kStorageStatusFieldCount,
+};
+
+// Layout of the packed arrays shared with SyncMetrics.java.
+enum SyncMetricsField {
+    kSyncBlocks = 0,
+    kSyncHeaders,
+    kSyncInitialBlockDownload,
+    kSyncPeers,
+    kSyncPeersInbound,
+    kSyncMempoolTx,
+    kSyncMempoolBytes,
+    kSyncBytesRecv,
+    kSyncBytesSent,
+    kSyncEtaSeconds,
+    kSyncMetricsFieldCount,
+};
 
-enum class NodeStatus {
-    NOT_RUNNING,
-    RUNNING,
-    BINARY_MISSING,
-    ERROR,
+enum SyncRateField {
+    kSyncVerificationProgress = 0,
+    kSyncBlocksPerSecond,
+    kSyncRecvBytesPerSecond,
+    kSyncSentBytesPerSecond,
+    kSyncRateFieldCount,
 };
 
-// Track the currently running node process ID (if any).
-static pid_t g_node_pid = -1;
-static NodeStatus g_status = NodeStatus::NOT_RUNNING;
-static std::string g_node_binary;
+// Return codes of nativePollSyncMetrics; mirrored as SYNC_METRICS_* in
+// DigiMobileNodeController.java.
+constexpr jint kSyncMetricsChanged = 1;
+constexpr jint kSyncMetricsUnchanged = 0;
+constexpr jint kSyncMetricsRpcError = -1;
+constexpr jint kSyncMetricsUnreachable = -2;
+
+using digimobile::Log;
+using digimobile::LogPriority;
+using digimobile::NodePhase;
+
+// Every node the app manages, each with its own controller, RPC client and
+// debug.log follower. DigiMobileNodeController holds a handle into it.
+static digimobile::NodeRegistry g_nodes;
+
+// Resolve a controller's handle; nullptr (logged) once it has been released.
+std::shared_ptr<digimobile::NodeInstance> FindNode(jlong handle, const char *what) {
+    std::shared_ptr<digimobile::NodeInstance> node = g_nodes.Find(handle);
+    if (!node) {
+        Log(LogPriority::kWarn, "%s on unknown node handle %lld", what,
+            static_cast<long long>(handle));
+    }
+    return node;
+}
 
 // Helper to convert jstring to std::string.
 std::string ToStdString(JNIEnv *env, jstring value) {
@@ -47,219 +152,1051 @@ std::string ToStdString(JNIEnv *env, jstring value) {
     return str;
 }
 
-bool IsProcessAlive(pid_t pid) {
-    if (pid <= 0) {
-        return false;
+// NewStringUTF for text from debug.log, which is not guaranteed to be valid
+// modified UTF-8 (CheckJNI aborts on that); non-ASCII bytes become '?'.
+jstring NewLogString(JNIEnv *env, std::string text) {
+    for (char &c : text) {
+        if (c == '\0' || (static_cast<unsigned char>(c) & 0x80) != 0) {
+            c = '?';
+        }
     }
-    // kill(..., 0) checks for existence without sending a signal.
-    return kill(pid, 0) == 0;
+    return env->NewStringUTF(text.c_str());
 }
 
-bool EnsureDir(const std::string &path) {
-    struct stat info {};
-    if (stat(path.c_str(), &info) == 0) {
-        return S_ISDIR(info.st_mode);
+// NewString for UTF-8 text from the node. Decodes to UTF-16 itself because
+// NewStringUTF only takes modified UTF-8, which excludes characters outside
+// the BMP; malformed bytes become U+FFFD.
+jstring NewUtf16String(JNIEnv *env, const std::string &text) {
+    std::vector<jchar> units;
+    units.reserve(text.size());
+    for (size_t i = 0; i < text.size();) {
+        const unsigned char lead = static_cast<unsigned char>(text[i]);
+        const size_t length = lead < 0x80   ? 1
+                              : lead >= 0xF0 ? 4
+                              : lead >= 0xE0 ? 3
+                              : lead >= 0xC0 ? 2
+                                             : 0;
+        // Payload bits of the lead byte: 7, 5, 4 or 3 of them.
+        uint32_t code_point = lead & (0xFF >> (length == 1 ? 1 : length + 1));
+        bool valid = length > 0 && i + length <= text.size();
+        for (size_t k = 1; valid && k < length; ++k) {
+            const unsigned char next = static_cast<unsigned char>(text[i + k]);
+            valid = (next & 0xC0) == 0x80;
+            code_point = (code_point << 6) | (next & 0x3F);
+        }
+        if (!valid || code_point > 0x10FFFF) {
+            units.push_back(0xFFFD);
+            ++i;
+            continue;
+        }
+        if (code_point >= 0x10000) {
+            code_point -= 0x10000;
+            units.push_back(static_cast<jchar>(0xD800 + (code_point >> 10)));
+            units.push_back(static_cast<jchar>(0xDC00 + (code_point & 0x3FF)));
+        } else {
+            units.push_back(static_cast<jchar>(code_point));
+        }
+        i += length;
     }
-    return mkdir(path.c_str(), 0700) == 0;
+    return env->NewString(units.data(), static_cast<jsize>(units.size()));
 }
 
-bool MakeExecutable(const std::string &path) {
-    return chmod(path.c_str(), 0700) == 0;
+// Return the reply body of a finished RPC round trip, or nullptr if the node
+// could not be reached or answered without a body (e.g. HTTP 401).
+jstring RpcResponseToJava(JNIEnv *env, const char *what,
+                          const digimobile::RpcResponse &response) {
+    if (!response.transport_ok) {
+        Log(LogPriority::kDebug, "RPC %s failed: %s", what, response.error.c_str());
+        return nullptr;
+    }
+    if (response.body.empty()) {
+        Log(LogPriority::kWarn, "RPC %s returned HTTP %d with no body", what, response.http_status);
+        return nullptr;
+    }
+    return NewUtf16String(env, response.body);
 }
 
-bool CopyAssetToFile(AAssetManager *asset_manager, const std::string &asset_path,
-                     const std::string &dest_path) {
-    if (!asset_manager) {
-        __android_log_print(ANDROID_LOG_ERROR, kLogTag, "Asset manager is null; cannot copy %s",
-                            asset_path.c_str());
-        return false;
+// Run requests against the in-process node. Returns nullptr if it is not
+// accepting RPC yet so the caller can use the socket client (which reports
+// warm-up errors properly).
+jstring EmbeddedRpcToJava(JNIEnv *env, digimobile::NodeController &controller,
+                          const std::vector<digimobile::RpcRequest> &requests, bool batch) {
+    std::string reply;
+    if (!controller.EmbeddedRpc(requests, batch, &reply)) {
+        return nullptr;
     }
+    return NewUtf16String(env, reply);
+}
+
+} // namespace
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeDefaultNode(
+        JNIEnv * /*env*/, jclass /*clazz*/) {
+    return static_cast<jlong>(g_nodes.Default());
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeCreateNode(
+        JNIEnv * /*env*/, jclass /*clazz*/) {
+    const int64_t handle = g_nodes.Create();
+    Log(LogPriority::kInfo, "Registered node handle %lld", static_cast<long long>(handle));
+    return static_cast<jlong>(handle);
+}
 
-    AAsset *asset = AAssetManager_open(asset_manager, asset_path.c_str(), AASSET_MODE_STREAMING);
-    if (!asset) {
-        __android_log_print(ANDROID_LOG_ERROR, kLogTag, "Asset %s not found in APK",
-                            asset_path.c_str());
-        return false;
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeReleaseNode(
+        JNIEnv * /*env*/, jclass /*clazz*/, jlong handle, jint j_timeout_ms) {
+    const std::shared_ptr<digimobile::NodeInstance> node = g_nodes.Remove(handle);
+    if (!node) {
+        return;
+    }
+    // Calls still holding the node keep it alive; the daemon is stopped now so
+    // its datadir and ports are free as soon as this returns.
+    {
+        std::lock_guard<std::mutex> lock(node->tailer_mutex);
+        node->log_tailer.Stop();
     }
+    node->controller.Stop(j_timeout_ms);
+    Log(LogPriority::kInfo, "Released node handle %lld", static_cast<long long>(handle));
+}
 
-    int fd = open(dest_path.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0700);
-    if (fd < 0) {
-        __android_log_print(ANDROID_LOG_ERROR, kLogTag, "Failed to open %s for writing: errno=%d",
-                            dest_path.c_str(), errno);
-        AAsset_close(asset);
-        return false;
-    }
-
-    constexpr size_t kBufferSize = 16 * 1024;
-    std::vector<unsigned char> buffer(kBufferSize);
-    int bytes_read = 0;
-    while ((bytes_read = AAsset_read(asset, buffer.data(), buffer.size())) > 0) {
-        ssize_t written = write(fd, buffer.data(), static_cast<size_t>(bytes_read));
-        if (written != bytes_read) {
-            __android_log_print(ANDROID_LOG_ERROR, kLogTag,
-                                "Short write while copying asset %s to %s (errno=%d)",
-                                asset_path.c_str(), dest_path.c_str(), errno);
-            close(fd);
-            AAsset_close(asset);
-            return false;
-        }
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeStartNode(
+        JNIEnv *env, jobject /*thiz*/, jlong handle, jobject j_asset_manager, jstring j_config_path,
+        jstring j_data_dir, jstring j_files_dir, jstring j_asset_stamp) {
+    const auto node = FindNode(handle, "nativeStartNode");
+    if (!node) {
+        return;
     }
+    digimobile::StartRequest request;
+    request.config_path = ToStdString(env, j_config_path);
+    request.data_dir = ToStdString(env, j_data_dir);
+    request.files_dir = ToStdString(env, j_files_dir);
+    request.asset_stamp = ToStdString(env, j_asset_stamp);
+    digimobile::ApkAssetProvider assets(AAssetManager_fromJava(env, j_asset_manager));
+    node->controller.Start(&assets, request);
+}
 
-    close(fd);
-    AAsset_close(asset);
-    if (bytes_read < 0) {
-        __android_log_print(ANDROID_LOG_ERROR, kLogTag,
-                            "Error reading asset %s (errno=%d)", asset_path.c_str(), errno);
-        return false;
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeStopNode(
+        JNIEnv * /*env*/, jobject /*thiz*/, jlong handle, jint j_timeout_ms) {
+    const auto node = FindNode(handle, "nativeStopNode");
+    if (!node) {
+        return;
     }
+    node->controller.Stop(j_timeout_ms);
+}
 
-    if (!MakeExecutable(dest_path)) {
-        __android_log_print(ANDROID_LOG_WARN, kLogTag,
-                            "Failed to mark %s executable (errno=%d)", dest_path.c_str(), errno);
-        return false;
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeGetStatus(
+        JNIEnv *env, jobject /*thiz*/, jlong handle) {
+    const auto node = FindNode(handle, "nativeGetStatus");
+    if (!node) {
+        return env->NewStringUTF("NOT_RUNNING");
     }
-    return true;
+    return env->NewStringUTF(node->controller.StatusString());
 }
 
-} // namespace
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeSetRestartPolicy(
+        JNIEnv * /*env*/, jobject /*thiz*/, jlong handle, jboolean j_enabled, jint j_max_restarts,
+        jint j_initial_backoff_ms, jint j_max_backoff_ms) {
+    const auto node = FindNode(handle, "nativeSetRestartPolicy");
+    if (!node) {
+        return;
+    }
+    digimobile::RestartPolicy policy;
+    policy.enabled = j_enabled == JNI_TRUE;
+    policy.max_restarts = std::max(0, static_cast<int>(j_max_restarts));
+    policy.initial_backoff_ms = std::max(0, static_cast<int>(j_initial_backoff_ms));
+    policy.max_backoff_ms = std::max(policy.initial_backoff_ms, static_cast<int>(j_max_backoff_ms));
+    node->controller.supervisor().SetRestartPolicy(policy);
+}
 
 extern "C" JNIEXPORT void JNICALL
-Java_com_digimobile_node_DigiMobileNodeController_nativeStartNode(
-        JNIEnv *env, jobject /*thiz*/, jobject j_asset_manager, jstring j_config_path,
-        jstring j_data_dir, jstring j_files_dir) {
-    std::string config_path = ToStdString(env, j_config_path);
-    std::string data_dir = ToStdString(env, j_data_dir);
-    std::string files_dir = ToStdString(env, j_files_dir);
-
-    if (config_path.empty() || data_dir.empty() || files_dir.empty()) {
-        __android_log_print(ANDROID_LOG_ERROR, kLogTag,
-                            "Config path, data dir, or files dir is empty; refusing to start node");
-        g_status = NodeStatus::ERROR;
+Java_com_digimobile_node_DigiMobileNodeController_nativeSetWarmRestart(
+        JNIEnv * /*env*/, jobject /*thiz*/, jlong handle, jboolean j_enabled,
+        jint j_prewarm_budget_mb) {
+    const auto node = FindNode(handle, "nativeSetWarmRestart");
+    if (!node) {
         return;
     }
+    digimobile::WarmRestartPolicy policy;
+    policy.enabled = j_enabled == JNI_TRUE;
+    const int budget_mb = std::max(0, static_cast<int>(j_prewarm_budget_mb));
+    policy.prewarm.budget_bytes = static_cast<int64_t>(budget_mb) << 20;
+    node->controller.SetWarmRestart(policy);
+}
 
-    if (g_node_pid > 0 && IsProcessAlive(g_node_pid)) {
-        __android_log_print(ANDROID_LOG_INFO, kLogTag,
-                            "nativeStartNode called but node already running with PID %d", g_node_pid);
-        g_status = NodeStatus::RUNNING;
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeSetStoragePolicy(
+        JNIEnv * /*env*/, jobject /*thiz*/, jlong handle, jint j_max_prune_mb, jint j_reserve_mb,
+        jboolean j_throttle, jint j_latency_threshold_ms, jint j_max_write_mb_per_sec) {
+    const auto node = FindNode(handle, "nativeSetStoragePolicy");
+    if (!node) {
         return;
     }
+    digimobile::StoragePolicy policy;
+    policy.prune.max_target_mb = std::max(0, static_cast<int>(j_max_prune_mb));
+    if (j_reserve_mb >= 0) {
+        policy.prune.reserve_bytes = static_cast<int64_t>(j_reserve_mb) << 20;
+    }
+    policy.io.enabled = j_throttle == JNI_TRUE;
+    if (j_latency_threshold_ms > 0) {
+        policy.io.latency_threshold_ms = j_latency_threshold_ms;
+    }
+    policy.io.max_write_bytes_per_s =
+            static_cast<int64_t>(std::max(0, static_cast<int>(j_max_write_mb_per_sec))) << 20;
+    node->controller.SetStoragePolicy(policy);
+}
 
-    AAssetManager *asset_manager = AAssetManager_fromJava(env, j_asset_manager);
-    const std::string bin_dir = files_dir + "/bin";
-    if (!EnsureDir(bin_dir)) {
-        __android_log_print(ANDROID_LOG_ERROR, kLogTag, "Failed to ensure bin directory at %s",
-                            bin_dir.c_str());
-        g_status = NodeStatus::ERROR;
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeSetBlockImport(
+        JNIEnv *env, jobject /*thiz*/, jlong handle, jstring j_path) {
+    const auto node = FindNode(handle, "nativeSetBlockImport");
+    if (!node) {
         return;
     }
+    node->controller.SetBlockImport(j_path ? ToStdString(env, j_path) : "");
+}
 
-    g_node_binary = bin_dir + "/digibyted";
-    if (access(g_node_binary.c_str(), X_OK) != 0) {
-        __android_log_print(ANDROID_LOG_INFO, kLogTag,
-                            "Extracting digibyted from assets into %s", g_node_binary.c_str());
-        if (!CopyAssetToFile(asset_manager, "bin/digibyted-arm64", g_node_binary)) {
-            g_status = NodeStatus::BINARY_MISSING;
-            g_node_pid = -1;
-            return;
-        }
-    } else {
-        if (!MakeExecutable(g_node_binary)) {
-            __android_log_print(ANDROID_LOG_WARN, kLogTag,
-                                "digibyted at %s exists but is not executable", g_node_binary.c_str());
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeSetSchedulingPolicy(
+        JNIEnv * /*env*/, jobject /*thiz*/, jlong handle, jint j_cores, jint j_nice,
+        jboolean j_batch, jint j_io_class, jint j_io_level, jint j_duty_percent,
+        jint j_duty_period_ms) {
+    const auto node = FindNode(handle, "nativeSetSchedulingPolicy");
+    if (!node) {
+        return JNI_FALSE;
+    }
+    digimobile::SchedulingPolicy policy;
+    policy.cores = j_cores >= 0 && j_cores <= static_cast<jint>(digimobile::CoreSet::kBig)
+                           ? static_cast<digimobile::CoreSet>(j_cores)
+                           : digimobile::CoreSet::kAll;
+    policy.nice = j_nice;
+    policy.batch = j_batch == JNI_TRUE;
+    policy.io_class = j_io_class;
+    policy.io_level = j_io_level;
+    policy.duty_percent = j_duty_percent;
+    policy.duty_period_ms = j_duty_period_ms;
+    const int error = node->controller.supervisor().SetSchedulingPolicy(policy);
+    if (error != 0) {
+        Log(LogPriority::kWarn, "Scheduling policy only partly applied to the running node: %s",
+            strerror(error));
+    }
+    return error == 0 ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeConfigureRpc(
+        JNIEnv *env, jobject /*thiz*/, jlong handle, jstring j_host, jint j_port, jstring j_user,
+        jstring j_password) {
+    const auto node = FindNode(handle, "nativeConfigureRpc");
+    if (!node) {
+        return;
+    }
+    std::string host = ToStdString(env, j_host);
+    std::string user = ToStdString(env, j_user);
+    std::string password = ToStdString(env, j_password);
+    if (host.empty() || j_port <= 0 || j_port > 65535) {
+        Log(LogPriority::kError, "Invalid RPC endpoint %s:%d", host.c_str(), j_port);
+        return;
+    }
+
+    node->console.Configure(host, static_cast<uint16_t>(j_port), user, password);
+    std::lock_guard<std::mutex> lock(node->rpc_mutex);
+    node->rpc_client = std::make_unique<digimobile::RpcClient>(
+            std::move(host), static_cast<uint16_t>(j_port), user, password);
+    node->sync_metrics.Reset();
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeRpcCall(
+        JNIEnv *env, jobject /*thiz*/, jlong handle, jstring j_method, jstring j_params_json) {
+    const auto node = FindNode(handle, "nativeRpcCall");
+    if (!node) {
+        return nullptr;
+    }
+    std::string method = ToStdString(env, j_method);
+    std::string params = ToStdString(env, j_params_json);
+    digimobile::TraceSpan span("jni", "nativeRpcCall", digimobile::kTraceNoArg, method.c_str());
+
+    if (jstring reply = EmbeddedRpcToJava(env, node->controller,
+                                          {digimobile::RpcRequest {method, params}}, false)) {
+        return reply;
+    }
+
+    std::lock_guard<std::mutex> lock(node->rpc_mutex);
+    if (!node->rpc_client) {
+        Log(LogPriority::kWarn, "nativeRpcCall(%s) before nativeConfigureRpc", method.c_str());
+        return nullptr;
+    }
+    return RpcResponseToJava(env, method.c_str(), node->rpc_client->Call(method, params));
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeRpcBatch(
+        JNIEnv *env, jobject /*thiz*/, jlong handle, jobjectArray j_methods,
+        jobjectArray j_params_json) {
+    const auto node = FindNode(handle, "nativeRpcBatch");
+    if (!node) {
+        return nullptr;
+    }
+    const jsize count = j_methods ? env->GetArrayLength(j_methods) : 0;
+    const jsize param_count = j_params_json ? env->GetArrayLength(j_params_json) : 0;
+
+    std::vector<digimobile::RpcRequest> requests(static_cast<size_t>(count));
+    for (jsize i = 0; i < count; ++i) {
+        auto j_method = static_cast<jstring>(env->GetObjectArrayElement(j_methods, i));
+        requests[i].method = ToStdString(env, j_method);
+        env->DeleteLocalRef(j_method);
+        if (i < param_count) {
+            auto j_params = static_cast<jstring>(env->GetObjectArrayElement(j_params_json, i));
+            if (j_params) {
+                requests[i].params_json = ToStdString(env, j_params);
+                env->DeleteLocalRef(j_params);
+            }
         }
     }
 
-    const std::string cli_binary = bin_dir + "/digibyte-cli";
-    if (access(cli_binary.c_str(), X_OK) != 0) {
-        __android_log_print(ANDROID_LOG_INFO, kLogTag,
-                            "Extracting digibyte-cli from assets into %s", cli_binary.c_str());
-        if (!CopyAssetToFile(asset_manager, "bin/digibyte-cli-arm64", cli_binary)) {
-            __android_log_print(ANDROID_LOG_ERROR, kLogTag,
-                                "digibyte-cli asset missing; stop/getblockchaininfo calls will fail");
-            g_status = NodeStatus::ERROR;
-            g_node_pid = -1;
-            return;
+    if (jstring reply = EmbeddedRpcToJava(env, node->controller, requests, true)) {
+        return reply;
+    }
+
+    std::lock_guard<std::mutex> lock(node->rpc_mutex);
+    if (!node->rpc_client) {
+        Log(LogPriority::kWarn, "nativeRpcBatch before nativeConfigureRpc");
+        return nullptr;
+    }
+    return RpcResponseToJava(env, "batch", node->rpc_client->CallBatch(requests));
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativePollSyncMetrics(
+        JNIEnv *env, jobject /*thiz*/, jlong handle, jlongArray j_values, jdoubleArray j_rates,
+        jobjectArray j_error) {
+    const auto node = FindNode(handle, "nativePollSyncMetrics");
+    if (!node) {
+        return kSyncMetricsUnreachable;
+    }
+    if (!j_values || env->GetArrayLength(j_values) < kSyncMetricsFieldCount || !j_rates ||
+        env->GetArrayLength(j_rates) < kSyncRateFieldCount) {
+        return kSyncMetricsUnreachable;
+    }
+
+    digimobile::SyncPollStatus status;
+    digimobile::SyncMetrics metrics;
+    std::string error;
+    {
+        std::lock_guard<std::mutex> lock(node->rpc_mutex);
+        const auto call = [&node](const std::vector<digimobile::RpcRequest> &requests,
+                                  std::string *body) {
+            if (node->controller.EmbeddedRpc(requests, true, body)) {
+                return true;
+            }
+            if (!node->rpc_client) {
+                return false;
+            }
+            digimobile::RpcResponse response = node->rpc_client->CallBatch(requests);
+            if (!response.transport_ok || response.body.empty()) {
+                return false;
+            }
+            *body = std::move(response.body);
+            return true;
+        };
+        status = node->sync_metrics.Poll(call, digimobile::MonotonicMillis(), &error);
+        metrics = node->sync_metrics.metrics();
+    }
+
+    switch (status) {
+        case digimobile::SyncPollStatus::kUnchanged:
+            return kSyncMetricsUnchanged;
+        case digimobile::SyncPollStatus::kRpcError:
+            if (j_error && env->GetArrayLength(j_error) > 0) {
+                jstring j_message = NewUtf16String(env, error);
+                env->SetObjectArrayElement(j_error, 0, j_message);
+                env->DeleteLocalRef(j_message);
+            }
+            return kSyncMetricsRpcError;
+        case digimobile::SyncPollStatus::kUnreachable:
+            Log(LogPriority::kDebug, "Sync poll failed: %s", error.c_str());
+            return kSyncMetricsUnreachable;
+        case digimobile::SyncPollStatus::kChanged:
+            break;
+    }
+
+    jlong values[kSyncMetricsFieldCount];
+    values[kSyncBlocks] = metrics.blocks;
+    values[kSyncHeaders] = metrics.headers;
+    values[kSyncInitialBlockDownload] = metrics.initial_block_download;
+    values[kSyncPeers] = metrics.peers;
+    values[kSyncPeersInbound] = metrics.peers_inbound;
+    values[kSyncMempoolTx] = metrics.mempool_tx;
+    values[kSyncMempoolBytes] = metrics.mempool_bytes;
+    values[kSyncBytesRecv] = metrics.bytes_recv;
+    values[kSyncBytesSent] = metrics.bytes_sent;
+    values[kSyncEtaSeconds] = metrics.eta_s;
+    jdouble rates[kSyncRateFieldCount];
+    rates[kSyncVerificationProgress] = metrics.verification_progress;
+    rates[kSyncBlocksPerSecond] = metrics.blocks_per_s;
+    rates[kSyncRecvBytesPerSecond] = metrics.recv_bytes_per_s;
+    rates[kSyncSentBytesPerSecond] = metrics.sent_bytes_per_s;
+    env->SetLongArrayRegion(j_values, 0, kSyncMetricsFieldCount, values);
+    env->SetDoubleArrayRegion(j_rates, 0, kSyncRateFieldCount, rates);
+    return kSyncMetricsChanged;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeConsoleExecute(
+        JNIEnv *env, jobject /*thiz*/, jlong handle, jstring j_method, jstring j_params_json,
+        jint j_max_output_bytes, jobject j_sink) {
+    // Exit codes shared with DigiMobileNodeController.CONSOLE_*.
+    constexpr jint kConsoleRpcError = 1;
+    constexpr jint kConsoleUnreachable = -2;
+    constexpr jint kConsoleCancelled = -3;
+
+    const auto node = FindNode(handle, "nativeConsoleExecute");
+    if (!node || !j_sink) {
+        return kConsoleUnreachable;
+    }
+    jclass sink_class = env->GetObjectClass(j_sink);
+    const jmethodID on_output = env->GetMethodID(sink_class, "onOutput", "(Ljava/lang/String;)Z");
+    const jmethodID on_error = env->GetMethodID(sink_class, "onError", "(Ljava/lang/String;)V");
+    env->DeleteLocalRef(sink_class);
+    if (!on_output || !on_error) {
+        env->ExceptionClear();
+        Log(LogPriority::kError, "nativeConsoleExecute: sink lacks onOutput/onError");
+        return kConsoleUnreachable;
+    }
+
+    const std::string method = ToStdString(env, j_method);
+    const std::string params = ToStdString(env, j_params_json);
+    digimobile::ConsoleOptions options;
+    if (j_max_output_bytes > 0) {
+        options.max_output_bytes = j_max_output_bytes;
+    }
+    // Runs on this thread, so env stays valid.
+    const digimobile::ConsoleSink sink = [env, j_sink, on_output](const std::string &text) {
+        jstring j_text = NewUtf16String(env, text);
+        const jboolean keep_going = env->CallBooleanMethod(j_sink, on_output, j_text);
+        env->DeleteLocalRef(j_text);
+        if (env->ExceptionCheck()) {
+            env->ExceptionClear();
+            return false;
         }
+        return keep_going == JNI_TRUE;
+    };
+
+    digimobile::ConsoleResult result;
+    std::string reply;
+    if (node->controller.EmbeddedRpc({digimobile::RpcRequest {method, params}}, false, &reply)) {
+        result = digimobile::RpcConsole::Render(reply, options, sink);
     } else {
-        if (!MakeExecutable(cli_binary)) {
-            __android_log_print(ANDROID_LOG_WARN, kLogTag,
-                                "digibyte-cli at %s exists but is not executable", cli_binary.c_str());
-        }
+        result = node->console.Execute(method, params, options, sink);
+    }
+    if (!result.error.empty()) {
+        jstring j_error = NewUtf16String(env, result.error);
+        env->CallVoidMethod(j_sink, on_error, j_error);
+        env->DeleteLocalRef(j_error);
+        env->ExceptionClear();
     }
+    switch (result.status) {
+        case digimobile::ConsoleStatus::kOk: return 0;
+        case digimobile::ConsoleStatus::kRpcError: return kConsoleRpcError;
+        case digimobile::ConsoleStatus::kCancelled: return kConsoleCancelled;
+        case digimobile::ConsoleStatus::kUnreachable: break;
+    }
+    return kConsoleUnreachable;
+}
 
-    // Always pass explicit config and datadir flags to avoid relying on defaults.
-    std::string conf_arg = "-conf=" + config_path;
-    std::string datadir_arg = "-datadir=" + data_dir;
-
-    pid_t child_pid = fork();
-    if (child_pid == 0) {
-        execl(g_node_binary.c_str(), g_node_binary.c_str(), conf_arg.c_str(), datadir_arg.c_str(),
-              static_cast<char *>(nullptr));
-        _exit(127);  // If execl fails.
-    } else if (child_pid > 0) {
-        g_node_pid = child_pid;
-        g_status = NodeStatus::RUNNING;
-        __android_log_print(ANDROID_LOG_INFO, kLogTag, "Started Digi-Mobile node with PID %d",
-                            g_node_pid);
-    } else {
-        g_status = NodeStatus::ERROR;
-        __android_log_print(ANDROID_LOG_ERROR, kLogTag,
-                            "Failed to fork for Digi-Mobile node: errno=%d", errno);
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeConsoleCancel(
+        JNIEnv * /*env*/, jobject /*thiz*/, jlong handle) {
+    const auto node = FindNode(handle, "nativeConsoleCancel");
+    if (!node) {
+        return;
+    }
+    node->console.Cancel();
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeStartSyncEvents(
+        JNIEnv *env, jobject /*thiz*/, jlong handle, jstring j_log_path) {
+    const auto node = FindNode(handle, "nativeStartSyncEvents");
+    if (!node) {
+        return JNI_FALSE;
+    }
+    std::string log_path = ToStdString(env, j_log_path);
+    std::lock_guard<std::mutex> lock(node->tailer_mutex);
+    if (node->log_tailer.running() && node->log_tailer.path() == log_path) {
+        return JNI_TRUE;
+    }
+    std::string error;
+    if (!node->log_tailer.Start(log_path, &error)) {
+        Log(LogPriority::kWarn, "Cannot follow %s: %s", log_path.c_str(), error.c_str());
+        return JNI_FALSE;
     }
+    Log(LogPriority::kInfo, "Following %s for sync events", log_path.c_str());
+    return JNI_TRUE;
 }
 
 extern "C" JNIEXPORT void JNICALL
-Java_com_digimobile_node_DigiMobileNodeController_nativeStopNode(
-        JNIEnv * /*env*/, jobject /*thiz*/) {
-    if (g_node_pid <= 0) {
-        __android_log_print(ANDROID_LOG_WARN, kLogTag,
-                            "nativeStopNode called but no node PID is recorded");
-        g_status = (g_status == NodeStatus::BINARY_MISSING) ? NodeStatus::BINARY_MISSING : NodeStatus::NOT_RUNNING;
+Java_com_digimobile_node_DigiMobileNodeController_nativeStopSyncEvents(
+        JNIEnv * /*env*/, jobject /*thiz*/, jlong handle) {
+    const auto node = FindNode(handle, "nativeStopSyncEvents");
+    if (!node) {
         return;
     }
+    std::lock_guard<std::mutex> lock(node->tailer_mutex);
+    node->log_tailer.Stop();
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativePollSyncEvents(
+        JNIEnv *env, jobject /*thiz*/, jlong handle, jlongArray j_heights, jdoubleArray j_progress,
+        jlongArray j_block_times, jint j_timeout_ms) {
+    const auto node = FindNode(handle, "nativePollSyncEvents");
+    if (!node) {
+        return 0;
+    }
+    const jsize capacity = env->GetArrayLength(j_heights);
+    if (capacity <= 0 || env->GetArrayLength(j_progress) < capacity ||
+        env->GetArrayLength(j_block_times) < capacity) {
+        return 0;
+    }
+
+    // Deliberately not holding the tailer mutex: the ring has its own lock and
+    // this call blocks for up to j_timeout_ms.
+    std::vector<digimobile::TipEvent> events(static_cast<size_t>(capacity));
+    const size_t count = node->log_tailer.PollTipEvents(events.data(), events.size(), j_timeout_ms);
+
+    std::vector<jlong> heights(count);
+    std::vector<jdouble> progress(count);
+    std::vector<jlong> block_times(count);
+    for (size_t i = 0; i < count; ++i) {
+        heights[i] = events[i].height;
+        progress[i] = events[i].progress;
+        block_times[i] = events[i].block_time;
+    }
+    env->SetLongArrayRegion(j_heights, 0, static_cast<jsize>(count), heights.data());
+    env->SetDoubleArrayRegion(j_progress, 0, static_cast<jsize>(count), progress.data());
+    env->SetLongArrayRegion(j_block_times, 0, static_cast<jsize>(count), block_times.data());
+    return static_cast<jint>(count);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativePollLogRecords(
+        JNIEnv *env, jobject /*thiz*/, jlong handle, jintArray j_kinds, jlongArray j_peer_ids,
+        jlongArray j_times, jobjectArray j_messages, jint j_timeout_ms) {
+    const auto node = FindNode(handle, "nativePollLogRecords");
+    if (!node) {
+        return 0;
+    }
+    const jsize capacity = env->GetArrayLength(j_kinds);
+    if (capacity <= 0 || env->GetArrayLength(j_peer_ids) < capacity ||
+        env->GetArrayLength(j_times) < capacity || env->GetArrayLength(j_messages) < capacity) {
+        return 0;
+    }
 
-    if (kill(g_node_pid, SIGTERM) == 0) {
-        __android_log_print(ANDROID_LOG_INFO, kLogTag,
-                            "Sent SIGTERM to Digi-Mobile node (PID %d)", g_node_pid);
-        int status = 0;
-        if (waitpid(g_node_pid, &status, WNOHANG) > 0) {
-            __android_log_print(ANDROID_LOG_INFO, kLogTag, "Digi-Mobile node exited with status %d", status);
+    // Like nativePollSyncEvents, this blocks on the ring's own lock only.
+    std::vector<digimobile::LogRecord> records(static_cast<size_t>(capacity));
+    const size_t count =
+            node->log_tailer.PollLogRecords(records.data(), records.size(), j_timeout_ms);
+
+    std::vector<jint> kinds(count);
+    std::vector<jlong> peer_ids(count);
+    std::vector<jlong> times(count);
+    for (size_t i = 0; i < count; ++i) {
+        kinds[i] = static_cast<jint>(records[i].kind);
+        peer_ids[i] = records[i].peer_id;
+        times[i] = records[i].observed_ms;
+        jstring message = NewLogString(env, std::move(records[i].message));
+        env->SetObjectArrayElement(j_messages, static_cast<jsize>(i), message);
+        env->DeleteLocalRef(message);
+    }
+    env->SetIntArrayRegion(j_kinds, 0, static_cast<jsize>(count), kinds.data());
+    env->SetLongArrayRegion(j_peer_ids, 0, static_cast<jsize>(count), peer_ids.data());
+    env->SetLongArrayRegion(j_times, 0, static_cast<jsize>(count), times.data());
+    return static_cast<jint>(count);
+}
+
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeRecentLogLines(
+        JNIEnv *env, jobject /*thiz*/, jlong handle, jstring j_log_path, jint j_max_lines) {
+    const auto node = FindNode(handle, "nativeRecentLogLines");
+    if (!node) {
+        return nullptr;
+    }
+    const std::string log_path = ToStdString(env, j_log_path);
+    std::vector<std::string> lines;
+    {
+        std::lock_guard<std::mutex> lock(node->tailer_mutex);
+        if (!node->log_tailer.running() || node->log_tailer.path() != log_path) {
+            return nullptr;  // not following this file; the caller reads it instead
         }
-    } else {
-        __android_log_print(ANDROID_LOG_ERROR, kLogTag,
-                            "Failed to signal Digi-Mobile node (PID %d): errno=%d", g_node_pid, errno);
+        lines = node->log_tailer.RecentLines(
+                static_cast<size_t>(std::max(0, static_cast<int>(j_max_lines))));
     }
 
-    g_node_pid = -1;
-    if (g_status != NodeStatus::BINARY_MISSING) {
-        g_status = NodeStatus::NOT_RUNNING;
+    jclass string_class = env->FindClass("java/lang/String");
+    jobjectArray result = env->NewObjectArray(static_cast<jsize>(lines.size()), string_class, nullptr);
+    env->DeleteLocalRef(string_class);
+    if (!result) {
+        return nullptr;
     }
+    for (size_t i = 0; i < lines.size(); ++i) {
+        jstring text = NewLogString(env, std::move(lines[i]));
+        env->SetObjectArrayElement(result, static_cast<jsize>(i), text);
+        env->DeleteLocalRef(text);
+    }
+    return result;
 }
 
 extern "C" JNIEXPORT jstring JNICALL
-Java_com_digimobile_node_DigiMobileNodeController_nativeGetStatus(
-        JNIEnv *env, jobject /*thiz*/) {
-    if (g_status == NodeStatus::BINARY_MISSING) {
-        return env->NewStringUTF("BINARY_MISSING");
+Java_com_digimobile_node_DigiMobileNodeController_nativeExtractTarGz(
+        JNIEnv *env, jobject /*thiz*/, jstring j_archive, jstring j_dest_dir,
+        jint j_strip_components, jstring j_expected_sha256, jobject j_listener) {
+    const std::string archive = ToStdString(env, j_archive);
+    const std::string dest_dir = ToStdString(env, j_dest_dir);
+
+    jmethodID on_progress = nullptr;
+    if (j_listener) {
+        jclass listener_class = env->GetObjectClass(j_listener);
+        on_progress = env->GetMethodID(listener_class, "onProgress", "(JJ)Z");
+        env->DeleteLocalRef(listener_class);
+        if (!on_progress) {
+            env->ExceptionClear();
+        }
     }
 
-    if (g_status == NodeStatus::ERROR) {
-        return env->NewStringUTF("ERROR");
+    digimobile::ExtractOptions options;
+    options.strip_components = j_strip_components;
+    if (j_expected_sha256) {
+        options.expected_sha256 = ToStdString(env, j_expected_sha256);
+        std::transform(options.expected_sha256.begin(), options.expected_sha256.end(),
+                       options.expected_sha256.begin(),
+                       [](unsigned char c) { return static_cast<char>(tolower(c)); });
+    }
+    digimobile::ExtractProgress progress;
+    if (on_progress) {
+        // Runs on this thread, so env stays valid.
+        progress = [env, j_listener, on_progress](int64_t done, int64_t total) {
+            const jboolean keep_going = env->CallBooleanMethod(
+                    j_listener, on_progress, static_cast<jlong>(done), static_cast<jlong>(total));
+            if (env->ExceptionCheck()) {
+                env->ExceptionClear();
+                return false;
+            }
+            return keep_going == JNI_TRUE;
+        };
     }
 
-    if (g_node_pid > 0) {
-        if (IsProcessAlive(g_node_pid)) {
-            g_status = NodeStatus::RUNNING;
-        } else {
-            g_node_pid = -1;
-            g_status = NodeStatus::NOT_RUNNING;
-        }
+    digimobile::ExtractStats stats;
+    std::string error;
+    const int64_t started_ms = digimobile::MonotonicMillis();
+    if (!digimobile::ExtractTarGz(archive, dest_dir, options, progress, &stats, &error)) {
+        Log(LogPriority::kError, "Extracting %s failed: %s", archive.c_str(), error.c_str());
+        return env->NewStringUTF(error.c_str());
+    }
+    Log(LogPriority::kInfo, "Extracted %s: %lld files, %lld bytes in %lld ms (sha256 %s)",
+        archive.c_str(), static_cast<long long>(stats.files),
+        static_cast<long long>(stats.bytes_written),
+        static_cast<long long>(digimobile::MonotonicMillis() - started_ms),
+        digimobile::Sha256::Implementation());
+    return nullptr;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativePreallocateFile(
+        JNIEnv *env, jobject /*thiz*/, jstring j_path, jlong j_length) {
+    const std::string path = ToStdString(env, j_path);
+    if (j_length < 0) {
+        return JNI_FALSE;
+    }
+    const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        Log(LogPriority::kError, "Unable to open %s: %s", path.c_str(), strerror(errno));
+        return JNI_FALSE;
+    }
+    // Reserve real blocks (not a sparse file) so a full disk fails here rather than
+    // halfway through a download, and chunks written out of order stay contiguous.
+    const int rc = posix_fallocate(fd, 0, static_cast<off_t>(j_length));
+    const bool ok = rc == 0 && ftruncate(fd, static_cast<off_t>(j_length)) == 0;
+    if (!ok) {
+        Log(LogPriority::kWarn, "Unable to preallocate %lld bytes for %s: %s",
+            static_cast<long long>(j_length), path.c_str(),
+            strerror(rc != 0 ? rc : errno));
+    }
+    close(fd);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_digimobile_node_Sha256Hasher_nativeCreate(JNIEnv * /*env*/, jclass /*clazz*/) {
+    return reinterpret_cast<jlong>(new digimobile::Sha256());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_Sha256Hasher_nativeUpdate(
+        JNIEnv *env, jclass /*clazz*/, jlong handle, jbyteArray j_data, jint offset, jint length) {
+    auto *hasher = reinterpret_cast<digimobile::Sha256 *>(handle);
+    if (!hasher || !j_data || offset < 0 || length <= 0 ||
+        offset > env->GetArrayLength(j_data) - length) {
+        return;
+    }
+    // Hashing never blocks, so the array can be pinned instead of copied.
+    void *data = env->GetPrimitiveArrayCritical(j_data, nullptr);
+    if (!data) {
+        return;
+    }
+    hasher->Update(static_cast<const unsigned char *>(data) + offset, static_cast<size_t>(length));
+    env->ReleasePrimitiveArrayCritical(j_data, data, JNI_ABORT);
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_digimobile_node_Sha256Hasher_nativeFinish(JNIEnv *env, jclass /*clazz*/, jlong handle) {
+    auto *hasher = reinterpret_cast<digimobile::Sha256 *>(handle);
+    if (!hasher) {
+        return nullptr;
+    }
+    return env->NewStringUTF(hasher->FinishHex().c_str());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_Sha256Hasher_nativeDestroy(JNIEnv * /*env*/, jclass /*clazz*/, jlong handle) {
+    delete reinterpret_cast<digimobile::Sha256 *>(handle);
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_digimobile_node_Sha256Hasher_nativeHashFile(JNIEnv *env, jclass /*clazz*/, jstring j_path) {
+    const std::string path = ToStdString(env, j_path);
+    std::string hex;
+    std::string error;
+    if (!digimobile::Sha256File(path, &hex, &error)) {
+        Log(LogPriority::kError, "Hashing failed: %s", error.c_str());
+        return nullptr;
+    }
+    return env->NewStringUTF(hex.c_str());
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_digimobile_node_Sha256Hasher_nativeImplementation(JNIEnv *env, jclass /*clazz*/) {
+    return env->NewStringUTF(digimobile::Sha256::Implementation());
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeGetProcessStatus(
+        JNIEnv *env, jobject /*thiz*/, jlong handle, jlongArray j_out) {
+    const auto node = FindNode(handle, "nativeGetProcessStatus");
+    if (!node) {
+        return JNI_FALSE;
+    }
+    if (!j_out || env->GetArrayLength(j_out) < kProcessStatusFieldCount) {
+        return JNI_FALSE;
+    }
+
+    jlong fields[kProcessStatusFieldCount];
+    std::fill(fields, fields + kProcessStatusFieldCount, static_cast<jlong>(-1));
+    const digimobile::NodeSnapshot snapshot = node->controller.Snapshot();
+    fields[kFieldPhase] = static_cast<jlong>(snapshot.phase);
+    fields[kFieldPid] = snapshot.pid;
+    fields[kFieldExitCode] = snapshot.exit_code;
+    fields[kFieldExitSignal] = snapshot.exit_signal;
+
+    digimobile::ProcessStats stats;
+    if (snapshot.pid > 0 && digimobile::ReadProcessStats(snapshot.pid, &stats)) {
+        fields[kFieldUptimeMs] = digimobile::MonotonicMillis() - snapshot.started_ms;
+        fields[kFieldRssBytes] = stats.rss_bytes;
+        fields[kFieldCpuUserMs] = stats.cpu_user_ms;
+        fields[kFieldCpuSystemMs] = stats.cpu_system_ms;
+        fields[kFieldIoReadBytes] = stats.io_read_bytes;
+        fields[kFieldIoWriteBytes] = stats.io_write_bytes;
+        fields[kFieldOpenFds] = stats.open_fds;
+        fields[kFieldThreads] = stats.threads;
+    }
+    env->SetLongArrayRegion(j_out, 0, kProcessStatusFieldCount, fields);
+    return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeGetStorageStatus(
+        JNIEnv *env, jobject /*thiz*/, jlong handle, jlongArray j_out) {
+    const auto node = FindNode(handle, "nativeGetStorageStatus");
+    if (!node) {
+        return JNI_FALSE;
+    }
+    if (!j_out || env->GetArrayLength(j_out) < kStorageStatusFieldCount) {
+        return JNI_FALSE;
+    }
+
+    const digimobile::StorageReport report = node->controller.Storage();
+    jlong fields[kStorageStatusFieldCount];
+    fields[kStorageTotalBytes] = report.storage.total_bytes;
+    fields[kStorageFreeBytes] = report.storage.free_bytes;
+    fields[kStorageBlocksBytes] = report.storage.blocks_bytes;
+    fields[kStoragePruneTargetMb] = report.prune_target_mb;
+    fields[kStorageNextPruneTargetMb] = report.next_prune_target_mb;
+    fields[kStorageWriteLimitBytesPerSec] = report.io.rate_bytes_per_s;
+    fields[kStorageWriteBytesPerSec] = report.io.write_bytes_per_s;
+    fields[kStorageLatencyMs] = report.io.latency_ms;
+    fields[kStorageThrottlePauses] = report.io.pauses;
+    fields[kStorageThrottlePausedMs] = report.io.paused_ms;
+    env->SetLongArrayRegion(j_out, 0, kStorageStatusFieldCount, fields);
+    return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeSampleResourceTuning(
+        JNIEnv *env, jobject /*thiz*/, jint battery_percent, jint charging, jint thermal_status,
+        jint unmetered, jlongArray j_out) {
+    if (!j_out || env->GetArrayLength(j_out) < kResourceTuningFieldCount) {
+        return JNI_FALSE;
+    }
+
+    digimobile::DeviceState state;
+    digimobile::ReadDeviceState(&state);
+    // SELinux hides most of /sys/class/power_supply from apps on recent Android
+    // releases; the framework's view wins whenever the app has one.
+    if (battery_percent >= 0) {
+        state.battery_percent = battery_percent;
+    }
+    if (charging >= 0) {
+        state.charging = charging;
+    }
+    state.thermal_status = thermal_status;
+    state.unmetered = unmetered;
+    const digimobile::NodeTuning tuning = digimobile::DeriveTuning(state);
+
+    jlong fields[kResourceTuningFieldCount];
+    fields[kTuningProfile] = static_cast<jlong>(tuning.profile);
+    fields[kTuningDbcacheMb] = tuning.dbcache_mb;
+    fields[kTuningPar] = tuning.par;
+    fields[kTuningMaxConnections] = tuning.max_connections;
+    fields[kTuningMaxMempoolMb] = tuning.max_mempool_mb;
+    fields[kTuningMemTotalKb] = state.mem_total_kb;
+    fields[kTuningMemAvailableKb] = state.mem_available_kb;
+    fields[kTuningCpuCores] = state.cpu_cores;
+    fields[kTuningThermalMilliCelsius] = state.thermal_millicelsius;
+    fields[kTuningBatteryPercent] = state.battery_percent;
+    fields[kTuningCharging] = state.charging;
+    env->SetLongArrayRegion(j_out, 0, kResourceTuningFieldCount, fields);
+    return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeIsEmbedded(
+        JNIEnv * /*env*/, jobject /*thiz*/, jlong handle) {
+    const auto node = FindNode(handle, "nativeIsEmbedded");
+    if (!node) {
+        return JNI_FALSE;
+    }
+    return node->controller.embedded_active() ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeSetTracingEnabled(
+        JNIEnv * /*env*/, jobject /*thiz*/, jboolean j_enabled, jboolean j_clear) {
+    if (j_clear == JNI_TRUE) {
+        digimobile::ClearTrace();
+    }
+    digimobile::SetTraceEnabled(j_enabled == JNI_TRUE);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_digimobile_node_DigiMobileNodeController_nativeDumpTrace(
+        JNIEnv *env, jobject /*thiz*/, jstring j_path) {
+    const std::string path = ToStdString(env, j_path);
+    std::string error;
+    if (path.empty() || !digimobile::WriteTraceJson(path, &error)) {
+        Log(LogPriority::kError, "Failed to dump trace: %s",
+            path.empty() ? "empty path" : error.c_str());
+        return JNI_FALSE;
+    }
+    Log(LogPriority::kInfo, "Trace written to %s", path.c_str());
+    return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_digimobile_node_SnapshotContainerApplier_nativeCreate(
+        JNIEnv *env, jclass /*clazz*/, jstring j_container, jstring j_dest_dir,
+        jstring j_expected_index_sha256) {
+    std::string expected = j_expected_index_sha256 ? ToStdString(env, j_expected_index_sha256) : "";
+    std::transform(expected.begin(), expected.end(), expected.begin(),
+                   [](unsigned char c) { return static_cast<char>(tolower(c)); });
+    return reinterpret_cast<jlong>(new digimobile::ContainerApplier(
+            ToStdString(env, j_container), ToStdString(env, j_dest_dir), expected));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_SnapshotContainerApplier_nativeMarkAvailable(
+        JNIEnv * /*env*/, jclass /*clazz*/, jlong handle, jlong offset, jlong length) {
+    auto *applier = reinterpret_cast<digimobile::ContainerApplier *>(handle);
+    if (applier && offset >= 0 && length > 0) {
+        applier->MarkAvailable(static_cast<uint64_t>(offset), static_cast<uint64_t>(length));
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_SnapshotContainerApplier_nativeInterrupt(
+        JNIEnv * /*env*/, jclass /*clazz*/, jlong handle) {
+    auto *applier = reinterpret_cast<digimobile::ContainerApplier *>(handle);
+    if (applier) {
+        applier->Interrupt();
+    }
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_digimobile_node_SnapshotContainerApplier_nativeApplyAvailable(
+        JNIEnv *env, jclass /*clazz*/, jlong handle, jint timeout_ms, jint threads) {
+    auto *applier = reinterpret_cast<digimobile::ContainerApplier *>(handle);
+    std::string error;
+    if (!applier || applier->ApplyAvailable(timeout_ms, threads, &error)) {
+        return nullptr;
+    }
+    return env->NewStringUTF(error.c_str());
+}
+
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_digimobile_node_SnapshotContainerApplier_nativeProgress(
+        JNIEnv *env, jclass /*clazz*/, jlong handle) {
+    auto *applier = reinterpret_cast<digimobile::ContainerApplier *>(handle);
+    jlong values[3] = {0, 0, 0};
+    if (applier) {
+        values[0] = static_cast<jlong>(applier->applied_bytes());
+        values[1] = static_cast<jlong>(applier->total_bytes());
+        values[2] = applier->complete() ? 1 : 0;
+    }
+    jlongArray out = env->NewLongArray(3);
+    if (out) {
+        env->SetLongArrayRegion(out, 0, 3, values);
+    }
+    return out;
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_digimobile_node_SnapshotContainerApplier_nativeFinish(
+        JNIEnv *env, jclass /*clazz*/, jlong handle) {
+    auto *applier = reinterpret_cast<digimobile::ContainerApplier *>(handle);
+    std::string error;
+    if (!applier) {
+        return env->NewStringUTF("applier closed");
+    }
+    if (applier->Finish(&error)) {
+        return nullptr;
+    }
+    return env->NewStringUTF(error.c_str());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_SnapshotContainerApplier_nativeDestroy(
+        JNIEnv * /*env*/, jclass /*clazz*/, jlong handle) {
+    delete reinterpret_cast<digimobile::ContainerApplier *>(handle);
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_digimobile_node_BlockBundleFeeder_nativeCreate(
+        JNIEnv *env, jclass /*clazz*/, jstring j_blocks_path, jstring j_headers_path) {
+    return reinterpret_cast<jlong>(new digimobile::BlockBundleFeeder(
+            ToStdString(env, j_blocks_path), ToStdString(env, j_headers_path)));
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_digimobile_node_BlockBundleFeeder_nativeVerify(
+        JNIEnv *env, jclass /*clazz*/, jlong handle, jstring j_expected_sha256,
+        jstring j_expected_prev_hash) {
+    auto *feeder = reinterpret_cast<digimobile::BlockBundleFeeder *>(handle);
+    if (!feeder) {
+        return env->NewStringUTF("feeder closed");
+    }
+    std::string expected = j_expected_sha256 ? ToStdString(env, j_expected_sha256) : "";
+    std::transform(expected.begin(), expected.end(), expected.begin(),
+                   [](unsigned char c) { return static_cast<char>(tolower(c)); });
+    const std::string prev_hash =
+            j_expected_prev_hash ? ToStdString(env, j_expected_prev_hash) : "";
+    std::string error;
+    if (feeder->Verify(expected, prev_hash, &error)) {
+        return nullptr;
+    }
+    return env->NewStringUTF(error.c_str());
+}
+
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_digimobile_node_BlockBundleFeeder_nativeInfo(
+        JNIEnv *env, jclass /*clazz*/, jlong handle) {
+    auto *feeder = reinterpret_cast<digimobile::BlockBundleFeeder *>(handle);
+    jlong values[2] = {0, 0};
+    if (feeder) {
+        values[0] = feeder->info().start_height;
+        values[1] = feeder->info().count;
+    }
+    jlongArray out = env->NewLongArray(2);
+    if (out) {
+        env->SetLongArrayRegion(out, 0, 2, values);
+    }
+    return out;
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_digimobile_node_BlockBundleFeeder_nativeOpenPipe(
+        JNIEnv *env, jclass /*clazz*/, jlong handle, jstring j_pipe_path) {
+    auto *feeder = reinterpret_cast<digimobile::BlockBundleFeeder *>(handle);
+    if (!feeder) {
+        return env->NewStringUTF("feeder closed");
+    }
+    std::string error;
+    if (feeder->OpenPipe(ToStdString(env, j_pipe_path), &error)) {
+        return nullptr;
+    }
+    return env->NewStringUTF(error.c_str());
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_digimobile_node_BlockBundleFeeder_nativeFeed(
+        JNIEnv *env, jclass /*clazz*/, jlong handle) {
+    auto *feeder = reinterpret_cast<digimobile::BlockBundleFeeder *>(handle);
+    if (!feeder) {
+        return env->NewStringUTF("feeder closed");
+    }
+    std::string error;
+    if (feeder->Feed(&error)) {
+        Log(LogPriority::kInfo, "Block bundle imported: %llu blocks",
+            static_cast<unsigned long long>(feeder->fed_blocks()));
+        return nullptr;
+    }
+    Log(LogPriority::kWarn, "Block bundle import stopped after %llu blocks: %s",
+        static_cast<unsigned long long>(feeder->fed_blocks()), error.c_str());
+    return env->NewStringUTF(error.c_str());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_BlockBundleFeeder_nativeInterrupt(
+        JNIEnv * /*env*/, jclass /*clazz*/, jlong handle) {
+    auto *feeder = reinterpret_cast<digimobile::BlockBundleFeeder *>(handle);
+    if (feeder) {
+        feeder->Interrupt();
     }
+}
 
-    const char *status = (g_status == NodeStatus::RUNNING) ? "RUNNING" : "NOT_RUNNING";
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_digimobile_node_BlockBundleFeeder_nativeProgress(
+        JNIEnv *env, jclass /*clazz*/, jlong handle) {
+    auto *feeder = reinterpret_cast<digimobile::BlockBundleFeeder *>(handle);
+    jlong values[3] = {0, 0, 0};
+    if (feeder) {
+        values[0] = static_cast<jlong>(feeder->fed_blocks());
+        values[1] = static_cast<jlong>(feeder->fed_bytes());
+        values[2] = static_cast<jlong>(feeder->total_bytes());
+    }
+    jlongArray out = env->NewLongArray(3);
+    if (out) {
+        env->SetLongArrayRegion(out, 0, 3, values);
+    }
+    return out;
+}
 
-    // A more complete implementation may track start-up phases and use RPC to
-    // report sync progress. This placeholder status is intentionally minimal.
-    return env->NewStringUTF(status);
+extern "C" JNIEXPORT void JNICALL
+Java_com_digimobile_node_BlockBundleFeeder_nativeDestroy(
+        JNIEnv * /*env*/, jclass /*clazz*/, jlong handle) {
+    delete reinterpret_cast<digimobile::BlockBundleFeeder *>(handle);
 }
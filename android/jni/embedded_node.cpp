@@ -0,0 +1,102 @@
+#include "embedded_node.h"
+
+#include <dlfcn.h>
+
+#include "node_supervisor.h"
+
+namespace digimobile {
+namespace {
+
+template <typename Fn>
+bool Resolve(void *handle, const char *name, Fn *out, std::string *error) {
+    *out = reinterpret_cast<Fn>(dlsym(handle, name));
+    if (*out == nullptr) {
+        *error = std::string("missing symbol ") + name;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool EmbeddedNode::Load(const char *library, std::string *error) {
+    if (handle_ != nullptr) {
+        return true;
+    }
+    void *handle = dlopen(library, RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        const char *reason = dlerror();
+        *error = reason ? reason : "dlopen failed";
+        return false;
+    }
+
+    const bool resolved = Resolve(handle, "dgbd_api_version", &api_version_, error) &&
+                          Resolve(handle, "dgbd_init", &init_, error) &&
+                          Resolve(handle, "dgbd_interrupt", &interrupt_, error) &&
+                          Resolve(handle, "dgbd_shutdown", &shutdown_, error) &&
+                          Resolve(handle, "dgbd_get_state", &get_state_, error) &&
+                          Resolve(handle, "dgbd_exit_status", &exit_status_, error) &&
+                          Resolve(handle, "dgbd_rpc", &rpc_, error) &&
+                          Resolve(handle, "dgbd_free", &free_, error);
+    if (resolved && api_version_() != DGBD_API_VERSION) {
+        *error = "API version " + std::to_string(api_version_()) + ", expected " +
+                 std::to_string(DGBD_API_VERSION);
+    } else if (resolved) {
+        handle_ = handle;
+        return true;
+    }
+    dlclose(handle);
+    return false;
+}
+
+bool EmbeddedNode::Start(const std::vector<std::string> &argv, std::string *error) {
+    if (handle_ == nullptr) {
+        *error = "libdigibyted.so not loaded";
+        return false;
+    }
+    std::vector<const char *> args;
+    args.reserve(argv.size());
+    for (const std::string &arg : argv) {
+        args.push_back(arg.c_str());
+    }
+    char message[256] = {};
+    if (init_(static_cast<int>(args.size()), args.data(), message, sizeof(message)) != 0) {
+        *error = message;
+        return false;
+    }
+    started_ms_ = MonotonicMillis();
+    return true;
+}
+
+void EmbeddedNode::Interrupt() {
+    if (handle_ != nullptr) {
+        interrupt_();
+    }
+}
+
+int EmbeddedNode::Shutdown(int timeout_ms) {
+    return handle_ != nullptr ? shutdown_(timeout_ms) : 0;
+}
+
+int EmbeddedNode::state() const {
+    return handle_ != nullptr ? get_state_() : DGBD_STATE_IDLE;
+}
+
+int EmbeddedNode::exit_status() const {
+    return handle_ != nullptr ? exit_status_() : -1;
+}
+
+bool EmbeddedNode::Rpc(const std::string &request_json, std::string *reply) {
+    if (handle_ == nullptr) {
+        return false;
+    }
+    char *raw = rpc_(request_json.c_str());
+    if (raw == nullptr) {
+        return false;
+    }
+    reply->assign(raw);
+    free_(raw);
+    return true;
+}
+
+} // namespace digimobile
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "digibyted_api.h"
+
+namespace digimobile {
+
+// Runtime binding to libdigibyted.so (DigiByte Core as an in-process library).
+// The library is optional: Load() fails cleanly when it is not packaged and
+// the caller keeps using the supervised digibyted child instead.
+class EmbeddedNode {
+public:
+    EmbeddedNode() = default;
+    EmbeddedNode(const EmbeddedNode &) = delete;
+    EmbeddedNode &operator=(const EmbeddedNode &) = delete;
+
+    // dlopen() the library and resolve the dgbd_* entry points. Idempotent;
+    // the handle is kept for the life of the process.
+    bool Load(const char *library, std::string *error);
+    bool loaded() const { return handle_ != nullptr; }
+
+    bool Start(const std::vector<std::string> &argv, std::string *error);
+    void Interrupt();
+    // Returns the exit status, or -1 if the node is still shutting down.
+    int Shutdown(int timeout_ms);
+
+    // One of DGBD_STATE_*; DGBD_STATE_IDLE when the library is not loaded.
+    int state() const;
+    int exit_status() const;
+    int64_t started_ms() const { return started_ms_; }
+
+    // Dispatch a JSON-RPC request or batch in-process. Returns false if the
+    // node is not accepting RPC (still starting, stopping, or not loaded).
+    bool Rpc(const std::string &request_json, std::string *reply);
+
+private:
+    void *handle_ = nullptr;
+    int64_t started_ms_ = 0;
+
+    decltype(&dgbd_api_version) api_version_ = nullptr;
+    decltype(&dgbd_init) init_ = nullptr;
+    decltype(&dgbd_interrupt) interrupt_ = nullptr;
+    decltype(&dgbd_shutdown) shutdown_ = nullptr;
+    decltype(&dgbd_get_state) get_state_ = nullptr;
+    decltype(&dgbd_exit_status) exit_status_ = nullptr;
+    decltype(&dgbd_rpc) rpc_ = nullptr;
+    decltype(&dgbd_free) free_ = nullptr;
+};
+
+} // namespace digimobile
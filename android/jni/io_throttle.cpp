@@ -0,0 +1,172 @@
+#include "io_throttle.h"
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace digimobile {
+namespace {
+
+// Debt beyond this many seconds of the rate is forgiven, so one huge flush
+// cannot keep the daemon paused long after the device has caught up.
+constexpr double kMaxDebtSeconds = 2.0;
+// While no ceiling is configured, a limit this far above what the daemon
+// actually writes no longer binds and is dropped.
+constexpr int64_t kReleaseFactor = 4;
+
+} // namespace
+
+bool ReadDiskCounters(const std::string &path, DiskCounters *out, const std::string &proc_root) {
+    struct stat info {};
+    if (stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+    const unsigned want_major = major(info.st_dev);
+    const unsigned want_minor = minor(info.st_dev);
+    FILE *file = fopen((proc_root + "/diskstats").c_str(), "re");
+    if (!file) {
+        return false;
+    }
+    // major minor name reads merged sectors ms_reading writes merged sectors ms_writing ...
+    char line[512];
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), file)) {
+        unsigned dev_major = 0;
+        unsigned dev_minor = 0;
+        long long reads = 0;
+        long long read_ms = 0;
+        long long writes = 0;
+        long long write_ms = 0;
+        if (sscanf(line, "%u %u %*s %lld %*s %*s %lld %lld %*s %*s %lld", &dev_major,
+                   &dev_minor, &reads, &read_ms, &writes, &write_ms) == 6 &&
+            dev_major == want_major && dev_minor == want_minor) {
+            out->requests = reads + writes;
+            out->busy_ms = read_ms + write_ms;
+            found = true;
+        }
+    }
+    fclose(file);
+    return found;
+}
+
+void TokenBucket::SetRate(int64_t bytes_per_s, int64_t now_ms) {
+    Refill(now_ms);
+    if (rate_ <= 0) {
+        tokens_ = static_cast<double>(bytes_per_s);
+    }
+    rate_ = std::max<int64_t>(bytes_per_s, 0);
+    tokens_ = std::min(tokens_, static_cast<double>(rate_));
+    last_ms_ = now_ms;
+}
+
+void TokenBucket::Refill(int64_t now_ms) {
+    if (rate_ > 0 && now_ms > last_ms_) {
+        tokens_ = std::min(static_cast<double>(rate_),
+                           tokens_ + static_cast<double>(rate_) * (now_ms - last_ms_) / 1000.0);
+    }
+    last_ms_ = std::max(last_ms_, now_ms);
+}
+
+int64_t TokenBucket::Consume(int64_t bytes, int64_t now_ms) {
+    Refill(now_ms);
+    if (rate_ <= 0) {
+        return 0;
+    }
+    tokens_ = std::max(tokens_ - static_cast<double>(bytes),
+                       -kMaxDebtSeconds * static_cast<double>(rate_));
+    if (tokens_ >= 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(std::ceil(-tokens_ * 1000.0 / static_cast<double>(rate_)));
+}
+
+IoThrottle::IoThrottle(const IoThrottlePolicy &policy) : policy_(policy) {}
+
+int IoThrottle::Update(int64_t now_ms, int64_t daemon_write_bytes, const DiskCounters &disk) {
+    if (last_ms_ < 0) {
+        bucket_.SetRate(policy_.max_write_bytes_per_s, now_ms);
+        stats_.rate_bytes_per_s = bucket_.rate();
+        last_ms_ = now_ms;
+        last_write_bytes_ = daemon_write_bytes;
+        StartCycle(now_ms, daemon_write_bytes, disk);
+        return 0;
+    }
+    const int64_t elapsed_ms = now_ms - last_ms_;
+    if (elapsed_ms <= 0) {
+        return 0;
+    }
+
+    int64_t written = 0;
+    if (daemon_write_bytes >= 0 && last_write_bytes_ >= 0) {
+        written = std::max<int64_t>(daemon_write_bytes - last_write_bytes_, 0);
+        stats_.write_bytes_per_s = written * 1000 / elapsed_ms;
+    } else {
+        stats_.write_bytes_per_s = -1;
+    }
+    last_ms_ = now_ms;
+    last_write_bytes_ = daemon_write_bytes;
+
+    // Writes beyond the budget are paid for with a pause. The device is only
+    // judged once a cycle is complete: the samples the daemon ran through
+    // plus the pause that paid for them. On the running part alone, a daemon
+    // that writes faster than the device always looks like it is slowing it
+    // down, and the limit would sink to the floor however much headroom the
+    // pauses leave; on the pause alone, it looks like it writes nothing.
+    const int64_t pause = bucket_.Consume(written, now_ms);
+    if (pause > 0) {
+        return static_cast<int>(std::min<int64_t>(pause, policy_.max_pause_ms));
+    }
+
+    const int64_t cycle_ms = now_ms - cycle_ms_;
+    int64_t cycle_rate = -1;
+    if (daemon_write_bytes >= 0 && cycle_write_bytes_ >= 0) {
+        cycle_rate = std::max<int64_t>(daemon_write_bytes - cycle_write_bytes_, 0) * 1000 / cycle_ms;
+    }
+    stats_.latency_ms = -1;
+    if (disk.requests >= 0 && cycle_disk_.requests >= 0) {
+        const int64_t requests = disk.requests - cycle_disk_.requests;
+        const int64_t busy_ms = disk.busy_ms - cycle_disk_.busy_ms;
+        stats_.latency_ms = requests > 0 ? static_cast<int>(std::max<int64_t>(busy_ms, 0) / requests)
+                                         : 0;
+    }
+    StartCycle(now_ms, daemon_write_bytes, disk);
+
+    // Halve the rate while the device is slow, win back a quarter per calm
+    // cycle: the limit drops within one cycle of a stall and recovers over a
+    // few seconds.
+    const int64_t floor = std::max<int64_t>(policy_.min_write_bytes_per_s, 1);
+    const int64_t ceiling = policy_.max_write_bytes_per_s;
+    const int64_t observed = std::max<int64_t>(cycle_rate, floor);
+    int64_t rate = bucket_.rate();
+    if (stats_.latency_ms > policy_.latency_threshold_ms) {
+        rate = std::max(floor, (rate > 0 ? rate : observed) / 2);
+    } else if (stats_.latency_ms >= 0 && rate > 0) {
+        rate += std::max(floor, rate / 4);
+        if (ceiling > 0) {
+            rate = std::min(rate, ceiling);
+        } else if (rate > kReleaseFactor * observed) {
+            rate = 0;
+        }
+    }
+    if (rate != bucket_.rate()) {
+        bucket_.SetRate(rate, now_ms);
+    }
+    stats_.rate_bytes_per_s = bucket_.rate();
+    return 0;
+}
+
+void IoThrottle::StartCycle(int64_t now_ms, int64_t daemon_write_bytes, const DiskCounters &disk) {
+    cycle_ms_ = now_ms;
+    cycle_write_bytes_ = daemon_write_bytes;
+    cycle_disk_ = disk;
+}
+
+void IoThrottle::NotePause(int64_t ms) {
+    ++stats_.pauses;
+    stats_.paused_ms += ms;
+}
+
+} // namespace digimobile
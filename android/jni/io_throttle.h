@@ -0,0 +1,102 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <string>
+
+namespace digimobile {
+
+// Limits how fast the daemon may write to storage. Block downloads, flushes
+// and prune deletions arrive in bursts that fill the eMMC/UFS queue and stall
+// foreground apps; the daemon's write rate is cut while the device's request
+// latency is above the threshold and recovers while it is below.
+struct IoThrottlePolicy {
+    bool enabled = false;
+    // Directory on the device whose latency is watched (the datadir).
+    std::string data_dir;
+    int sample_interval_ms = 250;
+    // Average time per completed request, over one sample, that counts as
+    // foreground I/O being slowed down.
+    int latency_threshold_ms = 40;
+    // Ceiling for the write rate; 0 lets it run unlimited while latency is
+    // fine. Only this ceiling applies where latency cannot be read.
+    int64_t max_write_bytes_per_s = 0;
+    // The rate is never cut below this, so the node keeps making progress.
+    int64_t min_write_bytes_per_s = 1ll << 20;
+    // Longest single pause; a daemon stopped for long misses peer timeouts.
+    int max_pause_ms = 2000;
+};
+
+// Snapshot of the throttle for status reporting. -1 when unknown.
+struct IoThrottleStats {
+    int64_t rate_bytes_per_s = 0;  // current limit, 0 while unlimited
+    int64_t write_bytes_per_s = -1;
+    int latency_ms = -1;
+    int64_t pauses = 0;
+    int64_t paused_ms = 0;
+};
+
+// Cumulative request counters of one block device from /proc/diskstats.
+struct DiskCounters {
+    int64_t requests = -1;  // reads + writes completed
+    int64_t busy_ms = -1;   // time spent on them (ms reading + ms writing)
+};
+
+// Find the counters of the device holding path. proc_root is "/proc" in
+// production. False where the device has no diskstats entry (tmpfs,
+// overlay) or, as on most Android builds, apps may not read the file.
+bool ReadDiskCounters(const std::string &path, DiskCounters *out,
+                      const std::string &proc_root = "/proc");
+
+// Token bucket over a byte counter. Holds one second of the rate as burst.
+class TokenBucket {
+public:
+    // rate 0 disables the bucket.
+    void SetRate(int64_t bytes_per_s, int64_t now_ms);
+    int64_t rate() const { return rate_; }
+
+    // Charge bytes written since the last call; returns how long the writer
+    // has to be paused to get back within the rate.
+    int64_t Consume(int64_t bytes, int64_t now_ms);
+
+private:
+    void Refill(int64_t now_ms);
+
+    int64_t rate_ = 0;
+    double tokens_ = 0;
+    int64_t last_ms_ = 0;
+};
+
+// Decides the daemon's pauses from its write counter and the device's
+// latency. Not thread-safe; NodeSupervisor drives it from one thread.
+class IoThrottle {
+public:
+    explicit IoThrottle(const IoThrottlePolicy &policy);
+
+    // Feed the cumulative write_bytes of the daemon (/proc/<pid>/io) and the
+    // device counters at now_ms. Returns the pause in milliseconds, 0 to let
+    // the daemon run until the next sample.
+    int Update(int64_t now_ms, int64_t daemon_write_bytes, const DiskCounters &disk);
+
+    // Record a pause that was actually taken.
+    void NotePause(int64_t ms);
+
+    const IoThrottleStats &stats() const { return stats_; }
+
+private:
+    void StartCycle(int64_t now_ms, int64_t daemon_write_bytes, const DiskCounters &disk);
+
+    IoThrottlePolicy policy_;
+    TokenBucket bucket_;
+    IoThrottleStats stats_;
+    int64_t last_ms_ = -1;
+    int64_t last_write_bytes_ = -1;
+    // Where the current cycle (running, then paying for it with a pause)
+    // began; the rate is adjusted once per cycle.
+    int64_t cycle_ms_ = 0;
+    int64_t cycle_write_bytes_ = -1;
+    DiskCounters cycle_disk_;
+};
+
+} // namespace digimobile
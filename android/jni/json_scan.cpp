@@ -0,0 +1,318 @@
+#include "json_scan.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <charconv>
+
+namespace digimobile {
+namespace {
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+size_t SkipSpace(std::string_view json, size_t pos) {
+    while (pos < json.size() && IsSpace(json[pos])) {
+        ++pos;
+    }
+    return pos;
+}
+
+// *pos is at the opening quote; leaves it just past the closing one.
+bool SkipString(std::string_view json, size_t *pos) {
+    for (size_t i = *pos + 1; i < json.size(); ++i) {
+        if (json[i] == '\\') {
+            ++i;
+        } else if (json[i] == '"') {
+            *pos = i + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+// The value with surrounding whitespace removed.
+std::string_view Trim(std::string_view value) {
+    size_t begin = SkipSpace(value, 0);
+    size_t end = value.size();
+    while (end > begin && IsSpace(value[end - 1])) {
+        --end;
+    }
+    return value.substr(begin, end - begin);
+}
+
+int HexDigit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+bool ReadHex4(std::string_view text, size_t pos, uint32_t *out) {
+    if (pos + 4 > text.size()) {
+        return false;
+    }
+    uint32_t value = 0;
+    for (size_t i = pos; i < pos + 4; ++i) {
+        const int digit = HexDigit(text[i]);
+        if (digit < 0) {
+            return false;
+        }
+        value = value << 4 | static_cast<uint32_t>(digit);
+    }
+    *out = value;
+    return true;
+}
+
+void AppendUtf8(uint32_t code_point, std::string *out) {
+    if (code_point < 0x80) {
+        out->push_back(static_cast<char>(code_point));
+    } else if (code_point < 0x800) {
+        out->push_back(static_cast<char>(0xC0 | code_point >> 6));
+        out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x10000) {
+        out->push_back(static_cast<char>(0xE0 | code_point >> 12));
+        out->push_back(static_cast<char>(0x80 | (code_point >> 6 & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else {
+        out->push_back(static_cast<char>(0xF0 | code_point >> 18));
+        out->push_back(static_cast<char>(0x80 | (code_point >> 12 & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (code_point >> 6 & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+}
+
+} // namespace
+
+bool SkipJsonValue(std::string_view json, size_t *pos) {
+    size_t i = SkipSpace(json, *pos);
+    if (i >= json.size()) {
+        return false;
+    }
+    const char first = json[i];
+    if (first == '"') {
+        *pos = i;
+        return SkipString(json, pos);
+    }
+    if (first == '{' || first == '[') {
+        // Strings are skipped whole, so counting brackets is enough to find the
+        // end of a container however deep it nests.
+        int depth = 0;
+        while (i < json.size()) {
+            const char c = json[i];
+            if (c == '"') {
+                if (!SkipString(json, &i)) {
+                    return false;
+                }
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                ++depth;
+            } else if ((c == '}' || c == ']') && --depth == 0) {
+                *pos = i + 1;
+                return true;
+            }
+            ++i;
+        }
+        return false;
+    }
+    // Number, true, false or null: runs up to the next delimiter.
+    const size_t start = i;
+    while (i < json.size() && !IsSpace(json[i]) && json[i] != ',' && json[i] != '}' &&
+           json[i] != ']') {
+        ++i;
+    }
+    *pos = i;
+    return i > start;
+}
+
+bool ForEachJsonMember(std::string_view object,
+                       const std::function<bool(std::string_view key, std::string_view value)> &visit) {
+    size_t i = SkipSpace(object, 0);
+    if (i >= object.size() || object[i] != '{') {
+        return false;
+    }
+    i = SkipSpace(object, i + 1);
+    if (i < object.size() && object[i] == '}') {
+        return true;
+    }
+    while (i < object.size() && object[i] == '"') {
+        size_t key_end = i;
+        if (!SkipString(object, &key_end)) {
+            return false;
+        }
+        const std::string_view key = object.substr(i + 1, key_end - i - 2);
+        i = SkipSpace(object, key_end);
+        if (i >= object.size() || object[i] != ':') {
+            return false;
+        }
+        const size_t value_start = SkipSpace(object, i + 1);
+        size_t value_end = value_start;
+        if (!SkipJsonValue(object, &value_end)) {
+            return false;
+        }
+        if (!visit(key, object.substr(value_start, value_end - value_start))) {
+            return true;
+        }
+        i = SkipSpace(object, value_end);
+        if (i < object.size() && object[i] == '}') {
+            return true;
+        }
+        if (i >= object.size() || object[i] != ',') {
+            return false;
+        }
+        i = SkipSpace(object, i + 1);
+    }
+    return false;
+}
+
+bool ForEachJsonElement(std::string_view array,
+                        const std::function<bool(std::string_view value)> &visit) {
+    size_t i = SkipSpace(array, 0);
+    if (i >= array.size() || array[i] != '[') {
+        return false;
+    }
+    i = SkipSpace(array, i + 1);
+    if (i < array.size() && array[i] == ']') {
+        return true;
+    }
+    while (i < array.size()) {
+        size_t end = i;
+        if (!SkipJsonValue(array, &end)) {
+            return false;
+        }
+        if (!visit(array.substr(i, end - i))) {
+            return true;
+        }
+        i = SkipSpace(array, end);
+        if (i < array.size() && array[i] == ']') {
+            return true;
+        }
+        if (i >= array.size() || array[i] != ',') {
+            return false;
+        }
+        i = SkipSpace(array, i + 1);
+    }
+    return false;
+}
+
+bool FindJsonMember(std::string_view object, std::string_view key, std::string_view *value) {
+    bool found = false;
+    ForEachJsonMember(object, [&](std::string_view name, std::string_view member) {
+        if (name != key) {
+            return true;
+        }
+        *value = member;
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+bool JsonIsNull(std::string_view value) {
+    return Trim(value) == "null";
+}
+
+bool JsonToBool(std::string_view value, bool *out) {
+    value = Trim(value);
+    if (value == "true" || value == "false") {
+        *out = value == "true";
+        return true;
+    }
+    return false;
+}
+
+bool JsonToInt64(std::string_view value, int64_t *out) {
+    value = Trim(value);
+    const char *end = value.data() + value.size();
+    int64_t parsed = 0;
+    const auto result = std::from_chars(value.data(), end, parsed);
+    if (result.ec != std::errc() || result.ptr != end || value.empty()) {
+        return false;
+    }
+    *out = parsed;
+    return true;
+}
+
+bool JsonToDouble(std::string_view value, double *out) {
+    value = Trim(value);
+    // strtod needs a terminator; numbers in RPC replies are far shorter than this.
+    char buffer[64];
+    if (value.empty() || value.size() >= sizeof(buffer) || value[0] == '"') {
+        return false;
+    }
+    memcpy(buffer, value.data(), value.size());
+    buffer[value.size()] = '\0';
+    char *end = nullptr;
+    const double parsed = strtod(buffer, &end);
+    if (end != buffer + value.size()) {
+        return false;
+    }
+    *out = parsed;
+    return true;
+}
+
+bool JsonToString(std::string_view value, std::string *out) {
+    value = Trim(value);
+    if (value.size() < 2 || value.front() != '"' || value.back() != '"') {
+        return false;
+    }
+    out->clear();
+    out->reserve(value.size() - 2);
+    for (size_t i = 1; i + 1 < value.size(); ++i) {
+        const char c = value[i];
+        if (c != '\\') {
+            out->push_back(c);
+            continue;
+        }
+        if (++i + 1 >= value.size()) {
+            return false;
+        }
+        switch (value[i]) {
+            case 'b':
+                out->push_back('\b');
+                break;
+            case 'f':
+                out->push_back('\f');
+                break;
+            case 'n':
+                out->push_back('\n');
+                break;
+            case 'r':
+                out->push_back('\r');
+                break;
+            case 't':
+                out->push_back('\t');
+                break;
+            case 'u': {
+                uint32_t code_point = 0;
+                if (!ReadHex4(value, i + 1, &code_point)) {
+                    return false;
+                }
+                i += 4;
+                uint32_t low = 0;
+                if (code_point >= 0xD800 && code_point < 0xDC00 && i + 6 < value.size() &&
+                    value[i + 1] == '\\' && value[i + 2] == 'u' && ReadHex4(value, i + 3, &low) &&
+                    low >= 0xDC00 && low < 0xE000) {
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                }
+                AppendUtf8(code_point, out);
+                break;
+            }
+            default:
+                out->push_back(value[i]);
+                break;
+        }
+    }
+    return true;
+}
+
+} // namespace digimobile
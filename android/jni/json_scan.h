@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace digimobile {
+
+// Zero-copy reading of RPC replies. Values are handed out as slices of the
+// input text, nested values the caller does not look at are skipped without
+// being decoded, and nothing is allocated. Only as much structure is checked
+// as skipping needs; a malformed reply fails where it stops making sense.
+
+// Advance *pos past the value starting at or after it (leading whitespace is
+// skipped). False if no complete value follows.
+bool SkipJsonValue(std::string_view json, size_t *pos);
+
+// Visit the members of an object in order; visit returns false to stop early.
+// Keys are the raw text between the quotes, so escaped keys never match a
+// plain name. False if object is not a well-formed object.
+bool ForEachJsonMember(std::string_view object,
+                       const std::function<bool(std::string_view key, std::string_view value)> &visit);
+
+// Visit the elements of an array in order; visit returns false to stop early.
+bool ForEachJsonElement(std::string_view array,
+                        const std::function<bool(std::string_view value)> &visit);
+
+// The value of the first member named key.
+bool FindJsonMember(std::string_view object, std::string_view key, std::string_view *value);
+
+// Scalar conversions; false if value is not of that type.
+bool JsonIsNull(std::string_view value);
+bool JsonToBool(std::string_view value, bool *out);
+bool JsonToInt64(std::string_view value, int64_t *out);
+bool JsonToDouble(std::string_view value, double *out);
+// Unescapes a string value into *out.
+bool JsonToString(std::string_view value, std::string *out);
+
+} // namespace digimobile
@@ -0,0 +1,391 @@
+#include "node_controller.h"
+
+#include "trace_recorder.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace digimobile {
+namespace {
+
+// Created by the supervisor in the datadir when digibyted exits cleanly.
+constexpr const char *kCleanShutdownMarker = ".digimobile-clean-shutdown";
+
+// Controllers started with the same files dir share bin/. Staging is
+// serialized across them so concurrent starts never write the same file; the
+// later ones find it up to date without reading the asset.
+std::mutex g_stage_mutex;
+
+// Core's globals allow one in-process node per process, so only the first
+// controller to try it gets to; every other node runs as a child.
+std::atomic<bool> g_embedded_claimed{false};
+
+bool EnsureDir(const std::string &path) {
+    struct stat info {};
+    if (stat(path.c_str(), &info) == 0) {
+        return S_ISDIR(info.st_mode);
+    }
+    return mkdir(path.c_str(), 0700) == 0;
+}
+
+bool EmbeddedAlive(int state) {
+    return state == DGBD_STATE_STARTING || state == DGBD_STATE_RUNNING ||
+           state == DGBD_STATE_STOPPING;
+}
+
+NodePhase EmbeddedPhase(int state) {
+    switch (state) {
+        case DGBD_STATE_STARTING:
+        case DGBD_STATE_RUNNING:
+            return NodePhase::RUNNING;
+        case DGBD_STATE_STOPPING:
+            return NodePhase::STOPPING;
+        case DGBD_STATE_STOPPED:
+            return NodePhase::EXITED;
+        case DGBD_STATE_FAILED:
+            return NodePhase::FAILED;
+        default:
+            return NodePhase::NOT_RUNNING;
+    }
+}
+
+// Exits, crash restarts and SIGKILL escalations reported by the supervisor.
+void LogSupervisorEvent(const std::string &message) {
+    Log(LogPriority::kInfo, "%s", message.c_str());
+}
+
+} // namespace
+
+// Stage an asset at dest_path, rewriting it only when its content changed
+// (see asset_stager.h). If the asset is missing, a previously staged
+// executable is kept.
+bool NodeController::StageAsset(AssetProvider *assets, const std::string &asset_path,
+                                const std::string &dest_path, const std::string &version) {
+    TraceSpan span("jni", "StageAsset", kTraceNoArg, asset_path.c_str());
+    std::string error;
+    std::unique_ptr<Asset> asset = assets ? assets->Open(asset_path, &error) : nullptr;
+    if (!asset) {
+        if (!error.empty()) {
+            Log(LogPriority::kError, "Error reading asset %s: %s", asset_path.c_str(),
+                error.c_str());
+            return false;
+        }
+        if (access(dest_path.c_str(), X_OK) == 0) {
+            Log(LogPriority::kWarn, "Asset %s not found; keeping existing %s", asset_path.c_str(),
+                dest_path.c_str());
+            return true;
+        }
+        Log(LogPriority::kError, "Asset %s not found", asset_path.c_str());
+        return false;
+    }
+
+    const StageSource source = asset->source();
+    switch (StageFile(source, dest_path, version, &error)) {
+        case StageResult::kUpToDate:
+            return true;
+        case StageResult::kStampRefreshed:
+            Log(LogPriority::kInfo, "%s unchanged by app update", dest_path.c_str());
+            return true;
+        case StageResult::kCopied:
+            Log(LogPriority::kInfo, "Staged %s (%lld bytes, %s) into %s", asset_path.c_str(),
+                static_cast<long long>(source.length), asset->stored() ? "stored" : "compressed",
+                dest_path.c_str());
+            return true;
+        case StageResult::kFailed:
+            break;
+    }
+    Log(LogPriority::kError, "Failed to stage %s into %s: %s", asset_path.c_str(),
+        dest_path.c_str(), error.c_str());
+    return false;
+}
+
+// Start DigiByte Core inside this process if the library is packaged and has
+// not been used yet (Core's globals allow one run per process).
+bool NodeController::TryStartEmbedded(const std::string &library,
+                                      const std::vector<std::string> &node_args) {
+    if (library.empty()) {
+        return false;
+    }
+    if (!embedded_owner_) {
+        if (g_embedded_claimed.exchange(true)) {
+            Log(LogPriority::kDebug, "In-process node belongs to another controller; using child");
+            return false;
+        }
+        embedded_owner_ = true;
+    }
+    std::string error;
+    if (!embedded_.Load(library.c_str(), &error)) {
+        Log(LogPriority::kDebug, "In-process node unavailable (%s); using digibyted child",
+            error.c_str());
+        return false;
+    }
+    std::vector<std::string> argv{"digibyted"};
+    argv.insert(argv.end(), node_args.begin(), node_args.end());
+    if (!embedded_.Start(argv, &error)) {
+        Log(LogPriority::kWarn, "In-process node cannot start (%s); using digibyted child",
+            error.c_str());
+        return false;
+    }
+    embedded_active_ = true;
+    Log(LogPriority::kInfo, "Started DigiByte Core in-process");
+    return true;
+}
+
+void NodeController::Start(AssetProvider *assets, const StartRequest &request) {
+    TraceSpan span("jni", "nativeStartNode");
+    std::lock_guard<std::mutex> start_lock(start_mutex_);
+    if (request.config_path.empty() || request.data_dir.empty() || request.files_dir.empty()) {
+        Log(LogPriority::kError,
+            "Config path, data dir, or files dir is empty; refusing to start node");
+        status_ = NodeStatus::ERROR;
+        supervisor_.MarkPhase(NodePhase::FAILED);
+        return;
+    }
+
+    if (embedded_active_) {
+        if (EmbeddedAlive(embedded_.state())) {
+            Log(LogPriority::kInfo, "Start requested but the in-process node is running");
+            status_ = NodeStatus::RUNNING;
+            return;
+        }
+        // The in-process node stopped on its own (e.g. RPC "stop"): collect its
+        // thread. It cannot be started again in this process.
+        embedded_.Shutdown(0);
+        embedded_active_ = false;
+    }
+
+    // Always pass explicit config and datadir flags to avoid relying on defaults.
+    const std::string conf_arg = "-conf=" + request.config_path;
+    const std::string datadir_arg = "-datadir=" + request.data_dir;
+
+    const NodePhase phase = supervisor_.phase();
+    if (phase == NodePhase::RUNNING || phase == NodePhase::RESTART_BACKOFF) {
+        Log(LogPriority::kInfo, "Start requested but node already running with PID %d",
+            supervisor_.pid());
+        status_ = NodeStatus::RUNNING;
+        return;
+    }
+
+    data_dir_ = request.data_dir;
+    last_launch_ = LaunchInfo();
+    std::vector<std::string> node_args{conf_arg, datadir_arg};
+    StorageState storage;
+    if (storage_.prune.max_target_mb > 0 && ReadStorageState(request.data_dir, &storage)) {
+        last_launch_.prune_target_mb = ChoosePruneTargetMb(storage_.prune, storage);
+        // Command-line settings take precedence over prune= in digibyte.conf.
+        node_args.push_back("-prune=" + std::to_string(last_launch_.prune_target_mb));
+        Log(LogPriority::kInfo, "Prune target %d MiB (%lld MiB free, block files %lld MiB)",
+            last_launch_.prune_target_mb, static_cast<long long>(storage.free_bytes >> 20),
+            static_cast<long long>(storage.blocks_bytes >> 20));
+    }
+    if (!block_import_.empty()) {
+        node_args.push_back("-loadblock=" + block_import_);
+        Log(LogPriority::kInfo, "Importing blocks from %s", block_import_.c_str());
+        block_import_.clear();
+    }
+
+    if (TryStartEmbedded(request.embedded_library, node_args)) {
+        status_ = NodeStatus::RUNNING;
+        return;
+    }
+
+    const std::string bin_dir = request.files_dir + "/bin";
+    supervisor_.MarkPhase(NodePhase::STAGING);
+    std::unique_lock<std::mutex> stage_lock(g_stage_mutex);
+    if (!EnsureDir(bin_dir)) {
+        Log(LogPriority::kError, "Failed to ensure bin directory at %s", bin_dir.c_str());
+        status_ = NodeStatus::ERROR;
+        supervisor_.MarkPhase(NodePhase::FAILED);
+        return;
+    }
+
+    node_binary_ = bin_dir + "/digibyted";
+    if (!StageAsset(assets, request.daemon_asset, node_binary_, request.asset_stamp)) {
+        status_ = NodeStatus::BINARY_MISSING;
+        supervisor_.MarkPhase(NodePhase::FAILED);
+        return;
+    }
+
+    const std::string cli_binary = bin_dir + "/digibyte-cli";
+    if (!StageAsset(assets, request.cli_asset, cli_binary, request.asset_stamp)) {
+        Log(LogPriority::kError,
+            "digibyte-cli asset missing; stop/getblockchaininfo calls will fail");
+        status_ = NodeStatus::ERROR;
+        supervisor_.MarkPhase(NodePhase::FAILED);
+        return;
+    }
+    stage_lock.unlock();
+
+    // The marker is tracked even while warm restarts are off, so enabling
+    // them later knows how the datadir was last closed.
+    const std::string marker = request.data_dir + "/" + kCleanShutdownMarker;
+    std::vector<std::string> launch_args;
+    if (warm_restart_.enabled) {
+        if (access(marker.c_str(), F_OK) == 0) {
+            last_launch_.warm = true;
+            launch_args = {"-checkblocks=" + std::to_string(warm_restart_.check_blocks),
+                           "-checklevel=" + std::to_string(warm_restart_.check_level)};
+        }
+        last_launch_.prewarm = PrewarmDatadir(request.data_dir, warm_restart_.prewarm);
+        Log(LogPriority::kInfo, "%s start: prewarmed %d files (%lld MiB) in %lld ms",
+            last_launch_.warm ? "Warm" : "Cold (no clean shutdown recorded)",
+            last_launch_.prewarm.files, static_cast<long long>(last_launch_.prewarm.bytes >> 20),
+            static_cast<long long>(last_launch_.prewarm.elapsed_ms));
+    }
+
+    supervisor_.SetEventCallback(LogSupervisorEvent);
+    supervisor_.SetCleanExitMarker(marker);
+    IoThrottlePolicy io = storage_.io;
+    io.data_dir = request.data_dir;
+    supervisor_.SetIoThrottle(io);
+    std::vector<std::string> argv{node_binary_};
+    argv.insert(argv.end(), node_args.begin(), node_args.end());
+    std::string error;
+    if (!supervisor_.Start(argv, &error, launch_args)) {
+        status_ = NodeStatus::ERROR;
+        Log(LogPriority::kError, "Failed to start Digi-Mobile node: %s", error.c_str());
+        return;
+    }
+    status_ = NodeStatus::RUNNING;
+    Log(LogPriority::kInfo, "Started Digi-Mobile node with PID %d (datadir %s)", supervisor_.pid(),
+        request.data_dir.c_str());
+}
+
+void NodeController::Stop(int timeout_ms) {
+    TraceSpan span("jni", "nativeStopNode");
+    if (embedded_active_) {
+        // In-process shutdown cannot be escalated; a node that does not finish
+        // within the timeout keeps shutting down and is reported as running.
+        const int exit_status = embedded_.Shutdown(timeout_ms);
+        if (exit_status < 0) {
+            Log(LogPriority::kWarn, "In-process node still shutting down after %d ms", timeout_ms);
+            return;
+        }
+        Log(LogPriority::kInfo, "In-process node stopped: status=%d", exit_status);
+        embedded_active_ = false;
+        NodeStatus expected = NodeStatus::RUNNING;
+        status_.compare_exchange_strong(expected, NodeStatus::NOT_RUNNING);
+        return;
+    }
+
+    if (supervisor_.pid() <= 0 && supervisor_.phase() != NodePhase::RESTART_BACKOFF) {
+        Log(LogPriority::kWarn, "Stop requested but no node process is running");
+    }
+
+    // Blocks until the daemon has exited (or been killed) so a following
+    // start never races it for the datadir locks.
+    const ExitInfo exit = supervisor_.Stop(timeout_ms);
+    Log(LogPriority::kInfo, "Digi-Mobile node stopped: code=%d signal=%d", exit.code, exit.signal);
+
+    NodeStatus expected = NodeStatus::RUNNING;
+    status_.compare_exchange_strong(expected, NodeStatus::NOT_RUNNING);
+}
+
+void NodeController::SetWarmRestart(const WarmRestartPolicy &policy) {
+    std::lock_guard<std::mutex> lock(start_mutex_);
+    warm_restart_ = policy;
+}
+
+void NodeController::SetStoragePolicy(const StoragePolicy &policy) {
+    std::lock_guard<std::mutex> lock(start_mutex_);
+    storage_ = policy;
+    if (!data_dir_.empty()) {
+        IoThrottlePolicy io = policy.io;
+        io.data_dir = data_dir_;
+        supervisor_.SetIoThrottle(io);
+    }
+}
+
+void NodeController::SetBlockImport(const std::string &path) {
+    std::lock_guard<std::mutex> lock(start_mutex_);
+    block_import_ = path;
+}
+
+StorageReport NodeController::Storage() const {
+    StorageReport report;
+    std::string data_dir;
+    PrunePolicy prune;
+    {
+        std::lock_guard<std::mutex> lock(start_mutex_);
+        data_dir = data_dir_;
+        prune = storage_.prune;
+        report.prune_target_mb = last_launch_.prune_target_mb;
+    }
+    if (!data_dir.empty() && ReadStorageState(data_dir, &report.storage)) {
+        report.next_prune_target_mb = ChoosePruneTargetMb(prune, report.storage);
+    }
+    report.io = supervisor_.io_throttle_stats();
+    return report;
+}
+
+LaunchInfo NodeController::last_launch() const {
+    std::lock_guard<std::mutex> lock(start_mutex_);
+    return last_launch_;
+}
+
+const char *NodeController::StatusString() const {
+    const NodeStatus status = status_.load();
+    if (status == NodeStatus::BINARY_MISSING) {
+        return "BINARY_MISSING";
+    }
+    if (status == NodeStatus::ERROR) {
+        return "ERROR";
+    }
+    if (embedded_active_) {
+        return EmbeddedAlive(embedded_.state()) ? "RUNNING" : "NOT_RUNNING";
+    }
+    switch (supervisor_.phase()) {
+        case NodePhase::RUNNING:
+        case NodePhase::STOPPING:
+            return "RUNNING";
+        case NodePhase::RESTART_BACKOFF:
+            return "RESTARTING";
+        default:
+            return "NOT_RUNNING";
+    }
+}
+
+NodeSnapshot NodeController::Snapshot() const {
+    NodeSnapshot snapshot;
+    if (embedded_active_) {
+        // The node shares this process, so /proc figures include the app itself.
+        const int state = embedded_.state();
+        const bool alive = EmbeddedAlive(state);
+        snapshot.embedded = true;
+        snapshot.phase = EmbeddedPhase(state);
+        snapshot.pid = alive ? getpid() : -1;
+        snapshot.started_ms = embedded_.started_ms();
+        snapshot.exit_code = alive ? -1 : embedded_.exit_status();
+        return snapshot;
+    }
+    const ExitInfo exit = supervisor_.last_exit();
+    snapshot.phase = supervisor_.phase();
+    snapshot.pid = supervisor_.pid();
+    snapshot.started_ms = supervisor_.started_ms();
+    snapshot.exit_code = exit.code;
+    snapshot.exit_signal = exit.signal;
+    return snapshot;
+}
+
+bool NodeController::EmbeddedRpc(const std::vector<RpcRequest> &requests, bool batch,
+                                 std::string *reply) {
+    if (!embedded_active_ || embedded_.state() != DGBD_STATE_RUNNING || requests.empty()) {
+        return false;
+    }
+    std::string body;
+    if (batch) {
+        body.push_back('[');
+        for (size_t i = 0; i < requests.size(); ++i) {
+            if (i > 0) {
+                body.push_back(',');
+            }
+            AppendRpcRequestJson(requests[i], i, &body);
+        }
+        body.push_back(']');
+    } else {
+        AppendRpcRequestJson(requests.front(), 0, &body);
+    }
+    return embedded_.Rpc(body, reply);
+}
+
+} // namespace digimobile
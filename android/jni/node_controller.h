@@ -0,0 +1,157 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "datadir_cache.h"
+#include "embedded_node.h"
+#include "node_supervisor.h"
+#include "platform.h"
+#include "rpc_client.h"
+#include "storage_budget.h"
+
+namespace digimobile {
+
+// Outcome of the last start request, as reported by nativeGetStatus.
+enum class NodeStatus : int {
+    NOT_RUNNING = 0,
+    RUNNING,
+    BINARY_MISSING,
+    ERROR,
+};
+
+struct StartRequest {
+    std::string config_path;
+    std::string data_dir;
+    std::string files_dir;  // binaries are staged into files_dir/bin
+    std::string asset_stamp;
+    std::string daemon_asset = "bin/digibyted-arm64";
+    std::string cli_asset = "bin/digibyte-cli-arm64";
+    // Preferred over the child when it loads; empty to always spawn.
+    std::string embedded_library = "libdigibyted.so";
+};
+
+// Restarting after a clean shutdown: the chain was flushed and closed
+// properly, so the start-up block verification (default 6 blocks at level 3,
+// rereading and undoing each) can be cut down. After a crash or SIGKILL the
+// daemon runs its full checks.
+struct WarmRestartPolicy {
+    bool enabled = false;
+    int check_blocks = 1;  // 0 would mean every block to digibyted
+    int check_level = 0;
+    // Applied to every child start while enabled, clean shutdown or not.
+    PrewarmOptions prewarm;
+};
+
+// Sizing the node to the device's storage: the prune target is chosen from
+// free space at every start, and the daemon's writes are throttled while
+// they slow the device down. The throttle pauses the child process, so it
+// does not apply to an in-process node.
+struct StoragePolicy {
+    PrunePolicy prune;
+    // data_dir is filled in from the start request.
+    IoThrottlePolicy io;
+};
+
+// How the current (or last) daemon child was launched.
+struct LaunchInfo {
+    bool warm = false;  // reduced verification after a clean shutdown
+    PrewarmStats prewarm;
+    int prune_target_mb = 0;  // passed as -prune, 0 if left to digibyte.conf
+};
+
+// Storage as it stands now, for status reporting.
+struct StorageReport {
+    StorageState storage;
+    int prune_target_mb = 0;       // in effect since the last start
+    int next_prune_target_mb = 0;  // what a start would choose now
+    IoThrottleStats io;
+};
+
+// The node as NodeProcessStatus sees it, whichever way it runs.
+struct NodeSnapshot {
+    NodePhase phase = NodePhase::NOT_RUNNING;
+    pid_t pid = -1;  // the app's own PID for an in-process node
+    int64_t started_ms = 0;
+    int exit_code = -1;
+    int exit_signal = 0;
+    bool embedded = false;
+};
+
+// Lifecycle of one node: stages the daemon and CLI from the app's assets,
+// then runs DigiByte Core in-process (libdigibyted.so) when available and as
+// a supervised digibyted child otherwise. Platform-neutral: the JNI layer
+// and host tools drive the same code with different asset providers.
+// Several controllers may run at once (see node_registry.h); they share the
+// staged binaries, and only the first to start can run Core in-process.
+class NodeController {
+public:
+    NodeController() = default;
+    NodeController(const NodeController &) = delete;
+    NodeController &operator=(const NodeController &) = delete;
+
+    // Blocks while staging; a second start while running is a no-op.
+    void Start(AssetProvider *assets, const StartRequest &request);
+    // Blocks until the node has exited or timeout_ms passed (child: then
+    // SIGKILL; in-process: it keeps shutting down and stays running).
+    void Stop(int timeout_ms);
+    // Takes effect at the next start.
+    void SetWarmRestart(const WarmRestartPolicy &policy);
+    // The prune target takes effect at the next start, the I/O throttle
+    // immediately.
+    void SetStoragePolicy(const StoragePolicy &policy);
+    StorageReport Storage() const;
+    // Pass -loadblock=path to the next start only, e.g. the pipe of a
+    // BlockBundleFeeder. A restart after a crash reuses it; once the feeder
+    // has removed the pipe the daemon logs that it cannot open it and goes on.
+    void SetBlockImport(const std::string &path);
+
+    NodeStatus status() const { return status_.load(); }
+    // "RUNNING", "RESTARTING", "NOT_RUNNING", "BINARY_MISSING" or "ERROR".
+    const char *StatusString() const;
+    NodeSnapshot Snapshot() const;
+    bool embedded_active() const { return embedded_active_.load(); }
+    const std::string &node_binary() const { return node_binary_; }
+    LaunchInfo last_launch() const;
+
+    // Run a request (or batch) against the in-process node. Returns false if
+    // it is not accepting RPC, so the caller falls back to the socket client.
+    bool EmbeddedRpc(const std::vector<RpcRequest> &requests, bool batch, std::string *reply);
+
+    NodeSupervisor &supervisor() { return supervisor_; }
+
+private:
+    bool StageAsset(AssetProvider *assets, const std::string &asset_path,
+                    const std::string &dest_path, const std::string &version);
+    bool TryStartEmbedded(const std::string &library, const std::vector<std::string> &node_args);
+
+    // BINARY_MISSING and ERROR stick until the next start; whether the
+    // daemon is actually alive comes from supervisor_ or embedded_.
+    std::atomic<NodeStatus> status_{NodeStatus::NOT_RUNNING};
+    // Serializes start requests so staging and spawning never interleave.
+    // Also guards warm_restart_, storage_, block_import_, data_dir_ and
+    // last_launch_.
+    mutable std::mutex start_mutex_;
+    std::string node_binary_;
+    std::string data_dir_;
+    WarmRestartPolicy warm_restart_;
+    StoragePolicy storage_;
+    std::string block_import_;
+    LaunchInfo last_launch_;
+    // Owns the daemon child: reaps it on its own thread, escalates stop
+    // requests to SIGKILL and restarts it after crashes when enabled.
+    NodeSupervisor supervisor_;
+    // Core linked in-process; embedded_active_ while the current node runs
+    // inside this process.
+    EmbeddedNode embedded_;
+    std::atomic<bool> embedded_active_{false};
+    // Whether this controller holds the process's one in-process node slot.
+    bool embedded_owner_ = false;
+};
+
+} // namespace digimobile
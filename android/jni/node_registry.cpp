@@ -0,0 +1,41 @@
+#include "node_registry.h"
+
+namespace digimobile {
+
+int64_t NodeRegistry::CreateLocked() {
+    const int64_t handle = next_handle_++;
+    nodes_.emplace(handle, std::make_shared<NodeInstance>());
+    return handle;
+}
+
+int64_t NodeRegistry::Default() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (default_handle_ == 0) {
+        default_handle_ = CreateLocked();
+    }
+    return default_handle_;
+}
+
+int64_t NodeRegistry::Create() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return CreateLocked();
+}
+
+std::shared_ptr<NodeInstance> NodeRegistry::Find(int64_t handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = nodes_.find(handle);
+    return it != nodes_.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<NodeInstance> NodeRegistry::Remove(int64_t handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = nodes_.find(handle);
+    if (it == nodes_.end() || handle == default_handle_) {
+        return nullptr;
+    }
+    std::shared_ptr<NodeInstance> node = std::move(it->second);
+    nodes_.erase(it);
+    return node;
+}
+
+} // namespace digimobile
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "debug_log_tailer.h"
+#include "node_controller.h"
+#include "rpc_client.h"
+#include "rpc_console.h"
+#include "sync_metrics.h"
+
+namespace digimobile {
+
+// One node managed through the registry: its lifecycle plus the RPC client
+// and debug.log follower that talk to it.
+struct NodeInstance {
+    NodeController controller;
+
+    // One keep-alive connection per node, so calls are serialized by rpc_mutex.
+    std::mutex rpc_mutex;
+    std::unique_ptr<RpcClient> rpc_client;
+    // Last sync poll, so only changes are handed to Java; under rpc_mutex.
+    SyncMetricsPoller sync_metrics;
+
+    // The Core console's own connection; thread-safe by itself.
+    RpcConsole console;
+
+    // Guards starting and stopping the tailer; polling uses the rings' own locks.
+    std::mutex tailer_mutex;
+    DebugLogTailer log_tailer;
+};
+
+// Nodes addressed by opaque handles, so several daemons with their own
+// datadirs, ports and scheduling can run side by side in one process. Lookups
+// hand out shared ownership: a node removed while a call is using it is
+// destroyed when that call returns. Handles are never reused, so a stale one
+// finds nothing rather than another node. Thread-safe.
+class NodeRegistry {
+public:
+    NodeRegistry() = default;
+    NodeRegistry(const NodeRegistry &) = delete;
+    NodeRegistry &operator=(const NodeRegistry &) = delete;
+
+    // The node every caller shares unless it asked for its own; created on
+    // first use and never removed.
+    int64_t Default();
+    int64_t Create();
+    // nullptr for an unknown or removed handle.
+    std::shared_ptr<NodeInstance> Find(int64_t handle) const;
+    // Unregisters the node and returns it so the caller can stop it outside
+    // the registry lock. The default node cannot be removed.
+    std::shared_ptr<NodeInstance> Remove(int64_t handle);
+
+private:
+    int64_t CreateLocked();
+
+    mutable std::mutex mutex_;
+    int64_t next_handle_ = 1;
+    int64_t default_handle_ = 0;
+    std::unordered_map<int64_t, std::shared_ptr<NodeInstance>> nodes_;
+};
+
+} // namespace digimobile
@@ -0,0 +1,520 @@
+#include "node_supervisor.h"
+
+#include "proc_stats.h"
+#include "trace_recorder.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(__ANDROID__)
+#include <android/api-level.h>
+#endif
+
+#ifndef __NR_pidfd_open
+#define __NR_pidfd_open 434
+#endif
+#ifndef __NR_pidfd_send_signal
+#define __NR_pidfd_send_signal 424
+#endif
+
+namespace digimobile {
+namespace {
+
+// After SIGKILL the kernel tears the process down promptly unless it is stuck
+// in uninterruptible I/O; do not hang the caller forever in that case.
+constexpr int kKillGraceMs = 5000;
+// Upper bound for Start() waiting on a previous daemon that is still exiting.
+constexpr int kPreviousExitWaitMs = 30000;
+// Duty cycle bounds: shorter periods cost more wakeups than they save, and a
+// daemon paused most of the time misses RPC and peer timeouts.
+constexpr int kMinDutyPeriodMs = 100;
+constexpr int kMinDutyPercent = 10;
+
+// Sampling /proc faster than this costs more than the writes it catches.
+constexpr int kMinIoSampleMs = 50;
+
+// Reasons for the child to be SIGSTOPped (NodeSupervisor::holds_).
+constexpr unsigned kHoldDuty = 1;
+constexpr unsigned kHoldIo = 2;
+
+int OpenPidfd(pid_t pid) {
+#if defined(__ANDROID__)
+    // The app seccomp filter only allows pidfd_* from Android 12 on; calling it
+    // earlier raises SIGSYS and takes the whole app down.
+#if __ANDROID_API__ >= 29
+    if (android_get_device_api_level() < 31) {
+        return -1;
+    }
+#else
+    return -1;
+#endif
+#endif
+    const long fd = syscall(__NR_pidfd_open, pid, 0);
+    return fd >= 0 ? static_cast<int>(fd) : -1;
+}
+
+std::string DescribeExit(pid_t pid, const ExitInfo &exit) {
+    std::string text = "digibyted (PID " + std::to_string(pid) + ") ";
+    if (exit.signal > 0) {
+        return text + "killed by signal " + std::to_string(exit.signal);
+    }
+    if (exit.code >= 0) {
+        return text + "exited with code " + std::to_string(exit.code);
+    }
+    return text + "exited (status unavailable)";
+}
+
+} // namespace
+
+int64_t MonotonicMillis() {
+    timespec ts {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+NodeSupervisor::~NodeSupervisor() {
+    Stop(kKillGraceMs);
+    JoinFinishedThread();
+}
+
+void NodeSupervisor::SetRestartPolicy(const RestartPolicy &policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_ = policy;
+}
+
+int NodeSupervisor::SetSchedulingPolicy(const SchedulingPolicy &policy) {
+    // Resolving core sets reads sysfs; do it before taking the lock.
+    const PreparedScheduling prepared = PrepareScheduling(policy);
+    std::lock_guard<std::mutex> apply_lock(scheduling_mutex_);
+    pid_t child;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        scheduling_ = policy;
+        prepared_scheduling_ = prepared;
+        has_scheduling_ = true;
+        ++scheduling_generation_;
+        changed_.notify_all();
+        if (!child_alive_) {
+            return 0;
+        }
+        child = pid_.load(std::memory_order_acquire);
+        ++scheduling_walks_;
+    }
+    // The /proc walk and its per-thread calls run outside the lock, so the
+    // duty cycle and I/O throttle never wait on them. The child is not reaped
+    // while scheduling_walks_ is set, so its PID is still ours.
+    const int result = ApplySchedulingToProcess(child, prepared);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --scheduling_walks_;
+    }
+    changed_.notify_all();
+    return result;
+}
+
+void NodeSupervisor::SetEventCallback(EventCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    on_event_ = std::move(callback);
+}
+
+void NodeSupervisor::SetCleanExitMarker(const std::string &path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    clean_exit_marker_ = path;
+}
+
+void NodeSupervisor::SetIoThrottle(const IoThrottlePolicy &policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    io_policy_ = policy;
+    io_stats_ = IoThrottleStats();
+    ++io_generation_;
+    changed_.notify_all();
+}
+
+IoThrottleStats NodeSupervisor::io_throttle_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return io_stats_;
+}
+
+ExitInfo NodeSupervisor::last_exit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_exit_;
+}
+
+void NodeSupervisor::Emit(const std::string &message) {
+    EventCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callback = on_event_;
+    }
+    if (callback) {
+        callback(message);
+    }
+}
+
+void NodeSupervisor::JoinFinishedThread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!thread_done_ || !thread_.joinable()) {
+        return;
+    }
+    std::thread finished = std::move(thread_);
+    std::thread duty = std::move(duty_thread_);
+    std::thread io = std::move(io_thread_);
+    lock.unlock();
+    finished.join();
+    if (duty.joinable()) {
+        duty.join();
+    }
+    if (io.joinable()) {
+        io.join();
+    }
+}
+
+bool NodeSupervisor::Start(const std::vector<std::string> &argv, std::string *error,
+                           const std::vector<std::string> &launch_args) {
+    if (argv.empty()) {
+        *error = "empty argv";
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!thread_done_ && !stop_requested_) {
+        // Running, or waiting out a crash backoff that will respawn it.
+        return true;
+    }
+    if (!thread_done_) {
+        // A stop is in flight; never let a second daemon race it for the
+        // datadir's LevelDB locks.
+        if (!changed_.wait_for(lock, std::chrono::milliseconds(kPreviousExitWaitMs),
+                               [this] { return thread_done_; })) {
+            *error = "previous digibyted is still shutting down";
+            return false;
+        }
+    }
+    std::thread finished = std::move(thread_);
+    std::thread duty = std::move(duty_thread_);
+    std::thread io = std::move(io_thread_);
+    lock.unlock();
+    if (finished.joinable()) {
+        finished.join();
+    }
+    if (duty.joinable()) {
+        duty.join();
+    }
+    if (io.joinable()) {
+        io.join();
+    }
+    lock.lock();
+
+    argv_ = argv;
+    launch_args_ = launch_args;
+    stop_requested_ = false;
+    restart_count_.store(0, std::memory_order_release);
+    if (!SpawnLocked(error)) {
+        phase_.store(NodePhase::FAILED, std::memory_order_release);
+        return false;
+    }
+    thread_done_ = false;
+    thread_ = std::thread(&NodeSupervisor::Supervise, this);
+    duty_thread_ = std::thread(&NodeSupervisor::DutyCycle, this);
+    io_thread_ = std::thread(&NodeSupervisor::ThrottleIo, this);
+    return true;
+}
+
+bool NodeSupervisor::SpawnLocked(std::string *error) {
+    // Everything the child needs is prepared before fork(): only
+    // async-signal-safe calls are allowed in a child of a threaded process.
+    std::vector<char *> exec_argv;
+    exec_argv.reserve(argv_.size() + launch_args_.size() + 1);
+    for (std::string &arg : argv_) {
+        exec_argv.push_back(arg.data());
+    }
+    for (std::string &arg : launch_args_) {
+        exec_argv.push_back(arg.data());
+    }
+    exec_argv.push_back(nullptr);
+    if (!clean_exit_marker_.empty()) {
+        unlink(clean_exit_marker_.c_str());
+    }
+    const bool schedule = has_scheduling_;
+    const PreparedScheduling prepared = prepared_scheduling_;
+
+    TraceSpan span("node", "fork");
+    const pid_t child = fork();
+    if (child == 0) {
+        // Threads of the app (and this supervisor) may block signals such as
+        // SIGTERM; the daemon must start with a clean mask to shut down.
+        sigset_t empty;
+        sigemptyset(&empty);
+        sigprocmask(SIG_SETMASK, &empty, nullptr);
+        // Set on the only thread before exec, so the script-verification and
+        // network threads the daemon starts inherit it. Failures (e.g. a
+        // cpuset that excludes the requested cores) leave the defaults.
+        if (schedule) {
+            ApplySchedulingToThread(0, prepared);
+        }
+        execv(exec_argv[0], exec_argv.data());
+        _exit(127);  // If execv fails.
+    }
+    if (child < 0) {
+        *error = std::string("fork failed: ") + strerror(errno);
+        return false;
+    }
+
+    span.set_arg(child);
+    // exec_argv still points into launch_args_; the child has its own copy.
+    launch_args_.clear();
+    pidfd_ = OpenPidfd(child);
+    child_alive_ = true;
+    holds_ = 0;
+    started_ms_.store(MonotonicMillis(), std::memory_order_release);
+    pid_.store(child, std::memory_order_release);
+    phase_.store(NodePhase::RUNNING, std::memory_order_release);
+    changed_.notify_all();
+    return true;
+}
+
+void NodeSupervisor::SignalLocked(int signo) {
+    if (!child_alive_) {
+        return;
+    }
+    if (pidfd_ >= 0 && syscall(__NR_pidfd_send_signal, pidfd_, signo, nullptr, 0) == 0) {
+        return;
+    }
+    // The child is not reaped until child_alive_ is cleared under this lock,
+    // so the PID cannot have been recycled yet.
+    kill(pid_.load(std::memory_order_acquire), signo);
+}
+
+void NodeSupervisor::HoldLocked(unsigned hold, bool on) {
+    const unsigned before = holds_;
+    holds_ = on ? holds_ | hold : holds_ & ~hold;
+    if (before == 0 && holds_ != 0) {
+        SignalLocked(SIGSTOP);
+    } else if (before != 0 && holds_ == 0) {
+        SignalLocked(SIGCONT);
+    }
+}
+
+void NodeSupervisor::Supervise() {
+    TraceSetThreadName("supervisor");
+    for (;;) {
+        const pid_t child = pid_.load(std::memory_order_acquire);
+
+        // Wait without reaping: the zombie keeps the PID reserved until the
+        // state below has been updated under the lock.
+        siginfo_t info {};
+        int rc;
+        {
+            TraceSpan running("node", "waitid", child);
+            do {
+                rc = waitid(P_PID, static_cast<id_t>(child), &info, WEXITED | WNOWAIT);
+            } while (rc < 0 && errno == EINTR);
+        }
+
+        ExitInfo exit;
+        if (rc == 0) {
+            if (info.si_code == CLD_EXITED) {
+                exit.code = info.si_status;
+            } else if (info.si_code == CLD_KILLED || info.si_code == CLD_DUMPED) {
+                exit.signal = info.si_status;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        child_alive_ = false;
+        pid_.store(-1, std::memory_order_release);
+        if (pidfd_ >= 0) {
+            close(pidfd_);
+            pidfd_ = -1;
+        }
+        changed_.wait(lock, [this] { return scheduling_walks_ == 0; });
+        waitpid(child, nullptr, WNOHANG);
+        last_exit_ = exit;
+        if (exit.clean() && !clean_exit_marker_.empty()) {
+            const int fd = open(clean_exit_marker_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                                0600);
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+        if (TraceEnabled()) {
+            char detail[24];
+            snprintf(detail, sizeof(detail), exit.signal != 0 ? "signal %d" : "code %d",
+                     exit.signal != 0 ? exit.signal : exit.code);
+            TraceInstant("node", "exit", child, detail);
+        }
+
+        const int64_t uptime_ms = MonotonicMillis() - started_ms_.load(std::memory_order_acquire);
+        if (uptime_ms >= policy_.stable_after_ms) {
+            restart_count_.store(0, std::memory_order_release);
+        }
+        const int restarts = restart_count_.load(std::memory_order_acquire);
+        const bool restart = !stop_requested_ && policy_.enabled && !exit.clean() &&
+                             restarts < policy_.max_restarts;
+        std::string message = DescribeExit(child, exit);
+
+        if (!restart) {
+            phase_.store(stop_requested_ ? NodePhase::NOT_RUNNING : NodePhase::EXITED,
+                         std::memory_order_release);
+            thread_done_ = true;
+            changed_.notify_all();
+            lock.unlock();
+            Emit(message);
+            return;
+        }
+
+        const int shift = std::min(restarts, 16);
+        const int backoff_ms = static_cast<int>(std::min<int64_t>(
+                static_cast<int64_t>(policy_.initial_backoff_ms) << shift, policy_.max_backoff_ms));
+        restart_count_.store(restarts + 1, std::memory_order_release);
+        phase_.store(NodePhase::RESTART_BACKOFF, std::memory_order_release);
+        changed_.notify_all();
+        lock.unlock();
+        Emit(message + "; restarting in " + std::to_string(backoff_ms) + " ms (attempt " +
+             std::to_string(restarts + 1) + "/" + std::to_string(policy_.max_restarts) + ")");
+        lock.lock();
+
+        changed_.wait_for(lock, std::chrono::milliseconds(backoff_ms),
+                          [this] { return stop_requested_; });
+        std::string error;
+        if (stop_requested_ || !SpawnLocked(&error)) {
+            phase_.store(stop_requested_ ? NodePhase::NOT_RUNNING : NodePhase::FAILED,
+                         std::memory_order_release);
+            thread_done_ = true;
+            changed_.notify_all();
+            lock.unlock();
+            if (!error.empty()) {
+                Emit("restart failed: " + error);
+            }
+            return;
+        }
+    }
+}
+
+void NodeSupervisor::DutyCycle() {
+    TraceSetThreadName("duty cycle");
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!thread_done_) {
+        const int percent = scheduling_.duty_percent;
+        if (!child_alive_ || stop_requested_ || percent >= 100) {
+            changed_.wait(lock);
+            continue;
+        }
+        const uint64_t generation = scheduling_generation_;
+        const pid_t child = pid_.load(std::memory_order_acquire);
+        const int period_ms = std::max(scheduling_.duty_period_ms, kMinDutyPeriodMs);
+        const int run_ms = period_ms * std::max(percent, kMinDutyPercent) / 100;
+        // Any of these ends the current phase early: a new policy, a stop
+        // request, or the child exiting (possibly replaced by a restart).
+        auto interrupted = [this, generation, child] {
+            return thread_done_ || stop_requested_ || !child_alive_ ||
+                   scheduling_generation_ != generation ||
+                   pid_.load(std::memory_order_acquire) != child;
+        };
+
+        if (changed_.wait_for(lock, std::chrono::milliseconds(run_ms), interrupted)) {
+            continue;
+        }
+        HoldLocked(kHoldDuty, true);
+        changed_.wait_for(lock, std::chrono::milliseconds(period_ms - run_ms), interrupted);
+        HoldLocked(kHoldDuty, false);
+    }
+}
+
+void NodeSupervisor::ThrottleIo() {
+    TraceSetThreadName("io throttle");
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!thread_done_) {
+        if (!child_alive_ || stop_requested_ || !io_policy_.enabled) {
+            changed_.wait(lock);
+            continue;
+        }
+        const uint64_t generation = io_generation_;
+        const pid_t child = pid_.load(std::memory_order_acquire);
+        const IoThrottlePolicy policy = io_policy_;
+        // A new policy or a new child starts over with fresh counters.
+        auto interrupted = [this, generation, child] {
+            return thread_done_ || stop_requested_ || !child_alive_ ||
+                   io_generation_ != generation || pid_.load(std::memory_order_acquire) != child;
+        };
+
+        IoThrottle throttle(policy);
+        while (!interrupted()) {
+            // /proc reads stay outside the lock; the PID cannot be recycled
+            // before the supervisor thread clears child_alive_, and a stale
+            // sample is dropped by the check below.
+            lock.unlock();
+            ProcessStats stats;
+            ReadProcessStats(child, &stats);
+            DiskCounters disk;
+            ReadDiskCounters(policy.data_dir, &disk);
+            const int pause_ms = throttle.Update(MonotonicMillis(), stats.io_write_bytes, disk);
+            lock.lock();
+            io_stats_ = throttle.stats();
+            if (interrupted()) {
+                break;
+            }
+            if (pause_ms <= 0) {
+                changed_.wait_for(
+                        lock,
+                        std::chrono::milliseconds(std::max(policy.sample_interval_ms, kMinIoSampleMs)),
+                        interrupted);
+                continue;
+            }
+            TraceSpan span("node", "IoPause", pause_ms);
+            const int64_t paused_at = MonotonicMillis();
+            HoldLocked(kHoldIo, true);
+            changed_.wait_for(lock, std::chrono::milliseconds(pause_ms), interrupted);
+            HoldLocked(kHoldIo, false);
+            throttle.NotePause(MonotonicMillis() - paused_at);
+            io_stats_ = throttle.stats();
+        }
+    }
+}
+
+ExitInfo NodeSupervisor::Stop(int timeout_ms) {
+    TraceSpan span("node", "Stop");
+    std::unique_lock<std::mutex> lock(mutex_);
+    stop_requested_ = true;
+    if (child_alive_) {
+        phase_.store(NodePhase::STOPPING, std::memory_order_release);
+        // A paused child would not act on SIGTERM until resumed.
+        if (holds_ != 0) {
+            SignalLocked(SIGCONT);
+            holds_ = 0;
+        }
+        SignalLocked(SIGTERM);
+        if (!changed_.wait_for(lock, std::chrono::milliseconds(std::max(timeout_ms, 0)),
+                               [this] { return !child_alive_; })) {
+            const pid_t child = pid_.load(std::memory_order_acquire);
+            lock.unlock();
+            Emit("digibyted (PID " + std::to_string(child) + ") ignored SIGTERM for " +
+                 std::to_string(timeout_ms) + " ms; sending SIGKILL");
+            lock.lock();
+            SignalLocked(SIGKILL);
+            changed_.wait_for(lock, std::chrono::milliseconds(kKillGraceMs),
+                              [this] { return !child_alive_; });
+        }
+    } else {
+        // Cancels a pending crash-restart backoff.
+        changed_.notify_all();
+    }
+    changed_.wait_for(lock, std::chrono::milliseconds(kKillGraceMs),
+                      [this] { return thread_done_; });
+    const ExitInfo exit = last_exit_;
+    lock.unlock();
+    JoinFinishedThread();
+    return exit;
+}
+
+} // namespace digimobile
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <thread>
+#include <vector>
+
+#include "io_throttle.h"
+#include "process_scheduling.h"
+
+namespace digimobile {
+
+// Lifecycle phase of the supervised daemon. Values are part of the Java
+// contract (NodeProcessStatus.PHASE_*).
+enum class NodePhase : int {
+    NOT_RUNNING = 0,
+    STAGING = 1,
+    RUNNING = 2,
+    EXITED = 3,
+    FAILED = 4,
+    STOPPING = 5,
+    RESTART_BACKOFF = 6,
+};
+
+struct ExitInfo {
+    int code = -1;   // exit status if the child exited normally
+    int signal = 0;  // terminating signal, 0 if none
+
+    bool clean() const { return code == 0 && signal == 0; }
+};
+
+// Automatic restart after a crash (non-zero exit or fatal signal). Clean
+// exits, including an RPC "stop", are never restarted.
+struct RestartPolicy {
+    bool enabled = false;
+    int max_restarts = 3;
+    int initial_backoff_ms = 2000;
+    int max_backoff_ms = 60000;
+    // A child that stayed up this long resets the restart budget.
+    int stable_after_ms = 5 * 60 * 1000;
+};
+
+// Owns one daemon child process. A dedicated supervisor thread forks/execs the
+// child, blocks in waitid() until it exits, records the real exit status and,
+// if the restart policy allows, respawns it with exponential backoff.
+//
+// The supervisor thread is the only place that reaps the child. It observes
+// the exit with WNOWAIT first and marks the child gone under the lock before
+// reaping, so Stop() can never signal a PID that the kernel has recycled.
+// Where pidfd_open is available, signals are delivered through the pidfd.
+//
+// The child is scheduled (affinity, nice, SCHED_BATCH, I/O priority) between
+// fork and exec, so every daemon thread inherits it. A duty cycle below 100%
+// is enforced by a second thread that alternates SIGSTOP and SIGCONT; Android
+// does not let apps write their own cgroup CPU limits. A third thread holds
+// the child stopped the same way when its writes exceed the I/O throttle's
+// token bucket. The child runs whenever neither holds it.
+//
+// All public methods are thread-safe.
+class NodeSupervisor {
+public:
+    using EventCallback = std::function<void(const std::string &)>;
+
+    NodeSupervisor() = default;
+    ~NodeSupervisor();
+
+    NodeSupervisor(const NodeSupervisor &) = delete;
+    NodeSupervisor &operator=(const NodeSupervisor &) = delete;
+
+    // Spawn argv[0] with argv. Returns true if a child is running afterwards,
+    // including when one was already running. A child that is still shutting
+    // down is waited for first so two daemons never share a datadir.
+    // launch_args are appended for this spawn only; crash restarts use argv
+    // alone.
+    bool Start(const std::vector<std::string> &argv, std::string *error,
+               const std::vector<std::string> &launch_args = {});
+
+    // Send SIGTERM, wait up to timeout_ms for a graceful exit, then escalate to
+    // SIGKILL. Disables restarts for this child. Returns the exit details, or
+    // the last known ones if nothing was running.
+    ExitInfo Stop(int timeout_ms);
+
+    void SetRestartPolicy(const RestartPolicy &policy);
+    // Takes effect at the next spawn and, for a running child, on all of its
+    // threads right away. Returns 0 or the errno of the first failed call.
+    int SetSchedulingPolicy(const SchedulingPolicy &policy);
+    void SetEventCallback(EventCallback callback);
+    // File created whenever the child exits cleanly and removed before every
+    // spawn, so it exists only while the datadir was last closed properly.
+    // Empty to disable.
+    void SetCleanExitMarker(const std::string &path);
+    // Takes effect immediately, also for a running child.
+    void SetIoThrottle(const IoThrottlePolicy &policy);
+    IoThrottleStats io_throttle_stats() const;
+
+    // Record a pre-spawn phase (binary staging, staging failure).
+    void MarkPhase(NodePhase phase) { phase_.store(phase, std::memory_order_release); }
+
+    pid_t pid() const { return pid_.load(std::memory_order_acquire); }
+    NodePhase phase() const { return phase_.load(std::memory_order_acquire); }
+    ExitInfo last_exit() const;
+    int restart_count() const { return restart_count_.load(std::memory_order_acquire); }
+    // CLOCK_MONOTONIC milliseconds at which the current child was spawned.
+    int64_t started_ms() const { return started_ms_.load(std::memory_order_acquire); }
+
+private:
+    bool SpawnLocked(std::string *error);
+    void Supervise();
+    void DutyCycle();
+    void ThrottleIo();
+    void SignalLocked(int signo);
+    // Add or release a reason for the child to be stopped; SIGSTOP when the
+    // first is added, SIGCONT when the last is released.
+    void HoldLocked(unsigned hold, bool on);
+    void Emit(const std::string &message);
+    void JoinFinishedThread();
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::thread thread_;
+    std::thread duty_thread_;
+    std::thread io_thread_;
+    std::vector<std::string> argv_;
+    std::vector<std::string> launch_args_;
+    std::string clean_exit_marker_;
+    RestartPolicy policy_;
+    SchedulingPolicy scheduling_;
+    PreparedScheduling prepared_scheduling_;
+    bool has_scheduling_ = false;  // the child inherits the app's scheduling until set
+    uint64_t scheduling_generation_ = 0;
+    // SetSchedulingPolicy() calls walking the live child's threads; the child
+    // is not reaped until they are done.
+    int scheduling_walks_ = 0;
+    // Serializes SetSchedulingPolicy(), so an older policy never lands last.
+    std::mutex scheduling_mutex_;
+    unsigned holds_ = 0;  // kHold* bits; SIGSTOPped while any is set
+    IoThrottlePolicy io_policy_;
+    uint64_t io_generation_ = 0;
+    IoThrottleStats io_stats_;
+    EventCallback on_event_;
+
+    bool child_alive_ = false;
+    bool stop_requested_ = false;
+    bool thread_done_ = true;
+    int pidfd_ = -1;
+    ExitInfo last_exit_;
+
+    std::atomic<pid_t> pid_{-1};
+    std::atomic<NodePhase> phase_{NodePhase::NOT_RUNNING};
+    std::atomic<int> restart_count_{0};
+    std::atomic<int64_t> started_ms_{0};
+};
+
+int64_t MonotonicMillis();
+
+} // namespace digimobile
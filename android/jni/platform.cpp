@@ -0,0 +1,50 @@
+#include "platform.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace digimobile {
+namespace {
+
+class FileAsset : public Asset {
+public:
+    FileAsset(int fd, int64_t length) : fd_(fd), length_(length) {}
+    ~FileAsset() override { close(fd_); }
+
+    StageSource source() const override {
+        StageSource source;
+        source.fd = fd_;
+        source.length = length_;
+        return source;
+    }
+    bool stored() const override { return true; }
+
+private:
+    int fd_;
+    int64_t length_;
+};
+
+} // namespace
+
+std::unique_ptr<Asset> DirectoryAssetProvider::Open(const std::string &path, std::string *error) {
+    const std::string full = root_ + "/" + path;
+    const int fd = open(full.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno != ENOENT) {
+            *error = "open " + full + ": " + strerror(errno);
+        }
+        return nullptr;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        *error = full + " is not a regular file";
+        close(fd);
+        return nullptr;
+    }
+    return std::make_unique<FileAsset>(fd, static_cast<int64_t>(info.st_size));
+}
+
+} // namespace digimobile
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "asset_stager.h"
+
+namespace digimobile {
+
+// What the core library needs from the platform it runs on. Android builds
+// link platform_android.cpp (logcat, APK assets); Linux builds link
+// platform_linux.cpp (stderr) and stage assets from a directory.
+
+enum class LogPriority : int {
+    kDebug = 0,
+    kInfo,
+    kWarn,
+    kError,
+};
+
+// printf-style; one call is one log line.
+void Log(LogPriority priority, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+// An opened asset, readable through source() until it is destroyed.
+class Asset {
+public:
+    virtual ~Asset() = default;
+    virtual StageSource source() const = 0;
+    // Stored assets are read through source().fd; compressed ones were
+    // inflated into source().data.
+    virtual bool stored() const = 0;
+};
+
+class AssetProvider {
+public:
+    virtual ~AssetProvider() = default;
+    // nullptr with *error empty if the asset does not exist, or with *error
+    // set if it exists but could not be read.
+    virtual std::unique_ptr<Asset> Open(const std::string &path, std::string *error) = 0;
+};
+
+// Assets are plain files under root, e.g. a directory holding
+// bin/digibyted-arm64 for a host run.
+class DirectoryAssetProvider : public AssetProvider {
+public:
+    explicit DirectoryAssetProvider(std::string root) : root_(std::move(root)) {}
+    std::unique_ptr<Asset> Open(const std::string &path, std::string *error) override;
+
+private:
+    std::string root_;
+};
+
+} // namespace digimobile
@@ -0,0 +1,83 @@
+#include "platform_android.h"
+
+#include <android/log.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+namespace digimobile {
+namespace {
+
+constexpr const char *kLogTag = "DigiMobileJNI";
+
+// Stored (uncompressed) assets are exposed as a range of the APK's file
+// descriptor, so staging copies them kernel-side; compressed ones are
+// inflated once into memory by the asset manager.
+class ApkAsset : public Asset {
+public:
+    explicit ApkAsset(AAsset *asset) : asset_(asset) {
+        off64_t start = 0;
+        off64_t length = 0;
+        source_.fd = AAsset_openFileDescriptor64(asset_, &start, &length);
+        if (source_.fd >= 0) {
+            source_.offset = static_cast<off_t>(start);
+            source_.length = length;
+        } else {
+            source_.data = AAsset_getBuffer(asset_);
+            source_.length = AAsset_getLength64(asset_);
+        }
+    }
+    ~ApkAsset() override {
+        if (source_.fd >= 0) {
+            close(source_.fd);
+        }
+        AAsset_close(asset_);
+    }
+
+    bool readable() const { return source_.fd >= 0 || source_.data != nullptr; }
+    StageSource source() const override { return source_; }
+    bool stored() const override { return source_.fd >= 0; }
+
+private:
+    AAsset *asset_;
+    StageSource source_;
+};
+
+int AndroidPriority(LogPriority priority) {
+    switch (priority) {
+        case LogPriority::kDebug:
+            return ANDROID_LOG_DEBUG;
+        case LogPriority::kInfo:
+            return ANDROID_LOG_INFO;
+        case LogPriority::kWarn:
+            return ANDROID_LOG_WARN;
+        case LogPriority::kError:
+            return ANDROID_LOG_ERROR;
+    }
+    return ANDROID_LOG_INFO;
+}
+
+} // namespace
+
+void Log(LogPriority priority, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    __android_log_vprint(AndroidPriority(priority), kLogTag, format, args);
+    va_end(args);
+}
+
+std::unique_ptr<Asset> ApkAssetProvider::Open(const std::string &path, std::string *error) {
+    AAsset *asset = manager_
+            ? AAssetManager_open(manager_, path.c_str(), AASSET_MODE_STREAMING)
+            : nullptr;
+    if (!asset) {
+        return nullptr;
+    }
+    auto opened = std::make_unique<ApkAsset>(asset);
+    if (!opened->readable()) {
+        *error = "error reading asset " + path;
+        return nullptr;
+    }
+    return opened;
+}
+
+} // namespace digimobile
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <android/asset_manager.h>
+
+#include "platform.h"
+
+namespace digimobile {
+
+// Assets packaged in the APK. The AAssetManager must outlive the provider.
+class ApkAssetProvider : public AssetProvider {
+public:
+    explicit ApkAssetProvider(AAssetManager *manager) : manager_(manager) {}
+    std::unique_ptr<Asset> Open(const std::string &path, std::string *error) override;
+
+private:
+    AAssetManager *manager_;
+};
+
+} // namespace digimobile
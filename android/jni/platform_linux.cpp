@@ -0,0 +1,26 @@
+#include "platform.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace digimobile {
+
+// Host builds log to stderr. Debug lines are only printed with
+// DIGIMOBILE_LOG_DEBUG set, matching logcat's default filtering.
+void Log(LogPriority priority, const char *format, ...) {
+    static const bool debug = getenv("DIGIMOBILE_LOG_DEBUG") != nullptr;
+    if (priority == LogPriority::kDebug && !debug) {
+        return;
+    }
+    static const char *const kPrefixes[] = {"D", "I", "W", "E"};
+    char line[1024];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    // One fprintf per line so lines from different threads do not interleave.
+    fprintf(stderr, "%s DigiMobileJNI: %s\n", kPrefixes[static_cast<int>(priority)], line);
+}
+
+} // namespace digimobile
@@ -0,0 +1,100 @@
+#include "proc_stats.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace digimobile {
+namespace {
+
+// Read a small /proc file into buf (NUL-terminated). Returns bytes read or -1.
+ssize_t ReadSmallFile(const std::string &path, char *buf, size_t size) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t total = 0;
+    while (static_cast<size_t>(total) < size - 1) {
+        const ssize_t n = read(fd, buf + total, size - 1 - static_cast<size_t>(total));
+        if (n <= 0) {
+            break;
+        }
+        total += n;
+    }
+    close(fd);
+    buf[total] = '\0';
+    return total;
+}
+
+int64_t FindKeyValue(const char *text, const char *key) {
+    const char *pos = strstr(text, key);
+    if (!pos) {
+        return -1;
+    }
+    return strtoll(pos + strlen(key), nullptr, 10);
+}
+
+} // namespace
+
+bool ReadProcessStats(pid_t pid, ProcessStats *out, const std::string &proc_root) {
+    const std::string base = proc_root + "/" + std::to_string(pid);
+    char buf[4096];
+    ProcessStats stats;
+
+    // /proc/<pid>/stat: "pid (comm) state ppid ..."; comm may contain spaces
+    // and parentheses, so fields are counted from the last ')'.
+    if (ReadSmallFile(base + "/stat", buf, sizeof(buf)) <= 0) {
+        return false;
+    }
+    const char *after_comm = strrchr(buf, ')');
+    if (!after_comm) {
+        return false;
+    }
+    // Field 3 (state) follows ") "; utime/stime are fields 14/15, num_threads 20.
+    long long fields[18] = {};
+    char *cursor = const_cast<char *>(after_comm) + 2;
+    if (*cursor == 'Z' || *cursor == 'X') {
+        return false;  // Exited; only the zombie entry remains.
+    }
+    cursor = strchr(cursor, ' ');
+    for (int i = 0; cursor && i < 18; ++i) {
+        fields[i] = strtoll(cursor, &cursor, 10);
+    }
+    const long ticks = sysconf(_SC_CLK_TCK);
+    if (ticks > 0) {
+        stats.cpu_user_ms = fields[10] * 1000 / ticks;    // field 14
+        stats.cpu_system_ms = fields[11] * 1000 / ticks;  // field 15
+    }
+    stats.threads = fields[16];                           // field 20
+
+    if (ReadSmallFile(base + "/statm", buf, sizeof(buf)) > 0) {
+        char *end = nullptr;
+        strtoll(buf, &end, 10);  // size
+        const long long resident_pages = strtoll(end, nullptr, 10);
+        stats.rss_bytes = resident_pages * sysconf(_SC_PAGESIZE);
+    }
+
+    if (ReadSmallFile(base + "/io", buf, sizeof(buf)) > 0) {
+        stats.io_read_bytes = FindKeyValue(buf, "\nread_bytes: ");
+        stats.io_write_bytes = FindKeyValue(buf, "\nwrite_bytes: ");
+    }
+
+    if (DIR *dir = opendir((base + "/fd").c_str())) {
+        int64_t count = 0;
+        while (dirent *entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                ++count;
+            }
+        }
+        closedir(dir);
+        stats.open_fds = count;
+    }
+
+    *out = stats;
+    return true;
+}
+
+} // namespace digimobile
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+
+namespace digimobile {
+
+// Resource usage of a live process sampled from /proc/<pid>. Fields that could
+// not be read are left at -1 so callers can tell "zero" from "unknown".
+struct ProcessStats {
+    int64_t rss_bytes = -1;
+    int64_t cpu_user_ms = -1;
+    int64_t cpu_system_ms = -1;
+    int64_t io_read_bytes = -1;   // bytes fetched from storage (read_bytes)
+    int64_t io_write_bytes = -1;  // bytes sent to storage (write_bytes)
+    int64_t open_fds = -1;
+    int64_t threads = -1;
+};
+
+// Sample /proc/<pid>/{stat,statm,io,fd}. proc_root is "/proc" in production and
+// may point at a fake tree elsewhere. Returns false if the process is gone.
+bool ReadProcessStats(pid_t pid, ProcessStats *out, const std::string &proc_root = "/proc");
+
+} // namespace digimobile
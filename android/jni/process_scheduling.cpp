@@ -0,0 +1,162 @@
+#include "process_scheduling.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifndef __NR_ioprio_set
+#if defined(__aarch64__)
+#define __NR_ioprio_set 30
+#elif defined(__x86_64__)
+#define __NR_ioprio_set 251
+#endif
+#endif
+
+namespace digimobile {
+namespace {
+
+constexpr int kIoprioWhoProcess = 1;  // IOPRIO_WHO_PROCESS: a single thread id
+constexpr int kIoprioClassShift = 13;
+constexpr int kIoprioClassIdle = 3;
+
+int64_t ReadMaxFrequency(const std::string &cpu_dir) {
+    const int fd = open((cpu_dir + "/cpufreq/cpuinfo_max_freq").c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    char buf[32];
+    const ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) {
+        return -1;
+    }
+    buf[n] = '\0';
+    return strtoll(buf, nullptr, 10);
+}
+
+} // namespace
+
+uint64_t CoreSetMask(CoreSet set, const std::string &sys_root) {
+    const std::string base = sys_root + "/sys/devices/system/cpu";
+    DIR *dir = opendir(base.c_str());
+    if (!dir) {
+        return 0;
+    }
+    std::vector<std::pair<int, int64_t>> cores;  // cpu number, max frequency
+    while (dirent *entry = readdir(dir)) {
+        const char *name = entry->d_name;
+        if (strncmp(name, "cpu", 3) != 0 || name[3] < '0' || name[3] > '9') {
+            continue;
+        }
+        char *end = nullptr;
+        const long cpu = strtol(name + 3, &end, 10);
+        if (*end != '\0') {
+            continue;  // cpufreq, cpuidle, ...
+        }
+        if (cpu >= 64) {
+            closedir(dir);
+            return 0;
+        }
+        cores.emplace_back(static_cast<int>(cpu), ReadMaxFrequency(base + "/" + name));
+    }
+    closedir(dir);
+    if (cores.empty()) {
+        return 0;
+    }
+
+    uint64_t all = 0;
+    int64_t slowest = INT64_MAX;
+    for (const auto &core : cores) {
+        all |= uint64_t{1} << core.first;
+        if (core.second > 0) {
+            slowest = std::min(slowest, core.second);
+        }
+    }
+    if (set == CoreSet::kAll || slowest == INT64_MAX) {
+        return all;
+    }
+    uint64_t little = 0;
+    for (const auto &core : cores) {
+        if (core.second == slowest) {
+            little |= uint64_t{1} << core.first;
+        }
+    }
+    if (little == all) {
+        return all;  // one cluster
+    }
+    return set == CoreSet::kLittle ? little : all & ~little;
+}
+
+PreparedScheduling PrepareScheduling(const SchedulingPolicy &policy, const std::string &sys_root) {
+    PreparedScheduling prepared;
+    CPU_ZERO(&prepared.cpus);
+    const uint64_t mask = CoreSetMask(policy.cores, sys_root);
+    for (int cpu = 0; cpu < 64; ++cpu) {
+        if (mask & (uint64_t{1} << cpu)) {
+            CPU_SET(cpu, &prepared.cpus);
+        }
+    }
+    prepared.restrict_cpus = mask != 0;
+    prepared.nice = std::clamp(policy.nice, -20, 19);
+    prepared.sched_policy = policy.batch ? SCHED_BATCH : SCHED_OTHER;
+    if (policy.io_class > 0) {
+        // The idle class has no levels.
+        const int level = policy.io_class == kIoprioClassIdle ? 0 : std::clamp(policy.io_level, 0, 7);
+        prepared.ioprio = (policy.io_class << kIoprioClassShift) | level;
+    }
+    return prepared;
+}
+
+int ApplySchedulingToThread(pid_t tid, const PreparedScheduling &prepared) {
+    int first_error = 0;
+    auto check = [&first_error](bool ok) {
+        if (!ok && first_error == 0) {
+            first_error = errno;
+        }
+    };
+    // Affinity is narrowed further by the app's cpuset cgroup; sched_setaffinity
+    // fails with EINVAL only if the two do not overlap at all.
+    if (prepared.restrict_cpus) {
+        check(sched_setaffinity(tid, sizeof(prepared.cpus), &prepared.cpus) == 0);
+    }
+    sched_param param {};
+    check(sched_setscheduler(tid, prepared.sched_policy, &param) == 0);
+    check(setpriority(PRIO_PROCESS, static_cast<id_t>(tid), prepared.nice) == 0);
+#ifdef __NR_ioprio_set
+    if (prepared.ioprio >= 0) {
+        check(syscall(__NR_ioprio_set, kIoprioWhoProcess, tid, prepared.ioprio) == 0);
+    }
+#endif
+    return first_error;
+}
+
+int ApplySchedulingToProcess(pid_t pid, const PreparedScheduling &prepared,
+                             const std::string &proc_root) {
+    DIR *dir = opendir((proc_root + "/" + std::to_string(pid) + "/task").c_str());
+    if (!dir) {
+        return errno;
+    }
+    int first_error = 0;
+    while (dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        const pid_t tid = static_cast<pid_t>(strtol(entry->d_name, nullptr, 10));
+        const int error = ApplySchedulingToThread(tid, prepared);
+        if (error != 0 && error != ESRCH && first_error == 0) {
+            first_error = error;  // ESRCH: the thread exited meanwhile
+        }
+    }
+    closedir(dir);
+    return first_error;
+}
+
+} // namespace digimobile
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <sched.h>
+#include <sys/types.h>
+
+#include <cstdint>
+#include <string>
+
+namespace digimobile {
+
+// Cores the daemon may run on. Little and big are told apart by each core's
+// maximum frequency; on a device with a single cluster both mean "all".
+enum class CoreSet : int {
+    kAll = 0,
+    kLittle = 1,
+    kBig = 2,
+};
+
+// How the node child is scheduled. Values are part of the Java contract
+// (DigiMobileNodeController.setSchedulingPolicy).
+struct SchedulingPolicy {
+    CoreSet cores = CoreSet::kAll;
+    int nice = 0;             // -20..19; the app itself runs at 0
+    bool batch = false;       // SCHED_BATCH: no wakeup preemption of the UI
+    int io_class = 0;         // IOPRIO_CLASS_BE (2) or _IDLE (3); 0 leaves I/O priority alone
+    int io_level = 4;         // 0 (highest) .. 7 within the best-effort class
+    int duty_percent = 100;   // share of each period the daemon may run
+    int duty_period_ms = 1000;
+};
+
+// A policy resolved to raw values before fork(), so applying it in the child
+// makes only async-signal-safe system calls.
+struct PreparedScheduling {
+    cpu_set_t cpus;
+    bool restrict_cpus = false;
+    int nice = 0;
+    int sched_policy = SCHED_OTHER;
+    int ioprio = -1;  // encoded for ioprio_set, -1 to leave it alone
+};
+
+// Bit n set for every core of the set; 0 if the set cannot be resolved (cpufreq
+// unreadable, more than 64 cores). sys_root is "" in production.
+uint64_t CoreSetMask(CoreSet set, const std::string &sys_root = "");
+
+PreparedScheduling PrepareScheduling(const SchedulingPolicy &policy,
+                                     const std::string &sys_root = "");
+
+// Apply to one thread; tid 0 is the calling thread. Async-signal-safe. Returns
+// 0, or the errno of the first call that failed (the rest are still tried).
+int ApplySchedulingToThread(pid_t tid, const PreparedScheduling &prepared);
+
+// Apply to every thread of a running process. Threads it starts later inherit
+// the calling thread's settings, so a daemon scheduled before exec needs no
+// further calls.
+int ApplySchedulingToProcess(pid_t pid, const PreparedScheduling &prepared,
+                             const std::string &proc_root = "/proc");
+
+} // namespace digimobile
@@ -0,0 +1,251 @@
+#include "resource_governor.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace digimobile {
+namespace {
+
+// Thermal zones often include the CPU itself, which runs warm under load; only
+// treat the device as hot well above that. THERMAL_STATUS_MODERATE (2) is the
+// level at which Android itself starts throttling.
+constexpr int kHotMilliCelsius = 65000;
+constexpr int kThermalStatusModerate = 2;
+constexpr int kLowBatteryPercent = 20;
+
+// Assumed when /proc/meminfo is unreadable: the low end of supported devices.
+constexpr int64_t kFallbackMemTotalMb = 3072;
+constexpr int kFallbackCores = 4;
+
+constexpr int kMinDbcacheMb = 64;
+constexpr int kMaxDbcacheMb = 2048;
+// digibyted scales script verification to at most 15 worker threads.
+constexpr int kMaxPar = 16;
+
+ssize_t ReadSmallFile(const std::string &path, char *buf, size_t size) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t total = 0;
+    while (static_cast<size_t>(total) < size - 1) {
+        const ssize_t n = read(fd, buf + total, size - 1 - static_cast<size_t>(total));
+        if (n <= 0) {
+            break;
+        }
+        total += n;
+    }
+    close(fd);
+    buf[total] = '\0';
+    return total;
+}
+
+bool ReadInt(const std::string &path, int64_t *value) {
+    char buf[64];
+    if (ReadSmallFile(path, buf, sizeof(buf)) <= 0) {
+        return false;
+    }
+    char *end = nullptr;
+    const long long parsed = strtoll(buf, &end, 10);
+    if (end == buf) {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+bool ReadWord(const std::string &path, std::string *value) {
+    char buf[64];
+    if (ReadSmallFile(path, buf, sizeof(buf)) <= 0) {
+        return false;
+    }
+    value->assign(buf, strcspn(buf, "\r\n"));
+    return true;
+}
+
+int64_t FindKeyValue(const char *text, const char *key) {
+    const char *pos = strstr(text, key);
+    if (!pos) {
+        return -1;
+    }
+    return strtoll(pos + strlen(key), nullptr, 10);
+}
+
+// "0-3,6-7" -> 6.
+int CountCpuList(const char *list) {
+    int count = 0;
+    const char *p = list;
+    while (*p >= '0' && *p <= '9') {
+        char *end = nullptr;
+        const long first = strtol(p, &end, 10);
+        long last = first;
+        if (*end == '-') {
+            last = strtol(end + 1, &end, 10);
+        }
+        if (last >= first) {
+            count += static_cast<int>(last - first + 1);
+        }
+        p = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+template <typename Fn>
+void ForEachEntry(const std::string &dir_path, const char *prefix, Fn fn) {
+    DIR *dir = opendir(dir_path.c_str());
+    if (!dir) {
+        return;
+    }
+    const size_t prefix_length = strlen(prefix);
+    while (dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] != '.' && strncmp(entry->d_name, prefix, prefix_length) == 0) {
+            fn(dir_path + "/" + entry->d_name);
+        }
+    }
+    closedir(dir);
+}
+
+void ReadMemory(DeviceState *state, const std::string &root) {
+    char buf[4096];
+    if (ReadSmallFile(root + "/proc/meminfo", buf, sizeof(buf)) <= 0) {
+        return;
+    }
+    state->mem_total_kb = FindKeyValue(buf, "MemTotal:");
+    state->mem_available_kb = FindKeyValue(buf, "MemAvailable:");
+}
+
+void ReadCores(DeviceState *state, const std::string &root) {
+    // Big.LITTLE devices hotplug cores, so the online count drifts; size for
+    // every core the kernel can bring up.
+    char buf[256];
+    if (ReadSmallFile(root + "/sys/devices/system/cpu/possible", buf, sizeof(buf)) > 0) {
+        const int cores = CountCpuList(buf);
+        if (cores > 0) {
+            state->cpu_cores = cores;
+            return;
+        }
+    }
+    if (root.empty()) {
+        const long cores = sysconf(_SC_NPROCESSORS_CONF);
+        if (cores > 0) {
+            state->cpu_cores = static_cast<int>(cores);
+        }
+    }
+}
+
+void ReadThermal(DeviceState *state, const std::string &root) {
+    int hottest = -1;
+    ForEachEntry(root + "/sys/class/thermal", "thermal_zone", [&](const std::string &zone) {
+        int64_t temp = 0;
+        if (!ReadInt(zone + "/temp", &temp) || temp <= 0) {
+            return;  // disabled zones report 0 or a negative sentinel
+        }
+        if (temp <= 150) {
+            temp *= 1000;  // a few drivers report whole degrees
+        }
+        if (temp < 150000) {
+            hottest = std::max(hottest, static_cast<int>(temp));
+        }
+    });
+    state->thermal_millicelsius = hottest;
+}
+
+void ReadPower(DeviceState *state, const std::string &root) {
+    ForEachEntry(root + "/sys/class/power_supply", "", [&](const std::string &supply) {
+        std::string type;
+        if (!ReadWord(supply + "/type", &type)) {
+            return;
+        }
+        if (type == "Battery") {
+            int64_t capacity = 0;
+            if (ReadInt(supply + "/capacity", &capacity) && capacity >= 0 && capacity <= 100) {
+                state->battery_percent = static_cast<int>(capacity);
+            }
+            std::string status;
+            if (ReadWord(supply + "/status", &status) && state->charging != 1) {
+                state->charging = status == "Charging" || status == "Full" ? 1 : 0;
+            }
+            return;
+        }
+        // Mains, USB, Wireless, ...: any supply that is online means we are plugged in.
+        int64_t online = 0;
+        if (ReadInt(supply + "/online", &online)) {
+            if (online > 0) {
+                state->charging = 1;
+            } else if (state->charging < 0) {
+                state->charging = 0;
+            }
+        }
+    });
+}
+
+} // namespace
+
+void ReadDeviceState(DeviceState *out, const std::string &root) {
+    DeviceState state;
+    ReadMemory(&state, root);
+    ReadCores(&state, root);
+    ReadThermal(&state, root);
+    ReadPower(&state, root);
+    *out = state;
+}
+
+ResourceProfile SelectProfile(const DeviceState &state) {
+    if (state.thermal_status >= kThermalStatusModerate ||
+        state.thermal_millicelsius >= kHotMilliCelsius) {
+        return ResourceProfile::kThrottled;
+    }
+    if (state.charging == 1 && state.unmetered == 1) {
+        return ResourceProfile::kFull;
+    }
+    if (state.charging == 0 && state.battery_percent >= 0 &&
+        state.battery_percent <= kLowBatteryPercent) {
+        return ResourceProfile::kThrottled;
+    }
+    return ResourceProfile::kBalanced;
+}
+
+NodeTuning DeriveTuning(const DeviceState &state) {
+    NodeTuning tuning;
+    tuning.profile = SelectProfile(state);
+
+    const int64_t total_mb =
+            state.mem_total_kb > 0 ? state.mem_total_kb / 1024 : kFallbackMemTotalMb;
+    const int cores = state.cpu_cores > 0 ? state.cpu_cores : kFallbackCores;
+
+    // dbcache gets a share of RAM, never more than a third of what is free
+    // right now: the low-memory killer picks the largest background process.
+    int64_t dbcache = 0;
+    switch (tuning.profile) {
+    case ResourceProfile::kFull:
+        dbcache = total_mb / 8;
+        tuning.par = std::min(cores, kMaxPar);
+        tuning.max_connections = total_mb >= 6144 ? 24 : 16;
+        tuning.max_mempool_mb = static_cast<int>(std::clamp<int64_t>(total_mb / 64, 50, 300));
+        break;
+    case ResourceProfile::kBalanced:
+        dbcache = total_mb / 16;
+        tuning.par = std::clamp(cores / 2, 1, 4);
+        tuning.max_connections = total_mb >= 4096 ? 12 : 10;
+        tuning.max_mempool_mb = total_mb >= 4096 ? 50 : 32;
+        break;
+    case ResourceProfile::kThrottled:
+        dbcache = total_mb / 32;
+        tuning.par = 1;
+        tuning.max_connections = 8;
+        tuning.max_mempool_mb = 20;
+        break;
+    }
+    if (state.mem_available_kb > 0) {
+        dbcache = std::min(dbcache, state.mem_available_kb / 1024 / 3);
+    }
+    tuning.dbcache_mb = static_cast<int>(std::clamp<int64_t>(dbcache, kMinDbcacheMb, kMaxDbcacheMb));
+    return tuning;
+}
+
+} // namespace digimobile
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace digimobile {
+
+// Device conditions the node is tuned against. Fields that could not be read
+// stay at -1. The app fills the ones sysfs may hide from it (battery, thermal
+// status, network) from Android APIs before the tuning is derived.
+struct DeviceState {
+    int64_t mem_total_kb = -1;
+    int64_t mem_available_kb = -1;
+    int cpu_cores = -1;             // possible cores, not the ones online right now
+    int thermal_millicelsius = -1;  // hottest thermal zone
+    int thermal_status = -1;        // PowerManager.THERMAL_STATUS_*, from the app
+    int battery_percent = -1;
+    int charging = -1;              // 1 on external power, 0 on battery
+    int unmetered = -1;             // 1 on Wi-Fi/Ethernet, from the app
+};
+
+enum class ResourceProfile {
+    kThrottled = 0,  // hot, or on a low battery
+    kBalanced = 1,
+    kFull = 2,       // charging on an unmetered network
+};
+
+// Values written to digibyte.conf for a profile.
+struct NodeTuning {
+    ResourceProfile profile = ResourceProfile::kBalanced;
+    int dbcache_mb = 0;
+    int par = 0;
+    int max_connections = 0;
+    int max_mempool_mb = 0;
+};
+
+// Read /proc/meminfo, /sys/devices/system/cpu/possible, the thermal zones and
+// the power supplies. root is "" in production and may point at a fake tree
+// holding proc/ and sys/ elsewhere. Missing files leave their fields unknown.
+void ReadDeviceState(DeviceState *out, const std::string &root = "");
+
+ResourceProfile SelectProfile(const DeviceState &state);
+
+// Size dbcache, script threads, peers and mempool from memory and cores for
+// the profile SelectProfile() picks.
+NodeTuning DeriveTuning(const DeviceState &state);
+
+} // namespace digimobile
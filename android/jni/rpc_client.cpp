@@ -0,0 +1,441 @@
+#include "rpc_client.h"
+
+#include "trace_recorder.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+namespace digimobile {
+namespace {
+
+constexpr size_t kReadChunkSize = 16 * 1024;
+// Guard against a misbehaving peer streaming an unbounded header block.
+constexpr size_t kMaxHeaderLine = 8 * 1024;
+// Content-Length comes from the peer; reserve at most this up front and let
+// the body grow as it actually arrives.
+constexpr size_t kMaxBodyReserve = 1 << 20;
+
+std::string Base64Encode(const std::string &input) {
+    static constexpr char kAlphabet[] =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve(((input.size() + 2) / 3) * 4);
+    size_t i = 0;
+    while (i + 2 < input.size()) {
+        const uint32_t triple = (static_cast<uint8_t>(input[i]) << 16) |
+                                (static_cast<uint8_t>(input[i + 1]) << 8) |
+                                static_cast<uint8_t>(input[i + 2]);
+        out.push_back(kAlphabet[(triple >> 18) & 0x3F]);
+        out.push_back(kAlphabet[(triple >> 12) & 0x3F]);
+        out.push_back(kAlphabet[(triple >> 6) & 0x3F]);
+        out.push_back(kAlphabet[triple & 0x3F]);
+        i += 3;
+    }
+    const size_t remaining = input.size() - i;
+    if (remaining > 0) {
+        uint32_t triple = static_cast<uint8_t>(input[i]) << 16;
+        if (remaining == 2) {
+            triple |= static_cast<uint8_t>(input[i + 1]) << 8;
+        }
+        out.push_back(kAlphabet[(triple >> 18) & 0x3F]);
+        out.push_back(kAlphabet[(triple >> 12) & 0x3F]);
+        out.push_back(remaining == 2 ? kAlphabet[(triple >> 6) & 0x3F] : '=');
+        out.push_back('=');
+    }
+    return out;
+}
+
+void AppendJsonString(const std::string &value, std::string *out) {
+    out->push_back('"');
+    for (char c : value) {
+        switch (c) {
+            case '"': out->append("\\\""); break;
+            case '\\': out->append("\\\\"); break;
+            case '\n': out->append("\\n"); break;
+            case '\r': out->append("\\r"); break;
+            case '\t': out->append("\\t"); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    static constexpr char kHex[] = "0123456789abcdef";
+                    out->append("\\u00");
+                    out->push_back(kHex[(c >> 4) & 0xF]);
+                    out->push_back(kHex[c & 0xF]);
+                } else {
+                    out->push_back(c);
+                }
+        }
+    }
+    out->push_back('"');
+}
+
+std::string ErrnoString(const char *what) {
+    return std::string(what) + " failed: " + strerror(errno);
+}
+
+} // namespace
+
+void AppendRpcRequestJson(const RpcRequest &request, uint64_t id, std::string *out) {
+    out->append("{\"jsonrpc\":\"1.0\",\"id\":");
+    out->append(std::to_string(id));
+    out->append(",\"method\":");
+    AppendJsonString(request.method, out);
+    out->append(",\"params\":");
+    out->append(request.params_json.empty() ? "[]" : request.params_json);
+    out->push_back('}');
+}
+
+RpcClient::RpcClient(std::string host, uint16_t port, const std::string &user,
+                     const std::string &password)
+    : host_(std::move(host)),
+      port_(port),
+      auth_header_("Authorization: Basic " + Base64Encode(user + ":" + password) + "\r\n") {}
+
+RpcClient::~RpcClient() { Disconnect(); }
+
+void RpcClient::Disconnect() {
+    {
+        std::lock_guard<std::mutex> lock(fd_mutex_);
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+    buffer_.clear();
+    buffer_pos_ = 0;
+}
+
+void RpcClient::Abort() {
+    aborted_ = true;
+    // shutdown() rather than close(): the calling thread still owns the
+    // descriptor, and its blocked send()/recv() returns immediately.
+    std::lock_guard<std::mutex> lock(fd_mutex_);
+    if (fd_ >= 0) {
+        shutdown(fd_, SHUT_RDWR);
+    }
+}
+
+bool RpcClient::EnsureConnected(std::string *error) {
+    if (fd_ >= 0) {
+        return true;
+    }
+    TraceSpan span("rpc", "connect", port_);
+
+    addrinfo hints {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *results = nullptr;
+    const std::string port = std::to_string(port_);
+    const int gai = getaddrinfo(host_.c_str(), port.c_str(), &hints, &results);
+    if (gai != 0) {
+        *error = std::string("getaddrinfo failed: ") + gai_strerror(gai);
+        return false;
+    }
+
+    int fd = -1;
+    for (addrinfo *ai = results; ai != nullptr; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        *error = ErrnoString("connect");
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(results);
+    if (fd < 0) {
+        if (error->empty()) {
+            *error = "connect failed: no usable address";
+        }
+        return false;
+    }
+
+    timeval tv {};
+    tv.tv_sec = timeout_ms_ / 1000;
+    tv.tv_usec = (timeout_ms_ % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    // Requests are written in one go; do not let Nagle hold them back.
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    {
+        std::lock_guard<std::mutex> lock(fd_mutex_);
+        fd_ = fd;
+        if (aborted_) {
+            shutdown(fd_, SHUT_RDWR);
+        }
+    }
+    buffer_.clear();
+    buffer_pos_ = 0;
+    return true;
+}
+
+RpcResponse RpcClient::Call(const std::string &method, const std::string &params_json) {
+    TraceSpan span("rpc", "Call", kTraceNoArg, method.c_str());
+    std::string body;
+    AppendRpcRequestJson(RpcRequest {method, params_json}, 0, &body);
+    return Post(body, nullptr);
+}
+
+RpcResponse RpcClient::CallStreaming(const std::string &method, const std::string &params_json,
+                                     const RpcBodySink &sink) {
+    TraceSpan span("rpc", "CallStreaming", kTraceNoArg, method.c_str());
+    std::string body;
+    AppendRpcRequestJson(RpcRequest {method, params_json}, 0, &body);
+    return Post(body, &sink);
+}
+
+RpcResponse RpcClient::CallBatch(const std::vector<RpcRequest> &requests) {
+    TraceSpan span("rpc", "CallBatch", static_cast<int64_t>(requests.size()));
+    std::string body = "[";
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (i > 0) {
+            body.push_back(',');
+        }
+        AppendRpcRequestJson(requests[i], i, &body);
+    }
+    body.push_back(']');
+    return Post(body, nullptr);
+}
+
+RpcResponse RpcClient::Post(const std::string &body, const RpcBodySink *sink) {
+    std::string request;
+    request.reserve(body.size() + 256);
+    request.append("POST / HTTP/1.1\r\nHost: ");
+    request.append(host_);
+    request.append("\r\nConnection: keep-alive\r\nContent-Type: application/json\r\n");
+    request.append(auth_header_);
+    request.append("Content-Length: ");
+    request.append(std::to_string(body.size()));
+    request.append("\r\n\r\n");
+    request.append(body);
+
+    RpcResponse response;
+    if (aborted_) {
+        response.error = "aborted";
+        return response;
+    }
+    // A cached keep-alive socket may have been closed by the server since the
+    // last call (idle timeout, node restart). Retry once on a fresh connection
+    // before reporting a transport failure.
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        const bool reused = fd_ >= 0;
+        response = RpcResponse {};
+        received_ = 0;
+        if (!EnsureConnected(&response.error)) {
+            return response;
+        }
+        bool keep_alive = false;
+        if (SendAll(request, &response.error) && ReadResponse(&response, &keep_alive, sink)) {
+            response.transport_ok = true;
+            if (!keep_alive) {
+                Disconnect();
+            }
+            return response;
+        }
+        Disconnect();
+        if (aborted_) {
+            response.error = "aborted";
+            break;
+        }
+        if (!reused || received_ > 0) {
+            break;
+        }
+    }
+    return response;
+}
+
+bool RpcClient::SendAll(const std::string &data, std::string *error) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = send(fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            *error = ErrnoString("send");
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool RpcClient::FillBuffer(std::string *error) {
+    if (buffer_pos_ > 0 && buffer_pos_ == buffer_.size()) {
+        buffer_.clear();
+        buffer_pos_ = 0;
+    }
+    char chunk[kReadChunkSize];
+    for (;;) {
+        const ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+        if (n > 0) {
+            buffer_.append(chunk, static_cast<size_t>(n));
+            received_ += static_cast<size_t>(n);
+            return true;
+        }
+        if (n == 0) {
+            *error = "connection closed by server";
+            return false;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        *error = ErrnoString("recv");
+        return false;
+    }
+}
+
+bool RpcClient::ReadLine(std::string *line, std::string *error) {
+    for (;;) {
+        const size_t eol = buffer_.find("\r\n", buffer_pos_);
+        if (eol != std::string::npos) {
+            line->assign(buffer_, buffer_pos_, eol - buffer_pos_);
+            buffer_pos_ = eol + 2;
+            return true;
+        }
+        if (buffer_.size() - buffer_pos_ > kMaxHeaderLine) {
+            *error = "HTTP header line too long";
+            return false;
+        }
+        if (!FillBuffer(error)) {
+            return false;
+        }
+    }
+}
+
+bool RpcClient::StreamExact(size_t length, const RpcBodySink &sink, std::string *error) {
+    while (length > 0) {
+        // FillBuffer() starts over once everything buffered was consumed, so
+        // the buffer never holds more than one read of a large body.
+        if (buffer_pos_ == buffer_.size() && !FillBuffer(error)) {
+            return false;
+        }
+        const size_t n = std::min(length, buffer_.size() - buffer_pos_);
+        const char *data = buffer_.data() + buffer_pos_;
+        buffer_pos_ += n;
+        length -= n;
+        if (!sink(data, n)) {
+            *error = "reply rejected by caller";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RpcClient::StreamChunkedBody(const RpcBodySink &sink, std::string *error) {
+    std::string line;
+    for (;;) {
+        if (!ReadLine(&line, error)) {
+            return false;
+        }
+        const size_t chunk_size = strtoul(line.c_str(), nullptr, 16);
+        if (chunk_size == 0) {
+            // Consume optional trailers up to the terminating blank line.
+            do {
+                if (!ReadLine(&line, error)) {
+                    return false;
+                }
+            } while (!line.empty());
+            return true;
+        }
+        if (!StreamExact(chunk_size, sink, error) || !ReadLine(&line, error)) {
+            return false;
+        }
+    }
+}
+
+bool RpcClient::ReadResponse(RpcResponse *response, bool *keep_alive, const RpcBodySink *sink) {
+    std::string line;
+    if (!ReadLine(&line, &response->error)) {
+        return false;
+    }
+    // Status line: HTTP/1.1 200 OK
+    const size_t space = line.find(' ');
+    if (line.compare(0, 5, "HTTP/") != 0 || space == std::string::npos) {
+        response->error = "malformed HTTP status line";
+        return false;
+    }
+    response->http_status = atoi(line.c_str() + space + 1);
+    *keep_alive = line.compare(0, 8, "HTTP/1.1") == 0;
+
+    long long content_length = -1;
+    bool chunked = false;
+    for (;;) {
+        if (!ReadLine(&line, &response->error)) {
+            return false;
+        }
+        if (line.empty()) {
+            break;
+        }
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        const std::string name = line.substr(0, colon);
+        size_t value_start = colon + 1;
+        while (value_start < line.size() && line[value_start] == ' ') {
+            ++value_start;
+        }
+        const char *value = line.c_str() + value_start;
+        if (strcasecmp(name.c_str(), "Content-Length") == 0) {
+            content_length = atoll(value);
+        } else if (strcasecmp(name.c_str(), "Transfer-Encoding") == 0) {
+            chunked = strcasestr(value, "chunked") != nullptr;
+        } else if (strcasecmp(name.c_str(), "Connection") == 0) {
+            if (strcasestr(value, "close") != nullptr) {
+                *keep_alive = false;
+            } else if (strcasestr(value, "keep-alive") != nullptr) {
+                *keep_alive = true;
+            }
+        }
+    }
+
+    response->body.clear();
+    const RpcBodySink collect = [response](const char *data, size_t size) {
+        response->body.append(data, size);
+        return true;
+    };
+    const RpcBodySink &deliver = sink ? *sink : collect;
+    if (chunked) {
+        return StreamChunkedBody(deliver, &response->error);
+    }
+    if (content_length >= 0) {
+        if (!sink) {
+            response->body.reserve(
+                    std::min(static_cast<size_t>(content_length), kMaxBodyReserve));
+        }
+        return StreamExact(static_cast<size_t>(content_length), deliver, &response->error);
+    }
+
+    // No framing: the body runs until the server closes the connection.
+    *keep_alive = false;
+    std::string ignored;
+    do {
+        const size_t n = buffer_.size() - buffer_pos_;
+        const char *data = buffer_.data() + buffer_pos_;
+        buffer_pos_ = buffer_.size();
+        if (n > 0 && !deliver(data, n)) {
+            response->error = "reply rejected by caller";
+            return false;
+        }
+    } while (FillBuffer(&ignored));
+    return !aborted_;
+}
+
+} // namespace digimobile
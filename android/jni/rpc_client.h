@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace digimobile {
+
+// One JSON-RPC call inside a request. params_json must already be a JSON array
+// (or object) literal; it is forwarded verbatim.
+struct RpcRequest {
+    std::string method;
+    std::string params_json = "[]";
+};
+
+// Outcome of a single HTTP round trip to the node's RPC server. The body is
+// returned untouched (single reply object or batch reply array) so callers can
+// parse only the fields they need.
+struct RpcResponse {
+    bool transport_ok = false;  // false if connect/send/receive failed
+    int http_status = 0;
+    std::string body;
+    std::string error;  // transport failure description when !transport_ok
+};
+
+// Receives a reply body as it arrives, in pieces of arbitrary size. Return
+// false to stop reading; the call then fails and the connection is dropped.
+using RpcBodySink = std::function<bool(const char *data, size_t size)>;
+
+// Minimal HTTP/1.1 JSON-RPC client for the node's loopback RPC port.
+//
+// A single keep-alive connection is reused across calls so periodic status
+// polls cost one write and one read instead of a digibyte-cli fork+exec. The
+// client is not thread-safe; callers serialize access. Abort() is the
+// exception and may be called from any thread.
+class RpcClient {
+public:
+    RpcClient(std::string host, uint16_t port, const std::string &user,
+              const std::string &password);
+    ~RpcClient();
+
+    RpcClient(const RpcClient &) = delete;
+    RpcClient &operator=(const RpcClient &) = delete;
+
+    // Issue a single call. params_json defaults to an empty positional list.
+    RpcResponse Call(const std::string &method, const std::string &params_json = "[]");
+
+    // Issue several calls in one JSON-RPC batch; the reply body is an array
+    // whose "id" fields match the index of each request.
+    RpcResponse CallBatch(const std::vector<RpcRequest> &requests);
+
+    // Like Call, but hands the body to sink as it is received instead of
+    // buffering it, so memory stays bounded by the read buffer however large
+    // the reply is; response.body stays empty.
+    RpcResponse CallStreaming(const std::string &method, const std::string &params_json,
+                              const RpcBodySink &sink);
+
+    // Unblock the call in progress on another thread, which then fails with
+    // "aborted". Calls fail the same way until ClearAbort(), so an Abort()
+    // that lands before its call has connected is not lost.
+    void Abort();
+    // Re-arm the client for the next call; callers do this once per command,
+    // before dispatching it.
+    void ClearAbort() { aborted_ = false; }
+
+    // Close the cached connection; the next call reconnects.
+    void Disconnect();
+
+    void SetTimeoutMs(int timeout_ms) { timeout_ms_ = timeout_ms; }
+
+    const std::string &host() const { return host_; }
+    uint16_t port() const { return port_; }
+
+private:
+    bool EnsureConnected(std::string *error);
+    // sink == nullptr collects the body into the response.
+    RpcResponse Post(const std::string &body, const RpcBodySink *sink);
+    bool SendAll(const std::string &data, std::string *error);
+    bool ReadResponse(RpcResponse *response, bool *keep_alive, const RpcBodySink *sink);
+    bool FillBuffer(std::string *error);
+    bool ReadLine(std::string *line, std::string *error);
+    bool StreamExact(size_t length, const RpcBodySink &sink, std::string *error);
+    bool StreamChunkedBody(const RpcBodySink &sink, std::string *error);
+
+    std::string host_;
+    uint16_t port_;
+    std::string auth_header_;
+    int timeout_ms_ = 15000;
+    // Written only by the calling thread, under fd_mutex_ so Abort() never
+    // shuts down a descriptor that has been closed and reused.
+    int fd_ = -1;
+    std::mutex fd_mutex_;
+    std::atomic<bool> aborted_{false};
+    std::string buffer_;
+    size_t buffer_pos_ = 0;
+    // Bytes received during the current attempt; a request is only re-sent if
+    // nothing came back, never after a reply has started.
+    size_t received_ = 0;
+};
+
+// Append request to out as a JSON-RPC 1.0 call object with the given id.
+void AppendRpcRequestJson(const RpcRequest &request, uint64_t id, std::string *out);
+
+} // namespace digimobile
@@ -0,0 +1,496 @@
+#include "rpc_console.h"
+
+#include "trace_recorder.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace digimobile {
+namespace {
+
+// Console commands can legitimately run for minutes (gettxoutsetinfo,
+// scantxoutset, rescans); the user cancels them instead of a short timeout.
+constexpr int kConsoleTimeoutMs = 10 * 60 * 1000;
+// An error object is a code and a message; anything bigger is not read.
+constexpr size_t kMaxErrorJson = 64 * 1024;
+
+bool IsJsonSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+void AppendUtf8(uint32_t code_point, std::string *out) {
+    if (code_point < 0x80) {
+        out->push_back(static_cast<char>(code_point));
+    } else if (code_point < 0x800) {
+        out->push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+        out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x10000) {
+        out->push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+        out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else {
+        out->push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+        out->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+}
+
+// Length of the longest prefix of text that does not end inside a UTF-8
+// sequence, so chunks never split a character.
+size_t Utf8Boundary(const std::string &text) {
+    const size_t size = text.size();
+    size_t lead = size;
+    while (lead > 0 && size - lead < 4 &&
+           (static_cast<unsigned char>(text[lead - 1]) & 0xC0) == 0x80) {
+        --lead;
+    }
+    if (lead == 0) {
+        return size;
+    }
+    const unsigned char byte = static_cast<unsigned char>(text[lead - 1]);
+    if (byte < 0xC0) {
+        return size;
+    }
+    const size_t length = byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : 2;
+    return lead - 1 + length > size ? lead - 1 : size;
+}
+
+// Batches printer output into chunk_bytes pieces for the sink and enforces
+// the output limit.
+class ConsoleWriter {
+public:
+    ConsoleWriter(const ConsoleOptions &options, const ConsoleSink &sink)
+        : options_(options), sink_(sink) {}
+
+    // False once the sink cancelled or the limit was reached; the caller
+    // stops reading the reply.
+    bool Write(const std::string &text) {
+        if (cancelled_ || truncated_) {
+            return false;
+        }
+        const int64_t room = options_.max_output_bytes - written_ -
+                             static_cast<int64_t>(pending_.size());
+        if (static_cast<int64_t>(text.size()) > room) {
+            pending_.append(text, 0, static_cast<size_t>(std::max<int64_t>(room, 0)));
+            pending_.resize(Utf8Boundary(pending_));
+            truncated_ = true;
+            if (Flush(true)) {
+                Deliver("\n[output truncated after " + std::to_string(written_) + " bytes]");
+            }
+            return false;
+        }
+        pending_.append(text);
+        return pending_.size() < options_.chunk_bytes || Flush(false);
+    }
+
+    void Finish() {
+        if (!cancelled_) {
+            Flush(true);
+        }
+    }
+
+    bool cancelled() const { return cancelled_; }
+    bool truncated() const { return truncated_; }
+    int64_t written() const { return written_; }
+
+private:
+    bool Flush(bool all) {
+        const size_t cut = all ? pending_.size() : Utf8Boundary(pending_);
+        if (cut == 0) {
+            return true;
+        }
+        const bool keep_going = Deliver(pending_.substr(0, cut));
+        written_ += static_cast<int64_t>(cut);
+        pending_.erase(0, cut);
+        return keep_going;
+    }
+
+    bool Deliver(const std::string &text) {
+        if (!sink_(text)) {
+            cancelled_ = true;
+        }
+        return !cancelled_;
+    }
+
+    const ConsoleOptions &options_;
+    const ConsoleSink &sink_;
+    std::string pending_;
+    int64_t written_ = 0;
+    bool cancelled_ = false;
+    bool truncated_ = false;
+};
+
+ConsoleResult Summarize(const RpcResponse &response, const RpcReplyPrinter &printer,
+                        const ConsoleWriter &writer) {
+    ConsoleResult result;
+    result.output_bytes = writer.written();
+    result.truncated = writer.truncated();
+    if (writer.cancelled() || response.error == "aborted") {
+        result.status = ConsoleStatus::kCancelled;
+        result.error = "cancelled";
+    } else if (writer.truncated()) {
+        result.status = ConsoleStatus::kOk;
+    } else if (!response.transport_ok) {
+        result.status = ConsoleStatus::kUnreachable;
+        const char *prefix =
+                writer.written() > 0 ? "connection lost: " : "couldn't connect to server: ";
+        result.error = prefix + response.error;
+    } else if (response.http_status == 401) {
+        result.status = ConsoleStatus::kRpcError;
+        result.error = "error: Authorization failed: Incorrect rpcuser or rpcpassword";
+    } else if (printer.has_error()) {
+        // Same shape as digibyte-cli, which warm-up detection matches on.
+        result.status = ConsoleStatus::kRpcError;
+        result.error = "error code: " + std::to_string(printer.error_code()) +
+                       "\nerror message:\n" + printer.error_message();
+    } else {
+        result.status = ConsoleStatus::kOk;
+    }
+    return result;
+}
+
+} // namespace
+
+void RpcReplyPrinter::Feed(const char *data, size_t size, std::string *out) {
+    for (size_t i = 0; i < size; ++i) {
+        const char c = data[i];
+        if (!in_value_) {
+            FeedEnvelope(c);
+            continue;
+        }
+        if (!in_string_ && value_depth_ <= 0 && (c == ',' || c == '}')) {
+            // End of the member's value.
+            if (target_ == Target::kResult) {
+                if (!raw_string_ && scalar_ != "null") {
+                    out->append(scalar_);
+                }
+                if (high_surrogate_ != 0) {
+                    AppendUtf8(0xFFFD, out);
+                    high_surrogate_ = 0;
+                }
+            }
+            scalar_.clear();
+            in_value_ = false;
+            target_ = Target::kNone;
+            FeedEnvelope(c);
+            continue;
+        }
+        if (target_ == Target::kResult) {
+            if (!value_started_) {
+                if (IsJsonSpace(c)) {
+                    continue;
+                }
+                value_started_ = true;
+                if (c == '"') {
+                    raw_string_ = true;
+                    in_string_ = true;
+                    continue;
+                }
+            }
+            if (raw_string_) {
+                if (in_string_) {
+                    FeedRawString(c, out);
+                }
+            } else {
+                FeedResult(c, out);
+            }
+            continue;
+        }
+        if (target_ == Target::kError && error_json_.size() < kMaxErrorJson) {
+            error_json_.push_back(c);
+        }
+        TrackValue(c);
+    }
+}
+
+void RpcReplyPrinter::FeedEnvelope(char c) {
+    if (in_key_) {
+        if (key_escape_) {
+            key_escape_ = false;
+            key_.push_back(c);
+        } else if (c == '\\') {
+            key_escape_ = true;
+        } else if (c == '"') {
+            in_key_ = false;
+        } else if (key_.size() < 16) {
+            key_.push_back(c);
+        }
+        return;
+    }
+    switch (c) {
+        case '{':
+            ++envelope_depth_;
+            break;
+        case '}':
+            --envelope_depth_;
+            break;
+        case '"':
+            if (envelope_depth_ == 1) {
+                in_key_ = true;
+                key_.clear();
+            }
+            break;
+        case ':':
+            if (envelope_depth_ == 1) {
+                in_value_ = true;
+                value_depth_ = 0;
+                value_started_ = false;
+                in_string_ = false;
+                escape_ = false;
+                target_ = key_ == "result" ? Target::kResult
+                          : key_ == "error" ? Target::kError
+                                            : Target::kNone;
+                if (target_ == Target::kError) {
+                    error_json_.clear();
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void RpcReplyPrinter::TrackValue(char c) {
+    if (in_string_) {
+        if (escape_) {
+            escape_ = false;
+        } else if (c == '\\') {
+            escape_ = true;
+        } else if (c == '"') {
+            in_string_ = false;
+        }
+    } else if (c == '"') {
+        in_string_ = true;
+    } else if (c == '{' || c == '[') {
+        ++value_depth_;
+    } else if (c == '}' || c == ']') {
+        --value_depth_;
+    }
+}
+
+void RpcReplyPrinter::FeedResult(char c, std::string *out) {
+    if (in_string_) {
+        // Escapes stay as they are: the output is still JSON.
+        out->push_back(c);
+        TrackValue(c);
+        return;
+    }
+    if (IsJsonSpace(c)) {
+        return;
+    }
+    if (level_ == 0 && c != '{' && c != '[') {
+        // A scalar result; held back so a null result prints nothing.
+        scalar_.push_back(c);
+        TrackValue(c);
+        return;
+    }
+    switch (c) {
+        case '{':
+        case '[':
+            OpenPending(out);
+            out->push_back(c);
+            ++level_;
+            pending_open_ = true;
+            break;
+        case '}':
+        case ']':
+            --level_;
+            if (pending_open_) {
+                pending_open_ = false;
+            } else {
+                Newline(out);
+            }
+            out->push_back(c);
+            break;
+        case ',':
+            out->push_back(c);
+            Newline(out);
+            break;
+        case ':':
+            out->append(": ");
+            break;
+        default:
+            OpenPending(out);
+            out->push_back(c);
+            break;
+    }
+    TrackValue(c);
+}
+
+void RpcReplyPrinter::FeedRawString(char c, std::string *out) {
+    if (unicode_digits_ >= 0) {
+        const int digit = c >= '0' && c <= '9'   ? c - '0'
+                          : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                          : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                                 : 0;
+        unicode_value_ = (unicode_value_ << 4) | static_cast<uint32_t>(digit);
+        if (++unicode_digits_ < 4) {
+            return;
+        }
+        unicode_digits_ = -1;
+        const uint32_t unit = unicode_value_;
+        if (unit >= 0xD800 && unit <= 0xDBFF) {
+            if (high_surrogate_ != 0) {
+                AppendUtf8(0xFFFD, out);
+            }
+            high_surrogate_ = unit;
+        } else if (unit >= 0xDC00 && unit <= 0xDFFF) {
+            AppendUtf8(high_surrogate_ != 0
+                               ? 0x10000 + ((high_surrogate_ - 0xD800) << 10) + (unit - 0xDC00)
+                               : 0xFFFD,
+                       out);
+            high_surrogate_ = 0;
+        } else {
+            if (high_surrogate_ != 0) {
+                AppendUtf8(0xFFFD, out);
+                high_surrogate_ = 0;
+            }
+            AppendUtf8(unit, out);
+        }
+        return;
+    }
+    char decoded = c;
+    if (escape_) {
+        escape_ = false;
+        switch (c) {
+            case 'u':
+                unicode_digits_ = 0;
+                unicode_value_ = 0;
+                return;
+            case 'n': decoded = '\n'; break;
+            case 't': decoded = '\t'; break;
+            case 'r': decoded = '\r'; break;
+            case 'b': decoded = '\b'; break;
+            case 'f': decoded = '\f'; break;
+            default: break;  // \" \\ \/
+        }
+    } else if (c == '\\') {
+        escape_ = true;
+        return;
+    } else if (c == '"') {
+        in_string_ = false;
+        return;
+    }
+    if (high_surrogate_ != 0) {
+        AppendUtf8(0xFFFD, out);
+        high_surrogate_ = 0;
+    }
+    out->push_back(decoded);
+}
+
+void RpcReplyPrinter::OpenPending(std::string *out) {
+    if (pending_open_) {
+        pending_open_ = false;
+        Newline(out);
+    }
+}
+
+void RpcReplyPrinter::Newline(std::string *out) const {
+    out->push_back('\n');
+    out->append(static_cast<size_t>(std::max(level_, 0) * indent_), ' ');
+}
+
+bool RpcReplyPrinter::has_error() const {
+    const size_t start = error_json_.find_first_not_of(" \t\r\n");
+    return start != std::string::npos && error_json_.compare(start, 4, "null") != 0;
+}
+
+int RpcReplyPrinter::error_code() const {
+    const size_t key = error_json_.find("\"code\"");
+    if (key == std::string::npos) {
+        return 0;
+    }
+    const size_t colon = error_json_.find(':', key);
+    return colon == std::string::npos ? 0 : atoi(error_json_.c_str() + colon + 1);
+}
+
+std::string RpcReplyPrinter::error_message() const {
+    const size_t key = error_json_.find("\"message\"");
+    const size_t colon = key == std::string::npos ? key : error_json_.find(':', key);
+    if (colon == std::string::npos) {
+        return {};
+    }
+    // Reuse the string-result path to unescape it: the message becomes the
+    // result of a one-member reply, and whatever follows it is ignored.
+    RpcReplyPrinter printer;
+    const std::string reply = "{\"result\":" + error_json_.substr(colon + 1) + "}";
+    std::string message;
+    printer.Feed(reply.data(), reply.size(), &message);
+    return message;
+}
+
+void RpcConsole::Configure(std::string host, uint16_t port, const std::string &user,
+                           const std::string &password) {
+    auto client = std::make_shared<RpcClient>(std::move(host), port, user, password);
+    client->SetTimeoutMs(kConsoleTimeoutMs);
+    std::lock_guard<std::mutex> lock(client_mutex_);
+    client_ = std::move(client);
+}
+
+ConsoleResult RpcConsole::Execute(const std::string &method, const std::string &params_json,
+                                  const ConsoleOptions &options, const ConsoleSink &sink) {
+    std::lock_guard<std::mutex> call_lock(call_mutex_);
+    std::shared_ptr<RpcClient> client;
+    {
+        std::lock_guard<std::mutex> lock(client_mutex_);
+        client = client_;
+    }
+    if (!client) {
+        ConsoleResult result;
+        result.error = "couldn't connect to server: RPC is not configured";
+        return result;
+    }
+    TraceSpan span("rpc", "ConsoleExecute", kTraceNoArg, method.c_str());
+    // Cleared here rather than per round trip, so a Cancel() racing the
+    // start of this command still stops it.
+    client->ClearAbort();
+
+    RpcReplyPrinter printer(options.indent);
+    ConsoleWriter writer(options, sink);
+    std::string text;
+    const RpcResponse response = client->CallStreaming(
+            method, params_json, [&](const char *data, size_t size) {
+                text.clear();
+                printer.Feed(data, size, &text);
+                return writer.Write(text);
+            });
+    writer.Finish();
+    span.set_arg(writer.written());
+    return Summarize(response, printer, writer);
+}
+
+ConsoleResult RpcConsole::Render(const std::string &reply, const ConsoleOptions &options,
+                                 const ConsoleSink &sink) {
+    RpcReplyPrinter printer(options.indent);
+    ConsoleWriter writer(options, sink);
+    RpcResponse response;
+    response.transport_ok = true;
+    response.http_status = 200;
+    // Printed in chunk-sized pieces so the first output reaches the sink
+    // before the whole reply has been formatted.
+    std::string text;
+    for (size_t offset = 0; offset < reply.size(); offset += options.chunk_bytes) {
+        text.clear();
+        printer.Feed(reply.data() + offset, std::min(options.chunk_bytes, reply.size() - offset),
+                     &text);
+        if (!writer.Write(text)) {
+            break;
+        }
+    }
+    writer.Finish();
+    return Summarize(response, printer, writer);
+}
+
+void RpcConsole::Cancel() {
+    std::shared_ptr<RpcClient> client;
+    {
+        std::lock_guard<std::mutex> lock(client_mutex_);
+        client = client_;
+    }
+    if (client) {
+        client->Abort();
+    }
+}
+
+} // namespace digimobile
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "rpc_client.h"
+
+namespace digimobile {
+
+// Incremental printer for a JSON-RPC reply body, fed in pieces of any size as
+// they come off the socket. The "result" member is written out the way
+// digibyte-cli prints it (objects and arrays indented, a string result
+// unquoted and unescaped) while it streams; the "error" member is kept for
+// has_error(). Nothing else of the reply is buffered.
+class RpcReplyPrinter {
+public:
+    explicit RpcReplyPrinter(int indent = 2) : indent_(indent) {}
+
+    // Append the printable text for the next piece of the body to *out.
+    void Feed(const char *data, size_t size, std::string *out);
+
+    // True once the reply carried a non-null "error"; code and message are
+    // extracted from it.
+    bool has_error() const;
+    int error_code() const;
+    std::string error_message() const;
+
+private:
+    enum class Target { kNone, kResult, kError };
+
+    void FeedEnvelope(char c);
+    void TrackValue(char c);
+    void FeedResult(char c, std::string *out);
+    void FeedRawString(char c, std::string *out);
+    void OpenPending(std::string *out);
+    void Newline(std::string *out) const;
+
+    int indent_;
+    // The envelope: {"result": ..., "error": ..., "id": ...}.
+    int envelope_depth_ = 0;
+    bool in_key_ = false;
+    bool key_escape_ = false;
+    std::string key_;
+    bool in_value_ = false;
+    Target target_ = Target::kNone;
+    // The value being routed, which may span any number of pieces.
+    int value_depth_ = 0;
+    bool value_started_ = false;
+    bool in_string_ = false;
+    bool escape_ = false;
+    // Result output: nesting level, and whether the last '{'/'[' still waits
+    // for its first element (so empty containers print as {} and []).
+    int level_ = 0;
+    bool pending_open_ = false;
+    std::string scalar_;
+    // A string result is printed raw; \uXXXX escapes decode across pieces.
+    bool raw_string_ = false;
+    int unicode_digits_ = -1;
+    uint32_t unicode_value_ = 0;
+    uint32_t high_surrogate_ = 0;
+    std::string error_json_;
+};
+
+enum class ConsoleStatus {
+    kOk,
+    kRpcError,
+    kUnreachable,
+    kCancelled,
+};
+
+struct ConsoleOptions {
+    // Output beyond this is dropped and the reply is no longer read.
+    int64_t max_output_bytes = 1 << 20;
+    // Output is handed over in pieces of about this size, cut on UTF-8
+    // character boundaries.
+    size_t chunk_bytes = 16 * 1024;
+    int indent = 2;
+};
+
+struct ConsoleResult {
+    ConsoleStatus status = ConsoleStatus::kUnreachable;
+    // digibyte-cli style stderr text for anything but kOk.
+    std::string error;
+    int64_t output_bytes = 0;
+    bool truncated = false;
+};
+
+// Receives console output; return false to cancel the command.
+using ConsoleSink = std::function<bool(const std::string &text)>;
+
+// The Core console's connection to the node. Commands run over their own
+// keep-alive RPC socket, so a long reply never holds up status polling, and
+// their output is pretty-printed and handed to the sink while the reply is
+// still being received. One command runs at a time; Cancel() may be called
+// from any thread.
+class RpcConsole {
+public:
+    void Configure(std::string host, uint16_t port, const std::string &user,
+                   const std::string &password);
+
+    ConsoleResult Execute(const std::string &method, const std::string &params_json,
+                          const ConsoleOptions &options, const ConsoleSink &sink);
+
+    // Print a reply that is already complete (the in-process node answers
+    // in one piece) the same way Execute would.
+    static ConsoleResult Render(const std::string &reply, const ConsoleOptions &options,
+                                const ConsoleSink &sink);
+
+    // Stop the command in progress; it returns kCancelled. Execute() re-arms
+    // the connection as soon as it owns the console, so a Cancel() from then
+    // on is kept even if the request has not been sent yet.
+    void Cancel();
+
+private:
+    std::mutex call_mutex_;
+    std::mutex client_mutex_;
+    // Shared so Cancel() and Configure() can run while a command holds it.
+    std::shared_ptr<RpcClient> client_;
+};
+
+} // namespace digimobile
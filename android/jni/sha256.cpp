@@ -0,0 +1,226 @@
+#include "sha256.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2 (1 << 6)
+#endif
+#elif defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+namespace digimobile {
+namespace sha256_internal {
+
+const uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+namespace {
+
+inline uint32_t Rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+inline uint32_t ReadBe32(const unsigned char *p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+} // namespace
+
+void TransformScalar(uint32_t state[8], const unsigned char *blocks, size_t count) {
+    uint32_t w[64];
+    for (; count > 0; --count, blocks += 64) {
+        for (int i = 0; i < 16; ++i) {
+            w[i] = ReadBe32(blocks + 4 * i);
+        }
+        for (int i = 16; i < 64; ++i) {
+            const uint32_t s0 = Rotr(w[i - 15], 7) ^ Rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const uint32_t s1 = Rotr(w[i - 2], 17) ^ Rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            const uint32_t s1 = Rotr(e, 6) ^ Rotr(e, 11) ^ Rotr(e, 25);
+            const uint32_t ch = (e & f) ^ (~e & g);
+            const uint32_t t1 = h + s1 + ch + kRoundConstants[i] + w[i];
+            const uint32_t s0 = Rotr(a, 2) ^ Rotr(a, 13) ^ Rotr(a, 22);
+            const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            const uint32_t t2 = s0 + maj;
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+} // namespace sha256_internal
+
+namespace {
+
+using sha256_internal::TransformFn;
+
+struct Dispatch {
+    TransformFn transform;
+    const char *name;
+};
+
+Dispatch Select() {
+#if defined(__aarch64__) && defined(__linux__)
+    if (getauxval(AT_HWCAP) & HWCAP_SHA2) {
+        return {sha256_internal::TransformArmv8, "armv8-sha2"};
+    }
+#elif defined(__x86_64__)
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        const bool ssse3 = ecx & (1u << 9);
+        const bool sse41 = ecx & (1u << 19);
+        if (ssse3 && sse41 && __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) &&
+            (ebx & (1u << 29))) {
+            return {sha256_internal::TransformShaNi, "x86-shani"};
+        }
+    }
+#endif
+    return {sha256_internal::TransformScalar, "scalar"};
+}
+
+const Dispatch &Selected() {
+    static const Dispatch dispatch = Select();
+    return dispatch;
+}
+
+} // namespace
+
+void Sha256::Reset() {
+    static const uint32_t kInit[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                      0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    memcpy(state_, kInit, sizeof(state_));
+    buffered_ = 0;
+    total_ = 0;
+}
+
+void Sha256::Update(const void *data, size_t length) {
+    const TransformFn transform = Selected().transform;
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    total_ += length;
+    if (buffered_ > 0) {
+        const size_t take = length < 64 - buffered_ ? length : 64 - buffered_;
+        memcpy(buffer_ + buffered_, p, take);
+        buffered_ += take;
+        p += take;
+        length -= take;
+        if (buffered_ < 64) {
+            return;
+        }
+        transform(state_, buffer_, 1);
+        buffered_ = 0;
+    }
+    if (length >= 64) {
+        transform(state_, p, length / 64);
+        p += length & ~static_cast<size_t>(63);
+        length &= 63;
+    }
+    if (length > 0) {
+        memcpy(buffer_, p, length);
+        buffered_ = length;
+    }
+}
+
+void Sha256::Finish(unsigned char out[kDigestSize]) {
+    const uint64_t bits = total_ * 8;
+    unsigned char pad[72] = {0x80};
+    const size_t pad_length = 1 + ((119 - (total_ % 64)) % 64);
+    for (int i = 0; i < 8; ++i) {
+        pad[pad_length + i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+    }
+    Update(pad, pad_length + 8);
+    for (int i = 0; i < 8; ++i) {
+        out[4 * i] = static_cast<unsigned char>(state_[i] >> 24);
+        out[4 * i + 1] = static_cast<unsigned char>(state_[i] >> 16);
+        out[4 * i + 2] = static_cast<unsigned char>(state_[i] >> 8);
+        out[4 * i + 3] = static_cast<unsigned char>(state_[i]);
+    }
+    Reset();
+}
+
+std::string Sha256::FinishHex() {
+    unsigned char digest[kDigestSize];
+    Finish(digest);
+    return HexDigest(digest, sizeof(digest));
+}
+
+const char *Sha256::Implementation() {
+    return Selected().name;
+}
+
+std::string HexDigest(const unsigned char *digest, size_t length) {
+    static const char kHex[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(length * 2);
+    for (size_t i = 0; i < length; ++i) {
+        hex.push_back(kHex[digest[i] >> 4]);
+        hex.push_back(kHex[digest[i] & 0xf]);
+    }
+    return hex;
+}
+
+bool Sha256File(const std::string &path, std::string *hex, std::string *error) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        *error = "open " + path + ": " + strerror(errno);
+        return false;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    std::vector<unsigned char> buffer(1 << 20);
+    Sha256 hasher;
+    for (;;) {
+        const ssize_t n = read(fd, buffer.data(), buffer.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            *error = "read " + path + ": " + strerror(errno);
+            close(fd);
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        hasher.Update(buffer.data(), static_cast<size_t>(n));
+    }
+    close(fd);
+    *hex = hasher.FinishHex();
+    return true;
+}
+
+} // namespace digimobile
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace digimobile {
+
+// Incremental SHA-256. Compression runs on the ARMv8 SHA2 or x86 SHA-NI
+// instructions when the CPU has them (picked once, at first use) and on a
+// portable implementation otherwise.
+class Sha256 {
+public:
+    static constexpr size_t kDigestSize = 32;
+
+    Sha256() { Reset(); }
+
+    void Reset();
+    void Update(const void *data, size_t length);
+    // Write the digest and reset for reuse.
+    void Finish(unsigned char out[kDigestSize]);
+    std::string FinishHex();
+
+    // "armv8-sha2", "x86-shani" or "scalar".
+    static const char *Implementation();
+
+private:
+    uint32_t state_[8];
+    unsigned char buffer_[64];
+    size_t buffered_ = 0;
+    uint64_t total_ = 0;
+};
+
+// Hash a whole file with large sequential reads. Returns false on I/O error.
+bool Sha256File(const std::string &path, std::string *hex, std::string *error);
+
+std::string HexDigest(const unsigned char *digest, size_t length);
+
+namespace sha256_internal {
+
+// Process count 64-byte blocks. All variants produce identical output.
+using TransformFn = void (*)(uint32_t state[8], const unsigned char *blocks, size_t count);
+
+void TransformScalar(uint32_t state[8], const unsigned char *blocks, size_t count);
+#if defined(__aarch64__)
+void TransformArmv8(uint32_t state[8], const unsigned char *blocks, size_t count);
+#endif
+#if defined(__x86_64__)
+void TransformShaNi(uint32_t state[8], const unsigned char *blocks, size_t count);
+#endif
+
+extern const uint32_t kRoundConstants[64];
+
+} // namespace sha256_internal
+} // namespace digimobile
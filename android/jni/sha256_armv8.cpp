@@ -0,0 +1,52 @@
+// SHA-256 compression on the ARMv8 Cryptography Extension. Built with
+// -march=armv8-a+crypto (see CMakeLists.txt) and only called after
+// HWCAP_SHA2 has been seen at runtime.
+#include "sha256.h"
+
+#if defined(__aarch64__)
+
+#include <arm_neon.h>
+
+namespace digimobile {
+namespace sha256_internal {
+
+void TransformArmv8(uint32_t state[8], const unsigned char *blocks, size_t count) {
+    uint32x4_t state0 = vld1q_u32(&state[0]);  // ABCD
+    uint32x4_t state1 = vld1q_u32(&state[4]);  // EFGH
+
+    for (; count > 0; --count, blocks += 64) {
+        const uint32x4_t abcd_save = state0;
+        const uint32x4_t efgh_save = state1;
+
+        uint32x4_t msg[4];
+        for (int i = 0; i < 4; ++i) {
+            msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 16 * i)));
+        }
+
+        // Sixteen groups of four rounds. Group g consumes W[4g..4g+3] from
+        // msg[g % 4] and, while it runs, replaces it with W[4g+16..4g+19].
+        for (int g = 0; g < 16; ++g) {
+            const uint32x4_t wk = vaddq_u32(msg[g % 4], vld1q_u32(&kRoundConstants[4 * g]));
+            if (g < 12) {
+                msg[g % 4] = vsha256su0q_u32(msg[g % 4], msg[(g + 1) % 4]);
+            }
+            const uint32x4_t abcd = state0;
+            state0 = vsha256hq_u32(state0, state1, wk);
+            state1 = vsha256h2q_u32(state1, abcd, wk);
+            if (g < 12) {
+                msg[g % 4] = vsha256su1q_u32(msg[g % 4], msg[(g + 2) % 4], msg[(g + 3) % 4]);
+            }
+        }
+
+        state0 = vaddq_u32(state0, abcd_save);
+        state1 = vaddq_u32(state1, efgh_save);
+    }
+
+    vst1q_u32(&state[0], state0);
+    vst1q_u32(&state[4], state1);
+}
+
+} // namespace sha256_internal
+} // namespace digimobile
+
+#endif // __aarch64__
@@ -0,0 +1,61 @@
+// SHA-256 compression on the x86 SHA extensions. Built with -msse4.1 -msha
+// (see CMakeLists.txt) and only called after CPUID reports SHA and SSE4.1.
+#include "sha256.h"
+
+#if defined(__x86_64__)
+
+#include <immintrin.h>
+
+namespace digimobile {
+namespace sha256_internal {
+
+void TransformShaNi(uint32_t state[8], const unsigned char *blocks, size_t count) {
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // The rounds instructions want the state as ABEF/CDGH.
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[0])), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[4])), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (; count > 0; --count, blocks += 64) {
+        const __m128i abef_save = state0;
+        const __m128i cdgh_save = state1;
+
+        __m128i msg[4];
+        for (int i = 0; i < 4; ++i) {
+            msg[i] = _mm_shuffle_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(blocks + 16 * i)), byte_swap);
+        }
+
+        // Same schedule as the ARMv8 path: group g consumes msg[g % 4] and
+        // then refills it with W[4g+16..4g+19].
+        for (int g = 0; g < 16; ++g) {
+            __m128i wk = _mm_add_epi32(
+                    msg[g % 4], _mm_loadu_si128(reinterpret_cast<const __m128i *>(&kRoundConstants[4 * g])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+            wk = _mm_shuffle_epi32(wk, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, wk);
+            if (g < 12) {
+                __m128i next = _mm_sha256msg1_epu32(msg[g % 4], msg[(g + 1) % 4]);
+                next = _mm_add_epi32(next, _mm_alignr_epi8(msg[(g + 3) % 4], msg[(g + 2) % 4], 4));
+                msg[g % 4] = _mm_sha256msg2_epu32(next, msg[(g + 3) % 4]);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[4]), state1);
+}
+
+} // namespace sha256_internal
+} // namespace digimobile
+
+#endif // __x86_64__
@@ -0,0 +1,582 @@
+#include "snapshot_container.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "sha256.h"
+#include "trace_recorder.h"
+
+namespace digimobile {
+namespace {
+
+void PutU16(std::string *out, uint16_t v) {
+    for (int i = 0; i < 2; ++i) {
+        out->push_back(static_cast<char>(v >> (8 * i)));
+    }
+}
+
+void PutU32(std::string *out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out->push_back(static_cast<char>(v >> (8 * i)));
+    }
+}
+
+void PutU64(std::string *out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        out->push_back(static_cast<char>(v >> (8 * i)));
+    }
+}
+
+// Bounds-checked little-endian reader over the index bytes.
+class IndexReader {
+public:
+    IndexReader(const unsigned char *data, size_t length) : data_(data), length_(length) {}
+
+    bool Read(void *out, size_t n) {
+        if (length_ - pos_ < n) {
+            return false;
+        }
+        memcpy(out, data_ + pos_, n);
+        pos_ += n;
+        return true;
+    }
+
+    template <typename T>
+    bool ReadInt(T *out) {
+        unsigned char bytes[sizeof(T)];
+        if (!Read(bytes, sizeof(T))) {
+            return false;
+        }
+        T v = 0;
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            v |= static_cast<T>(bytes[i]) << (8 * i);
+        }
+        *out = v;
+        return true;
+    }
+
+    bool at_end() const { return pos_ == length_; }
+
+private:
+    const unsigned char *data_;
+    size_t length_;
+    size_t pos_ = 0;
+};
+
+bool SafeRelativePath(const std::string &path) {
+    if (path.empty() || path[0] == '/') {
+        return false;
+    }
+    size_t pos = 0;
+    while (pos <= path.size()) {
+        size_t slash = path.find('/', pos);
+        if (slash == std::string::npos) {
+            slash = path.size();
+        }
+        const std::string part = path.substr(pos, slash - pos);
+        if (part.empty() || part == "." || part == "..") {
+            return false;
+        }
+        pos = slash + 1;
+    }
+    return true;
+}
+
+bool PreadAll(int fd, unsigned char *out, size_t length, uint64_t offset) {
+    while (length > 0) {
+        const ssize_t n = pread(fd, out, length, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        out += n;
+        length -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+bool PwriteAll(int fd, const unsigned char *data, size_t length, uint64_t offset) {
+    while (length > 0) {
+        const ssize_t n = pwrite(fd, data, length, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        length -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+bool InflateRaw(const unsigned char *in, size_t in_length, unsigned char *out, size_t out_length) {
+    z_stream stream{};
+    if (inflateInit2(&stream, -15) != Z_OK) {
+        return false;
+    }
+    stream.next_in = const_cast<unsigned char *>(in);
+    stream.avail_in = static_cast<uInt>(in_length);
+    stream.next_out = out;
+    stream.avail_out = static_cast<uInt>(out_length);
+    const int rc = inflate(&stream, Z_FINISH);
+    const bool ok = rc == Z_STREAM_END && stream.avail_out == 0 && stream.avail_in == 0;
+    inflateEnd(&stream);
+    return ok;
+}
+
+std::string ErrnoString(const std::string &what) {
+    return what + ": " + strerror(errno);
+}
+
+void FsyncDir(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+constexpr int kFdClosed = -2;
+
+} // namespace
+
+std::string SerializeContainerIndex(const ContainerIndex &index) {
+    std::string out;
+    PutU32(&out, static_cast<uint32_t>(index.files.size()));
+    for (const ContainerFile &file : index.files) {
+        PutU16(&out, static_cast<uint16_t>(file.path.size()));
+        out.append(file.path);
+        PutU32(&out, file.mode);
+        PutU64(&out, file.size);
+    }
+    PutU32(&out, static_cast<uint32_t>(index.chunks.size()));
+    for (const ContainerChunk &chunk : index.chunks) {
+        PutU64(&out, chunk.offset);
+        PutU32(&out, chunk.stored_size);
+        PutU32(&out, chunk.raw_size);
+        PutU32(&out, chunk.file);
+        PutU64(&out, chunk.file_offset);
+        out.push_back(static_cast<char>(chunk.compression));
+        out.append(reinterpret_cast<const char *>(chunk.sha256), sizeof(chunk.sha256));
+    }
+    return out;
+}
+
+bool ParseContainerIndex(const unsigned char *data, size_t length, ContainerIndex *out,
+                         std::string *error) {
+    IndexReader reader(data, length);
+    ContainerIndex index;
+    uint32_t file_count = 0;
+    if (!reader.ReadInt(&file_count) || file_count > length) {
+        *error = "bad file count";
+        return false;
+    }
+    index.files.resize(file_count);
+    for (ContainerFile &file : index.files) {
+        uint16_t path_length = 0;
+        if (!reader.ReadInt(&path_length)) {
+            *error = "truncated file entry";
+            return false;
+        }
+        file.path.resize(path_length);
+        if (!reader.Read(&file.path[0], path_length) || !reader.ReadInt(&file.mode) ||
+            !reader.ReadInt(&file.size)) {
+            *error = "truncated file entry";
+            return false;
+        }
+        if (!SafeRelativePath(file.path)) {
+            *error = "unsafe path in container: " + file.path;
+            return false;
+        }
+    }
+
+    uint32_t chunk_count = 0;
+    if (!reader.ReadInt(&chunk_count) || chunk_count > length) {
+        *error = "bad chunk count";
+        return false;
+    }
+    index.chunks.resize(chunk_count);
+    std::vector<uint64_t> covered(file_count, 0);
+    for (ContainerChunk &chunk : index.chunks) {
+        uint8_t compression = 0;
+        if (!reader.ReadInt(&chunk.offset) || !reader.ReadInt(&chunk.stored_size) ||
+            !reader.ReadInt(&chunk.raw_size) || !reader.ReadInt(&chunk.file) ||
+            !reader.ReadInt(&chunk.file_offset) || !reader.ReadInt(&compression) ||
+            !reader.Read(chunk.sha256, sizeof(chunk.sha256))) {
+            *error = "truncated chunk entry";
+            return false;
+        }
+        if (compression > static_cast<uint8_t>(ChunkCompression::kDeflate)) {
+            *error = "unknown chunk compression";
+            return false;
+        }
+        chunk.compression = static_cast<ChunkCompression>(compression);
+        if (chunk.file >= file_count ||
+            chunk.file_offset + chunk.raw_size > index.files[chunk.file].size ||
+            (chunk.compression == ChunkCompression::kStored && chunk.stored_size != chunk.raw_size)) {
+            *error = "inconsistent chunk entry";
+            return false;
+        }
+        covered[chunk.file] += chunk.raw_size;
+    }
+    for (uint32_t i = 0; i < file_count; ++i) {
+        if (covered[i] != index.files[i].size) {
+            *error = "chunks do not cover " + index.files[i].path;
+            return false;
+        }
+    }
+    if (!reader.at_end()) {
+        *error = "trailing bytes in index";
+        return false;
+    }
+    *out = std::move(index);
+    return true;
+}
+
+ContainerApplier::ContainerApplier(const std::string &container_path, const std::string &dest_dir,
+                                   const std::string &expected_index_sha256)
+    : container_path_(container_path), dest_dir_(dest_dir),
+      expected_index_sha256_(expected_index_sha256) {}
+
+ContainerApplier::~ContainerApplier() {
+    for (int fd : file_fds_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+void ContainerApplier::MarkAvailable(uint64_t offset, uint64_t length) {
+    if (length == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t start = offset;
+        uint64_t end = offset + length;
+        // Merge with every range that touches [start, end).
+        auto it = available_.upper_bound(start);
+        if (it != available_.begin()) {
+            auto prev = std::prev(it);
+            if (prev->second >= start) {
+                it = prev;
+            }
+        }
+        while (it != available_.end() && it->first <= end) {
+            start = std::min(start, it->first);
+            end = std::max(end, it->second);
+            it = available_.erase(it);
+        }
+        available_[start] = end;
+        ++generation_;
+    }
+    available_cv_.notify_all();
+}
+
+void ContainerApplier::Interrupt() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+    }
+    available_cv_.notify_all();
+}
+
+bool ContainerApplier::IsAvailable(uint64_t offset, uint64_t length) const {
+    auto it = available_.upper_bound(offset);
+    if (it == available_.begin()) {
+        return false;
+    }
+    --it;
+    return it->first <= offset && it->second >= offset + length;
+}
+
+bool ContainerApplier::LoadIndex(std::string *error) {
+    unsigned char preamble[kContainerPreambleSize];
+    uint32_t index_size = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!IsAvailable(0, kContainerPreambleSize)) {
+            return true;  // not yet
+        }
+    }
+    if (fd_ < 0) {
+        fd_ = open(container_path_.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            *error = ErrnoString("open " + container_path_);
+            return false;
+        }
+    }
+    if (!PreadAll(fd_, preamble, sizeof(preamble), 0) ||
+        memcmp(preamble, kContainerMagic, sizeof(kContainerMagic)) != 0) {
+        *error = "not a snapshot container";
+        return false;
+    }
+    for (int i = 0; i < 4; ++i) {
+        index_size |= static_cast<uint32_t>(preamble[sizeof(kContainerMagic) + i]) << (8 * i);
+    }
+    if (index_size > kContainerMaxIndexSize) {
+        *error = "index too large";
+        return false;
+    }
+    const uint64_t data_start = kContainerPreambleSize + index_size + Sha256::kDigestSize;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!IsAvailable(0, data_start)) {
+            return true;
+        }
+    }
+
+    std::vector<unsigned char> bytes(index_size + Sha256::kDigestSize);
+    if (!PreadAll(fd_, bytes.data(), bytes.size(), kContainerPreambleSize)) {
+        *error = ErrnoString("read index");
+        return false;
+    }
+    Sha256 hasher;
+    hasher.Update(bytes.data(), index_size);
+    unsigned char digest[Sha256::kDigestSize];
+    hasher.Finish(digest);
+    if (memcmp(digest, bytes.data() + index_size, sizeof(digest)) != 0) {
+        *error = "index checksum mismatch";
+        return false;
+    }
+    const std::string digest_hex = HexDigest(digest, sizeof(digest));
+    if (!expected_index_sha256_.empty() && digest_hex != expected_index_sha256_) {
+        *error = "unexpected snapshot: index " + digest_hex + ", expected " + expected_index_sha256_;
+        return false;
+    }
+    if (!ParseContainerIndex(bytes.data(), index_size, &index_, error)) {
+        return false;
+    }
+    for (const ContainerChunk &chunk : index_.chunks) {
+        if (chunk.offset < data_start) {
+            *error = "chunk overlaps the index";
+            return false;
+        }
+    }
+
+    if (mkdir(dest_dir_.c_str(), 0700) != 0 && errno != EEXIST) {
+        *error = ErrnoString("mkdir " + dest_dir_);
+        return false;
+    }
+    dirs_.push_back(dest_dir_);
+    file_fds_.assign(index_.files.size(), -1);
+    file_remaining_.resize(index_.files.size());
+    for (size_t i = 0; i < index_.files.size(); ++i) {
+        const ContainerFile &file = index_.files[i];
+        file_remaining_[i] = file.size;
+        total_bytes_ += file.size;
+        for (size_t slash = file.path.find('/'); slash != std::string::npos;
+             slash = file.path.find('/', slash + 1)) {
+            const std::string dir = dest_dir_ + "/" + file.path.substr(0, slash);
+            if (std::find(dirs_.begin(), dirs_.end(), dir) != dirs_.end()) {
+                continue;
+            }
+            if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+                *error = ErrnoString("mkdir " + dir);
+                return false;
+            }
+            dirs_.push_back(dir);
+        }
+        if (file.size == 0) {
+            if (OutputFd(static_cast<uint32_t>(i), error) < 0) {
+                return false;
+            }
+            ChunkWritten(static_cast<uint32_t>(i), 0);
+        }
+    }
+    pending_.resize(index_.chunks.size());
+    for (size_t i = 0; i < pending_.size(); ++i) {
+        pending_[i] = i;
+    }
+    index_loaded_ = true;
+    return true;
+}
+
+int ContainerApplier::OutputFd(uint32_t file, std::string *error) {
+    std::lock_guard<std::mutex> lock(files_mutex_);
+    int &fd = file_fds_[file];
+    if (fd >= 0) {
+        return fd;
+    }
+    const ContainerFile &entry = index_.files[file];
+    const std::string path = dest_dir_ + "/" + entry.path;
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, static_cast<mode_t>((entry.mode & 0777) | 0600));
+    if (fd < 0) {
+        *error = ErrnoString("create " + path);
+        return -1;
+    }
+    // Exact final size up front: chunks land out of order and a stale longer
+    // file must not keep its tail.
+    if (entry.size > 0) {
+        posix_fallocate(fd, 0, static_cast<off_t>(entry.size));
+    }
+    if (ftruncate(fd, static_cast<off_t>(entry.size)) != 0) {
+        *error = ErrnoString("truncate " + path);
+        close(fd);
+        fd = -1;
+        return -1;
+    }
+    return fd;
+}
+
+void ContainerApplier::ChunkWritten(uint32_t file, uint32_t raw_size) {
+    std::lock_guard<std::mutex> lock(files_mutex_);
+    file_remaining_[file] -= raw_size;
+    if (file_remaining_[file] == 0 && file_fds_[file] >= 0) {
+        fsync(file_fds_[file]);
+        close(file_fds_[file]);
+        file_fds_[file] = kFdClosed;
+    }
+    applied_bytes_ += raw_size;
+}
+
+bool ContainerApplier::ApplyChunk(size_t index, std::vector<unsigned char> *stored,
+                                  std::vector<unsigned char> *raw, std::string *error) {
+    TraceSpan span("snapshot", "ApplyChunk", static_cast<int64_t>(index));
+    const ContainerChunk &chunk = index_.chunks[index];
+    stored->resize(chunk.stored_size);
+    if (!PreadAll(fd_, stored->data(), stored->size(), chunk.offset)) {
+        *error = ErrnoString("read chunk " + std::to_string(index));
+        return false;
+    }
+    Sha256 hasher;
+    hasher.Update(stored->data(), stored->size());
+    unsigned char digest[Sha256::kDigestSize];
+    hasher.Finish(digest);
+    if (memcmp(digest, chunk.sha256, sizeof(digest)) != 0) {
+        *error = "chunk " + std::to_string(index) + " checksum mismatch";
+        return false;
+    }
+
+    const unsigned char *payload = stored->data();
+    if (chunk.compression == ChunkCompression::kDeflate) {
+        raw->resize(chunk.raw_size);
+        if (!InflateRaw(stored->data(), stored->size(), raw->data(), raw->size())) {
+            *error = "chunk " + std::to_string(index) + " does not inflate";
+            return false;
+        }
+        payload = raw->data();
+    }
+
+    const int fd = OutputFd(chunk.file, error);
+    if (fd < 0) {
+        return false;
+    }
+    if (!PwriteAll(fd, payload, chunk.raw_size, chunk.file_offset)) {
+        *error = ErrnoString("write " + index_.files[chunk.file].path);
+        return false;
+    }
+    ChunkWritten(chunk.file, chunk.raw_size);
+    return true;
+}
+
+bool ContainerApplier::ApplyAvailable(int timeout_ms, int threads, std::string *error) {
+    if (!error_.empty()) {
+        *error = error_;
+        return false;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (generation_ == seen_generation_ && timeout_ms > 0) {
+            available_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                                   [this] { return generation_ != seen_generation_; });
+        }
+        seen_generation_ = generation_;
+    }
+
+    if (!index_loaded_ && !LoadIndex(&error_)) {
+        *error = error_;
+        return false;
+    }
+    if (!index_loaded_) {
+        return true;
+    }
+
+    std::vector<size_t> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<size_t> still_pending;
+        for (size_t chunk : pending_) {
+            const ContainerChunk &entry = index_.chunks[chunk];
+            if (IsAvailable(entry.offset, entry.stored_size)) {
+                ready.push_back(chunk);
+            } else {
+                still_pending.push_back(chunk);
+            }
+        }
+        pending_.swap(still_pending);
+    }
+    if (ready.empty()) {
+        return true;
+    }
+
+    std::atomic<size_t> next{0};
+    std::mutex failure_mutex;
+    std::string failure;
+    auto worker = [&] {
+        std::vector<unsigned char> stored;
+        std::vector<unsigned char> raw;
+        std::string chunk_error;
+        for (size_t i = next++; i < ready.size(); i = next++) {
+            if (!ApplyChunk(ready[i], &stored, &raw, &chunk_error)) {
+                std::lock_guard<std::mutex> lock(failure_mutex);
+                if (failure.empty()) {
+                    failure = chunk_error;
+                }
+                next = ready.size();
+                return;
+            }
+        }
+    };
+    const size_t worker_count =
+            std::min(ready.size(), static_cast<size_t>(std::max(threads, 1)));
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < worker_count; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &t : workers) {
+        t.join();
+    }
+
+    if (!failure.empty()) {
+        error_ = failure;
+        *error = error_;
+        return false;
+    }
+    return true;
+}
+
+bool ContainerApplier::complete() const {
+    return index_loaded_ && pending_.empty() && applied_bytes_.load() == total_bytes_;
+}
+
+bool ContainerApplier::Finish(std::string *error) {
+    if (!complete()) {
+        *error = error_.empty() ? "snapshot not fully applied" : error_;
+        return false;
+    }
+    // Deepest first so every new entry is durable before its parent is synced.
+    for (auto it = dirs_.rbegin(); it != dirs_.rend(); ++it) {
+        FsyncDir(*it);
+    }
+    return true;
+}
+
+} // namespace digimobile
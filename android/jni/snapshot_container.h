@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace digimobile {
+
+// Seekable snapshot container ("DGBSNAP1"). Unlike a tar.gz, every chunk can
+// be verified and decompressed on its own, so a snapshot can be applied while
+// it is still downloading, in whatever order its byte ranges arrive.
+//
+//   magic      "DGBSNAP1"
+//   u32        index size (little endian, like every integer below)
+//   index      files, then chunks (see ContainerIndex)
+//   u8[32]     SHA-256 of the index bytes
+//   chunk data at the offsets recorded in the index
+//
+// The index digest is the trust anchor: the index carries each chunk's
+// SHA-256, so pinning it pins the whole snapshot.
+constexpr char kContainerMagic[8] = {'D', 'G', 'B', 'S', 'N', 'A', 'P', '1'};
+constexpr size_t kContainerPreambleSize = sizeof(kContainerMagic) + 4;
+constexpr uint32_t kContainerMaxIndexSize = 64u << 20;
+
+enum class ChunkCompression : uint8_t {
+    kStored = 0,
+    kDeflate = 1,  // raw deflate (no zlib/gzip wrapper)
+};
+
+struct ContainerFile {
+    std::string path;  // relative, '/'-separated
+    uint32_t mode = 0600;
+    uint64_t size = 0;
+};
+
+// A slice of one file; chunks never span files.
+struct ContainerChunk {
+    uint64_t offset = 0;       // absolute position in the container
+    uint32_t stored_size = 0;  // bytes in the container
+    uint32_t raw_size = 0;     // bytes once decompressed
+    uint32_t file = 0;         // index into ContainerIndex::files
+    uint64_t file_offset = 0;
+    ChunkCompression compression = ChunkCompression::kStored;
+    unsigned char sha256[32] = {};  // of the stored bytes
+};
+
+struct ContainerIndex {
+    std::vector<ContainerFile> files;
+    std::vector<ContainerChunk> chunks;
+};
+
+std::string SerializeContainerIndex(const ContainerIndex &index);
+bool ParseContainerIndex(const unsigned char *data, size_t length, ContainerIndex *out,
+                         std::string *error);
+
+// Applies a container into dest_dir while the container file is still being
+// written. The producer of the bytes (a downloader, or the caller for a file
+// that is already complete) reports finished byte ranges with MarkAvailable();
+// ApplyAvailable() then verifies, inflates and writes every chunk whose bytes
+// are all present, directly at the file's final path and offset.
+//
+// MarkAvailable() may be called from any thread; the other methods belong to
+// a single consumer thread.
+class ContainerApplier {
+public:
+    ContainerApplier(const std::string &container_path, const std::string &dest_dir,
+                     const std::string &expected_index_sha256);
+    ~ContainerApplier();
+    ContainerApplier(const ContainerApplier &) = delete;
+    ContainerApplier &operator=(const ContainerApplier &) = delete;
+
+    void MarkAvailable(uint64_t offset, uint64_t length);
+    // Wake a consumer blocked in ApplyAvailable(), e.g. when the download failed.
+    void Interrupt();
+
+    // Apply every ready chunk, waiting up to timeout_ms for more bytes if none
+    // is ready. Chunks are inflated on up to `threads` workers. Returns false
+    // on a corrupt or unexpected container; the error is sticky.
+    bool ApplyAvailable(int timeout_ms, int threads, std::string *error);
+
+    // Every chunk has been written. Finish() then fsyncs the remaining files
+    // and directories.
+    bool complete() const;
+    bool Finish(std::string *error);
+
+    uint64_t applied_bytes() const { return applied_bytes_.load(); }
+    uint64_t total_bytes() const { return total_bytes_; }
+
+private:
+    bool LoadIndex(std::string *error);
+    bool IsAvailable(uint64_t offset, uint64_t length) const;  // mutex_ held
+    bool ApplyChunk(size_t chunk, std::vector<unsigned char> *stored,
+                    std::vector<unsigned char> *raw, std::string *error);
+    int OutputFd(uint32_t file, std::string *error);
+    void ChunkWritten(uint32_t file, uint32_t raw_size);
+
+    const std::string container_path_;
+    const std::string dest_dir_;
+    const std::string expected_index_sha256_;
+    int fd_ = -1;
+    std::string error_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable available_cv_;
+    std::map<uint64_t, uint64_t> available_;  // start -> end, merged and disjoint
+    uint64_t generation_ = 0;                 // bumped by MarkAvailable/Interrupt
+    uint64_t seen_generation_ = 0;
+
+    bool index_loaded_ = false;
+    ContainerIndex index_;
+    std::vector<size_t> pending_;  // chunk indices not yet applied
+    uint64_t total_bytes_ = 0;
+    std::atomic<uint64_t> applied_bytes_{0};
+
+    std::mutex files_mutex_;
+    std::vector<int> file_fds_;
+    std::vector<uint64_t> file_remaining_;
+    std::vector<std::string> dirs_;
+};
+
+} // namespace digimobile
@@ -0,0 +1,772 @@
+#include "snapshot_extractor.h"
+
+#include "sha256.h"
+#include "trace_recorder.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace digimobile {
+namespace {
+
+constexpr size_t kTarBlock = 512;
+constexpr size_t kBufferAlignment = 4096;
+// Bound on GNU long-name and pax records kept in memory.
+constexpr int64_t kMaxMetaRecord = 1 << 20;
+
+// Fixed-size aligned buffer handed between pipeline stages.
+struct Block {
+    unsigned char *data = nullptr;
+    size_t length = 0;
+};
+
+// Recycles blocks so the steady state allocates nothing. The pool must outlive
+// every handle it returned.
+class BlockPool {
+public:
+    explicit BlockPool(size_t block_size) : block_size_(block_size) {}
+    ~BlockPool() {
+        for (Block *block : free_) {
+            free(block->data);
+            delete block;
+        }
+    }
+
+    std::shared_ptr<Block> Get() {
+        Block *block = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                block = free_.back();
+                free_.pop_back();
+            }
+        }
+        if (block == nullptr) {
+            void *data = nullptr;
+            if (posix_memalign(&data, kBufferAlignment, block_size_) != 0) {
+                return nullptr;
+            }
+            block = new Block;
+            block->data = static_cast<unsigned char *>(data);
+        }
+        block->length = 0;
+        return std::shared_ptr<Block>(block, [this](Block *b) { Put(b); });
+    }
+
+    size_t block_size() const { return block_size_; }
+
+private:
+    void Put(Block *block) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(block);
+    }
+
+    const size_t block_size_;
+    std::mutex mutex_;
+    std::vector<Block *> free_;
+};
+
+// Single-producer/single-consumer hand-off with backpressure. Close() ends the
+// stream: Pop() drains what is left and then returns false.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity ? capacity : 1) {}
+
+    bool Push(T value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(std::move(value));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    bool Pop(T *out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+        if (items_.empty()) {
+            return false;
+        }
+        *out = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+private:
+    const size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<T> items_;
+    bool closed_ = false;
+};
+
+// A file to create, or a run of its payload (a slice of a shared block), or its end.
+struct WriteOp {
+    enum Kind { kOpen, kData, kClose } kind = kData;
+    std::string path;
+    mode_t mode = 0600;
+    int64_t size = 0;
+    std::shared_ptr<Block> block;
+    const unsigned char *data = nullptr;
+    size_t length = 0;
+};
+
+// First error wins; every stage polls failed() and winds down.
+class Failure {
+public:
+    void Set(const std::string &message) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!failed_.exchange(true)) {
+            message_ = message;
+        }
+    }
+    bool failed() const { return failed_.load(); }
+    std::string message() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return message_;
+    }
+
+private:
+    std::atomic<bool> failed_{false};
+    std::mutex mutex_;
+    std::string message_;
+};
+
+std::string ErrnoString(const std::string &what) {
+    return what + ": " + strerror(errno);
+}
+
+bool WriteAll(int fd, const unsigned char *data, size_t length) {
+    while (length > 0) {
+        const ssize_t n = write(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool FsyncPath(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+// Reader stage: sequential large reads of the compressed archive, hashed on
+// the way through.
+void ReadStage(int fd, BlockPool *pool, BoundedQueue<std::shared_ptr<Block>> *out,
+               const std::string &expected_sha256, std::string *sha256, Failure *failure) {
+    TraceSetThreadName("extract read");
+    Sha256 hasher;
+    bool complete = false;
+    while (!failure->failed()) {
+        std::shared_ptr<Block> block = pool->Get();
+        if (!block) {
+            failure->Set("out of memory");
+            break;
+        }
+        ssize_t n;
+        {
+            TraceSpan span("extract", "read");
+            do {
+                n = read(fd, block->data, pool->block_size());
+            } while (n < 0 && errno == EINTR);
+            span.set_arg(n);
+        }
+        if (n < 0) {
+            failure->Set(ErrnoString("read archive"));
+            break;
+        }
+        if (n == 0) {
+            complete = true;
+            break;
+        }
+        block->length = static_cast<size_t>(n);
+        hasher.Update(block->data, block->length);
+        if (!out->Push(std::move(block))) {
+            break;
+        }
+    }
+    if (complete) {
+        *sha256 = hasher.FinishHex();
+        if (!expected_sha256.empty() && *sha256 != expected_sha256) {
+            failure->Set("checksum mismatch: expected " + expected_sha256 + ", found " + *sha256);
+        }
+    }
+    out->Close();
+}
+
+// Inflate stage: gzip members back to back (as written by pigz/bgzip or cat).
+void InflateStage(BlockPool *pool, BoundedQueue<std::shared_ptr<Block>> *in,
+                  BoundedQueue<std::shared_ptr<Block>> *out, std::atomic<int64_t> *consumed,
+                  Failure *failure) {
+    TraceSetThreadName("extract inflate");
+    z_stream stream{};
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+        failure->Set("inflateInit2 failed");
+        in->Close();
+        out->Close();
+        return;
+    }
+
+    bool member_open = false;
+    bool saw_data = false;
+    int64_t finished = 0;  // bytes of fully consumed input blocks
+    std::shared_ptr<Block> input;
+    std::shared_ptr<Block> output;
+    while (!failure->failed()) {
+        if (stream.avail_in == 0) {
+            if (input) {
+                finished += static_cast<int64_t>(input->length);
+                input.reset();
+            }
+            if (!in->Pop(&input)) {
+                break;
+            }
+            stream.next_in = input->data;
+            stream.avail_in = static_cast<uInt>(input->length);
+        }
+        if (!output) {
+            output = pool->Get();
+            if (!output) {
+                failure->Set("out of memory");
+                break;
+            }
+            stream.next_out = output->data;
+            stream.avail_out = static_cast<uInt>(pool->block_size());
+        }
+
+        if (!member_open) {
+            inflateReset(&stream);
+            member_open = true;
+        }
+        const uInt out_before = stream.avail_out;
+        int rc;
+        {
+            TraceSpan span("extract", "inflate");
+            rc = inflate(&stream, Z_NO_FLUSH);
+            span.set_arg(out_before - stream.avail_out);
+        }
+        saw_data = true;
+        consumed->store(finished + static_cast<int64_t>(input->length - stream.avail_in));
+        if (rc == Z_STREAM_END) {
+            member_open = false;
+        } else if (rc == Z_BUF_ERROR) {
+            // Needs more input (avail_in is 0) or more output (handled below).
+        } else if (rc != Z_OK) {
+            failure->Set(std::string("corrupt gzip stream: ") + (stream.msg ? stream.msg : "inflate"));
+            break;
+        }
+
+        if (stream.avail_out == 0) {
+            output->length = pool->block_size();
+            if (!out->Push(std::move(output))) {
+                break;
+            }
+            output.reset();
+        }
+    }
+
+    if (!failure->failed()) {
+        if (output && stream.avail_out < pool->block_size()) {
+            output->length = pool->block_size() - stream.avail_out;
+            out->Push(std::move(output));
+        }
+        if (!saw_data) {
+            failure->Set("archive is empty");
+        } else if (member_open) {
+            failure->Set("truncated gzip stream");
+        }
+    }
+    inflateEnd(&stream);
+    in->Close();
+    out->Close();
+}
+
+// Writer stage: creates files and appends payload slices. Finished files are
+// kept open until a batch is full, then fsync'd and closed together so the
+// flushes overlap with the next batch's writes instead of serializing each file.
+void WriteStage(BoundedQueue<WriteOp> *in, size_t fsync_batch, Failure *failure) {
+    TraceSetThreadName("extract write");
+    std::vector<int> pending;
+    auto flush = [&] {
+        TraceSpan span("extract", "fsync batch", static_cast<int64_t>(pending.size()));
+        for (int fd : pending) {
+            if (fsync(fd) != 0 && !failure->failed()) {
+                failure->Set(ErrnoString("fsync"));
+            }
+            close(fd);
+        }
+        pending.clear();
+    };
+
+    int fd = -1;
+    std::string path;
+    WriteOp op;
+    while (in->Pop(&op)) {
+        if (failure->failed()) {
+            continue;  // drain so the producer never blocks
+        }
+        switch (op.kind) {
+            case WriteOp::kOpen:
+                path = op.path;
+                fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, op.mode);
+                if (fd < 0) {
+                    failure->Set(ErrnoString("create " + path));
+                    break;
+                }
+                if (op.size > 0) {
+                    posix_fallocate(fd, 0, op.size);  // best effort; limits fragmentation
+                }
+                break;
+            case WriteOp::kData:
+                if (fd >= 0 && !WriteAll(fd, op.data, op.length)) {
+                    failure->Set(ErrnoString("write " + path));
+                }
+                break;
+            case WriteOp::kClose:
+                if (fd >= 0) {
+                    pending.push_back(fd);
+                    fd = -1;
+                }
+                if (pending.size() >= fsync_batch) {
+                    flush();
+                }
+                break;
+        }
+        op.block.reset();
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    flush();
+}
+
+int64_t ParseOctal(const char *field, size_t length) {
+    // GNU base-256 for sizes of 8 GiB and up.
+    if (length > 0 && (static_cast<unsigned char>(field[0]) & 0x80)) {
+        int64_t value = static_cast<unsigned char>(field[0]) & 0x7f;
+        for (size_t i = 1; i < length; ++i) {
+            value = (value << 8) | static_cast<unsigned char>(field[i]);
+        }
+        return value;
+    }
+    int64_t value = 0;
+    size_t i = 0;
+    while (i < length && (field[i] == ' ' || field[i] == '\0')) {
+        ++i;
+    }
+    for (; i < length && field[i] >= '0' && field[i] <= '7'; ++i) {
+        value = value * 8 + (field[i] - '0');
+    }
+    return value;
+}
+
+std::string FieldString(const char *field, size_t length) {
+    return std::string(field, strnlen(field, length));
+}
+
+// Extract "path=" from a pax extended header ("<len> key=value\n" records).
+std::string PaxPath(const std::string &records) {
+    size_t pos = 0;
+    while (pos < records.size()) {
+        const size_t space = records.find(' ', pos);
+        if (space == std::string::npos) {
+            break;
+        }
+        const int64_t record_len = atoll(records.c_str() + pos);
+        if (record_len <= 0 || pos + static_cast<size_t>(record_len) > records.size()) {
+            break;
+        }
+        const std::string record = records.substr(space + 1, pos + record_len - space - 2);
+        if (record.compare(0, 5, "path=") == 0) {
+            return record.substr(5);
+        }
+        pos += static_cast<size_t>(record_len);
+    }
+    return std::string();
+}
+
+// Drop strip leading components into out (empty when nothing is left, as for
+// the stripped top-level directory). Returns false for names with a ".."
+// component, which could escape the destination.
+bool SanitizePath(const std::string &name, int strip, std::string *out) {
+    std::vector<std::string> parts;
+    size_t pos = 0;
+    while (pos <= name.size()) {
+        size_t slash = name.find('/', pos);
+        if (slash == std::string::npos) {
+            slash = name.size();
+        }
+        const std::string part = name.substr(pos, slash - pos);
+        if (part == "..") {
+            return false;
+        }
+        if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+        pos = slash + 1;
+    }
+    out->clear();
+    for (size_t i = static_cast<size_t>(std::max(strip, 0)); i < parts.size(); ++i) {
+        if (!out->empty()) {
+            out->push_back('/');
+        }
+        out->append(parts[i]);
+    }
+    return true;
+}
+
+// Tar stream parser running on the caller's thread. It only creates
+// directories itself; file payloads go to the writer as slices of the
+// inflated blocks, without copying.
+class TarParser {
+public:
+    TarParser(const std::string &dest, int strip, BoundedQueue<WriteOp> *writes,
+              ExtractStats *stats, Failure *failure)
+        : dest_(dest), strip_(strip), writes_(writes), stats_(stats), failure_(failure) {}
+
+    void Feed(const std::shared_ptr<Block> &block) {
+        const unsigned char *p = block->data;
+        size_t left = block->length;
+        while (left > 0 && !done_ && !failure_->failed()) {
+            switch (state_) {
+                case State::kHeader: {
+                    const size_t take = std::min(left, kTarBlock - header_fill_);
+                    memcpy(header_ + header_fill_, p, take);
+                    header_fill_ += take;
+                    p += take;
+                    left -= take;
+                    if (header_fill_ == kTarBlock) {
+                        header_fill_ = 0;
+                        OnHeader();
+                    }
+                    break;
+                }
+                case State::kData: {
+                    const size_t take = static_cast<size_t>(
+                            std::min<int64_t>(static_cast<int64_t>(left), remaining_));
+                    if (writing_) {
+                        WriteOp op;
+                        op.kind = WriteOp::kData;
+                        op.block = block;
+                        op.data = p;
+                        op.length = take;
+                        writes_->Push(std::move(op));
+                        stats_->bytes_written += static_cast<int64_t>(take);
+                    } else if (meta_ != Meta::kNone) {
+                        meta_buffer_.append(reinterpret_cast<const char *>(p), take);
+                    }
+                    p += take;
+                    left -= take;
+                    remaining_ -= static_cast<int64_t>(take);
+                    if (remaining_ == 0) {
+                        EndEntry();
+                    }
+                    break;
+                }
+                case State::kPadding: {
+                    const size_t take = static_cast<size_t>(
+                            std::min<int64_t>(static_cast<int64_t>(left), remaining_));
+                    p += take;
+                    left -= take;
+                    remaining_ -= static_cast<int64_t>(take);
+                    if (remaining_ == 0) {
+                        state_ = State::kHeader;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    bool Finish(std::string *error) {
+        if (!done_ && (state_ != State::kHeader || header_fill_ != 0 || !saw_header_)) {
+            *error = "truncated tar stream";
+            return false;
+        }
+        for (const std::string &dir : dirs_) {
+            FsyncPath(dir);
+        }
+        return true;
+    }
+
+private:
+    enum class State { kHeader, kData, kPadding };
+    enum class Meta { kNone, kLongName, kPax };
+
+    void OnHeader() {
+        bool zero = true;
+        for (size_t i = 0; i < kTarBlock; ++i) {
+            if (header_[i] != 0) {
+                zero = false;
+                break;
+            }
+        }
+        if (zero) {
+            if (++zero_blocks_ == 2) {
+                done_ = true;
+            }
+            return;
+        }
+        zero_blocks_ = 0;
+        saw_header_ = true;
+
+        const char *h = reinterpret_cast<const char *>(header_);
+        const int64_t size = ParseOctal(h + 124, 12);
+        const char type = h[156];
+        std::string name;
+        if (!pending_name_.empty()) {
+            name.swap(pending_name_);
+        } else {
+            name = FieldString(h, 100);
+            if (memcmp(h + 257, "ustar", 5) == 0 && h[345] != '\0') {
+                name = FieldString(h + 345, 155) + "/" + name;
+            }
+        }
+
+        entry_size_ = size;
+        remaining_ = size;
+        writing_ = false;
+        meta_ = Meta::kNone;
+        meta_buffer_.clear();
+
+        if (type == 'L' || type == 'x') {
+            if (size > kMaxMetaRecord) {
+                failure_->Set("oversized tar metadata record");
+                return;
+            }
+            meta_ = type == 'L' ? Meta::kLongName : Meta::kPax;
+        } else if (type == '0' || type == '\0' || type == '7' || type == '5') {
+            std::string relative;
+            if (!SanitizePath(name, strip_, &relative)) {
+                failure_->Set("unsafe path in archive: " + name);
+                return;
+            }
+            if (relative.empty()) {
+                // Stripped away entirely; its payload is skipped below.
+            } else if (type == '5') {
+                if (!MakeDirs(dest_ + "/" + relative)) {
+                    return;
+                }
+                ++stats_->directories;
+            } else {
+                const std::string path = dest_ + "/" + relative;
+                if (!MakeParents(path)) {
+                    return;
+                }
+                WriteOp op;
+                op.kind = WriteOp::kOpen;
+                op.path = path;
+                op.mode = static_cast<mode_t>((ParseOctal(h + 100, 8) & 0777) | 0600);
+                op.size = size;
+                writes_->Push(std::move(op));
+                writing_ = true;
+                ++stats_->files;
+            }
+        } else if (type != 'g') {
+            ++stats_->skipped;  // hard/symbolic links, devices, fifos
+        }
+
+        if (remaining_ == 0) {
+            EndEntry();
+        } else {
+            state_ = State::kData;
+        }
+    }
+
+    void EndEntry() {
+        if (writing_) {
+            WriteOp op;
+            op.kind = WriteOp::kClose;
+            writes_->Push(std::move(op));
+            writing_ = false;
+        }
+        if (meta_ == Meta::kLongName) {
+            pending_name_ = FieldString(meta_buffer_.data(), meta_buffer_.size());
+        } else if (meta_ == Meta::kPax) {
+            std::string path = PaxPath(meta_buffer_);
+            if (!path.empty()) {
+                pending_name_ = path;
+            }
+        }
+        meta_ = Meta::kNone;
+
+        const int64_t block = static_cast<int64_t>(kTarBlock);
+        remaining_ = (block - entry_size_ % block) % block;
+        state_ = remaining_ > 0 ? State::kPadding : State::kHeader;
+    }
+
+    bool MakeParents(const std::string &path) {
+        const size_t slash = path.rfind('/');
+        return slash == std::string::npos || MakeDirs(path.substr(0, slash));
+    }
+
+    bool MakeDirs(const std::string &path) {
+        if (dirs_.count(path)) {
+            return true;
+        }
+        for (size_t pos = dest_.size() + 1; pos <= path.size(); ++pos) {
+            if (pos != path.size() && path[pos] != '/') {
+                continue;
+            }
+            const std::string prefix = path.substr(0, pos);
+            if (dirs_.count(prefix)) {
+                continue;
+            }
+            if (mkdir(prefix.c_str(), 0700) != 0 && errno != EEXIST) {
+                failure_->Set(ErrnoString("mkdir " + prefix));
+                return false;
+            }
+            dirs_.insert(prefix);
+        }
+        return true;
+    }
+
+    const std::string dest_;
+    const int strip_;
+    BoundedQueue<WriteOp> *writes_;
+    ExtractStats *stats_;
+    Failure *failure_;
+
+    State state_ = State::kHeader;
+    unsigned char header_[kTarBlock] = {};
+    size_t header_fill_ = 0;
+    int64_t entry_size_ = 0;
+    int64_t remaining_ = 0;
+    bool writing_ = false;
+    Meta meta_ = Meta::kNone;
+    std::string meta_buffer_;
+    std::string pending_name_;
+    int zero_blocks_ = 0;
+    bool saw_header_ = false;
+    bool done_ = false;
+    std::set<std::string> dirs_;
+};
+
+} // namespace
+
+bool ExtractTarGz(const std::string &archive, const std::string &dest_dir,
+                  const ExtractOptions &options, const ExtractProgress &progress,
+                  ExtractStats *stats, std::string *error) {
+    TraceSpan span("extract", "ExtractTarGz");
+    ExtractStats local_stats;
+    if (stats == nullptr) {
+        stats = &local_stats;
+    }
+    *stats = ExtractStats();
+
+    const int fd = open(archive.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        *error = ErrnoString("open " + archive);
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        *error = ErrnoString("stat " + archive);
+        close(fd);
+        return false;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (mkdir(dest_dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        *error = ErrnoString("mkdir " + dest_dir);
+        close(fd);
+        return false;
+    }
+
+    const size_t chunk = std::max<size_t>(options.chunk_size, 64 * 1024);
+    const size_t depth = std::max<size_t>(options.queue_depth, 1);
+    // Declared first so it outlives every queued block.
+    BlockPool pool(chunk);
+    BoundedQueue<std::shared_ptr<Block>> compressed(depth);
+    BoundedQueue<std::shared_ptr<Block>> inflated(depth);
+    // Each inflated block yields a handful of ops; leave room so the parser
+    // rarely waits on the writer while it still has input.
+    BoundedQueue<WriteOp> writes(depth * 64);
+    std::atomic<int64_t> consumed{0};
+    Failure failure;
+
+    std::thread reader(ReadStage, fd, &pool, &compressed, std::cref(options.expected_sha256),
+                       &stats->sha256, &failure);
+    std::thread inflater(InflateStage, &pool, &compressed, &inflated, &consumed, &failure);
+    std::thread writer(WriteStage, &writes, std::max<size_t>(options.fsync_batch, 1), &failure);
+
+    TarParser parser(dest_dir, options.strip_components, &writes, stats, &failure);
+    int64_t reported = -1;
+    std::shared_ptr<Block> block;
+    while (inflated.Pop(&block)) {
+        if (!failure.failed()) {
+            parser.Feed(block);
+        }
+        block.reset();
+        const int64_t done = consumed.load();
+        if (progress && done != reported && !failure.failed()) {
+            reported = done;
+            if (!progress(done, static_cast<int64_t>(st.st_size))) {
+                failure.Set("cancelled");
+            }
+        }
+        if (failure.failed()) {
+            compressed.Close();
+            inflated.Close();
+        }
+    }
+    writes.Close();
+    inflater.join();
+    reader.join();
+    writer.join();
+    close(fd);
+
+    std::string parse_error;
+    if (!failure.failed() && !parser.Finish(&parse_error)) {
+        failure.Set(parse_error);
+    }
+    if (failure.failed()) {
+        *error = failure.message();
+        return false;
+    }
+    if (progress) {
+        progress(static_cast<int64_t>(st.st_size), static_cast<int64_t>(st.st_size));
+    }
+    FsyncPath(dest_dir);
+    return true;
+}
+
+} // namespace digimobile
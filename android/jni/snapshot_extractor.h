@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace digimobile {
+
+struct ExtractOptions {
+    // Leading path components dropped from every entry (tar --strip-components).
+    int strip_components = 0;
+    // Size of the aligned read/inflate buffers.
+    size_t chunk_size = 1 << 20;
+    // Buffers in flight between each pair of pipeline stages.
+    size_t queue_depth = 8;
+    // Finished files are fsync'd and closed in batches of this many.
+    size_t fsync_batch = 64;
+    // Lowercase hex SHA-256 the archive must have. The reader hashes each
+    // buffer as it goes, so verification costs no extra pass; a mismatch
+    // fails the extraction.
+    std::string expected_sha256;
+};
+
+struct ExtractStats {
+    int64_t files = 0;
+    int64_t directories = 0;
+    int64_t skipped = 0;        // links and special files, which are never created
+    int64_t bytes_written = 0;  // file payload bytes
+    std::string sha256;         // of the compressed archive, lowercase hex
+};
+
+// Called on the extracting thread with compressed bytes consumed so far and
+// the archive size. Returning false cancels the extraction.
+using ExtractProgress = std::function<bool(int64_t done, int64_t total)>;
+
+// Extract a .tar.gz (single or multi-member gzip; ustar, GNU long names and
+// pax path records) into dest_dir. Reading, inflating and writing each run on
+// their own thread and hand off buffers through bounded queues, so the CPU-bound
+// inflate overlaps with both disk reads and writes; tar parsing and progress
+// run on the calling thread. Entries that would land outside dest_dir are
+// rejected. Every file and directory is fsync'd before this returns true.
+// On failure dest_dir may hold a partial tree; callers extract into a scratch
+// directory and move it into place.
+bool ExtractTarGz(const std::string &archive, const std::string &dest_dir,
+                  const ExtractOptions &options, const ExtractProgress &progress,
+                  ExtractStats *stats, std::string *error);
+
+} // namespace digimobile
@@ -0,0 +1,78 @@
+#include "storage_budget.h"
+
+#include <dirent.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+#include <algorithm>
+
+namespace digimobile {
+namespace {
+
+bool IsBlockFile(const char *name) {
+    const size_t length = strlen(name);
+    return length > 4 && (strncmp(name, "blk", 3) == 0 || strncmp(name, "rev", 3) == 0) &&
+           strcmp(name + length - 4, ".dat") == 0;
+}
+
+int64_t BlockFilesBytes(const std::string &blocks_dir) {
+    DIR *handle = opendir(blocks_dir.c_str());
+    if (!handle) {
+        return 0;
+    }
+    int64_t bytes = 0;
+    while (dirent *entry = readdir(handle)) {
+        if (!IsBlockFile(entry->d_name)) {
+            continue;
+        }
+        struct stat info {};
+        const std::string path = blocks_dir + "/" + entry->d_name;
+        // Allocated blocks rather than st_size: the daemon preallocates block
+        // files in 16 MiB steps, and that is what the filesystem loses.
+        if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+            bytes += static_cast<int64_t>(info.st_blocks) * 512;
+        }
+    }
+    closedir(handle);
+    return bytes;
+}
+
+} // namespace
+
+bool ReadStorageState(const std::string &data_dir, StorageState *out) {
+    struct statvfs fs {};
+    if (statvfs(data_dir.c_str(), &fs) != 0) {
+        return false;
+    }
+    out->total_bytes = static_cast<int64_t>(fs.f_blocks) * static_cast<int64_t>(fs.f_frsize);
+    out->free_bytes = static_cast<int64_t>(fs.f_bavail) * static_cast<int64_t>(fs.f_frsize);
+
+    int64_t blocks = BlockFilesBytes(data_dir + "/blocks");
+    if (DIR *handle = opendir(data_dir.c_str())) {
+        while (dirent *entry = readdir(handle)) {
+            if (entry->d_name[0] != '.' && strcmp(entry->d_name, "blocks") != 0) {
+                blocks += BlockFilesBytes(data_dir + "/" + entry->d_name + "/blocks");
+            }
+        }
+        closedir(handle);
+    }
+    out->blocks_bytes = blocks;
+    return true;
+}
+
+int ChoosePruneTargetMb(const PrunePolicy &policy, const StorageState &state) {
+    if (policy.max_target_mb <= 0 || state.free_bytes < 0 || state.total_bytes <= 0) {
+        return 0;
+    }
+    const int64_t reserve =
+            std::max(policy.reserve_bytes, state.total_bytes / 100 * policy.reserve_percent);
+    // Block files already on disk are recycled by pruning, so they count as
+    // space the target may use.
+    const int64_t usable = std::max<int64_t>(state.blocks_bytes, 0) + state.free_bytes - reserve;
+    const int64_t fit_mb = usable > 0 ? usable >> 20 : 0;
+    return static_cast<int>(std::clamp<int64_t>(fit_mb, kMinPruneTargetMb,
+                                                std::max(policy.max_target_mb, kMinPruneTargetMb)));
+}
+
+} // namespace digimobile
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace digimobile {
+
+// digibyted refuses automatic pruning below this many MiB.
+constexpr int kMinPruneTargetMb = 550;
+
+// Space on the datadir's filesystem and what the node occupies of it. -1 when
+// unknown.
+struct StorageState {
+    int64_t total_bytes = -1;
+    int64_t free_bytes = -1;   // available to the app (f_bavail)
+    int64_t blocks_bytes = -1; // blk*.dat and rev*.dat, which pruning bounds
+};
+
+// Reads statvfs() of data_dir and sizes the block files of every network under
+// it (blocks/ in data_dir for mainnet, <network>/blocks/ otherwise).
+bool ReadStorageState(const std::string &data_dir, StorageState *out);
+
+struct PrunePolicy {
+    // The user's prune setting; the chosen target never exceeds it. 0 leaves
+    // pruning to digibyte.conf.
+    int max_target_mb = 0;
+    // Space kept free for the system and other apps: the larger of the two.
+    int64_t reserve_bytes = 1ll << 30;
+    int reserve_percent = 10;
+};
+
+// Prune target that fits the block files into what is free now plus what they
+// already occupy, minus the reserve; between kMinPruneTargetMb and
+// max_target_mb. 0 when the policy leaves pruning alone or the state is
+// unknown.
+int ChoosePruneTargetMb(const PrunePolicy &policy, const StorageState &state);
+
+} // namespace digimobile
@@ -0,0 +1,231 @@
+#include "sync_metrics.h"
+
+#include "json_scan.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace digimobile {
+namespace {
+
+// Batch ids are the index into this list.
+enum SyncRequest {
+    kBlockchainInfo = 0,
+    kNetworkInfo,
+    kMempoolInfo,
+    kNetTotals,
+    kSyncRequestCount,
+};
+
+const std::vector<RpcRequest> &SyncRequests() {
+    static const std::vector<RpcRequest> requests = {
+            {"getblockchaininfo", "[]"},
+            {"getnetworkinfo", "[]"},
+            {"getmempoolinfo", "[]"},
+            {"getnettotals", "[]"},
+    };
+    return requests;
+}
+
+// A rate has to move by this fraction before it counts as a change on its own;
+// block and byte rates jitter on every poll.
+constexpr double kRateChangeFraction = 0.1;
+// Verification progress is estimated against the clock and creeps on every
+// poll; steps finer than the app displays are not a change.
+constexpr double kProgressEpsilon = 1e-4;
+
+// The same text digibyte-cli prints, which the app matches for warm-up.
+std::string FormatRpcError(std::string_view error) {
+    int64_t code = 0;
+    std::string message;
+    ForEachJsonMember(error, [&](std::string_view key, std::string_view value) {
+        if (key == "code") {
+            JsonToInt64(value, &code);
+        } else if (key == "message") {
+            JsonToString(value, &message);
+        }
+        return true;
+    });
+    return "error code: " + std::to_string(code) + "\nerror message:\n" + message;
+}
+
+void ReadInt(std::string_view value, int64_t *out) {
+    int64_t parsed = 0;
+    if (JsonToInt64(value, &parsed)) {
+        *out = parsed;
+    }
+}
+
+void ReadBlockchainInfo(std::string_view result, SyncMetrics *out) {
+    ForEachJsonMember(result, [out](std::string_view key, std::string_view value) {
+        if (key == "blocks") {
+            ReadInt(value, &out->blocks);
+        } else if (key == "headers") {
+            ReadInt(value, &out->headers);
+        } else if (key == "verificationprogress") {
+            JsonToDouble(value, &out->verification_progress);
+        } else if (key == "initialblockdownload") {
+            bool ibd = false;
+            if (JsonToBool(value, &ibd)) {
+                out->initial_block_download = ibd ? 1 : 0;
+            }
+        }
+        return true;
+    });
+}
+
+void ReadNetworkInfo(std::string_view result, SyncMetrics *out) {
+    ForEachJsonMember(result, [out](std::string_view key, std::string_view value) {
+        if (key == "connections") {
+            ReadInt(value, &out->peers);
+        } else if (key == "connections_in") {
+            ReadInt(value, &out->peers_inbound);
+        }
+        return true;
+    });
+}
+
+void ReadMempoolInfo(std::string_view result, SyncMetrics *out) {
+    ForEachJsonMember(result, [out](std::string_view key, std::string_view value) {
+        if (key == "size") {
+            ReadInt(value, &out->mempool_tx);
+        } else if (key == "bytes") {
+            ReadInt(value, &out->mempool_bytes);
+        }
+        return true;
+    });
+}
+
+void ReadNetTotals(std::string_view result, SyncMetrics *out) {
+    ForEachJsonMember(result, [out](std::string_view key, std::string_view value) {
+        if (key == "totalbytesrecv") {
+            ReadInt(value, &out->bytes_recv);
+        } else if (key == "totalbytessent") {
+            ReadInt(value, &out->bytes_sent);
+        }
+        return true;
+    });
+}
+
+// Per-second rate of a counter between two polls; -1 if either is unknown or
+// the counter went backwards (the node restarted).
+double Rate(int64_t previous, int64_t current, int64_t elapsed_ms) {
+    if (previous < 0 || current < previous || elapsed_ms <= 0) {
+        return -1;
+    }
+    return static_cast<double>(current - previous) * 1000.0 / static_cast<double>(elapsed_ms);
+}
+
+bool RateMoved(double before, double after) {
+    if ((before < 0) != (after < 0) || (before == 0) != (after == 0)) {
+        return true;
+    }
+    return std::fabs(after - before) >
+           kRateChangeFraction * std::max(std::fabs(before), std::fabs(after));
+}
+
+// Byte totals and the mempool's size in bytes move on every poll; they are
+// carried along with a change but do not make one.
+bool Changed(const SyncMetrics &before, const SyncMetrics &after) {
+    return before.blocks != after.blocks || before.headers != after.headers ||
+           std::fabs(before.verification_progress - after.verification_progress) > kProgressEpsilon ||
+           before.initial_block_download != after.initial_block_download ||
+           before.peers != after.peers || before.peers_inbound != after.peers_inbound ||
+           before.mempool_tx != after.mempool_tx ||
+           RateMoved(before.blocks_per_s, after.blocks_per_s) ||
+           RateMoved(before.recv_bytes_per_s, after.recv_bytes_per_s) ||
+           RateMoved(before.sent_bytes_per_s, after.sent_bytes_per_s);
+}
+
+} // namespace
+
+SyncPollStatus SyncMetricsPoller::Poll(const RpcBatchCall &call, int64_t now_ms,
+                                       std::string *error) {
+    std::string body;
+    if (!call(SyncRequests(), &body)) {
+        *error = "RPC batch failed";
+        return SyncPollStatus::kUnreachable;
+    }
+    return Update(body, now_ms, error);
+}
+
+SyncPollStatus SyncMetricsPoller::Update(std::string_view body, int64_t now_ms,
+                                         std::string *error) {
+    std::string_view results[kSyncRequestCount];
+    std::string_view errors[kSyncRequestCount];
+    const bool batch = ForEachJsonElement(body, [&](std::string_view reply) {
+        std::string_view id;
+        std::string_view result;
+        std::string_view reply_error;
+        ForEachJsonMember(reply, [&](std::string_view key, std::string_view value) {
+            if (key == "id") {
+                id = value;
+            } else if (key == "result") {
+                result = value;
+            } else if (key == "error") {
+                reply_error = value;
+            }
+            return true;
+        });
+        int64_t index = -1;
+        if (JsonToInt64(id, &index) && index >= 0 && index < kSyncRequestCount) {
+            results[index] = result;
+            errors[index] = reply_error;
+        }
+        return true;
+    });
+    if (!batch) {
+        // The server rejects a whole batch with a single error object.
+        std::string_view reply_error;
+        if (FindJsonMember(body, "error", &reply_error) && !JsonIsNull(reply_error)) {
+            *error = FormatRpcError(reply_error);
+            return SyncPollStatus::kRpcError;
+        }
+        *error = "Malformed batch reply";
+        return SyncPollStatus::kUnreachable;
+    }
+    if (!errors[kBlockchainInfo].empty() && !JsonIsNull(errors[kBlockchainInfo])) {
+        *error = FormatRpcError(errors[kBlockchainInfo]);
+        return SyncPollStatus::kRpcError;
+    }
+    if (results[kBlockchainInfo].empty() || JsonIsNull(results[kBlockchainInfo])) {
+        *error = "Missing getblockchaininfo reply";
+        return SyncPollStatus::kUnreachable;
+    }
+
+    SyncMetrics next;
+    ReadBlockchainInfo(results[kBlockchainInfo], &next);
+    // The others are optional; a failed one leaves its fields unknown.
+    ReadNetworkInfo(results[kNetworkInfo], &next);
+    ReadMempoolInfo(results[kMempoolInfo], &next);
+    ReadNetTotals(results[kNetTotals], &next);
+
+    const int64_t elapsed_ms = sample_ms_ >= 0 ? now_ms - sample_ms_ : 0;
+    next.blocks_per_s = Rate(metrics_.blocks, next.blocks, elapsed_ms);
+    next.recv_bytes_per_s = Rate(metrics_.bytes_recv, next.bytes_recv, elapsed_ms);
+    next.sent_bytes_per_s = Rate(metrics_.bytes_sent, next.bytes_sent, elapsed_ms);
+    if (next.blocks_per_s > 0 && next.headers >= next.blocks) {
+        next.eta_s = static_cast<int64_t>(
+                std::ceil(static_cast<double>(next.headers - next.blocks) / next.blocks_per_s));
+    } else if (next.blocks >= 0 && next.headers == next.blocks) {
+        next.eta_s = 0;
+    }
+    metrics_ = next;
+    sample_ms_ = now_ms;
+
+    if (have_reported_ && !Changed(reported_, next)) {
+        return SyncPollStatus::kUnchanged;
+    }
+    reported_ = next;
+    have_reported_ = true;
+    return SyncPollStatus::kChanged;
+}
+
+void SyncMetricsPoller::Reset() {
+    metrics_ = SyncMetrics();
+    reported_ = SyncMetrics();
+    have_reported_ = false;
+    sample_ms_ = -1;
+}
+
+} // namespace digimobile
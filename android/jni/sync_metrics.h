@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "rpc_client.h"
+
+namespace digimobile {
+
+// What the app shows about a syncing node, gathered in one RPC round trip.
+// -1 where the node did not report a value.
+struct SyncMetrics {
+    int64_t blocks = -1;
+    int64_t headers = -1;
+    double verification_progress = -1;
+    int initial_block_download = -1;  // 1 or 0
+    int64_t peers = -1;
+    int64_t peers_inbound = -1;
+    int64_t mempool_tx = -1;
+    int64_t mempool_bytes = -1;
+    int64_t bytes_recv = -1;
+    int64_t bytes_sent = -1;
+    // Derived from the previous poll; -1 until two polls are known.
+    double blocks_per_s = -1;
+    double recv_bytes_per_s = -1;
+    double sent_bytes_per_s = -1;
+    // Time to reach the best header at the current block rate.
+    int64_t eta_s = -1;
+};
+
+enum class SyncPollStatus {
+    kChanged,
+    kUnchanged,
+    // getblockchaininfo failed, e.g. while the node is warming up.
+    kRpcError,
+    // No usable reply.
+    kUnreachable,
+};
+
+// Sends a batch and returns the reply body; false when the node could not be
+// reached.
+using RpcBatchCall = std::function<bool(const std::vector<RpcRequest> &requests, std::string *body)>;
+
+// Polls getblockchaininfo, getnetworkinfo, getmempoolinfo and getnettotals in
+// one batch, reads the fields it needs straight out of the reply text and
+// derives rates from consecutive polls. Reports whether anything the app
+// shows has changed, so an unchanged poll costs the caller nothing further.
+// Not thread-safe.
+class SyncMetricsPoller {
+public:
+    // error receives digibyte-cli style text for kRpcError, a reason for
+    // kUnreachable.
+    SyncPollStatus Poll(const RpcBatchCall &call, int64_t now_ms, std::string *error);
+
+    // Process a batch reply body that was obtained some other way.
+    SyncPollStatus Update(std::string_view body, int64_t now_ms, std::string *error);
+
+    // The latest poll, whether or not it was reported as changed.
+    const SyncMetrics &metrics() const { return metrics_; }
+
+    // Forget the previous poll, e.g. when the node restarts.
+    void Reset();
+
+private:
+    SyncMetrics metrics_;
+    SyncMetrics reported_;
+    bool have_reported_ = false;
+    int64_t sample_ms_ = -1;
+};
+
+} // namespace digimobile
@@ -0,0 +1,79 @@
+#include "asset_stager.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+// What staging did before: read the asset through a user-space buffer,
+// optionally hashing it on the way for the stamp.
+bool BufferedCopy(int src, off_t offset, int64_t length, const std::string &dest, bool hash) {
+    const int out = open(dest.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0700);
+    if (out < 0) {
+        return false;
+    }
+    std::vector<char> buffer(64 * 1024);
+    int64_t done = 0;
+    uint64_t digest = 0;
+    bool ok = true;
+    while (ok && done < length) {
+        const ssize_t n = pread(src, buffer.data(),
+                                static_cast<size_t>(std::min<int64_t>(length - done, buffer.size())),
+                                offset + done);
+        ok = n > 0 && write(out, buffer.data(), static_cast<size_t>(n)) == n;
+        if (ok && hash) {
+            digest = HashBytes64(buffer.data(), static_cast<size_t>(n), digest);
+        }
+        done += n;
+    }
+    ok = ok && fsync(out) == 0;
+    return close(out) == 0 && ok;
+}
+
+} // namespace
+
+// Staging a daemon-sized asset out of an APK-like file: the buffered copy
+// it replaced, the kernel-side copy, and the restarts that only hash or only
+// read the stamp. All copies fsync; a first StageFile also hashes the source
+// for the stamp, so compare it with the hashing buffered copy. Set
+// DIGIMOBILE_BENCH_MB for the size.
+TEST(StageThroughput) {
+    const int64_t size = BenchBytes(64);
+    TempDir dir;
+    REQUIRE(WriteFile(dir.Join("app.apk"), PseudoRandomBytes(static_cast<size_t>(size) + 4096, 1)));
+    const int fd = open(dir.Join("app.apk").c_str(), O_RDONLY | O_CLOEXEC);
+    REQUIRE(fd >= 0);
+    StageSource source;
+    source.fd = fd;
+    source.offset = 4096;
+    source.length = size;
+
+    int64_t started = NowMicros();
+    REQUIRE(BufferedCopy(fd, source.offset, size, dir.Join("buffered"), false));
+    ReportThroughput("buffered copy", size, NowMicros() - started);
+
+    started = NowMicros();
+    REQUIRE(BufferedCopy(fd, source.offset, size, dir.Join("buffered-hashed"), true));
+    ReportThroughput("buffered copy + hash", size, NowMicros() - started);
+
+    std::string error;
+    started = NowMicros();
+    REQUIRE(StageFile(source, dir.Join("digibyted"), "1", &error) == StageResult::kCopied);
+    ReportThroughput("StageFile, copied", size, NowMicros() - started);
+
+    started = NowMicros();
+    REQUIRE(StageFile(source, dir.Join("digibyted"), "2", &error) == StageResult::kStampRefreshed);
+    ReportThroughput("StageFile, new version (hash only)", size, NowMicros() - started);
+
+    started = NowMicros();
+    REQUIRE(StageFile(source, dir.Join("digibyted"), "2", &error) == StageResult::kUpToDate);
+    ReportThroughput("StageFile, up to date", size, NowMicros() - started);
+    close(fd);
+}
@@ -0,0 +1,141 @@
+#include "asset_stager.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+StageSource MemorySource(const std::string &data) {
+    StageSource source;
+    source.data = data.data();
+    source.length = static_cast<int64_t>(data.size());
+    return source;
+}
+
+bool IsExecutable(const std::string &path) {
+    struct stat info {};
+    return stat(path.c_str(), &info) == 0 && (info.st_mode & 0700) == 0700;
+}
+
+} // namespace
+
+TEST(StampDecidesWhatIsRewritten) {
+    TempDir dir;
+    const std::string dest = dir.Join("digibyted");
+    const std::string v1 = PseudoRandomBytes(300000, 1);
+    std::string error;
+
+    CHECK_EQ(StageFile(MemorySource(v1), dest, "1", &error), StageResult::kCopied);
+    CHECK_EQ(ReadFile(dest), v1);
+    CHECK(IsExecutable(dest));
+    StageStamp stamp;
+    REQUIRE(ReadStageStamp(dest + ".stamp", &stamp));
+    CHECK_EQ(stamp.version, std::string("1"));
+    CHECK_EQ(stamp.size, static_cast<int64_t>(v1.size()));
+    CHECK_EQ(stamp.hash, HashBytes64(v1.data(), v1.size()));
+    CHECK(!PathExists(dest + ".tmp"));
+
+    CHECK_EQ(StageFile(MemorySource(v1), dest, "1", &error), StageResult::kUpToDate);
+    // An app update that ships the same binary only touches the stamp.
+    CHECK_EQ(StageFile(MemorySource(v1), dest, "2", &error), StageResult::kStampRefreshed);
+    REQUIRE(ReadStageStamp(dest + ".stamp", &stamp));
+    CHECK_EQ(stamp.version, std::string("2"));
+
+    // Same size, different content: always rewritten.
+    std::string v3 = v1;
+    v3[1234] ^= 0x40;
+    CHECK_EQ(StageFile(MemorySource(v3), dest, "3", &error), StageResult::kCopied);
+    CHECK_EQ(ReadFile(dest), v3);
+
+    // Without a version every call hashes, and still skips identical content.
+    CHECK_EQ(StageFile(MemorySource(v3), dest, "", &error), StageResult::kStampRefreshed);
+}
+
+TEST(DamagedDestinationIsRestaged) {
+    TempDir dir;
+    const std::string dest = dir.Join("digibyted");
+    const std::string data = PseudoRandomBytes(100000, 2);
+    std::string error;
+    REQUIRE(StageFile(MemorySource(data), dest, "1", &error) == StageResult::kCopied);
+
+    // Truncated by a crash outside StageFile, same version stamp.
+    REQUIRE(truncate(dest.c_str(), 5000) == 0);
+    CHECK_EQ(StageFile(MemorySource(data), dest, "1", &error), StageResult::kCopied);
+    CHECK_EQ(ReadFile(dest), data);
+
+    // Lost its exec bit.
+    REQUIRE(chmod(dest.c_str(), 0600) == 0);
+    CHECK_EQ(StageFile(MemorySource(data), dest, "1", &error), StageResult::kCopied);
+    CHECK(IsExecutable(dest));
+
+    // Stamp deleted.
+    REQUIRE(unlink((dest + ".stamp").c_str()) == 0);
+    CHECK_EQ(StageFile(MemorySource(data), dest, "1", &error), StageResult::kCopied);
+}
+
+// A stored asset inside an APK is a range of a larger file.
+TEST(CopiesAFileRange) {
+    TempDir dir;
+    const std::string apk = PseudoRandomBytes(3 << 20, 3);
+    REQUIRE(WriteFile(dir.Join("app.apk"), apk));
+    const int fd = open(dir.Join("app.apk").c_str(), O_RDONLY | O_CLOEXEC);
+    REQUIRE(fd >= 0);
+    for (off_t offset : {off_t(0), off_t(4096), off_t(12345)}) {
+        StageSource source;
+        source.fd = fd;
+        source.offset = offset;
+        source.length = (2 << 20) + 17;
+        const std::string dest = dir.Join("bin" + std::to_string(offset));
+        std::string error;
+        CHECK_EQ(StageFile(source, dest, "1", &error), StageResult::kCopied);
+        const std::string expected = apk.substr(static_cast<size_t>(offset),
+                                                static_cast<size_t>(source.length));
+        CHECK_EQ(ReadFile(dest), expected);
+        StageStamp stamp;
+        REQUIRE(ReadStageStamp(dest + ".stamp", &stamp));
+        CHECK_EQ(stamp.hash, HashBytes64(expected.data(), expected.size()));
+        CHECK_EQ(StageFile(source, dest, "2", &error), StageResult::kStampRefreshed);
+    }
+
+    // A range past the end of the source fails and leaves nothing behind.
+    StageSource source;
+    source.fd = fd;
+    source.offset = static_cast<off_t>(apk.size() - 100);
+    source.length = 1000;
+    std::string error;
+    CHECK_EQ(StageFile(source, dir.Join("short"), "1", &error), StageResult::kFailed);
+    CHECK(!PathExists(dir.Join("short")));
+    CHECK(!PathExists(dir.Join("short.tmp")));
+    close(fd);
+}
+
+TEST(EmptyAndInvalidSources) {
+    TempDir dir;
+    std::string error;
+    CHECK_EQ(StageFile(MemorySource(std::string()), dir.Join("empty"), "1", &error),
+             StageResult::kCopied);
+    CHECK_EQ(ReadFile(dir.Join("empty")), std::string());
+    CHECK_EQ(StageFile(StageSource(), dir.Join("none"), "1", &error), StageResult::kFailed);
+    CHECK_EQ(error, std::string("invalid source"));
+}
+
+TEST(HashBytes64) {
+    const std::string data = PseudoRandomBytes(1000, 4);
+    // Every length exercises a different mix of stripes, words and bytes.
+    for (size_t length = 0; length < 80; ++length) {
+        CHECK(HashBytes64(data.data(), length) != HashBytes64(data.data(), length + 1));
+        CHECK(HashBytes64(data.data(), length, 0) != HashBytes64(data.data(), length, 1));
+    }
+    std::string flipped = data;
+    for (size_t i = 0; i < data.size(); i += 37) {
+        flipped[i] ^= 1;
+        CHECK(HashBytes64(flipped.data(), flipped.size()) != HashBytes64(data.data(), data.size()));
+        flipped[i] ^= 1;
+    }
+}
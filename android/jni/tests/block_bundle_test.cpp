@@ -0,0 +1,294 @@
+#include "block_bundle.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "sha256.h"
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+const unsigned char kMagic[4] = {0xfa, 0xbf, 0xb5, 0xda};
+
+void PutU32(std::string *out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out->push_back(static_cast<char>(v >> (8 * i)));
+    }
+}
+
+std::vector<unsigned char> FromHex(const std::string &hex) {
+    std::vector<unsigned char> out;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        out.push_back(static_cast<unsigned char>(strtoul(hex.substr(i, 2).c_str(), nullptr, 16)));
+    }
+    return out;
+}
+
+// A synthetic chain of count blocks after prev_hex: linked headers and
+// random "transactions", in the two bundle files.
+struct Bundle {
+    TempDir dir;
+    std::string blocks_path = dir.Join("bundle.dgbblocks");
+    std::string headers_path = dir.Join("bundle.dgbblocks.headers");
+    std::string blocks;
+    std::string headers;
+    std::vector<size_t> block_offsets;
+    std::string prev_hex = std::string(62, '0') + "2a";
+    uint32_t start_height = 1000;
+
+    void Build(uint32_t count, size_t payload = 3000) {
+        BundleHeadersInfo info;
+        memcpy(info.network_magic, kMagic, sizeof(kMagic));
+        info.start_height = start_height;
+        info.count = count;
+        BlockHashFromHex(prev_hex, info.prev_hash);
+        headers = SerializeHeadersPreamble(info);
+        unsigned char prev[32];
+        memcpy(prev, info.prev_hash, sizeof(prev));
+        for (uint32_t i = 0; i < count; ++i) {
+            std::string header;
+            PutU32(&header, 0x20000002);
+            header.append(reinterpret_cast<const char *>(prev), sizeof(prev));
+            header += PseudoRandomBytes(32, i);  // merkle root
+            PutU32(&header, 1700000000 + 15 * i);
+            PutU32(&header, 0x1d00ffff);
+            PutU32(&header, i * 7919);
+            headers += header;
+            BlockHeaderHash(reinterpret_cast<const unsigned char *>(header.data()), prev);
+
+            const std::string body = header + PseudoRandomBytes(payload + i % 500, 10000 + i);
+            block_offsets.push_back(blocks.size());
+            blocks.append(reinterpret_cast<const char *>(kMagic), sizeof(kMagic));
+            PutU32(&blocks, static_cast<uint32_t>(body.size()));
+            blocks += body;
+        }
+        Write();
+    }
+    void Write() {
+        REQUIRE(WriteFile(blocks_path, blocks));
+        REQUIRE(WriteFile(headers_path, headers));
+    }
+    std::string HeadersSha256() const {
+        Sha256 hasher;
+        hasher.Update(headers.data(), headers.size());
+        return hasher.FinishHex();
+    }
+};
+
+// Stands in for digibyted's -loadblock: opens the pipe (possibly late) and
+// reads it to the end.
+class PipeReader {
+public:
+    PipeReader(const std::string &path, int open_delay_ms) {
+        thread_ = std::thread([this, path, open_delay_ms] {
+            usleep(open_delay_ms * 1000);
+            const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+            char buffer[16 * 1024];
+            ssize_t n;
+            while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+                data_.append(buffer, static_cast<size_t>(n));
+            }
+            close(fd);
+        });
+    }
+    const std::string &Join() {
+        thread_.join();
+        return data_;
+    }
+
+private:
+    std::thread thread_;
+    std::string data_;
+};
+
+} // namespace
+
+TEST(BlockHeaderHash) {
+    // Bitcoin's genesis header: the double SHA-256 every chain uses.
+    const std::vector<unsigned char> header = FromHex(
+            "0100000000000000000000000000000000000000000000000000000000000000000000003ba3edfd7a7b"
+            "12b27ac72c3e67768f617fc81bc3888a51323a9fb8aa4b1e5e4a29ab5f49ffff001d1dac2b7c");
+    REQUIRE(header.size() == kBlockHeaderSize);
+    unsigned char hash[32];
+    BlockHeaderHash(header.data(), hash);
+    const std::string hex = BlockHashToHex(hash);
+    CHECK_EQ(hex, std::string("000000000019d6689c085ae165831e934ff763ae46a2a6c172b3f1b60a8ce26f"));
+    unsigned char parsed[32];
+    REQUIRE(BlockHashFromHex(hex, parsed));
+    CHECK(memcmp(parsed, hash, 32) == 0);
+    CHECK(!BlockHashFromHex(hex.substr(1), parsed));
+    CHECK(!BlockHashFromHex(std::string(63, '0') + "g", parsed));
+}
+
+TEST(VerifyChecksTheHeaderChain) {
+    Bundle bundle;
+    bundle.Build(300);
+    std::string error;
+    {
+        BlockBundleFeeder feeder(bundle.blocks_path, bundle.headers_path);
+        REQUIRE(feeder.Verify(bundle.HeadersSha256(), bundle.prev_hex, &error));
+        CHECK_EQ(feeder.info().start_height, static_cast<uint32_t>(1000));
+        CHECK_EQ(feeder.info().count, static_cast<uint32_t>(300));
+        CHECK_EQ(feeder.total_bytes(), static_cast<uint64_t>(bundle.blocks.size()));
+    }
+    {
+        BlockBundleFeeder feeder(bundle.blocks_path, bundle.headers_path);
+        CHECK(!feeder.Verify(std::string(64, '0'), "", &error));
+        CHECK(error.find("does not match") != std::string::npos);
+        CHECK(!feeder.Verify("", std::string(64, '1'), &error));
+        CHECK(error.rfind("bundle extends " + bundle.prev_hex, 0) == 0);
+        CHECK(!feeder.Verify("", "not hex", &error));
+        CHECK_EQ(error, std::string("bad expected previous block hash"));
+    }
+    // One header no longer links to its parent.
+    std::string headers = bundle.headers;
+    headers[kHeadersPreambleSize + 120 * kBlockHeaderSize + 10] ^= 1;
+    REQUIRE(WriteFile(bundle.headers_path, headers));
+    {
+        BlockBundleFeeder feeder(bundle.blocks_path, bundle.headers_path);
+        CHECK(!feeder.Verify("", "", &error));
+        CHECK_EQ(error, std::string("header at height 1120 does not link to the one before it"));
+    }
+    // A count that does not match the file.
+    REQUIRE(WriteFile(bundle.headers_path, bundle.headers.substr(0, bundle.headers.size() - 80)));
+    {
+        BlockBundleFeeder feeder(bundle.blocks_path, bundle.headers_path);
+        CHECK(!feeder.Verify("", "", &error));
+        CHECK_EQ(error, std::string("headers file size does not match its count of 300"));
+    }
+    REQUIRE(WriteFile(bundle.headers_path, "DGBHDRS0" + bundle.headers.substr(8)));
+    {
+        BlockBundleFeeder feeder(bundle.blocks_path, bundle.headers_path);
+        CHECK(!feeder.Verify("", "", &error));
+        CHECK_EQ(error, std::string("not a bundle headers file"));
+    }
+    // Headers fine, blocks file cut short.
+    bundle.Write();
+    REQUIRE(WriteFile(bundle.blocks_path, bundle.blocks.substr(0, 1000)));
+    {
+        BlockBundleFeeder feeder(bundle.blocks_path, bundle.headers_path);
+        CHECK(!feeder.Verify("", "", &error));
+        CHECK_EQ(error, std::string("blocks file is too small for 300 blocks"));
+    }
+}
+
+// The whole bundle reaches a reader that opens the pipe only after the
+// feeder has filled it, and nothing is lost when the feeder closes its end.
+TEST(FeedsThroughTheFifo) {
+    Bundle bundle;
+    bundle.Build(400);
+    const std::string pipe = bundle.dir.Join("bundle.fifo");
+    BlockBundleFeeder feeder(bundle.blocks_path, bundle.headers_path);
+    std::string error;
+    REQUIRE(feeder.Verify("", "", &error));
+    REQUIRE(feeder.OpenPipe(pipe, &error));
+    struct stat info {};
+    REQUIRE(stat(pipe.c_str(), &info) == 0);
+    CHECK(S_ISFIFO(info.st_mode));
+
+    PipeReader reader(pipe, 300);
+    REQUIRE(feeder.Feed(&error));
+    const std::string &received = reader.Join();
+    CHECK(received == bundle.blocks);
+    CHECK_EQ(received.size(), bundle.blocks.size());
+    CHECK_EQ(feeder.fed_blocks(), static_cast<uint64_t>(400));
+    CHECK_EQ(feeder.fed_bytes(), static_cast<uint64_t>(bundle.blocks.size()));
+    CHECK(!PathExists(pipe));
+}
+
+// Feeding stops before the first block that differs from its header; the
+// reader still sees a clean end of file after the good blocks.
+TEST(StopsAtABlockThatDoesNotMatchItsHeader) {
+    Bundle bundle;
+    bundle.Build(50);
+    bundle.blocks[bundle.block_offsets[30] + 8 + 40] ^= 1;  // inside the merkle root
+    bundle.Write();
+    const std::string pipe = bundle.dir.Join("bundle.fifo");
+    BlockBundleFeeder feeder(bundle.blocks_path, bundle.headers_path);
+    std::string error;
+    REQUIRE(feeder.Verify("", "", &error));
+    REQUIRE(feeder.OpenPipe(pipe, &error));
+    PipeReader reader(pipe, 0);
+    CHECK(!feeder.Feed(&error));
+    CHECK_EQ(error, std::string("block 1030 does not match its header"));
+    CHECK_EQ(feeder.fed_blocks(), static_cast<uint64_t>(30));
+    // Blocks before the bad one may or may not have been read when the pipe
+    // closed; whatever arrived is a prefix of them.
+    const std::string &received = reader.Join();
+    CHECK(received.size() <= bundle.block_offsets[30]);
+    CHECK(bundle.blocks.compare(0, received.size(), received) == 0);
+    CHECK(!PathExists(pipe));
+}
+
+// With no reader the pipe fills up; Interrupt() still ends the feed.
+TEST(InterruptWithoutAReader) {
+    Bundle bundle;
+    bundle.Build(200);
+    const std::string pipe = bundle.dir.Join("bundle.fifo");
+    BlockBundleFeeder feeder(bundle.blocks_path, bundle.headers_path);
+    std::string error;
+    CHECK(!feeder.Feed(&error));
+    CHECK_EQ(error, std::string("bundle has not been verified"));
+    REQUIRE(feeder.Verify("", "", &error));
+    CHECK(!feeder.Feed(&error));
+    CHECK_EQ(error, std::string("pipe is not open"));
+    REQUIRE(feeder.OpenPipe(pipe, &error));
+
+    std::thread interrupter([&feeder] {
+        usleep(300 * 1000);
+        feeder.Interrupt();
+    });
+    const int64_t started = NowMicros();
+    CHECK(!feeder.Feed(&error));
+    interrupter.join();
+    CHECK_EQ(error, std::string("interrupted"));
+    CHECK(NowMicros() - started < 3000 * 1000);
+    CHECK(feeder.fed_blocks() < 200);
+    CHECK(!PathExists(pipe));
+}
+
+// A pipe left by a killed feed is replaced.
+TEST(OpenPipeReplacesAStalePipe) {
+    Bundle bundle;
+    bundle.Build(5);
+    const std::string pipe = bundle.dir.Join("bundle.fifo");
+    REQUIRE(WriteFile(pipe, "stale"));
+    BlockBundleFeeder feeder(bundle.blocks_path, bundle.headers_path);
+    std::string error;
+    REQUIRE(feeder.Verify("", "", &error));
+    REQUIRE(feeder.OpenPipe(pipe, &error));
+    struct stat info {};
+    REQUIRE(stat(pipe.c_str(), &info) == 0);
+    CHECK(S_ISFIFO(info.st_mode));
+    PipeReader reader(pipe, 0);
+    REQUIRE(feeder.Feed(&error));
+    CHECK(reader.Join() == bundle.blocks);
+}
+
+TEST(StopsAtABadRecord) {
+    Bundle bundle;
+    bundle.Build(20);
+    bundle.blocks[bundle.block_offsets[12]] ^= 0xff;  // record magic
+    bundle.Write();
+    const std::string pipe = bundle.dir.Join("bundle.fifo");
+    BlockBundleFeeder feeder(bundle.blocks_path, bundle.headers_path);
+    std::string error;
+    REQUIRE(feeder.Verify("", "", &error));
+    REQUIRE(feeder.OpenPipe(pipe, &error));
+    PipeReader reader(pipe, 0);
+    CHECK(!feeder.Feed(&error));
+    CHECK_EQ(error, std::string("bad record for block 1012"));
+    CHECK_EQ(feeder.fed_blocks(), static_cast<uint64_t>(12));
+    reader.Join();
+}
@@ -0,0 +1,35 @@
+#include "container_packer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+
+namespace digimobile {
+namespace test {
+
+std::string PackContainer(const std::string &datadir, const std::string &output,
+                          const std::string &options, const std::string &subdirs) {
+    const char *tool = getenv("MAKE_SNAPSHOT_CONTAINER");
+    if (tool == nullptr || *tool == '\0') {
+        return std::string();
+    }
+    const std::string command = std::string("'") + tool + "' " + options + " '" + datadir +
+                                "' '" + output + "' " + subdirs;
+    FILE *pipe = popen(command.c_str(), "r");
+    if (pipe == nullptr) {
+        return std::string();
+    }
+    std::string digest;
+    char line[256];
+    while (fgets(line, sizeof(line), pipe) != nullptr) {
+        if (strncmp(line, "index_sha256=", 13) == 0) {
+            digest.assign(line + 13, strcspn(line + 13, "\r\n"));
+        }
+    }
+    const int status = pclose(pipe);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? digest : std::string();
+}
+
+} // namespace test
+} // namespace digimobile
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+namespace digimobile {
+namespace test {
+
+// Run the make_snapshot_container tool ($MAKE_SNAPSHOT_CONTAINER, set by
+// ctest) over subdirectories of datadir. Returns the index SHA-256 it
+// printed, or "" if the tool is unavailable or failed.
+std::string PackContainer(const std::string &datadir, const std::string &output,
+                          const std::string &options = std::string(),
+                          const std::string &subdirs = "chainstate blocks");
+
+} // namespace test
+} // namespace digimobile
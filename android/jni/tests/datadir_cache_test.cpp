@@ -0,0 +1,94 @@
+#include "datadir_cache.h"
+
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+constexpr int64_t kMiB = 1 << 20;
+
+// A LevelDB file of size bytes, last written age_s seconds ago.
+void AddFile(const std::string &path, int64_t size, int age_s) {
+    REQUIRE(WriteFile(path, std::string(static_cast<size_t>(size), 'd')));
+    timeval times[2] {};
+    gettimeofday(&times[0], nullptr);
+    times[0].tv_sec -= age_s;
+    times[1] = times[0];
+    CHECK_EQ(utimes(path.c_str(), times), 0);
+}
+
+void MakeDbDirs(const std::string &root) {
+    REQUIRE(mkdir(root.c_str(), 0700) == 0 || PathExists(root));
+    REQUIRE(mkdir((root + "/chainstate").c_str(), 0700) == 0);
+    REQUIRE(mkdir((root + "/blocks").c_str(), 0700) == 0);
+    REQUIRE(mkdir((root + "/blocks/index").c_str(), 0700) == 0);
+}
+
+} // namespace
+
+TEST(WarmsTheDatabasesOfEveryNetwork) {
+    TempDir dir;
+    MakeDbDirs(dir.path());
+    MakeDbDirs(dir.Join("regtest"));
+    AddFile(dir.Join("chainstate/000010.ldb"), 3000, 10);
+    AddFile(dir.Join("chainstate/MANIFEST-000002"), 100, 10);
+    AddFile(dir.Join("blocks/index/000005.ldb"), 2000, 10);
+    AddFile(dir.Join("regtest/chainstate/000003.log"), 500, 10);
+    AddFile(dir.Join("regtest/blocks/index/000004.ldb"), 400, 10);
+    // Not read: the lock, empty files, anything outside the databases.
+    AddFile(dir.Join("chainstate/LOCK"), 10, 10);
+    REQUIRE(WriteFile(dir.Join("chainstate/000011.log"), ""));
+    AddFile(dir.Join("blocks/blk00000.dat"), 5000, 10);
+    AddFile(dir.Join("debug.log"), 5000, 10);
+
+    const PrewarmStats stats = PrewarmDatadir(dir.path(), PrewarmOptions());
+    CHECK_EQ(stats.files, 5);
+    CHECK_EQ(stats.bytes, static_cast<int64_t>(3000 + 100 + 2000 + 500 + 400));
+    CHECK(stats.elapsed_ms >= 0);
+
+    const PrewarmStats none = PrewarmDatadir(dir.Join("missing"), PrewarmOptions());
+    CHECK_EQ(none.files, 0);
+    CHECK_EQ(none.bytes, static_cast<int64_t>(0));
+}
+
+// Newest files first, up to budget_bytes.
+TEST(RespectsTheBudget) {
+    TempDir dir;
+    MakeDbDirs(dir.path());
+    for (int i = 0; i < 6; ++i) {
+        AddFile(dir.Join("chainstate/00000" + std::to_string(i) + ".ldb"), kMiB, 100 - i * 10);
+    }
+    for (int threads : {1, 4}) {
+        PrewarmOptions options;
+        options.threads = threads;
+        options.budget_bytes = 3 * kMiB + kMiB / 2;
+        const PrewarmStats stats = PrewarmDatadir(dir.path(), options);
+        CHECK_EQ(stats.files, 3);
+        CHECK_EQ(stats.bytes, 3 * kMiB);
+    }
+    PrewarmOptions none;
+    none.budget_bytes = kMiB - 1;
+    CHECK_EQ(PrewarmDatadir(dir.path(), none).files, 0);
+}
+
+// One large table among the newest files does not use up the budget for the
+// smaller, older ones after it.
+TEST(SkipsAFileThatDoesNotFit) {
+    TempDir dir;
+    MakeDbDirs(dir.path());
+    AddFile(dir.Join("chainstate/000100.log"), kMiB, 10);
+    AddFile(dir.Join("chainstate/000090.ldb"), 8 * kMiB, 20);
+    AddFile(dir.Join("chainstate/000080.ldb"), kMiB, 30);
+    AddFile(dir.Join("blocks/index/000070.ldb"), kMiB, 40);
+    AddFile(dir.Join("chainstate/000060.ldb"), 2 * kMiB, 50);
+    PrewarmOptions options;
+    options.budget_bytes = 4 * kMiB;
+    const PrewarmStats stats = PrewarmDatadir(dir.path(), options);
+    CHECK_EQ(stats.files, 3);
+    CHECK_EQ(stats.bytes, 3 * kMiB);
+}
@@ -0,0 +1,103 @@
+#include "debug_log_tailer.h"
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+// A sync-heavy debug.log: mostly UpdateTip, some peer and noise lines.
+std::string LogLines(int64_t bytes, int64_t *last_height) {
+    std::string text;
+    int64_t height = 0;
+    while (static_cast<int64_t>(text.size()) < bytes) {
+        ++height;
+        text += "2024-05-01T12:34:56Z UpdateTip: new best=00000000000000000001a2b3c4d5e6f7 "
+                "height=" + std::to_string(height) +
+                " version=0x20000202 log2_work=75.1 tx=5123456 date='2024-04-30T08:00:00Z' "
+                "progress=0.987654 cache=12.3MiB(45678txo)\n";
+        if (height % 10 == 0) {
+            text += "2024-05-01T12:34:56Z New outbound peer connected: version: 70019, blocks=100, "
+                    "peer=" + std::to_string(height) + " (outbound-full-relay)\n";
+        }
+        if (height % 3 == 0) {
+            text += "2024-05-01T12:34:56Z Pre-allocating up to position 0x1000000 in blk00012.dat\n";
+        }
+    }
+    *last_height = height;
+    return text;
+}
+
+// What the console did before the LineRing: read the file and keep the
+// last count lines.
+std::vector<std::string> ReadTail(const std::string &path, size_t count) {
+    const std::string data = ReadFile(path);
+    std::vector<std::string> lines;
+    size_t start = 0;
+    for (size_t eol = data.find('\n'); eol != std::string::npos; eol = data.find('\n', start)) {
+        lines.emplace_back(data, start, eol - start);
+        start = eol + 1;
+    }
+    if (lines.size() > count) {
+        lines.erase(lines.begin(), lines.end() - static_cast<ptrdiff_t>(count));
+    }
+    return lines;
+}
+
+} // namespace
+
+// How fast appended log text is parsed into events (from the write until the
+// last tip is delivered), and what a 256-line console refresh costs from the
+// ring versus re-reading the file. Set DIGIMOBILE_BENCH_MB for the size.
+TEST(TailerThroughput) {
+    TempDir dir;
+    const std::string log = dir.Join("debug.log");
+    int64_t last_height = 0;
+    const std::string text = LogLines(BenchBytes(32), &last_height);
+
+    DebugLogTailer tailer;
+    std::string error;
+    REQUIRE(tailer.Start(log, &error));
+    FILE *file = fopen(log.c_str(), "ab");
+    REQUIRE(file != nullptr);
+    const int64_t started = NowMicros();
+    for (size_t offset = 0; offset < text.size(); offset += 4096) {
+        fwrite(text.data() + offset, 1, std::min<size_t>(4096, text.size() - offset), file);
+        fflush(file);
+    }
+    fclose(file);
+    TipEvent events[256];
+    int64_t height = 0;
+    while (height != last_height && NowMicros() - started < 60 * 1000000LL) {
+        const size_t n = tailer.PollTipEvents(events, 256, 100);
+        if (n > 0) {
+            height = events[n - 1].height;
+        }
+    }
+    REQUIRE(height == last_height);
+    ReportThroughput("append 4 KiB writes, parse", static_cast<int64_t>(text.size()),
+                     NowMicros() - started);
+
+    const int refreshes = 100;
+    int64_t begin = NowMicros();
+    size_t lines = 0;
+    for (int i = 0; i < refreshes; ++i) {
+        lines += tailer.RecentLines(256).size();
+    }
+    const int64_t ring_micros = NowMicros() - begin;
+    begin = NowMicros();
+    for (int i = 0; i < refreshes; ++i) {
+        lines += ReadTail(log, 256).size();
+    }
+    const int64_t file_micros = NowMicros() - begin;
+    CHECK_EQ(lines, static_cast<size_t>(2 * refreshes * 256));
+    fprintf(stderr, "  %-40s %8.1f us per refresh\n", "console tail from LineRing",
+            static_cast<double>(ring_micros) / refreshes);
+    fprintf(stderr, "  %-40s %8.1f us per refresh\n", "console tail re-reading the file",
+            static_cast<double>(file_micros) / refreshes);
+}
@@ -0,0 +1,208 @@
+#include "debug_log_tailer.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+std::string TipLine(int64_t height) {
+    return "2024-05-01T12:34:56Z UpdateTip: new best=00000000000000000001a2b3c4d5e6f7 height=" +
+           std::to_string(height) +
+           " version=0x20000202 log2_work=75.1 tx=5123456 date='2024-04-30T08:00:00Z' "
+           "progress=0.987654 cache=12.3MiB(45678txo)\n";
+}
+
+bool Append(const std::string &path, const std::string &text) {
+    FILE *file = fopen(path.c_str(), "ab");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+    return fclose(file) == 0 && ok;
+}
+
+// Poll until an event for height arrives; returns the heights seen.
+std::vector<int64_t> WaitForHeight(DebugLogTailer *tailer, int64_t height, int timeout_ms = 5000) {
+    std::vector<int64_t> seen;
+    TipEvent events[64];
+    const int64_t deadline = NowMicros() + timeout_ms * 1000LL;
+    while (NowMicros() < deadline) {
+        const size_t n = tailer->PollTipEvents(events, 64, 100);
+        for (size_t i = 0; i < n; ++i) {
+            seen.push_back(events[i].height);
+        }
+        if (!seen.empty() && seen.back() == height) {
+            break;
+        }
+    }
+    return seen;
+}
+
+} // namespace
+
+TEST(ParseUpdateTipLine) {
+    TipEvent event;
+    REQUIRE(ParseUpdateTipLine(TipLine(1234567), &event));
+    CHECK_EQ(event.height, static_cast<int64_t>(1234567));
+    CHECK(event.progress > 0.9876 && event.progress < 0.9877);
+    CHECK_EQ(event.block_time, static_cast<int64_t>(1714464000));
+    CHECK(event.observed_ms > 0);
+
+    CHECK(!ParseUpdateTipLine("2024-05-01T12:34:56Z Loaded best chain: hashBestChain=00ab height=7", &event));
+    CHECK(!ParseUpdateTipLine("UpdateTip: new best=00ab version=0x2", &event));
+}
+
+TEST(ParseLogRecordLine) {
+    LogRecord record;
+    REQUIRE(ParseLogRecordLine("2024-05-01T12:34:56Z New outbound peer connected: version: 70019, "
+                               "blocks=100, peer=12 (outbound-full-relay)", &record));
+    CHECK_EQ(record.kind, LogRecordKind::kPeerConnected);
+    CHECK_EQ(record.peer_id, static_cast<int64_t>(12));
+    CHECK(record.message.rfind("New outbound peer connected:", 0) == 0);
+
+    REQUIRE(ParseLogRecordLine("2024-05-01T12:34:56.123456Z Peer=7 is stalling block download, "
+                               "disconnecting", &record));
+    CHECK_EQ(record.kind, LogRecordKind::kPeerDisconnected);
+    CHECK_EQ(record.peer_id, static_cast<int64_t>(7));
+    CHECK(record.message.rfind("Peer=7", 0) == 0);
+
+    REQUIRE(ParseLogRecordLine("2024-05-01T12:34:56Z ERROR: ReadBlockFromDisk: Deserialize failed", &record));
+    CHECK_EQ(record.kind, LogRecordKind::kError);
+    CHECK_EQ(record.peer_id, static_cast<int64_t>(-1));
+
+    REQUIRE(ParseLogRecordLine("2024-05-01T12:34:56Z Warning: Disk space is low!", &record));
+    CHECK_EQ(record.kind, LogRecordKind::kWarning);
+
+    CHECK(!ParseLogRecordLine("2024-05-01T12:34:56Z Pre-allocating up to position 0x1000000 in "
+                              "blk00012.dat", &record));
+
+    REQUIRE(ParseLogRecordLine("ERROR: " + std::string(4000, 'x'), &record));
+    CHECK_EQ(record.message.size(), static_cast<size_t>(512));
+}
+
+TEST(EventRingDropsOldest) {
+    EventRing<int> ring(4);
+    for (int i = 0; i < 10; ++i) {
+        ring.Push(i);
+    }
+    int out[8];
+    REQUIRE(ring.PopMany(out, 8, 0) == 4);
+    CHECK_EQ(out[0], 6);
+    CHECK_EQ(out[3], 9);
+    CHECK_EQ(ring.PopMany(out, 8, 0), static_cast<size_t>(0));
+
+    // A waiting consumer is released by Wake without an entry.
+    std::thread waker([&] {
+        usleep(50 * 1000);
+        ring.Wake();
+    });
+    const int64_t started = NowMicros();
+    CHECK_EQ(ring.PopMany(out, 8, 5000), static_cast<size_t>(0));
+    CHECK(NowMicros() - started < 2000 * 1000);
+    waker.join();
+}
+
+TEST(LineRingKeepsTheNewest) {
+    LineRing ring(3);
+    CHECK(ring.Tail(10).empty());
+    for (const char *line : {"a", "b", "c", "d", "e"}) {
+        ring.Push(line);
+    }
+    CHECK_EQ(ring.Tail(10), (std::vector<std::string>{"c", "d", "e"}));
+    CHECK_EQ(ring.Tail(2), (std::vector<std::string>{"d", "e"}));
+    ring.Clear();
+    CHECK(ring.Tail(10).empty());
+}
+
+// The file appears after Start, lines arrive in pieces, and the log is
+// later truncated and then replaced.
+TEST(FollowsCreationTruncationAndRotation) {
+    TempDir dir;
+    const std::string log = dir.Join("debug.log");
+    DebugLogTailer tailer(64, 8);
+    std::string error;
+    REQUIRE(tailer.Start(log, &error));
+
+    const std::string first = TipLine(100);
+    REQUIRE(Append(log, first.substr(0, 40)));
+    usleep(100 * 1000);
+    REQUIRE(Append(log, first.substr(40) + "2024-05-01T12:34:57Z ERROR: something\n"));
+    REQUIRE(Append(log, TipLine(101)));
+    CHECK_EQ(WaitForHeight(&tailer, 101), (std::vector<int64_t>{100, 101}));
+    LogRecord records[4];
+    CHECK_EQ(tailer.PollLogRecords(records, 4, 1000), static_cast<size_t>(1));
+    CHECK_EQ(records[0].kind, LogRecordKind::kError);
+
+    // shrinkdebugfile rewrites the file in place, shorter.
+    REQUIRE(WriteFile(log, TipLine(7)));
+    CHECK_EQ(WaitForHeight(&tailer, 7), (std::vector<int64_t>{7}));
+
+    // Replaced by a new file.
+    REQUIRE(WriteFile(dir.Join("debug.log.new"), TipLine(200) + TipLine(201)));
+    REQUIRE(rename(dir.Join("debug.log.new").c_str(), log.c_str()) == 0);
+    CHECK_EQ(WaitForHeight(&tailer, 201), (std::vector<int64_t>{200, 201}));
+
+    const std::vector<std::string> recent = tailer.RecentLines(8);
+    REQUIRE(!recent.empty());
+    CHECK_EQ(recent.back() + "\n", TipLine(201));
+    tailer.Stop();
+    CHECK(!tailer.running());
+}
+
+// Only the last 64 KiB of an existing log is read, skipping the partial line
+// at the cut; overlong lines are dropped rather than buffered.
+TEST(StartsNearTheEndOfALargeLog) {
+    TempDir dir;
+    const std::string log = dir.Join("debug.log");
+    std::string text;
+    for (int64_t height = 1; text.size() < 1024 * 1024; ++height) {
+        text += TipLine(height);
+    }
+    text += "2024-05-01T12:34:56Z ERROR: " + std::string(40 * 1024, 'x') + "\n";
+    text += TipLine(999999);
+    REQUIRE(WriteFile(log, text));
+
+    DebugLogTailer tailer(1024, 4);
+    std::string error;
+    REQUIRE(tailer.Start(log, &error));
+    const std::vector<int64_t> seen = WaitForHeight(&tailer, 999999);
+    REQUIRE(!seen.empty());
+    CHECK_EQ(seen.back(), static_cast<int64_t>(999999));
+    // Nothing from the first megabyte.
+    CHECK(seen.size() < 200);
+    CHECK(seen.front() > 1000);
+    // The 40 KiB ERROR line was read whole but is over the line limit.
+    LogRecord records[4];
+    CHECK_EQ(tailer.PollLogRecords(records, 4, 0), static_cast<size_t>(0));
+
+    // A line longer than the limit, split over several writes.
+    REQUIRE(Append(log, "2024-05-01T12:34:56Z ERROR: " + std::string(20 * 1024, 'y')));
+    usleep(100 * 1000);
+    REQUIRE(Append(log, std::string(20 * 1024, 'y') + "\n" + TipLine(1000000)));
+    CHECK_EQ(WaitForHeight(&tailer, 1000000), (std::vector<int64_t>{1000000}));
+    for (const std::string &line : tailer.RecentLines(4)) {
+        CHECK(line.find("yyyy") == std::string::npos);
+    }
+}
+
+TEST(StopReleasesPollers) {
+    TempDir dir;
+    DebugLogTailer tailer;
+    std::string error;
+    CHECK(!tailer.Start("debug.log", &error));
+    REQUIRE(tailer.Start(dir.Join("debug.log"), &error));
+    std::thread stopper([&] {
+        usleep(50 * 1000);
+        tailer.Stop();
+    });
+    TipEvent events[4];
+    const int64_t started = NowMicros();
+    CHECK_EQ(tailer.PollTipEvents(events, 4, 5000), static_cast<size_t>(0));
+    CHECK(NowMicros() - started < 2000 * 1000);
+    stopper.join();
+}
@@ -0,0 +1,209 @@
+#include "json_scan.h"
+
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+// text copied to the very end of a readable page, followed by an
+// inaccessible one: reading a byte past the view faults.
+class GuardedText {
+public:
+    explicit GuardedText(std::string_view text) {
+        page_ = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        pages_ = (text.size() + page_ - 1) / page_ + 1;
+        base_ = static_cast<char *>(mmap(nullptr, pages_ * page_, PROT_READ | PROT_WRITE,
+                                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        mprotect(base_ + (pages_ - 1) * page_, page_, PROT_NONE);
+        char *start = base_ + (pages_ - 1) * page_ - text.size();
+        memcpy(start, text.data(), text.size());
+        view_ = std::string_view(start, text.size());
+    }
+    ~GuardedText() { munmap(base_, pages_ * page_); }
+    GuardedText(const GuardedText &) = delete;
+    GuardedText &operator=(const GuardedText &) = delete;
+
+    std::string_view view() const { return view_; }
+
+private:
+    char *base_ = nullptr;
+    size_t page_ = 0;
+    size_t pages_ = 0;
+    std::string_view view_;
+};
+
+std::vector<std::string> MemberKeys(std::string_view object) {
+    std::vector<std::string> keys;
+    ForEachJsonMember(object, [&](std::string_view key, std::string_view) {
+        keys.emplace_back(key);
+        return true;
+    });
+    return keys;
+}
+
+const char kReply[] =
+        "{\"result\": {\"chain\": \"main\", \"softforks\": {\"csv\": {\"type\": \"buried\", "
+        "\"active\": true, \"height\": [1, 2, {\"x\": \"}]\"}]}}, "
+        "\"warnings\": \"a \\\"quoted\\\" } ] warning\\\\\", \"blocks\": 42}, "
+        "\"error\": null, \"id\": 0}";
+
+} // namespace
+
+TEST(SkipsNestedAndEscapedValues) {
+    const std::string_view json = kReply;
+    size_t pos = 0;
+    REQUIRE(SkipJsonValue(json, &pos));
+    CHECK_EQ(pos, json.size());
+
+    std::string_view result;
+    REQUIRE(FindJsonMember(json, "result", &result));
+    CHECK_EQ(MemberKeys(result),
+             (std::vector<std::string>{"chain", "softforks", "warnings", "blocks"}));
+    std::string_view blocks;
+    REQUIRE(FindJsonMember(result, "blocks", &blocks));
+    int64_t count = 0;
+    CHECK(JsonToInt64(blocks, &count));
+    CHECK_EQ(count, static_cast<int64_t>(42));
+    std::string_view warnings;
+    REQUIRE(FindJsonMember(result, "warnings", &warnings));
+    std::string text;
+    CHECK(JsonToString(warnings, &text));
+    CHECK_EQ(text, std::string("a \"quoted\" } ] warning\\"));
+    std::string_view error;
+    REQUIRE(FindJsonMember(json, "error", &error));
+    CHECK(JsonIsNull(error));
+
+    // Skipping one value leaves pos on what follows it.
+    const std::string_view list = "  [1, [2, 3]] , \"next\"";
+    pos = 0;
+    REQUIRE(SkipJsonValue(list, &pos));
+    CHECK_EQ(list.substr(pos), std::string_view(" , \"next\""));
+}
+
+TEST(EscapedKeysDoNotMatchPlainNames) {
+    const std::string_view object = "{\"bl\\u006fcks\": 1, \"blocks\": 2}";
+    std::string_view value;
+    REQUIRE(FindJsonMember(object, "blocks", &value));
+    CHECK_EQ(value, std::string_view("2"));
+}
+
+TEST(ElementsAndEarlyStop) {
+    std::vector<std::string> seen;
+    CHECK(ForEachJsonElement(" [ {\"id\":0} , \"a,b\" ,[], null ] ", [&](std::string_view value) {
+        seen.emplace_back(value);
+        return true;
+    }));
+    CHECK_EQ(seen, (std::vector<std::string>{"{\"id\":0}", "\"a,b\"", "[]", "null"}));
+    seen.clear();
+    CHECK(ForEachJsonElement("[1, 2, 3]", [&](std::string_view value) {
+        seen.emplace_back(value);
+        return seen.size() < 2;
+    }));
+    CHECK_EQ(seen.size(), static_cast<size_t>(2));
+    CHECK(ForEachJsonElement("[]", [](std::string_view) { return true; }));
+    CHECK(ForEachJsonMember("{ }", [](std::string_view, std::string_view) { return true; }));
+    CHECK(!ForEachJsonElement("{}", [](std::string_view) { return true; }));
+    CHECK(!ForEachJsonMember("[]", [](std::string_view, std::string_view) { return true; }));
+}
+
+TEST(Scalars) {
+    int64_t i = 0;
+    CHECK(JsonToInt64(" -9223372036854775808 ", &i));
+    CHECK_EQ(i, INT64_MIN);
+    CHECK(!JsonToInt64("9223372036854775808", &i));
+    CHECK(!JsonToInt64("1.5", &i));
+    CHECK(!JsonToInt64("\"1\"", &i));
+    CHECK(!JsonToInt64("", &i));
+    double d = 0;
+    CHECK(JsonToDouble("0.99999123", &d));
+    CHECK_EQ(d, 0.99999123);
+    CHECK(JsonToDouble("1e-4", &d));
+    CHECK_EQ(d, 1e-4);
+    CHECK(!JsonToDouble("\"0.5\"", &d));
+    CHECK(!JsonToDouble("0.5x", &d));
+    CHECK(!JsonToDouble(std::string(100, '1'), &d));
+    bool b = false;
+    CHECK(JsonToBool("true", &b));
+    CHECK(b);
+    CHECK(JsonToBool(" false", &b));
+    CHECK(!b);
+    CHECK(!JsonToBool("null", &b));
+    CHECK(!JsonIsNull("nullx"));
+}
+
+TEST(StringEscapes) {
+    std::string out;
+    CHECK(JsonToString("\"tab\\there\\nnew\\/line\\r\\b\\f\"", &out));
+    CHECK_EQ(out, std::string("tab\there\nnew/line\r\b\f"));
+    CHECK(JsonToString("\"\\u00e9\\u20ac\"", &out));
+    CHECK_EQ(out, std::string("\xc3\xa9\xe2\x82\xac"));
+    // U+1F600 as a surrogate pair, in either case.
+    CHECK(JsonToString("\"x\\ud83d\\ude00y\"", &out));
+    CHECK_EQ(out, std::string("x\xf0\x9f\x98\x80y"));
+    CHECK(JsonToString("\"\\uD83D\\uDE00\"", &out));
+    CHECK_EQ(out, std::string("\xf0\x9f\x98\x80"));
+    // A high surrogate without its low half is kept as it is rather than
+    // swallowing what follows.
+    CHECK(JsonToString("\"\\ud83d!\"", &out));
+    CHECK_EQ(out.back(), '!');
+    CHECK(JsonToString("\"\"", &out));
+    CHECK(out.empty());
+
+    CHECK(!JsonToString("\"\\u12\"", &out));
+    CHECK(!JsonToString("\"\\u12g4\"", &out));
+    CHECK(!JsonToString("\"ends in a backslash\\\"", &out));
+    CHECK(!JsonToString("\"unterminated", &out));
+    CHECK(!JsonToString("42", &out));
+}
+
+// Every prefix of a valid reply is rejected, and none of them is read past
+// its end.
+TEST(TruncatedInputFailsWithinBounds) {
+    const std::string json = kReply;
+    for (size_t length = 0; length < json.size(); ++length) {
+        GuardedText text(std::string_view(json).substr(0, length));
+        size_t pos = 0;
+        CHECK(!SkipJsonValue(text.view(), &pos));
+        CHECK(!ForEachJsonMember(text.view(), [](std::string_view, std::string_view) { return true; }));
+        std::string_view value;
+        FindJsonMember(text.view(), "id", &value);
+    }
+    const std::string array = "[{\"a\":\"[\\\"\"},[1,2],\"\\u00e9\"]";
+    for (size_t length = 0; length < array.size(); ++length) {
+        GuardedText text(std::string_view(array).substr(0, length));
+        CHECK(!ForEachJsonElement(text.view(), [](std::string_view) { return true; }));
+    }
+    for (const char *value : {"\"\\", "\"\\u", "\"\\ud83d\\u", "\"\\ud83d\\ude0", "tru", "-"}) {
+        GuardedText text(value);
+        std::string out;
+        JsonToString(text.view(), &out);
+        double d = 0;
+        JsonToDouble(text.view(), &d);
+    }
+}
+
+TEST(MalformedInput) {
+    const auto members = [](std::string_view object) {
+        return ForEachJsonMember(object, [](std::string_view, std::string_view) { return true; });
+    };
+    CHECK(!members("{\"a\" 1}"));
+    CHECK(!members("{\"a\":1 \"b\":2}"));
+    CHECK(!members("{a:1}"));
+    CHECK(!members("{\"a\":}"));
+    CHECK(!members("{\"a\":1,}"));
+    CHECK(!members(""));
+    CHECK(!ForEachJsonElement("[1 2]", [](std::string_view) { return true; }));
+    CHECK(!ForEachJsonElement("[1,]", [](std::string_view) { return true; }));
+    size_t pos = 0;
+    CHECK(!SkipJsonValue("   ", &pos));
+    pos = 0;
+    CHECK(!SkipJsonValue("{\"a\":[1,2}", &pos));
+}
@@ -0,0 +1,186 @@
+#include "loopback_http_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+
+namespace digimobile {
+namespace test {
+namespace {
+
+// Wait for fd to become readable, giving up when the server stops.
+bool WaitReadable(int fd, const std::atomic<bool> &stopping) {
+    while (!stopping.load()) {
+        pollfd pfd {fd, POLLIN, 0};
+        const int ready = poll(&pfd, 1, 50);
+        if (ready > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WriteAll(int fd, const std::string &data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+LoopbackHttpServer::LoopbackHttpServer(Handler handler) : handler_(std::move(handler)) {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    const int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(addr);
+    if (bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        listen(listen_fd_, 8) != 0 ||
+        getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &length) != 0) {
+        abort();
+    }
+    port_ = ntohs(addr.sin_port);
+    thread_ = std::thread(&LoopbackHttpServer::Run, this);
+}
+
+LoopbackHttpServer::~LoopbackHttpServer() { Stop(); }
+
+void LoopbackHttpServer::Stop() {
+    stopping_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+bool LoopbackHttpServer::WaitForRequests(int count, int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return changed_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                             [&] { return requests_.load() >= count; });
+}
+
+void LoopbackHttpServer::Run() {
+    while (WaitReadable(listen_fd_, stopping_)) {
+        const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        const int connection = ++connections_;
+        Serve(fd, connection);
+        close(fd);
+    }
+}
+
+bool LoopbackHttpServer::Serve(int fd, int connection) {
+    std::string buffer;
+    char chunk[16 * 1024];
+    for (;;) {
+        // Headers, then Content-Length bytes of body.
+        size_t header_end;
+        while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (!WaitReadable(fd, stopping_)) {
+                return false;
+            }
+            const ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                return false;  // client closed the connection
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+        Request request;
+        request.connection = connection;
+        const size_t line_end = buffer.find("\r\n");
+        request.request_line = buffer.substr(0, line_end);
+        request.headers = buffer.substr(line_end + 2, header_end - line_end - 2);
+        std::transform(request.headers.begin(), request.headers.end(), request.headers.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        size_t content_length = 0;
+        const size_t field = request.headers.find("content-length:");
+        if (field != std::string::npos) {
+            content_length = strtoul(request.headers.c_str() + field + 15, nullptr, 10);
+        }
+        buffer.erase(0, header_end + 4);
+        while (buffer.size() < content_length) {
+            if (!WaitReadable(fd, stopping_)) {
+                return false;
+            }
+            const ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                return false;
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+        request.body = buffer.substr(0, content_length);
+        buffer.erase(0, content_length);
+        request.index = requests_.load();
+
+        const Reply reply = handler_(request);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++requests_;
+        }
+        changed_.notify_all();
+
+        if (!reply.raw.empty() && !WriteAll(fd, reply.raw)) {
+            return false;
+        }
+        if (reply.stall) {
+            // Until the client hangs up (e.g. after an abort) or Stop().
+            while (WaitReadable(fd, stopping_)) {
+                if (recv(fd, chunk, sizeof(chunk), 0) <= 0) {
+                    break;
+                }
+            }
+            return false;
+        }
+        if (reply.close) {
+            return true;
+        }
+    }
+}
+
+LoopbackHttpServer::Reply LoopbackHttpServer::Response(int status, const std::string &body,
+                                                       const std::string &extra_headers) {
+    Reply reply;
+    reply.raw = "HTTP/1.1 " + std::to_string(status) + " Status\r\nContent-Type: application/json\r\n" +
+                extra_headers + "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" +
+                body;
+    return reply;
+}
+
+LoopbackHttpServer::Reply LoopbackHttpServer::ChunkedResponse(
+        int status, const std::vector<std::string> &chunks) {
+    Reply reply;
+    reply.raw = "HTTP/1.1 " + std::to_string(status) +
+                " Status\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n";
+    char size[32];
+    for (const std::string &chunk : chunks) {
+        snprintf(size, sizeof(size), "%zx\r\n", chunk.size());
+        reply.raw += size + chunk + "\r\n";
+    }
+    reply.raw += "0\r\n\r\n";
+    return reply;
+}
+
+} // namespace test
+} // namespace digimobile
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace digimobile {
+namespace test {
+
+// Stand-in HTTP server on 127.0.0.1 for RPC client tests. Connections are
+// served one at a time on a background thread; every request is handed to
+// the handler, whose reply says exactly what goes back on the wire, so
+// tests can script keep-alive, chunking, dropped connections and stalls.
+class LoopbackHttpServer {
+public:
+    struct Request {
+        std::string request_line;
+        std::string headers;  // raw, lower-cased names
+        std::string body;
+        int connection = 0;   // 1 for the first accepted connection, and so on
+        int index = 0;        // 0-based over all requests
+    };
+
+    struct Reply {
+        // Written as-is; empty writes nothing.
+        std::string raw;
+        // Close the connection after writing raw.
+        bool close = false;
+        // Keep the connection open without answering until the client closes
+        // it or Stop().
+        bool stall = false;
+    };
+
+    using Handler = std::function<Reply(const Request &request)>;
+
+    explicit LoopbackHttpServer(Handler handler);
+    ~LoopbackHttpServer();
+
+    uint16_t port() const { return port_; }
+    int connections() const { return connections_.load(); }
+    int requests() const { return requests_.load(); }
+    // Block until at least count requests have arrived.
+    bool WaitForRequests(int count, int timeout_ms);
+    void Stop();
+
+    static Reply Response(int status, const std::string &body,
+                          const std::string &extra_headers = std::string());
+    static Reply ChunkedResponse(int status, const std::vector<std::string> &chunks);
+
+private:
+    void Run();
+    bool Serve(int fd, int connection);
+
+    Handler handler_;
+    int listen_fd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> stopping_{false};
+    std::atomic<int> connections_{0};
+    std::atomic<int> requests_{0};
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::thread thread_;
+};
+
+} // namespace test
+} // namespace digimobile
@@ -0,0 +1,141 @@
+#include "node_controller.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "platform.h"
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+// Stands in for digibyted: shuts down cleanly on SIGTERM like the daemon,
+// logs its arguments to <datadir>/argv once it can, then does what
+// <datadir>/mode says: "crash" exits 1 at once, anything else runs until
+// stopped.
+const char kFakeDaemon[] =
+        "#!/bin/sh\n"
+        "trap 'kill $pid 2>/dev/null; exit 0' TERM\n"
+        "for arg; do case \"$arg\" in -datadir=*) dir=\"${arg#-datadir=}\";; esac; done\n"
+        "echo \"$*\" >> \"$dir/argv\"\n"
+        "if [ \"$(cat \"$dir/mode\" 2>/dev/null)\" = crash ]; then exit 1; fi\n"
+        "sleep 30 &\n"
+        "pid=$!\n"
+        "wait\n";
+
+class FakeNode {
+public:
+    FakeNode() : assets_(dir_.Join("assets")) {
+        mkdir(dir_.Join("assets").c_str(), 0700);
+        mkdir(dir_.Join("assets/bin").c_str(), 0700);
+        mkdir(dir_.Join("data").c_str(), 0700);
+        WriteFile(dir_.Join("assets/bin/digibyted-arm64"), kFakeDaemon);
+        WriteFile(dir_.Join("assets/bin/digibyte-cli-arm64"), "#!/bin/sh\nexit 0\n");
+        request_.config_path = dir_.Join("data/digibyte.conf");
+        request_.data_dir = dir_.Join("data");
+        request_.files_dir = dir_.path();
+        request_.asset_stamp = "test";
+        request_.embedded_library.clear();
+    }
+
+    void Start(NodeController *controller) { controller->Start(&assets_, request_); }
+    void SetMode(const std::string &mode) { WriteFile(dir_.Join("data/mode"), mode); }
+    std::string Argv() const { return ReadFile(dir_.Join("data/argv")); }
+    // Until the daemon has started count times in all, so it handles SIGTERM.
+    bool WaitForRuns(size_t count) const {
+        for (int i = 0; i < 500; ++i) {
+            const std::string argv = Argv();
+            if (static_cast<size_t>(std::count(argv.begin(), argv.end(), '\n')) >= count) {
+                return true;
+            }
+            usleep(10 * 1000);
+        }
+        return false;
+    }
+    bool Marker() const { return PathExists(dir_.Join("data/.digimobile-clean-shutdown")); }
+
+private:
+    TempDir dir_;
+    DirectoryAssetProvider assets_;
+    StartRequest request_;
+};
+
+bool WaitForExit(NodeController *controller) {
+    for (int i = 0; i < 500; ++i) {
+        if (controller->supervisor().phase() == NodePhase::EXITED) {
+            return true;
+        }
+        usleep(10 * 1000);
+    }
+    return false;
+}
+
+} // namespace
+
+// Reduced start-up checks follow a clean shutdown, and only the start right
+// after it: not a crash restart, not the start after a crash.
+TEST(WarmRestartFollowsOnlyACleanShutdown) {
+    FakeNode node;
+    NodeController controller;
+    WarmRestartPolicy warm;
+    warm.enabled = true;
+    controller.SetWarmRestart(warm);
+    RestartPolicy restart;
+    restart.enabled = true;
+    restart.max_restarts = 1;
+    restart.initial_backoff_ms = 10;
+    controller.supervisor().SetRestartPolicy(restart);
+
+    // No shutdown recorded yet.
+    node.Start(&controller);
+    REQUIRE(controller.status() == NodeStatus::RUNNING);
+    CHECK(!controller.last_launch().warm);
+    REQUIRE(node.WaitForRuns(1));
+    controller.Stop(5000);
+    CHECK(controller.supervisor().last_exit().clean());
+    CHECK(node.Marker());
+
+    // Clean shutdown: warm, then a crash and its restart.
+    node.SetMode("crash");
+    node.Start(&controller);
+    CHECK(controller.last_launch().warm);
+    CHECK(WaitForExit(&controller));
+    CHECK_EQ(controller.supervisor().restart_count(), 1);
+    CHECK(!node.Marker());
+
+    // After the crash: cold.
+    node.SetMode("run");
+    node.Start(&controller);
+    CHECK(!controller.last_launch().warm);
+    REQUIRE(node.WaitForRuns(4));
+    controller.Stop(5000);
+
+    const std::string argv = node.Argv();
+    std::vector<std::string> warm_lines;
+    size_t start = 0;
+    for (size_t end; (end = argv.find('\n', start)) != std::string::npos; start = end + 1) {
+        warm_lines.push_back(argv.find("-checkblocks=1 -checklevel=0", start) < end ? "warm" : "cold");
+    }
+    CHECK_EQ(warm_lines, (std::vector<std::string>{"cold", "warm", "cold", "cold"}));
+}
+
+// While warm restarts are off the marker is still kept, but never acted on.
+TEST(WarmRestartDisabled) {
+    FakeNode node;
+    NodeController controller;
+    node.Start(&controller);
+    REQUIRE(controller.status() == NodeStatus::RUNNING);
+    REQUIRE(node.WaitForRuns(1));
+    controller.Stop(5000);
+    CHECK(node.Marker());
+    node.Start(&controller);
+    CHECK(!controller.last_launch().warm);
+    CHECK(!node.Marker());
+    REQUIRE(node.WaitForRuns(2));
+    controller.Stop(5000);
+    CHECK(node.Argv().find("-checkblocks") == std::string::npos);
+}
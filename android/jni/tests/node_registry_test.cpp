@@ -0,0 +1,105 @@
+#include "node_registry.h"
+
+#include <sys/stat.h>
+
+#include "platform.h"
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+TEST(DefaultHandleIsStable) {
+    NodeRegistry registry;
+    const int64_t handle = registry.Default();
+    CHECK(handle > 0);
+    CHECK_EQ(registry.Default(), handle);
+    CHECK(registry.Find(handle) != nullptr);
+}
+
+TEST(CreatedHandlesAreDistinctAndNeverReused) {
+    NodeRegistry registry;
+    const int64_t fallback = registry.Default();
+    const int64_t first = registry.Create();
+    const int64_t second = registry.Create();
+    CHECK(first != fallback);
+    CHECK(second != first);
+    CHECK(registry.Find(first) != registry.Find(second));
+
+    CHECK(registry.Remove(first) != nullptr);
+    const int64_t third = registry.Create();
+    CHECK(third != first);
+    CHECK(registry.Find(first) == nullptr);
+}
+
+TEST(UnknownAndRemovedHandlesFindNothing) {
+    NodeRegistry registry;
+    CHECK(registry.Find(0) == nullptr);
+    CHECK(registry.Find(-1) == nullptr);
+    CHECK(registry.Find(12345) == nullptr);
+
+    const int64_t handle = registry.Create();
+    CHECK(registry.Remove(handle) != nullptr);
+    CHECK(registry.Find(handle) == nullptr);
+    CHECK(registry.Remove(handle) == nullptr);
+}
+
+TEST(DefaultNodeCannotBeRemoved) {
+    NodeRegistry registry;
+    const int64_t handle = registry.Default();
+    CHECK(registry.Remove(handle) == nullptr);
+    CHECK(registry.Find(handle) != nullptr);
+}
+
+TEST(RemovedNodeOutlivesItsLastUser) {
+    NodeRegistry registry;
+    const int64_t handle = registry.Create();
+    std::shared_ptr<NodeInstance> in_use = registry.Find(handle);
+    REQUIRE(in_use != nullptr);
+    std::shared_ptr<NodeInstance> removed = registry.Remove(handle);
+    CHECK(removed == in_use);
+    removed.reset();
+    // Still usable by the call that looked it up first.
+    CHECK_EQ(in_use->controller.status(), NodeStatus::NOT_RUNNING);
+    CHECK_EQ(in_use.use_count(), 1);
+}
+
+// Two registered nodes run their own child side by side and stop
+// independently; the daemon is a shell script standing in for digibyted.
+TEST(NodesStartAndStopIndependently) {
+    TempDir dir;
+    REQUIRE(mkdir(dir.Join("assets").c_str(), 0700) == 0);
+    REQUIRE(mkdir(dir.Join("assets/bin").c_str(), 0700) == 0);
+    REQUIRE(WriteFile(dir.Join("assets/bin/digibyted-arm64"), "#!/bin/sh\nexec sleep 30\n"));
+    REQUIRE(WriteFile(dir.Join("assets/bin/digibyte-cli-arm64"), "#!/bin/sh\nexit 0\n"));
+    DirectoryAssetProvider assets(dir.Join("assets"));
+
+    NodeRegistry registry;
+    const int64_t handles[2] = {registry.Default(), registry.Create()};
+    for (int i = 0; i < 2; ++i) {
+        const std::string node_dir = dir.Join("node" + std::to_string(i));
+        REQUIRE(mkdir(node_dir.c_str(), 0700) == 0);
+        StartRequest request;
+        request.config_path = node_dir + "/digibyte.conf";
+        request.data_dir = node_dir;
+        request.files_dir = dir.path();
+        request.asset_stamp = "test";
+        request.embedded_library.clear();
+        registry.Find(handles[i])->controller.Start(&assets, request);
+    }
+
+    std::shared_ptr<NodeInstance> first = registry.Find(handles[0]);
+    std::shared_ptr<NodeInstance> second = registry.Find(handles[1]);
+    REQUIRE(first->controller.status() == NodeStatus::RUNNING);
+    REQUIRE(second->controller.status() == NodeStatus::RUNNING);
+    CHECK(first->controller.supervisor().pid() > 0);
+    CHECK(first->controller.supervisor().pid() != second->controller.supervisor().pid());
+
+    std::shared_ptr<NodeInstance> removed = registry.Remove(handles[1]);
+    removed->controller.Stop(5000);
+    CHECK_EQ(removed->controller.status(), NodeStatus::NOT_RUNNING);
+    CHECK(first->controller.Snapshot().phase == NodePhase::RUNNING);
+
+    first->controller.Stop(5000);
+    CHECK_EQ(first->controller.status(), NodeStatus::NOT_RUNNING);
+    CHECK(first->controller.Snapshot().phase != NodePhase::RUNNING);
+}
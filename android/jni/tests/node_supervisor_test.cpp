@@ -0,0 +1,351 @@
+#include "node_supervisor.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+constexpr const char *kChildEnv = "DIGIMOBILE_TEST_THREADED_CHILD";
+constexpr int kChildThreads = 4;  // including the main thread
+
+// Re-executed by the supervisor as a stand-in daemon that starts a few
+// threads after exec, the way digibyted does, then waits to be signalled.
+const bool g_child = [] {
+    if (getenv(kChildEnv) == nullptr) {
+        return false;
+    }
+    for (int i = 1; i < kChildThreads; ++i) {
+        pthread_t thread;
+        pthread_create(&thread, nullptr, [](void *) -> void * {
+            for (;;) {
+                pause();
+            }
+        }, nullptr);
+    }
+    for (;;) {
+        pause();
+    }
+}();
+
+std::string SelfExe() {
+    char path[4096];
+    const ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    return std::string(path, n > 0 ? static_cast<size_t>(n) : 0);
+}
+
+std::vector<pid_t> Threads(pid_t pid) {
+    std::vector<pid_t> tids;
+    if (DIR *dir = opendir(("/proc/" + std::to_string(pid) + "/task").c_str())) {
+        while (dirent *entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                tids.push_back(static_cast<pid_t>(atoi(entry->d_name)));
+            }
+        }
+        closedir(dir);
+    }
+    return tids;
+}
+
+bool WaitForThreads(pid_t pid, size_t count) {
+    for (int i = 0; i < 500; ++i) {
+        if (Threads(pid).size() >= count) {
+            return true;
+        }
+        usleep(10 * 1000);
+    }
+    return false;
+}
+
+// Third field of /proc/<pid>/stat: R, S, T, ...
+char ProcessState(pid_t pid) {
+    const std::string stat = ReadFile("/proc/" + std::to_string(pid) + "/stat");
+    const size_t paren = stat.rfind(')');
+    return paren != std::string::npos && paren + 2 < stat.size() ? stat[paren + 2] : '?';
+}
+
+int IoPriority(pid_t tid) {
+    return static_cast<int>(syscall(SYS_ioprio_get, 1 /* IOPRIO_WHO_PROCESS */, tid));
+}
+
+// The highest CPU this process may run on, so pinning to it is a real change
+// wherever more than one is available.
+int LastAllowedCpu() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    sched_getaffinity(0, sizeof(set), &set);
+    int last = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+            last = cpu;
+        }
+    }
+    return last;
+}
+
+void CheckThreadScheduling(pid_t tid, int nice, int policy, int ioprio, int cpu) {
+    errno = 0;
+    CHECK_EQ(getpriority(PRIO_PROCESS, static_cast<id_t>(tid)), nice);
+    CHECK_EQ(sched_getscheduler(tid), policy);
+    CHECK_EQ(IoPriority(tid), ioprio);
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CHECK_EQ(sched_getaffinity(tid, sizeof(set), &set), 0);
+        CHECK_EQ(CPU_COUNT(&set), 1);
+        CHECK(CPU_ISSET(cpu, &set));
+    }
+}
+
+bool StartThreadedChild(NodeSupervisor *supervisor) {
+    setenv(kChildEnv, "1", 1);
+    std::string error;
+    const bool started = supervisor->Start({SelfExe()}, &error);
+    unsetenv(kChildEnv);
+    CHECK_EQ(error, std::string());
+    return started && WaitForThreads(supervisor->pid(), kChildThreads);
+}
+
+} // namespace
+
+TEST(StopsAChild) {
+    NodeSupervisor supervisor;
+    std::string error;
+    REQUIRE(supervisor.Start({"/bin/sleep", "30"}, &error));
+    const pid_t pid = supervisor.pid();
+    CHECK(pid > 0);
+    CHECK_EQ(supervisor.phase(), NodePhase::RUNNING);
+    const ExitInfo exit = supervisor.Stop(5000);
+    CHECK_EQ(exit.signal, SIGTERM);
+    CHECK_EQ(supervisor.phase(), NodePhase::NOT_RUNNING);
+    CHECK_EQ(supervisor.pid(), -1);
+    CHECK(kill(pid, 0) != 0);
+}
+
+TEST(ReportsExitCode) {
+    NodeSupervisor supervisor;
+    std::string error;
+    REQUIRE(supervisor.Start({"/bin/sh", "-c", "exit 3"}, &error));
+    for (int i = 0; i < 500 && supervisor.phase() == NodePhase::RUNNING; ++i) {
+        usleep(10 * 1000);
+    }
+    CHECK_EQ(supervisor.phase(), NodePhase::EXITED);
+    CHECK_EQ(supervisor.last_exit().code, 3);
+}
+
+// Scheduled between fork and exec, so threads the daemon starts inherit it.
+TEST(SchedulingReachesThreadsStartedAfterExec) {
+    SchedulingPolicy policy;
+    policy.nice = 7;
+    policy.batch = true;
+    policy.io_class = 2;
+    policy.io_level = 6;
+    NodeSupervisor supervisor;
+    CHECK_EQ(supervisor.SetSchedulingPolicy(policy), 0);
+    REQUIRE(StartThreadedChild(&supervisor));
+
+    const std::vector<pid_t> tids = Threads(supervisor.pid());
+    CHECK_EQ(tids.size(), static_cast<size_t>(kChildThreads));
+    for (pid_t tid : tids) {
+        CheckThreadScheduling(tid, 7, SCHED_BATCH, (2 << 13) | 6, -1);
+    }
+    supervisor.Stop(5000);
+}
+
+// A new policy for a running child is applied to each of its threads.
+TEST(SchedulingAppliesToEveryRunningThread) {
+    NodeSupervisor supervisor;
+    REQUIRE(StartThreadedChild(&supervisor));
+    const pid_t pid = supervisor.pid();
+
+    SchedulingPolicy policy;
+    policy.nice = 12;
+    policy.batch = true;
+    policy.io_class = 3;
+    CHECK_EQ(supervisor.SetSchedulingPolicy(policy), 0);
+    const std::vector<pid_t> tids = Threads(pid);
+    CHECK_EQ(tids.size(), static_cast<size_t>(kChildThreads));
+    for (pid_t tid : tids) {
+        CheckThreadScheduling(tid, 12, SCHED_BATCH, 3 << 13, -1);
+    }
+
+    // Core sets come from cpufreq, which hosts often lack; pin directly
+    // through the same per-thread walk instead.
+    const int cpu = LastAllowedCpu();
+    PreparedScheduling prepared = PrepareScheduling(policy);
+    CPU_ZERO(&prepared.cpus);
+    CPU_SET(cpu, &prepared.cpus);
+    prepared.restrict_cpus = true;
+    prepared.nice = 13;
+    CHECK_EQ(ApplySchedulingToProcess(pid, prepared), 0);
+    for (pid_t tid : Threads(pid)) {
+        CheckThreadScheduling(tid, 13, SCHED_BATCH, 3 << 13, cpu);
+    }
+    supervisor.Stop(5000);
+}
+
+TEST(DutyCycleStopsAndResumesTheChild) {
+    SchedulingPolicy policy;
+    policy.duty_percent = 50;
+    policy.duty_period_ms = 200;
+    NodeSupervisor supervisor;
+    supervisor.SetSchedulingPolicy(policy);
+    std::string error;
+    REQUIRE(supervisor.Start({"/bin/sleep", "30"}, &error));
+    const pid_t pid = supervisor.pid();
+
+    int stopped = 0;
+    int running = 0;
+    for (int i = 0; i < 200; ++i) {
+        ProcessState(pid) == 'T' ? ++stopped : ++running;
+        usleep(5 * 1000);
+    }
+    // About half of each 200 ms period either way; leave room for a slow host.
+    CHECK(stopped > 40);
+    CHECK(running > 40);
+
+    // Back to 100%: the hold is released and not taken again.
+    policy.duty_percent = 100;
+    supervisor.SetSchedulingPolicy(policy);
+    usleep(50 * 1000);
+    for (int i = 0; i < 60; ++i) {
+        CHECK(ProcessState(pid) != 'T');
+        usleep(5 * 1000);
+    }
+    supervisor.Stop(5000);
+}
+
+// A child held by the duty cycle is resumed so it can act on SIGTERM.
+TEST(StopTerminatesAStoppedChild) {
+    SchedulingPolicy policy;
+    policy.duty_percent = 10;
+    policy.duty_period_ms = 5000;
+    NodeSupervisor supervisor;
+    supervisor.SetSchedulingPolicy(policy);
+    std::string error;
+    REQUIRE(supervisor.Start({"/bin/sleep", "30"}, &error));
+    const pid_t pid = supervisor.pid();
+    bool held = false;
+    for (int i = 0; i < 300 && !held; ++i) {
+        held = ProcessState(pid) == 'T';
+        usleep(10 * 1000);
+    }
+    REQUIRE(held);
+
+    const int64_t started = NowMicros();
+    const ExitInfo exit = supervisor.Stop(3000);
+    CHECK_EQ(exit.signal, SIGTERM);
+    // SIGTERM took effect rather than the SIGKILL escalation.
+    CHECK(NowMicros() - started < 2000000);
+    CHECK(kill(pid, 0) != 0);
+}
+
+TEST(CrashRestartsWithinBudget) {
+    TempDir dir;
+    RestartPolicy restart;
+    restart.enabled = true;
+    restart.max_restarts = 2;
+    restart.initial_backoff_ms = 10;
+    restart.max_backoff_ms = 20;
+    NodeSupervisor supervisor;
+    supervisor.SetRestartPolicy(restart);
+    std::string error;
+    REQUIRE(supervisor.Start({"/bin/sh", "-c", "echo x >> " + dir.Join("runs") + "; exit 1"}, &error));
+    for (int i = 0; i < 500 && supervisor.phase() != NodePhase::EXITED; ++i) {
+        usleep(10 * 1000);
+    }
+    CHECK_EQ(supervisor.phase(), NodePhase::EXITED);
+    CHECK_EQ(supervisor.restart_count(), 2);
+    CHECK_EQ(ReadFile(dir.Join("runs")), std::string("x\nx\nx\n"));
+}
+
+// The marker exists only after a clean exit and is gone by the time any
+// child runs; each child logs whether it saw it.
+TEST(CleanExitMarker) {
+    TempDir dir;
+    const std::string marker = dir.Join(".clean");
+    const std::string log = dir.Join("log");
+    const auto child = [&](const std::string &then) -> std::vector<std::string> {
+        return {"/bin/sh", "-c",
+                "if [ -e " + marker + " ]; then echo seen >> " + log + "; else echo none >> " + log +
+                        "; fi; " + then};
+    };
+    const auto wait_exit = [](NodeSupervisor *supervisor) {
+        for (int i = 0; i < 500 && supervisor->phase() != NodePhase::EXITED; ++i) {
+            usleep(10 * 1000);
+        }
+    };
+    NodeSupervisor supervisor;
+    supervisor.SetCleanExitMarker(marker);
+    REQUIRE(WriteFile(marker, ""));
+    std::string error;
+
+    REQUIRE(supervisor.Start(child("exit 0"), &error));
+    wait_exit(&supervisor);
+    CHECK(supervisor.last_exit().clean());
+    CHECK(PathExists(marker));
+
+    REQUIRE(supervisor.Start(child("exit 3"), &error));
+    wait_exit(&supervisor);
+    CHECK_EQ(supervisor.last_exit().code, 3);
+    CHECK(!PathExists(marker));
+
+    REQUIRE(supervisor.Start(child("exit 0"), &error));
+    wait_exit(&supervisor);
+    REQUIRE(PathExists(marker));
+    // Terminated by a signal.
+    REQUIRE(supervisor.Start(child("exec sleep 30"), &error));
+    usleep(100 * 1000);
+    CHECK_EQ(supervisor.Stop(5000).signal, SIGTERM);
+    CHECK(!PathExists(marker));
+    CHECK_EQ(ReadFile(log), std::string("none\nnone\nnone\nnone\n"));
+
+    // Crash restarts remove it too.
+    RestartPolicy restart;
+    restart.enabled = true;
+    restart.max_restarts = 1;
+    restart.initial_backoff_ms = 10;
+    supervisor.SetRestartPolicy(restart);
+    REQUIRE(supervisor.Start(child("touch " + marker + "; kill -KILL $$"), &error));
+    for (int i = 0; i < 500 && (supervisor.phase() != NodePhase::EXITED || supervisor.restart_count() < 1); ++i) {
+        usleep(10 * 1000);
+    }
+    CHECK_EQ(supervisor.restart_count(), 1);
+    CHECK_EQ(supervisor.last_exit().signal, SIGKILL);
+    CHECK(PathExists(marker));  // left by the child itself, not by a clean exit
+    CHECK_EQ(ReadFile(log), std::string("none\nnone\nnone\nnone\nnone\nnone\n"));
+}
+
+// launch_args go to the spawn Start() makes and to no crash restart after it.
+TEST(LaunchArgsAreForTheFirstSpawnOnly) {
+    TempDir dir;
+    const std::string log = dir.Join("argv");
+    RestartPolicy restart;
+    restart.enabled = true;
+    restart.max_restarts = 2;
+    restart.initial_backoff_ms = 10;
+    restart.max_backoff_ms = 20;
+    NodeSupervisor supervisor;
+    supervisor.SetRestartPolicy(restart);
+    std::string error;
+    REQUIRE(supervisor.Start({"/bin/sh", "-c", "echo \"$*\" >> " + log + "; exit 1", "daemon", "-conf=x"},
+                             &error, {"-checkblocks=1", "-checklevel=0"}));
+    for (int i = 0; i < 500 && supervisor.phase() != NodePhase::EXITED; ++i) {
+        usleep(10 * 1000);
+    }
+    CHECK_EQ(supervisor.restart_count(), 2);
+    CHECK_EQ(ReadFile(log), std::string("-conf=x -checkblocks=1 -checklevel=0\n-conf=x\n-conf=x\n"));
+}
@@ -0,0 +1,139 @@
+#include "proc_stats.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+// /proc/<pid>/stat with the given comm; every numeric field n not set
+// explicitly holds n * 1000 + 7, so reading a neighbour shows up.
+std::string FakeStat(pid_t pid, const std::string &comm, long long utime, long long stime,
+                     long long threads) {
+    std::string stat = std::to_string(pid) + " (" + comm + ") S";
+    for (int field = 4; field <= 52; ++field) {
+        long long value = field * 1000LL + 7;
+        if (field == 14) {
+            value = utime;
+        } else if (field == 15) {
+            value = stime;
+        } else if (field == 20) {
+            value = threads;
+        }
+        stat += " " + std::to_string(value);
+    }
+    return stat + "\n";
+}
+
+char ProcessState(pid_t pid) {
+    const std::string stat = ReadFile("/proc/" + std::to_string(pid) + "/stat");
+    const size_t paren = stat.rfind(')');
+    return paren != std::string::npos && paren + 2 < stat.size() ? stat[paren + 2] : '?';
+}
+
+} // namespace
+
+TEST(FakeProcTree) {
+    TempDir proc;
+    const pid_t pid = 4321;
+    const std::string base = proc.Join(std::to_string(pid));
+    REQUIRE(mkdir(base.c_str(), 0700) == 0);
+    REQUIRE(mkdir((base + "/fd").c_str(), 0700) == 0);
+    const long ticks = sysconf(_SC_CLK_TCK);
+    REQUIRE(ticks > 0);
+    // A comm with spaces and a ')' of its own, as a thread can name itself.
+    REQUIRE(WriteFile(base + "/stat", FakeStat(pid, "digi (b) d) x", 3 * ticks, ticks / 2, 17)));
+    REQUIRE(WriteFile(base + "/statm", "25000 1234 300 10 0 900 0\n"));
+    REQUIRE(WriteFile(base + "/io",
+                      "rchar: 111\nwchar: 222\nsyscr: 3\nsyscw: 4\nread_bytes: 40960\n"
+                      "write_bytes: 8192\ncancelled_write_bytes: 999999\n"));
+    for (int fd = 0; fd < 5; ++fd) {
+        REQUIRE(symlink("/dev/null", (base + "/fd/" + std::to_string(fd)).c_str()) == 0);
+    }
+
+    ProcessStats stats;
+    REQUIRE(ReadProcessStats(pid, &stats, proc.path()));
+    CHECK_EQ(stats.cpu_user_ms, static_cast<int64_t>(3000));
+    CHECK_EQ(stats.cpu_system_ms, static_cast<int64_t>(ticks / 2 * 1000 / ticks));
+    CHECK_EQ(stats.threads, static_cast<int64_t>(17));
+    CHECK_EQ(stats.rss_bytes, 1234LL * sysconf(_SC_PAGESIZE));
+    CHECK_EQ(stats.io_read_bytes, static_cast<int64_t>(40960));
+    CHECK_EQ(stats.io_write_bytes, static_cast<int64_t>(8192));
+    CHECK_EQ(stats.open_fds, static_cast<int64_t>(5));
+
+    // cancelled_write_bytes ahead of write_bytes, and no write_bytes at all.
+    REQUIRE(WriteFile(base + "/io", "rchar: 1\ncancelled_write_bytes: 77\nread_bytes: 5\nwrite_bytes: 6\n"));
+    REQUIRE(ReadProcessStats(pid, &stats, proc.path()));
+    CHECK_EQ(stats.io_write_bytes, static_cast<int64_t>(6));
+    REQUIRE(WriteFile(base + "/io", "rchar: 1\nread_bytes: 5\ncancelled_write_bytes: 77\n"));
+    REQUIRE(ReadProcessStats(pid, &stats, proc.path()));
+    CHECK_EQ(stats.io_read_bytes, static_cast<int64_t>(5));
+    CHECK_EQ(stats.io_write_bytes, static_cast<int64_t>(-1));
+
+    // Only stat is required; what else is missing stays unknown.
+    unlink((base + "/statm").c_str());
+    unlink((base + "/io").c_str());
+    RemoveTree(base + "/fd");
+    REQUIRE(ReadProcessStats(pid, &stats, proc.path()));
+    CHECK_EQ(stats.rss_bytes, static_cast<int64_t>(-1));
+    CHECK_EQ(stats.io_read_bytes, static_cast<int64_t>(-1));
+    CHECK_EQ(stats.open_fds, static_cast<int64_t>(-1));
+    CHECK_EQ(stats.threads, static_cast<int64_t>(17));
+
+    std::string zombie = FakeStat(pid, "digibyted", 0, 0, 1);
+    zombie[zombie.find(") S") + 2] = 'Z';
+    REQUIRE(WriteFile(base + "/stat", zombie));
+    CHECK(!ReadProcessStats(pid, &stats, proc.path()));
+    CHECK(!ReadProcessStats(pid + 1, &stats, proc.path()));
+}
+
+TEST(RealProcess) {
+    int ready[2];
+    REQUIRE(pipe(ready) == 0);
+    const pid_t child = fork();
+    REQUIRE(child >= 0);
+    if (child == 0) {
+        // A few descriptors and some resident memory, then wait to be killed.
+        for (int i = 0; i < 8; ++i) {
+            open("/dev/null", O_RDONLY);
+        }
+        std::string touched(4 << 20, 'x');
+        write(ready[1], touched.data(), 1);
+        for (;;) {
+            pause();
+        }
+    }
+    close(ready[1]);
+    char byte;
+    REQUIRE(read(ready[0], &byte, 1) == 1);
+    close(ready[0]);
+
+    ProcessStats stats;
+    CHECK(ReadProcessStats(child, &stats));
+    CHECK(stats.rss_bytes >= 4 << 20);
+    CHECK_EQ(stats.threads, static_cast<int64_t>(1));
+    CHECK(stats.cpu_user_ms >= 0);
+    CHECK(stats.cpu_system_ms >= 0);
+    CHECK(stats.open_fds >= 8 + 2);
+    if (PathExists("/proc/self/io")) {
+        CHECK(stats.io_read_bytes >= 0);
+        CHECK(stats.io_write_bytes >= 0);
+    }
+
+    // Killed but not yet reaped: only the zombie entry is left.
+    kill(child, SIGKILL);
+    for (int i = 0; i < 500 && ProcessState(child) != 'Z'; ++i) {
+        usleep(10 * 1000);
+    }
+    CHECK_EQ(ProcessState(child), 'Z');
+    CHECK(!ReadProcessStats(child, &stats));
+    waitpid(child, nullptr, 0);
+    CHECK(!ReadProcessStats(child, &stats));
+}
@@ -0,0 +1,203 @@
+#include "resource_governor.h"
+
+#include <sys/stat.h>
+
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+// A fake proc/ and sys/ tree with the files ReadDeviceState() looks at.
+class FakeDevice {
+public:
+    FakeDevice() {
+        for (const char *path : {"proc", "sys", "sys/devices", "sys/devices/system",
+                                 "sys/devices/system/cpu", "sys/class", "sys/class/thermal",
+                                 "sys/class/power_supply"}) {
+            mkdir(dir_.Join(path).c_str(), 0700);
+        }
+    }
+
+    void Memory(int64_t total_kb, int64_t available_kb) {
+        Write("proc/meminfo", "MemTotal:       " + std::to_string(total_kb) +
+                                      " kB\nMemFree:          123456 kB\nMemAvailable:   " +
+                                      std::to_string(available_kb) + " kB\nBuffers: 1 kB\n");
+    }
+    void PossibleCpus(const std::string &list) { Write("sys/devices/system/cpu/possible", list + "\n"); }
+    void ThermalZone(int index, const std::string &temp) {
+        const std::string zone = "sys/class/thermal/thermal_zone" + std::to_string(index);
+        mkdir(dir_.Join(zone).c_str(), 0700);
+        Write(zone + "/temp", temp + "\n");
+    }
+    void Battery(int capacity, const std::string &status) {
+        mkdir(dir_.Join("sys/class/power_supply/battery").c_str(), 0700);
+        Write("sys/class/power_supply/battery/type", "Battery\n");
+        Write("sys/class/power_supply/battery/capacity", std::to_string(capacity) + "\n");
+        Write("sys/class/power_supply/battery/status", status + "\n");
+    }
+    void Supply(const std::string &name, const std::string &type, int online) {
+        const std::string supply = "sys/class/power_supply/" + name;
+        mkdir(dir_.Join(supply).c_str(), 0700);
+        Write(supply + "/type", type + "\n");
+        Write(supply + "/online", std::to_string(online) + "\n");
+    }
+
+    DeviceState Read() const {
+        DeviceState state;
+        ReadDeviceState(&state, dir_.path());
+        return state;
+    }
+
+private:
+    void Write(const std::string &relative, const std::string &data) {
+        CHECK(WriteFile(dir_.Join(relative), data));
+    }
+
+    TempDir dir_;
+};
+
+ResourceProfile ProfileOf(const FakeDevice &device, int unmetered = -1, int thermal_status = -1) {
+    DeviceState state = device.Read();
+    state.unmetered = unmetered;
+    state.thermal_status = thermal_status;
+    return SelectProfile(state);
+}
+
+} // namespace
+
+TEST(EmptyTreeLeavesEverythingUnknown) {
+    FakeDevice device;
+    const DeviceState state = device.Read();
+    CHECK_EQ(state.mem_total_kb, -1);
+    CHECK_EQ(state.mem_available_kb, -1);
+    CHECK_EQ(state.cpu_cores, -1);
+    CHECK_EQ(state.thermal_millicelsius, -1);
+    CHECK_EQ(state.battery_percent, -1);
+    CHECK_EQ(state.charging, -1);
+    CHECK_EQ(SelectProfile(state), ResourceProfile::kBalanced);
+    // Falls back to the low end of supported devices.
+    const NodeTuning tuning = DeriveTuning(state);
+    CHECK_EQ(tuning.dbcache_mb, 3072 / 16);
+    CHECK_EQ(tuning.par, 2);
+}
+
+TEST(ReadsMemoryAndPossibleCores) {
+    FakeDevice device;
+    device.Memory(7864320, 2097152);
+    device.PossibleCpus("0-3,6-7");
+    const DeviceState state = device.Read();
+    CHECK_EQ(state.mem_total_kb, 7864320);
+    CHECK_EQ(state.mem_available_kb, 2097152);
+    CHECK_EQ(state.cpu_cores, 6);
+}
+
+TEST(HottestValidZoneWins) {
+    FakeDevice device;
+    device.ThermalZone(0, "41000");
+    device.ThermalZone(1, "52");       // whole degrees
+    device.ThermalZone(2, "0");        // disabled
+    device.ThermalZone(3, "-273000");  // sentinel
+    device.ThermalZone(4, "200000");   // implausible
+    CHECK_EQ(device.Read().thermal_millicelsius, 52000);
+}
+
+TEST(ThermalThreshold) {
+    FakeDevice cool;
+    cool.ThermalZone(0, "64999");
+    CHECK_EQ(ProfileOf(cool), ResourceProfile::kBalanced);
+    CHECK_EQ(ProfileOf(cool, 1, 1), ResourceProfile::kBalanced);
+    // The app's thermal status overrides the zones from MODERATE up.
+    CHECK_EQ(ProfileOf(cool, -1, 2), ResourceProfile::kThrottled);
+
+    FakeDevice hot;
+    hot.ThermalZone(0, "65000");
+    hot.Supply("ac", "Mains", 1);
+    // Hot beats charging on Wi-Fi.
+    CHECK_EQ(ProfileOf(hot, 1), ResourceProfile::kThrottled);
+
+    FakeDevice hot_degrees;
+    hot_degrees.ThermalZone(0, "65");
+    CHECK_EQ(ProfileOf(hot_degrees), ResourceProfile::kThrottled);
+}
+
+TEST(BatteryThreshold) {
+    FakeDevice above;
+    above.Battery(21, "Discharging");
+    CHECK_EQ(above.Read().charging, 0);
+    CHECK_EQ(ProfileOf(above), ResourceProfile::kBalanced);
+
+    FakeDevice low;
+    low.Battery(20, "Discharging");
+    CHECK_EQ(low.Read().battery_percent, 20);
+    CHECK_EQ(ProfileOf(low), ResourceProfile::kThrottled);
+
+    FakeDevice low_charging;
+    low_charging.Battery(5, "Charging");
+    CHECK_EQ(low_charging.Read().charging, 1);
+    CHECK_EQ(ProfileOf(low_charging), ResourceProfile::kBalanced);
+    CHECK_EQ(ProfileOf(low_charging, 1), ResourceProfile::kFull);
+}
+
+TEST(AnyOnlineSupplyMeansCharging) {
+    FakeDevice device;
+    device.Battery(50, "Discharging");
+    device.Supply("usb", "USB", 0);
+    device.Supply("wireless", "Wireless", 1);
+    CHECK_EQ(device.Read().charging, 1);
+    CHECK_EQ(ProfileOf(device, 1), ResourceProfile::kFull);
+    // Charging on a metered network stays balanced.
+    CHECK_EQ(ProfileOf(device, 0), ResourceProfile::kBalanced);
+
+    FakeDevice unplugged;
+    unplugged.Supply("ac", "Mains", 0);
+    CHECK_EQ(unplugged.Read().charging, 0);
+}
+
+TEST(TuningPerProfile) {
+    FakeDevice device;
+    device.Memory(8 * 1024 * 1024, 6 * 1024 * 1024);
+    device.PossibleCpus("0-7");
+    DeviceState state = device.Read();
+
+    state.charging = 1;
+    state.unmetered = 1;
+    NodeTuning tuning = DeriveTuning(state);
+    CHECK_EQ(tuning.profile, ResourceProfile::kFull);
+    CHECK_EQ(tuning.dbcache_mb, 1024);
+    CHECK_EQ(tuning.par, 8);
+    CHECK_EQ(tuning.max_connections, 24);
+    CHECK_EQ(tuning.max_mempool_mb, 128);
+
+    state.unmetered = 0;
+    tuning = DeriveTuning(state);
+    CHECK_EQ(tuning.profile, ResourceProfile::kBalanced);
+    CHECK_EQ(tuning.dbcache_mb, 512);
+    CHECK_EQ(tuning.par, 4);
+    CHECK_EQ(tuning.max_connections, 12);
+    CHECK_EQ(tuning.max_mempool_mb, 50);
+
+    state.thermal_millicelsius = 70000;
+    tuning = DeriveTuning(state);
+    CHECK_EQ(tuning.profile, ResourceProfile::kThrottled);
+    CHECK_EQ(tuning.dbcache_mb, 256);
+    CHECK_EQ(tuning.par, 1);
+    CHECK_EQ(tuning.max_connections, 8);
+    CHECK_EQ(tuning.max_mempool_mb, 20);
+}
+
+// dbcache never takes more than a third of the memory free right now, and
+// stays within its floor.
+TEST(DbcacheBoundedByAvailableMemory) {
+    FakeDevice device;
+    device.Memory(8 * 1024 * 1024, 600 * 1024);
+    DeviceState state = device.Read();
+    state.charging = 1;
+    state.unmetered = 1;
+    CHECK_EQ(DeriveTuning(state).dbcache_mb, 200);
+
+    device.Memory(8 * 1024 * 1024, 90 * 1024);
+    state = device.Read();
+    CHECK_EQ(DeriveTuning(state).dbcache_mb, 64);
+}
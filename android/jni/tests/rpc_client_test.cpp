@@ -0,0 +1,248 @@
+#include "rpc_client.h"
+
+#include <thread>
+
+#include "loopback_http_server.h"
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+using Server = LoopbackHttpServer;
+
+TEST(CallSendsJsonRpcWithBasicAuth) {
+    Server server([](const Server::Request &request) {
+        CHECK_EQ(request.request_line, std::string("POST / HTTP/1.1"));
+        // "user:pass"
+        CHECK(request.headers.find("authorization: basic dxnlcjpwyxnz") != std::string::npos);
+        CHECK(request.body.find("\"method\":\"getblockcount\"") != std::string::npos);
+        CHECK(request.body.find("\"params\":[]") != std::string::npos);
+        return Server::Response(200, "{\"result\":42,\"error\":null,\"id\":0}");
+    });
+    RpcClient client("127.0.0.1", server.port(), "user", "pass");
+    const RpcResponse response = client.Call("getblockcount");
+    CHECK(response.transport_ok);
+    CHECK_EQ(response.http_status, 200);
+    CHECK_EQ(response.body, std::string("{\"result\":42,\"error\":null,\"id\":0}"));
+}
+
+TEST(CallBatchSendsOneArray) {
+    Server server([](const Server::Request &request) {
+        CHECK_EQ(request.body.front(), '[');
+        CHECK(request.body.find("\"method\":\"getblockcount\"") != std::string::npos);
+        CHECK(request.body.find("\"method\":\"getblockhash\"") != std::string::npos);
+        CHECK(request.body.find("\"params\":[7]") != std::string::npos);
+        return Server::Response(200, "[{\"result\":1,\"id\":0},{\"result\":\"ab\",\"id\":1}]");
+    });
+    RpcClient client("127.0.0.1", server.port(), "user", "pass");
+    const RpcResponse response =
+            client.CallBatch({RpcRequest{"getblockcount", "[]"}, RpcRequest{"getblockhash", "[7]"}});
+    CHECK(response.transport_ok);
+    CHECK_EQ(server.requests(), 1);
+    CHECK_EQ(response.body, std::string("[{\"result\":1,\"id\":0},{\"result\":\"ab\",\"id\":1}]"));
+}
+
+TEST(CallStreamingHandsOverTheBody) {
+    const std::string body = "{\"result\":\"" + std::string(200000, 'x') + "\"}";
+    Server server([&](const Server::Request &) { return Server::Response(200, body); });
+    RpcClient client("127.0.0.1", server.port(), "user", "pass");
+    std::string streamed;
+    const RpcResponse response = client.CallStreaming("getblock", "[]", [&](const char *data, size_t size) {
+        streamed.append(data, size);
+        return true;
+    });
+    CHECK(response.transport_ok);
+    CHECK(response.body.empty());
+    CHECK_EQ(streamed, body);
+}
+
+TEST(ConnectionRefused) {
+    uint16_t port;
+    {
+        Server server([](const Server::Request &) { return Server::Reply(); });
+        port = server.port();
+    }
+    RpcClient client("127.0.0.1", port, "user", "pass");
+    client.SetTimeoutMs(2000);
+    const RpcResponse response = client.Call("getblockcount");
+    CHECK(!response.transport_ok);
+    CHECK(!response.error.empty());
+}
+
+TEST(KeepAliveReusesTheConnection) {
+    Server server([](const Server::Request &) { return Server::Response(200, "{\"result\":1}"); });
+    RpcClient client("127.0.0.1", server.port(), "user", "pass");
+    for (int i = 0; i < 3; ++i) {
+        CHECK(client.Call("getblockcount").transport_ok);
+    }
+    CHECK_EQ(server.connections(), 1);
+    CHECK_EQ(server.requests(), 3);
+}
+
+TEST(ConnectionCloseStartsAFreshConnection) {
+    Server server([](const Server::Request &request) {
+        Server::Reply reply = Server::Response(200, "{}", "Connection: close\r\n");
+        reply.close = request.index == 0;
+        return reply;
+    });
+    RpcClient client("127.0.0.1", server.port(), "user", "pass");
+    CHECK(client.Call("getblockcount").transport_ok);
+    CHECK(client.Call("getblockcount").transport_ok);
+    CHECK_EQ(server.connections(), 2);
+    CHECK_EQ(server.requests(), 2);
+}
+
+TEST(ChunkedBody) {
+    const std::string expected = "{\"result\":\"" + std::string(70000, 'c') + "\",\"id\":0}";
+    Server server([&](const Server::Request &) {
+        return Server::ChunkedResponse(
+                200, {expected.substr(0, 1), expected.substr(1, 65536), expected.substr(65537)});
+    });
+    RpcClient client("127.0.0.1", server.port(), "user", "pass");
+    RpcResponse response = client.Call("getblock");
+    CHECK(response.transport_ok);
+    CHECK_EQ(response.body, expected);
+    // The terminating chunk was consumed: the next reply parses on the same socket.
+    response = client.Call("getblock");
+    CHECK(response.transport_ok);
+    CHECK_EQ(response.body, expected);
+    CHECK_EQ(server.connections(), 1);
+
+    std::string streamed;
+    response = client.CallStreaming("getblock", "[]", [&](const char *data, size_t size) {
+        streamed.append(data, size);
+        return true;
+    });
+    CHECK(response.transport_ok);
+    CHECK_EQ(streamed, expected);
+}
+
+TEST(BodyDelimitedByClose) {
+    Server server([](const Server::Request &) {
+        Server::Reply reply;
+        reply.raw = "HTTP/1.0 200 OK\r\nContent-Type: application/json\r\n\r\n{\"result\":null}";
+        reply.close = true;
+        return reply;
+    });
+    RpcClient client("127.0.0.1", server.port(), "user", "pass");
+    const RpcResponse response = client.Call("stop");
+    CHECK(response.transport_ok);
+    CHECK_EQ(response.body, std::string("{\"result\":null}"));
+}
+
+// The node closed the idle keep-alive socket before the second call: nothing
+// came back, so the client sends the request again on a new connection.
+TEST(RetriesOnStaleSocket) {
+    Server server([](const Server::Request &request) {
+        if (request.index == 1) {
+            Server::Reply reply;
+            reply.close = true;
+            return reply;
+        }
+        return Server::Response(200, "{\"result\":" + std::to_string(request.index) + "}");
+    });
+    RpcClient client("127.0.0.1", server.port(), "user", "pass");
+    CHECK(client.Call("getblockcount").transport_ok);
+    const RpcResponse response = client.Call("getblockcount");
+    CHECK(response.transport_ok);
+    CHECK_EQ(response.body, std::string("{\"result\":2}"));
+    CHECK_EQ(server.connections(), 2);
+    CHECK_EQ(server.requests(), 3);
+}
+
+// Once part of a reply has arrived the request may have run; it is never
+// sent twice.
+TEST(NoRetryAfterPartialReply) {
+    Server server([](const Server::Request &request) {
+        if (request.index == 1) {
+            Server::Reply reply;
+            reply.raw = "HTTP/1.1 200 OK\r\nContent-Length: 100\r\n\r\n{\"res";
+            reply.close = true;
+            return reply;
+        }
+        return Server::Response(200, "{}");
+    });
+    RpcClient client("127.0.0.1", server.port(), "user", "pass");
+    CHECK(client.Call("getblockcount").transport_ok);
+    const RpcResponse response = client.Call("sendrawtransaction", "[\"00\"]");
+    CHECK(!response.transport_ok);
+    CHECK(!response.error.empty());
+    CHECK_EQ(server.requests(), 2);
+}
+
+// A fresh connection that fails is not a stale socket; no retry either.
+TEST(NoRetryOnFreshConnection) {
+    Server server([](const Server::Request &) {
+        Server::Reply reply;
+        reply.close = true;
+        return reply;
+    });
+    RpcClient client("127.0.0.1", server.port(), "user", "pass");
+    const RpcResponse response = client.Call("getblockcount");
+    CHECK(!response.transport_ok);
+    CHECK_EQ(response.error, std::string("connection closed by server"));
+    CHECK_EQ(server.requests(), 1);
+}
+
+// Wrong rpcauth: Core answers 401 without a body. That is a complete HTTP
+// exchange, and the connection stays usable.
+TEST(UnauthorizedWithoutBody) {
+    Server server([](const Server::Request &request) {
+        if (request.index == 0) {
+            return Server::Response(401, "", "WWW-Authenticate: Basic realm=\"jsonrpc\"\r\n");
+        }
+        return Server::Response(200, "{}");
+    });
+    RpcClient client("127.0.0.1", server.port(), "user", "wrong");
+    RpcResponse response = client.Call("getblockcount");
+    CHECK(response.transport_ok);
+    CHECK_EQ(response.http_status, 401);
+    CHECK(response.body.empty());
+    response = client.Call("getblockcount");
+    CHECK(response.transport_ok);
+    CHECK_EQ(response.http_status, 200);
+    CHECK_EQ(server.connections(), 1);
+}
+
+TEST(AbortUnblocksACallInProgress) {
+    Server server([](const Server::Request &request) {
+        Server::Reply reply;
+        if (request.index == 0) {
+            reply.stall = true;
+            return reply;
+        }
+        return Server::Response(200, "{}");
+    });
+    RpcClient client("127.0.0.1", server.port(), "user", "pass");
+    std::thread aborter([&] {
+        CHECK(server.WaitForRequests(1, 5000));
+        client.Abort();
+    });
+    const int64_t started = NowMicros();
+    RpcResponse response = client.Call("waitfornewblock");
+    aborter.join();
+    CHECK(!response.transport_ok);
+    CHECK_EQ(response.error, std::string("aborted"));
+    CHECK(NowMicros() - started < 5000000);
+    CHECK_EQ(server.requests(), 1);
+
+    // Stays aborted until re-armed, then works again.
+    response = client.Call("getblockcount");
+    CHECK_EQ(response.error, std::string("aborted"));
+    CHECK_EQ(server.requests(), 1);
+    client.ClearAbort();
+    response = client.Call("getblockcount");
+    CHECK(response.transport_ok);
+    CHECK_EQ(response.http_status, 200);
+}
+
+// An abort that lands before the call connects is not lost.
+TEST(AbortBeforeCall) {
+    Server server([](const Server::Request &) { return Server::Response(200, "{}"); });
+    RpcClient client("127.0.0.1", server.port(), "user", "pass");
+    client.Abort();
+    const RpcResponse response = client.Call("getblockcount");
+    CHECK(!response.transport_ok);
+    CHECK_EQ(response.error, std::string("aborted"));
+    CHECK_EQ(server.requests(), 0);
+}
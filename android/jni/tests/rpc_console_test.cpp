@@ -0,0 +1,318 @@
+#include "rpc_console.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "loopback_http_server.h"
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+using Server = LoopbackHttpServer;
+
+namespace {
+
+const char kBlockReply[] =
+        "{\"result\": {\"hash\": \"00ab\", \"confirmations\": 3, \"tx\": [\"aa\", \"bb\"], "
+        "\"empty\": [], \"none\": {}, \"note\": \"caf\\u00e9 \\\"q\\\" ,:{}[]\", "
+        "\"nested\": [{\"a\": null, \"b\": [true, false]}], \"pi\": -3.25e-2}, "
+        "\"error\": null, \"id\": 1}";
+
+// What digibyte-cli prints for kBlockReply.
+const char kBlockText[] =
+        "{\n"
+        "  \"hash\": \"00ab\",\n"
+        "  \"confirmations\": 3,\n"
+        "  \"tx\": [\n"
+        "    \"aa\",\n"
+        "    \"bb\"\n"
+        "  ],\n"
+        "  \"empty\": [],\n"
+        "  \"none\": {},\n"
+        "  \"note\": \"caf\\u00e9 \\\"q\\\" ,:{}[]\",\n"
+        "  \"nested\": [\n"
+        "    {\n"
+        "      \"a\": null,\n"
+        "      \"b\": [\n"
+        "        true,\n"
+        "        false\n"
+        "      ]\n"
+        "    }\n"
+        "  ],\n"
+        "  \"pi\": -3.25e-2\n"
+        "}";
+
+struct Rendered {
+    ConsoleResult result;
+    std::string text;
+    std::vector<std::string> chunks;
+};
+
+Rendered Render(const std::string &reply, ConsoleOptions options = ConsoleOptions()) {
+    Rendered rendered;
+    rendered.result = RpcConsole::Render(reply, options, [&](const std::string &chunk) {
+        rendered.chunks.push_back(chunk);
+        rendered.text += chunk;
+        return true;
+    });
+    return rendered;
+}
+
+// Whole UTF-8 characters only: no stray continuation byte, no lead byte
+// without all of its continuation bytes.
+bool IsWholeUtf8(const std::string &text) {
+    for (size_t i = 0; i < text.size();) {
+        const unsigned char byte = static_cast<unsigned char>(text[i]);
+        const size_t length = byte < 0x80 ? 1 : byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : byte >= 0xC0 ? 2 : 0;
+        if (length == 0 || i + length > text.size()) {
+            return false;
+        }
+        for (size_t j = 1; j < length; ++j) {
+            if ((static_cast<unsigned char>(text[i + j]) & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+        i += length;
+    }
+    return true;
+}
+
+std::string StringReply(const std::string &escaped) {
+    return "{\"result\":\"" + escaped + "\",\"error\":null,\"id\":1}";
+}
+
+} // namespace
+
+TEST(PrettyPrintsLikeDigibyteCli) {
+    const Rendered rendered = Render(kBlockReply);
+    CHECK_EQ(rendered.result.status, ConsoleStatus::kOk);
+    CHECK_EQ(rendered.text, std::string(kBlockText));
+    CHECK_EQ(rendered.result.output_bytes, static_cast<int64_t>(rendered.text.size()));
+    CHECK(!rendered.result.truncated);
+    ConsoleOptions options;
+    options.indent = 4;
+    CHECK_EQ(Render("{\"result\":[1],\"error\":null}", options).text, std::string("[\n    1\n]"));
+}
+
+// The printer keeps its state across pieces, so where the socket splits the
+// body never shows in the output.
+TEST(OutputDoesNotDependOnHowTheReplyIsSplit) {
+    const std::vector<std::string> replies = {
+            kBlockReply,
+            StringReply("line 1\\nline 2 \\ud83d\\ude00 \\u00e9\\t\\\"end\\\""),
+            "{\"result\":null,\"error\":{\"code\":-5,\"message\":\"No such \\\"block\\\"\"},\"id\":1}",
+            "{\"result\": 12345678901234, \"error\": null, \"id\": 1}",
+    };
+    for (const std::string &reply : replies) {
+        std::string whole;
+        RpcReplyPrinter whole_printer;
+        whole_printer.Feed(reply.data(), reply.size(), &whole);
+        for (size_t split = 0; split <= reply.size(); ++split) {
+            RpcReplyPrinter printer;
+            std::string text;
+            printer.Feed(reply.data(), split, &text);
+            printer.Feed(reply.data() + split, reply.size() - split, &text);
+            CHECK_EQ(text, whole);
+            CHECK_EQ(printer.has_error(), whole_printer.has_error());
+            CHECK_EQ(printer.error_message(), whole_printer.error_message());
+        }
+        RpcReplyPrinter printer;
+        std::string text;
+        for (size_t i = 0; i < reply.size(); ++i) {
+            printer.Feed(reply.data() + i, 1, &text);
+        }
+        CHECK_EQ(text, whole);
+        // And Render in pieces of every small size.
+        for (size_t chunk = 1; chunk <= 9; ++chunk) {
+            ConsoleOptions options;
+            options.chunk_bytes = chunk;
+            CHECK_EQ(Render(reply, options).text, whole);
+        }
+    }
+}
+
+TEST(ChunksNeverSplitACharacter) {
+    // Two-, three- and four-byte characters in a row, so every cut position
+    // lands inside one of them for some chunk size.
+    std::string escaped;
+    for (int i = 0; i < 50; ++i) {
+        escaped += "\\u00e9\\u20ac\\ud83d\\ude00x";
+    }
+    for (size_t chunk = 1; chunk <= 8; ++chunk) {
+        ConsoleOptions options;
+        options.chunk_bytes = chunk;
+        const Rendered rendered = Render(StringReply(escaped), options);
+        CHECK(rendered.chunks.size() > 1);
+        for (const std::string &piece : rendered.chunks) {
+            CHECK(IsWholeUtf8(piece));
+        }
+        CHECK(IsWholeUtf8(rendered.text));
+        CHECK_EQ(rendered.text.size(), static_cast<size_t>(50 * (2 + 3 + 4 + 1)));
+    }
+}
+
+TEST(OutputLimitStopsOnACharacterBoundary) {
+    std::string escaped;
+    for (int i = 0; i < 100; ++i) {
+        escaped += "\\u20ac";  // three bytes each
+    }
+    for (int64_t limit = 1; limit <= 12; ++limit) {
+        ConsoleOptions options;
+        options.max_output_bytes = limit;
+        options.chunk_bytes = 4;
+        const Rendered rendered = Render(StringReply(escaped), options);
+        CHECK_EQ(rendered.result.status, ConsoleStatus::kOk);
+        CHECK(rendered.result.truncated);
+        const int64_t kept = limit / 3 * 3;
+        CHECK_EQ(rendered.result.output_bytes, kept);
+        const std::string trailer = "\n[output truncated after " + std::to_string(kept) + " bytes]";
+        REQUIRE(rendered.text.size() >= trailer.size());
+        CHECK_EQ(rendered.text.substr(rendered.text.size() - trailer.size()), trailer);
+        CHECK(IsWholeUtf8(rendered.text));
+    }
+    // Exactly at the limit is not truncated.
+    ConsoleOptions options;
+    options.max_output_bytes = 300;
+    const Rendered rendered = Render(StringReply(escaped), options);
+    CHECK(!rendered.result.truncated);
+    CHECK_EQ(rendered.result.output_bytes, static_cast<int64_t>(300));
+}
+
+TEST(ScalarAndNullResults) {
+    CHECK_EQ(Render("{\"result\":null,\"error\":null,\"id\":1}").text, std::string());
+    CHECK_EQ(Render("{\"result\": 42 ,\"error\":null,\"id\":1}").text, std::string("42"));
+    CHECK_EQ(Render("{\"result\":true,\"error\":null,\"id\":1}").text, std::string("true"));
+    CHECK_EQ(Render("{\"id\":1,\"error\":null,\"result\":0.00012}").text, std::string("0.00012"));
+    // Strings print raw and unescaped, as digibyte-cli does.
+    CHECK_EQ(Render(StringReply("00ab")).text, std::string("00ab"));
+    CHECK_EQ(Render(StringReply("a\\nb\\\\c\\/d\\\"e")).text, std::string("a\nb\\c/d\"e"));
+    CHECK_EQ(Render(StringReply("\\ud83d\\ude00 \\uD83D\\uDE00")).text,
+             std::string("\xf0\x9f\x98\x80 \xf0\x9f\x98\x80"));
+    // Unpaired surrogates become U+FFFD.
+    CHECK_EQ(Render(StringReply("\\ud83dx")).text, std::string("\xef\xbf\xbdx"));
+    CHECK_EQ(Render(StringReply("\\ude00")).text, std::string("\xef\xbf\xbd"));
+    CHECK_EQ(Render(StringReply("\\ud83d")).text, std::string("\xef\xbf\xbd"));
+}
+
+TEST(ErrorObject) {
+    const Rendered rendered = Render(
+            "{\"result\":null,\"error\":{\"code\":-8,\"message\":\"Block height out of range\\n"
+            "(max \\u00e9)\"},\"id\":1}");
+    CHECK_EQ(rendered.result.status, ConsoleStatus::kRpcError);
+    CHECK_EQ(rendered.result.error,
+             std::string("error code: -8\nerror message:\nBlock height out of range\n(max \xc3\xa9)"));
+    CHECK(rendered.text.empty());
+    CHECK_EQ(Render("{\"result\":1,\"error\":   null,\"id\":1}").result.status, ConsoleStatus::kOk);
+}
+
+TEST(SinkCancels) {
+    ConsoleOptions options;
+    options.chunk_bytes = 8;
+    int calls = 0;
+    const ConsoleResult result = RpcConsole::Render(kBlockReply, options, [&](const std::string &) {
+        return ++calls < 2;
+    });
+    CHECK_EQ(result.status, ConsoleStatus::kCancelled);
+    CHECK_EQ(calls, 2);
+    // Refusing the last piece cancels too.
+    const ConsoleResult last = RpcConsole::Render(StringReply("short"), ConsoleOptions(),
+                                                  [](const std::string &) { return false; });
+    CHECK_EQ(last.status, ConsoleStatus::kCancelled);
+}
+
+TEST(ExecuteStreamsFromTheNode) {
+    const std::string reply = kBlockReply;
+    Server server([&](const Server::Request &request) {
+        CHECK(request.body.find("\"method\":\"getblock\"") != std::string::npos);
+        CHECK(request.body.find("\"params\":[\"00ab\",1]") != std::string::npos);
+        // Chunked and cut mid-token, as a large reply arrives.
+        return Server::ChunkedResponse(200, {reply.substr(0, 37), reply.substr(37, 50), reply.substr(87)});
+    });
+    RpcConsole console;
+    console.Configure("127.0.0.1", server.port(), "user", "pass");
+    std::string text;
+    const ConsoleResult result = console.Execute("getblock", "[\"00ab\",1]", ConsoleOptions(),
+                                                 [&](const std::string &chunk) {
+                                                     text += chunk;
+                                                     return true;
+                                                 });
+    CHECK_EQ(result.status, ConsoleStatus::kOk);
+    CHECK_EQ(text, std::string(kBlockText));
+
+    RpcConsole unconfigured;
+    CHECK_EQ(unconfigured.Execute("getblockcount", "[]", ConsoleOptions(),
+                                  [](const std::string &) { return true; })
+                     .status,
+             ConsoleStatus::kUnreachable);
+}
+
+// Cancel() from another thread ends a command stuck on a slow reply, and the
+// console takes the next command as usual.
+TEST(CancelFromAnotherThread) {
+    Server server([](const Server::Request &request) {
+        if (request.index == 0) {
+            Server::Reply reply;
+            reply.raw = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                        "c\r\n{\"result\":[1\r\n";
+            reply.stall = true;
+            return reply;
+        }
+        return Server::Response(200, "{\"result\":7,\"error\":null,\"id\":1}");
+    });
+    RpcConsole console;
+    console.Configure("127.0.0.1", server.port(), "user", "pass");
+    std::atomic<bool> got_output{false};
+    ConsoleResult result;
+    std::thread command([&] {
+        result = console.Execute("scantxoutset", "[]", ConsoleOptions(), [&](const std::string &) {
+            got_output = true;
+            return true;
+        });
+    });
+    REQUIRE(server.WaitForRequests(1, 5000));
+    usleep(100 * 1000);
+    const int64_t cancelled_at = NowMicros();
+    console.Cancel();
+    command.join();
+    CHECK(NowMicros() - cancelled_at < 2000 * 1000);
+    CHECK_EQ(result.status, ConsoleStatus::kCancelled);
+    CHECK_EQ(result.error, std::string("cancelled"));
+
+    std::string text;
+    const ConsoleResult next = console.Execute("getblockcount", "[]", ConsoleOptions(),
+                                               [&](const std::string &chunk) {
+                                                   text += chunk;
+                                                   return true;
+                                               });
+    CHECK_EQ(next.status, ConsoleStatus::kOk);
+    CHECK_EQ(text, std::string("7"));
+}
+
+TEST(UnreachableAndAuthFailures) {
+    Server server([](const Server::Request &) {
+        Server::Reply reply;
+        reply.raw = "HTTP/1.1 401 Unauthorized\r\nContent-Length: 0\r\n\r\n";
+        return reply;
+    });
+    RpcConsole console;
+    console.Configure("127.0.0.1", server.port(), "user", "wrong");
+    const ConsoleResult denied =
+            console.Execute("getblockcount", "[]", ConsoleOptions(), [](const std::string &) { return true; });
+    CHECK_EQ(denied.status, ConsoleStatus::kRpcError);
+    CHECK_EQ(denied.error, std::string("error: Authorization failed: Incorrect rpcuser or rpcpassword"));
+
+    uint16_t port;
+    {
+        Server closed([](const Server::Request &) { return Server::Reply(); });
+        port = closed.port();
+    }
+    console.Configure("127.0.0.1", port, "user", "pass");
+    const ConsoleResult refused =
+            console.Execute("getblockcount", "[]", ConsoleOptions(), [](const std::string &) { return true; });
+    CHECK_EQ(refused.status, ConsoleStatus::kUnreachable);
+    CHECK(refused.error.rfind("couldn't connect to server: ", 0) == 0);
+}
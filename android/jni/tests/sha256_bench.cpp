@@ -0,0 +1,50 @@
+#include "sha256.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+void Time(const char *label, sha256_internal::TransformFn transform, const std::string &data) {
+    uint32_t state[8] = {};
+    const int64_t started = NowMicros();
+    transform(state, reinterpret_cast<const unsigned char *>(data.data()), data.size() / 64);
+    ReportThroughput(label, static_cast<int64_t>(data.size()), NowMicros() - started);
+}
+
+} // namespace
+
+// The portable transform against the one Sha256 dispatches to on this CPU,
+// then the whole Sha256File path (reads included) over the same bytes. Set
+// DIGIMOBILE_BENCH_MB for the size.
+TEST(HashThroughput) {
+    const std::string data = PseudoRandomBytes(static_cast<size_t>(BenchBytes(64)), 1);
+    fprintf(stderr, "  dispatch: %s\n", Sha256::Implementation());
+
+    Time("scalar transform", sha256_internal::TransformScalar, data);
+#if defined(__x86_64__)
+    if (strcmp(Sha256::Implementation(), "x86-shani") == 0) {
+        Time("SHA-NI transform", sha256_internal::TransformShaNi, data);
+    }
+#endif
+#if defined(__aarch64__)
+    if (strcmp(Sha256::Implementation(), "armv8-sha2") == 0) {
+        Time("ARMv8 SHA2 transform", sha256_internal::TransformArmv8, data);
+    }
+#endif
+
+    TempDir dir;
+    REQUIRE(WriteFile(dir.Join("blob"), data));
+    std::string hex;
+    std::string error;
+    const int64_t started = NowMicros();
+    REQUIRE(Sha256File(dir.Join("blob"), &hex, &error));
+    ReportThroughput("Sha256File (page cache)", static_cast<int64_t>(data.size()),
+                     NowMicros() - started);
+    CHECK_EQ(hex.size(), static_cast<size_t>(64));
+}
@@ -0,0 +1,121 @@
+#include "sha256.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+std::string Hash(const std::string &data) {
+    Sha256 hasher;
+    hasher.Update(data.data(), data.size());
+    return hasher.FinishHex();
+}
+
+const uint32_t kInitialState[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                   0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+// Run transform over blocks in one call and compare with the scalar path.
+void CheckTransformMatchesScalar(sha256_internal::TransformFn transform) {
+    for (size_t count : {size_t(1), size_t(2), size_t(7), size_t(64)}) {
+        const std::string blocks = PseudoRandomBytes(count * 64, static_cast<uint32_t>(count));
+        uint32_t expected[8];
+        uint32_t actual[8];
+        memcpy(expected, kInitialState, sizeof(expected));
+        memcpy(actual, kInitialState, sizeof(actual));
+        sha256_internal::TransformScalar(
+                expected, reinterpret_cast<const unsigned char *>(blocks.data()), count);
+        transform(actual, reinterpret_cast<const unsigned char *>(blocks.data()), count);
+        CHECK(memcmp(expected, actual, sizeof(expected)) == 0);
+    }
+}
+
+} // namespace
+
+// FIPS 180-2 appendix B vectors, through whichever transform the CPU picked.
+TEST(KnownVectors) {
+    CHECK_EQ(Hash(""), std::string("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+    CHECK_EQ(Hash("abc"),
+             std::string("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+    CHECK_EQ(Hash("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+             std::string("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"));
+    CHECK_EQ(Hash(std::string(1000000, 'a')),
+             std::string("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"));
+}
+
+TEST(IncrementalUpdatesMatchOneShot) {
+    const std::string data = PseudoRandomBytes(10000, 7);
+    const std::string expected = Hash(data);
+    // Split points around the 64-byte block boundary and the buffered tail.
+    for (size_t step : {size_t(1), size_t(3), size_t(63), size_t(64), size_t(65), size_t(4096)}) {
+        Sha256 hasher;
+        for (size_t offset = 0; offset < data.size(); offset += step) {
+            hasher.Update(data.data() + offset, std::min(step, data.size() - offset));
+        }
+        CHECK_EQ(hasher.FinishHex(), expected);
+    }
+    // Finish resets the hasher for reuse.
+    Sha256 hasher;
+    hasher.Update("x", 1);
+    hasher.FinishHex();
+    CHECK_EQ(hasher.FinishHex(), Hash(""));
+}
+
+TEST(ScalarTransformMatchesVectors) {
+    // "abc" padded to one block by hand.
+    unsigned char block[64] = {'a', 'b', 'c', 0x80};
+    block[63] = 24;
+    uint32_t state[8];
+    memcpy(state, kInitialState, sizeof(state));
+    sha256_internal::TransformScalar(state, block, 1);
+    unsigned char digest[32];
+    for (int i = 0; i < 8; ++i) {
+        digest[4 * i] = static_cast<unsigned char>(state[i] >> 24);
+        digest[4 * i + 1] = static_cast<unsigned char>(state[i] >> 16);
+        digest[4 * i + 2] = static_cast<unsigned char>(state[i] >> 8);
+        digest[4 * i + 3] = static_cast<unsigned char>(state[i]);
+    }
+    CHECK_EQ(HexDigest(digest, sizeof(digest)),
+             std::string("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+}
+
+TEST(ShaNiTransformMatchesScalar) {
+#if defined(__x86_64__)
+    if (strcmp(Sha256::Implementation(), "x86-shani") != 0) {
+        Skip("CPU has no SHA-NI");
+        return;
+    }
+    CheckTransformMatchesScalar(sha256_internal::TransformShaNi);
+#else
+    Skip("not an x86_64 build");
+#endif
+}
+
+TEST(Armv8TransformMatchesScalar) {
+#if defined(__aarch64__)
+    if (strcmp(Sha256::Implementation(), "armv8-sha2") != 0) {
+        Skip("CPU has no SHA2 extension");
+        return;
+    }
+    CheckTransformMatchesScalar(sha256_internal::TransformArmv8);
+#else
+    Skip("not an aarch64 build");
+#endif
+}
+
+TEST(FileHashMatchesBuffer) {
+    TempDir dir;
+    const std::string data = PseudoRandomBytes(3 * 1024 * 1024 + 17, 3);
+    REQUIRE(WriteFile(dir.Join("blob"), data));
+    std::string hex;
+    std::string error;
+    CHECK(Sha256File(dir.Join("blob"), &hex, &error));
+    CHECK_EQ(hex, Hash(data));
+    CHECK(!Sha256File(dir.Join("missing"), &hex, &error));
+    CHECK(!error.empty());
+}
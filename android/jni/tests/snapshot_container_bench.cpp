@@ -0,0 +1,68 @@
+#include "snapshot_container.h"
+
+#include <sys/stat.h>
+
+#include <thread>
+
+#include "container_packer.h"
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+// Applying a complete container: block files (stored chunks, a plain copy)
+// and chainstate (deflated chunks), with one inflate worker and with one per
+// core. Set DIGIMOBILE_BENCH_MB for a realistic size.
+TEST(ApplyThroughput) {
+    if (getenv("MAKE_SNAPSHOT_CONTAINER") == nullptr) {
+        Skip("MAKE_SNAPSHOT_CONTAINER not set; run through ctest");
+        return;
+    }
+    const int64_t total = BenchBytes(64);
+    TempDir dir;
+    for (const char *path : {"datadir", "datadir/chainstate", "datadir/blocks"}) {
+        mkdir(dir.Join(path).c_str(), 0700);
+    }
+    // Chainstate compresses roughly 2:1; block files barely at all.
+    const int64_t file_size = 16 << 20;
+    int64_t written = 0;
+    for (int i = 0; written < total; ++i) {
+        const int64_t size = std::min(file_size, total - written);
+        std::string data = PseudoRandomBytes(static_cast<size_t>(size), static_cast<uint32_t>(i));
+        std::string path;
+        if (i % 2 == 0) {
+            path = dir.Join("datadir/blocks/blk" + std::to_string(10000 + i).substr(1) + ".dat");
+        } else {
+            for (size_t j = 0; j < data.size(); j += 2) {
+                data[j] = 'x';
+            }
+            path = dir.Join("datadir/chainstate/" + std::to_string(100000 + i).substr(1) + ".ldb");
+        }
+        REQUIRE(WriteFile(path, data));
+        written += size;
+    }
+    const std::string container = dir.Join("snapshot.dgbsnap");
+    const std::string digest = PackContainer(dir.Join("datadir"), container);
+    REQUIRE(digest.size() == 64);
+    struct stat info {};
+    REQUIRE(stat(container.c_str(), &info) == 0);
+
+    const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int threads : {1, cores}) {
+        const std::string out = dir.Join("out" + std::to_string(threads));
+        const int64_t started = NowMicros();
+        ContainerApplier applier(container, out, digest);
+        applier.MarkAvailable(0, static_cast<uint64_t>(info.st_size));
+        std::string error;
+        while (!applier.complete()) {
+            REQUIRE(applier.ApplyAvailable(0, threads, &error));
+        }
+        REQUIRE(applier.Finish(&error));
+        ReportThroughput("apply, " + std::to_string(threads) + " thread(s)",
+                         static_cast<int64_t>(applier.total_bytes()), NowMicros() - started);
+        RemoveTree(out);
+        if (cores == 1) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,244 @@
+#include "snapshot_container.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "container_packer.h"
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+struct Fixture {
+    TempDir dir;
+    std::vector<std::pair<std::string, std::string>> files;  // relative path, content
+    std::string container;
+    std::string digest;
+
+    // A small datadir: compressible LevelDB-like files, incompressible block
+    // files spanning several chunks, an empty file and a lock file.
+    bool Pack(const std::string &options = "--chunk-size 65536") {
+        for (const char *path : {"datadir", "datadir/chainstate", "datadir/blocks",
+                                 "datadir/blocks/index"}) {
+            mkdir(dir.Join(path).c_str(), 0700);
+        }
+        files = {
+                {"chainstate/000005.ldb", std::string(200000, 'c') + PseudoRandomBytes(1000, 1)},
+                {"chainstate/CURRENT", "MANIFEST-000004\n"},
+                {"chainstate/LOG", ""},
+                {"blocks/blk00000.dat", PseudoRandomBytes(1000000, 2)},
+                {"blocks/rev00000.dat", PseudoRandomBytes(65536, 3)},
+                {"blocks/index/000003.ldb", PseudoRandomBytes(70000, 4)},
+        };
+        for (const auto &file : files) {
+            if (!WriteFile(dir.Join("datadir/" + file.first), file.second)) {
+                return false;
+            }
+        }
+        WriteFile(dir.Join("datadir/chainstate/LOCK"), "");
+        container = dir.Join("snapshot.dgbsnap");
+        digest = PackContainer(dir.Join("datadir"), container, options);
+        return digest.size() == 64;
+    }
+
+    ContainerIndex Index() const {
+        const std::string data = ReadFile(container);
+        uint32_t size = 0;
+        memcpy(&size, data.data() + sizeof(kContainerMagic), 4);
+        ContainerIndex index;
+        std::string error;
+        CHECK(ParseContainerIndex(
+                reinterpret_cast<const unsigned char *>(data.data()) + kContainerPreambleSize, size,
+                &index, &error));
+        return index;
+    }
+
+    void CheckApplied(const std::string &dest) const {
+        for (const auto &file : files) {
+            CHECK_EQ(ReadFile(dest + "/" + file.first), file.second);
+        }
+        CHECK(!PathExists(dest + "/chainstate/LOCK"));
+    }
+};
+
+bool PackerMissing() {
+    if (getenv("MAKE_SNAPSHOT_CONTAINER") == nullptr) {
+        Skip("MAKE_SNAPSHOT_CONTAINER not set; run through ctest");
+        return true;
+    }
+    return false;
+}
+
+// Apply a container that is already complete.
+bool ApplyAll(ContainerApplier *applier, uint64_t size, std::string *error) {
+    applier->MarkAvailable(0, size);
+    for (int i = 0; i < 100 && !applier->complete(); ++i) {
+        if (!applier->ApplyAvailable(0, 4, error)) {
+            return false;
+        }
+    }
+    return applier->Finish(error);
+}
+
+void FlipByte(const std::string &path, uint64_t offset) {
+    const int fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+    unsigned char byte = 0;
+    CHECK(pread(fd, &byte, 1, static_cast<off_t>(offset)) == 1);
+    byte ^= 0x01;
+    CHECK(pwrite(fd, &byte, 1, static_cast<off_t>(offset)) == 1);
+    close(fd);
+}
+
+} // namespace
+
+TEST(RoundTrip) {
+    Fixture fixture;
+    if (PackerMissing()) {
+        return;
+    }
+    REQUIRE(fixture.Pack());
+    const ContainerIndex index = fixture.Index();
+    CHECK_EQ(index.files.size(), fixture.files.size());
+    // Both compressed and stored chunks are exercised.
+    bool deflated = false;
+    bool stored = false;
+    for (const ContainerChunk &chunk : index.chunks) {
+        deflated |= chunk.compression == ChunkCompression::kDeflate;
+        stored |= chunk.compression == ChunkCompression::kStored;
+    }
+    CHECK(deflated);
+    CHECK(stored);
+
+    ContainerApplier applier(fixture.container, fixture.dir.Join("out"), fixture.digest);
+    std::string error;
+    REQUIRE(ApplyAll(&applier, ReadFile(fixture.container).size(), &error));
+    CHECK_EQ(error, std::string());
+    CHECK_EQ(applier.applied_bytes(), applier.total_bytes());
+    fixture.CheckApplied(fixture.dir.Join("out"));
+}
+
+// Byte ranges arrive out of order, the way a multi-connection download
+// delivers them; chunks are applied as soon as all their bytes are present.
+TEST(AppliesRangesAsTheyArrive) {
+    Fixture fixture;
+    if (PackerMissing()) {
+        return;
+    }
+    REQUIRE(fixture.Pack());
+    const uint64_t size = ReadFile(fixture.container).size();
+    const uint64_t range = 48 * 1024;
+    std::vector<uint64_t> starts;
+    for (uint64_t offset = 0; offset < size; offset += range) {
+        starts.push_back(offset);
+    }
+    // Last range first, then alternating from both ends.
+    std::vector<uint64_t> order;
+    for (size_t lo = 0, hi = starts.size(); lo < hi;) {
+        order.push_back(starts[--hi]);
+        if (lo < hi) {
+            order.push_back(starts[lo++]);
+        }
+    }
+
+    ContainerApplier applier(fixture.container, fixture.dir.Join("out"), fixture.digest);
+    std::string error;
+    uint64_t last_applied = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        applier.MarkAvailable(order[i], std::min(range, size - order[i]));
+        REQUIRE(applier.ApplyAvailable(0, 2, &error));
+        CHECK(applier.applied_bytes() >= last_applied);
+        last_applied = applier.applied_bytes();
+        if (i + 1 < order.size()) {
+            CHECK(!applier.complete());
+        }
+    }
+    CHECK(applier.complete());
+    REQUIRE(applier.Finish(&error));
+    fixture.CheckApplied(fixture.dir.Join("out"));
+}
+
+TEST(CorruptedChunkIsRejected) {
+    Fixture fixture;
+    if (PackerMissing()) {
+        return;
+    }
+    REQUIRE(fixture.Pack());
+    const ContainerIndex index = fixture.Index();
+    const size_t victim = index.chunks.size() / 2;
+    FlipByte(fixture.container, index.chunks[victim].offset + index.chunks[victim].stored_size / 2);
+
+    ContainerApplier applier(fixture.container, fixture.dir.Join("out"), fixture.digest);
+    std::string error;
+    CHECK(!ApplyAll(&applier, ReadFile(fixture.container).size(), &error));
+    CHECK_EQ(error, "chunk " + std::to_string(victim) + " checksum mismatch");
+    // Sticky: nothing is applied after the failure.
+    std::string again;
+    CHECK(!applier.ApplyAvailable(0, 1, &again));
+    CHECK_EQ(again, error);
+    CHECK(!applier.complete());
+    CHECK(!applier.Finish(&again));
+}
+
+TEST(IndexIsPinned) {
+    Fixture fixture;
+    if (PackerMissing()) {
+        return;
+    }
+    REQUIRE(fixture.Pack());
+    const uint64_t size = ReadFile(fixture.container).size();
+    std::string error;
+
+    // Another snapshot than the one the app pinned.
+    {
+        std::string other = fixture.digest;
+        other[0] = other[0] == '0' ? '1' : '0';
+        ContainerApplier applier(fixture.container, fixture.dir.Join("out1"), other);
+        CHECK(!ApplyAll(&applier, size, &error));
+        CHECK(error.find("unexpected snapshot") == 0);
+    }
+    // The index itself was altered.
+    FlipByte(fixture.container, kContainerPreambleSize + 2);
+    {
+        ContainerApplier applier(fixture.container, fixture.dir.Join("out2"), fixture.digest);
+        CHECK(!ApplyAll(&applier, size, &error));
+        CHECK_EQ(error, std::string("index checksum mismatch"));
+    }
+    // Not a container at all.
+    FlipByte(fixture.container, 0);
+    {
+        ContainerApplier applier(fixture.container, fixture.dir.Join("out3"), fixture.digest);
+        CHECK(!ApplyAll(&applier, size, &error));
+        CHECK_EQ(error, std::string("not a snapshot container"));
+    }
+}
+
+TEST(IndexRejectsUnsafePaths) {
+    for (const char *path : {"../escape", "/absolute", "chainstate/../../escape", ""}) {
+        ContainerIndex index;
+        index.files.push_back(ContainerFile{path, 0600, 0});
+        const std::string bytes = SerializeContainerIndex(index);
+        ContainerIndex parsed;
+        std::string error;
+        CHECK(!ParseContainerIndex(reinterpret_cast<const unsigned char *>(bytes.data()),
+                                   bytes.size(), &parsed, &error));
+        CHECK(!error.empty());
+    }
+    ContainerIndex index;
+    index.files.push_back(ContainerFile{"chainstate/CURRENT", 0600, 0});
+    const std::string bytes = SerializeContainerIndex(index);
+    ContainerIndex parsed;
+    std::string error;
+    CHECK(ParseContainerIndex(reinterpret_cast<const unsigned char *>(bytes.data()), bytes.size(),
+                              &parsed, &error));
+    CHECK_EQ(parsed.files.size(), static_cast<size_t>(1));
+    // A truncated index is rejected, not read past its end.
+    CHECK(!ParseContainerIndex(reinterpret_cast<const unsigned char *>(bytes.data()),
+                               bytes.size() - 1, &parsed, &error));
+}
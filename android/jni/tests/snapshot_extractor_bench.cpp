@@ -0,0 +1,106 @@
+#include "snapshot_extractor.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <vector>
+
+#include "tar_builder.h"
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+// The single-threaded path ExtractTarGz replaced: gzread into a small
+// buffer, parse ustar headers and write each file in turn. Plain names only.
+bool ExtractSerially(const std::string &archive, const std::string &dest, int64_t *written) {
+    gzFile in = gzopen(archive.c_str(), "rb");
+    if (in == nullptr) {
+        return false;
+    }
+    gzbuffer(in, 64 * 1024);
+    mkdir(dest.c_str(), 0700);
+    std::vector<char> buffer(8 * 1024);
+    char header[512];
+    bool ok = true;
+    while (ok && gzread(in, header, sizeof(header)) == static_cast<int>(sizeof(header))) {
+        if (header[0] == '\0') {
+            break;
+        }
+        const std::string name(header, strnlen(header, 100));
+        int64_t size = strtoll(std::string(header + 124, 12).c_str(), nullptr, 8);
+        const int64_t padded = (size + 511) / 512 * 512;
+        int out = -1;
+        if (header[156] == '5') {
+            mkdir((dest + "/" + name).c_str(), 0700);
+        } else {
+            out = open((dest + "/" + name).c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0600);
+            ok = out >= 0;
+        }
+        for (int64_t left = padded; ok && left > 0;) {
+            const int want = static_cast<int>(std::min<int64_t>(left, buffer.size()));
+            ok = gzread(in, buffer.data(), static_cast<unsigned>(want)) == want;
+            const int64_t payload = std::min<int64_t>(size, want);
+            if (ok && out >= 0 && payload > 0) {
+                ok = write(out, buffer.data(), static_cast<size_t>(payload)) == payload;
+                *written += payload;
+            }
+            size -= payload;
+            left -= want;
+        }
+        if (out >= 0) {
+            ok = fsync(out) == 0 && close(out) == 0 && ok;
+        }
+    }
+    gzclose(in);
+    return ok;
+}
+
+} // namespace
+
+// A snapshot-shaped archive: LevelDB tables that deflate well and block files
+// that barely do. Set DIGIMOBILE_BENCH_MB for a realistic size.
+TEST(ExtractThroughput) {
+    const int64_t total = BenchBytes(64);
+    TarBuilder tar;
+    tar.AddDirectory("chainstate/");
+    tar.AddDirectory("blocks/");
+    int64_t payload = 0;
+    for (int i = 0; payload < total; ++i) {
+        const bool table = i % 2 == 1;
+        const size_t size = static_cast<size_t>(std::min<int64_t>(table ? 2 << 20 : 16 << 20,
+                                                                  total - payload));
+        std::string data = PseudoRandomBytes(size, static_cast<uint32_t>(i));
+        if (table) {
+            for (size_t j = 0; j < data.size(); j += 2) {
+                data[j] = 'x';
+            }
+        }
+        const std::string number = std::to_string(100000 + i).substr(1);
+        tar.AddFile(table ? "chainstate/" + number + ".ldb" : "blocks/blk" + number + ".dat", data);
+        payload += static_cast<int64_t>(size);
+    }
+    TempDir dir;
+    REQUIRE(WriteFile(dir.Join("snapshot.tar.gz"), Gzip(tar.Finish())));
+
+    int64_t written = 0;
+    int64_t started = NowMicros();
+    REQUIRE(ExtractSerially(dir.Join("snapshot.tar.gz"), dir.Join("serial"), &written));
+    ReportThroughput("single thread, gzread", written, NowMicros() - started);
+    CHECK_EQ(written, payload);
+    RemoveTree(dir.Join("serial"));
+
+    ExtractStats stats;
+    std::string error;
+    started = NowMicros();
+    REQUIRE(ExtractTarGz(dir.Join("snapshot.tar.gz"), dir.Join("out"), ExtractOptions(), nullptr,
+                         &stats, &error));
+    ReportThroughput("ExtractTarGz pipeline", stats.bytes_written, NowMicros() - started);
+    CHECK_EQ(stats.bytes_written, payload);
+}
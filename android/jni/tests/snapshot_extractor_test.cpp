@@ -0,0 +1,251 @@
+#include "snapshot_extractor.h"
+
+#include <sys/stat.h>
+
+#include <vector>
+
+#include "sha256.h"
+#include "tar_builder.h"
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+std::string Sha256Hex(const std::string &data) {
+    Sha256 hasher;
+    hasher.Update(data.data(), data.size());
+    return hasher.FinishHex();
+}
+
+} // namespace
+
+// Every entry shape a snapshot archive uses comes back out byte for byte.
+TEST(RoundTrip) {
+    const std::string long_name =
+            "chainstate/" + std::string(120, 'n') + "/000123.ldb";
+    const std::string small = "MANIFEST-000001";
+    const std::string large = PseudoRandomBytes(5 * 1024 * 1024 + 3, 1);
+    const std::string pax = PseudoRandomBytes(70000, 2);
+
+    TarBuilder tar;
+    tar.AddDirectory("blocks/");
+    tar.AddFile("blocks/blk00000.dat", large);
+    tar.AddFile("chainstate/MANIFEST", small);
+    tar.AddFile("empty", "");
+    tar.AddFileLongName(long_name, small);
+    tar.AddFilePaxPath("indexes/" + std::string(150, 'p'), pax);
+    tar.AddSymlink("link", "blocks/blk00000.dat");
+    const std::string gz = Gzip(tar.Finish());
+
+    TempDir dir;
+    REQUIRE(WriteFile(dir.Join("snapshot.tar.gz"), gz));
+    ExtractOptions options;
+    options.chunk_size = 64 * 1024;
+    options.queue_depth = 2;
+    options.expected_sha256 = Sha256Hex(gz);
+    ExtractStats stats;
+    std::string error;
+    int64_t last_done = -1;
+    int64_t last_total = -1;
+    const bool ok = ExtractTarGz(dir.Join("snapshot.tar.gz"), dir.Join("out"), options,
+                                 [&](int64_t done, int64_t total) {
+                                     CHECK(done >= last_done);
+                                     last_done = done;
+                                     last_total = total;
+                                     return true;
+                                 },
+                                 &stats, &error);
+    REQUIRE(ok);
+    CHECK_EQ(error, std::string());
+    CHECK_EQ(last_total, static_cast<int64_t>(gz.size()));
+    CHECK_EQ(last_done, last_total);
+
+    CHECK_EQ(ReadFile(dir.Join("out/blocks/blk00000.dat")), large);
+    CHECK_EQ(ReadFile(dir.Join("out/chainstate/MANIFEST")), small);
+    CHECK(PathExists(dir.Join("out/empty")));
+    CHECK_EQ(ReadFile(dir.Join("out/" + long_name)), small);
+    CHECK_EQ(ReadFile(dir.Join("out/indexes/" + std::string(150, 'p'))), pax);
+    CHECK(!PathExists(dir.Join("out/placeholder")));
+    CHECK(!PathExists(dir.Join("out/link")));
+
+    CHECK_EQ(stats.files, 5);
+    CHECK_EQ(stats.directories, 1);
+    CHECK_EQ(stats.skipped, 1);
+    CHECK_EQ(stats.bytes_written,
+             static_cast<int64_t>(large.size() + 2 * small.size() + pax.size()));
+    CHECK_EQ(stats.sha256, Sha256Hex(gz));
+}
+
+// pigz and split uploads produce several gzip members back to back.
+TEST(MultiMemberGzip) {
+    TarBuilder tar;
+    tar.AddFile("a", PseudoRandomBytes(300000, 3));
+    tar.AddFile("b", PseudoRandomBytes(1000, 4));
+    const std::string stream = tar.Finish();
+    const size_t split = 512 * 3;
+    const std::string gz = Gzip(stream.substr(0, split)) + Gzip(stream.substr(split), 1);
+
+    TempDir dir;
+    REQUIRE(WriteFile(dir.Join("in.tar.gz"), gz));
+    ExtractStats stats;
+    std::string error;
+    REQUIRE(ExtractTarGz(dir.Join("in.tar.gz"), dir.Join("out"), ExtractOptions(), nullptr,
+                         &stats, &error));
+    CHECK_EQ(ReadFile(dir.Join("out/a")), PseudoRandomBytes(300000, 3));
+    CHECK_EQ(ReadFile(dir.Join("out/b")), PseudoRandomBytes(1000, 4));
+    CHECK_EQ(stats.files, 2);
+}
+
+namespace {
+
+struct Extraction {
+    TempDir dir;
+    ExtractStats stats;
+    std::string error;
+
+    bool Run(const std::string &gz, const ExtractOptions &options = ExtractOptions(),
+             const ExtractProgress &progress = nullptr) {
+        if (!WriteFile(dir.Join("in.tar.gz"), gz)) {
+            error = "write archive";
+            return false;
+        }
+        return ExtractTarGz(dir.Join("in.tar.gz"), dir.Join("out"), options, progress, &stats,
+                            &error);
+    }
+    std::string Out(const std::string &relative) const { return dir.Join("out/" + relative); }
+};
+
+} // namespace
+
+// Snapshot tarballs wrap the datadir in a top-level directory.
+TEST(StripComponents) {
+    TarBuilder tar;
+    tar.AddDirectory("digibyte-snapshot/");
+    tar.AddDirectory("digibyte-snapshot/chainstate/");
+    tar.AddFile("digibyte-snapshot/chainstate/CURRENT", "MANIFEST-000002\n");
+    tar.AddFile("./digibyte-snapshot/blocks/blk00000.dat", PseudoRandomBytes(2000, 5));
+    tar.AddFile("stray", "dropped");
+
+    ExtractOptions options;
+    options.strip_components = 1;
+    Extraction run;
+    REQUIRE(run.Run(Gzip(tar.Finish()), options));
+    CHECK_EQ(ReadFile(run.Out("chainstate/CURRENT")), std::string("MANIFEST-000002\n"));
+    CHECK_EQ(ReadFile(run.Out("blocks/blk00000.dat")), PseudoRandomBytes(2000, 5));
+    CHECK(!PathExists(run.Out("digibyte-snapshot")));
+    CHECK(!PathExists(run.Out("stray")));
+    CHECK_EQ(run.stats.files, 2);
+    CHECK_EQ(run.stats.directories, 1);
+}
+
+TEST(RejectsPathsOutsideTheDestination) {
+    for (const char *name : {"../escape", "chainstate/../../escape", "a/b/../../../escape"}) {
+        TarBuilder tar;
+        tar.AddFile("chainstate/CURRENT", "x");
+        tar.AddFile(name, "payload");
+        Extraction run;
+        CHECK(!run.Run(Gzip(tar.Finish())));
+        CHECK_EQ(run.error, "unsafe path in archive: " + std::string(name));
+        CHECK(!PathExists(run.dir.Join("escape")));
+    }
+    // Leading '/' is dropped, as tar does, so absolute names stay inside.
+    TarBuilder tar;
+    tar.AddFile("/abs/file", "inside");
+    Extraction run;
+    REQUIRE(run.Run(Gzip(tar.Finish())));
+    CHECK_EQ(ReadFile(run.Out("abs/file")), std::string("inside"));
+}
+
+TEST(TruncatedAndCorruptArchives) {
+    TarBuilder tar;
+    tar.AddFile("blocks/blk00000.dat", PseudoRandomBytes(400000, 6));
+    tar.AddFile("chainstate/CURRENT", "MANIFEST-000002\n");
+    const std::string stream = tar.Finish();
+    const std::string gz = Gzip(stream);
+
+    {
+        Extraction run;
+        CHECK(!run.Run(gz.substr(0, gz.size() / 2)));
+        CHECK_EQ(run.error, std::string("truncated gzip stream"));
+    }
+    {
+        // A complete gzip member around an incomplete tar stream.
+        Extraction run;
+        CHECK(!run.Run(Gzip(stream.substr(0, 512 + 100000))));
+        CHECK_EQ(run.error, std::string("truncated tar stream"));
+    }
+    {
+        std::string corrupt = gz;
+        for (size_t i = gz.size() / 3; i < gz.size() / 3 + 64; ++i) {
+            corrupt[i] = static_cast<char>(~corrupt[i]);
+        }
+        Extraction run;
+        CHECK(!run.Run(corrupt));
+        CHECK(run.error.rfind("corrupt gzip stream", 0) == 0);
+    }
+    {
+        Extraction run;
+        CHECK(!run.Run(std::string()));
+        CHECK_EQ(run.error, std::string("archive is empty"));
+    }
+    {
+        Extraction run;
+        CHECK(!run.Run(stream));  // not gzip at all
+        CHECK(run.error.rfind("corrupt gzip stream", 0) == 0);
+    }
+}
+
+TEST(ChecksumMismatchFails) {
+    TarBuilder tar;
+    tar.AddFile("chainstate/CURRENT", "MANIFEST-000002\n");
+    const std::string gz = Gzip(tar.Finish());
+    ExtractOptions options;
+    options.expected_sha256 = Sha256Hex("something else");
+    Extraction run;
+    CHECK(!run.Run(gz, options));
+    CHECK(run.error.rfind("checksum mismatch: expected " + options.expected_sha256, 0) == 0);
+    CHECK(run.error.find(Sha256Hex(gz)) != std::string::npos);
+}
+
+// Returning false from progress stops all three pipeline threads promptly.
+TEST(CancelFromProgress) {
+    TarBuilder tar;
+    for (int i = 0; i < 40; ++i) {
+        tar.AddFile("blocks/blk" + std::to_string(10000 + i) + ".dat",
+                    PseudoRandomBytes(256 * 1024, static_cast<uint32_t>(i)));
+    }
+    ExtractOptions options;
+    options.chunk_size = 64 * 1024;
+    options.queue_depth = 1;
+    int calls = 0;
+    Extraction run;
+    CHECK(!run.Run(Gzip(tar.Finish(), 1), options, [&](int64_t, int64_t) { return ++calls < 3; }));
+    CHECK_EQ(run.error, std::string("cancelled"));
+    CHECK_EQ(calls, 3);
+    CHECK(run.stats.files < 40);
+}
+
+// The smallest buffers and queues, many tiny files and entries straddling
+// every buffer boundary.
+TEST(SmallBuffersAndManyFiles) {
+    TarBuilder tar;
+    std::vector<std::string> contents;
+    for (int i = 0; i < 600; ++i) {
+        contents.push_back(PseudoRandomBytes(static_cast<size_t>(i * 97 % 3000), static_cast<uint32_t>(i)));
+        tar.AddFile("chainstate/" + std::to_string(i) + ".ldb", contents.back());
+    }
+    tar.AddFile("blocks/blk00000.dat", PseudoRandomBytes(1 << 20, 7));
+    ExtractOptions options;
+    options.chunk_size = 1;  // raised to the 64 KiB minimum
+    options.queue_depth = 0;
+    options.fsync_batch = 0;
+    Extraction run;
+    REQUIRE(run.Run(Gzip(tar.Finish()), options));
+    for (int i = 0; i < 600; ++i) {
+        CHECK_EQ(ReadFile(run.Out("chainstate/" + std::to_string(i) + ".ldb")), contents[i]);
+    }
+    CHECK_EQ(ReadFile(run.Out("blocks/blk00000.dat")), PseudoRandomBytes(1 << 20, 7));
+    CHECK_EQ(run.stats.files, 601);
+}
@@ -0,0 +1,355 @@
+#include "storage_budget.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "io_throttle.h"
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+constexpr int64_t kMiB = 1 << 20;
+
+StorageState State(int64_t total_mb, int64_t free_mb, int64_t blocks_mb) {
+    StorageState state;
+    state.total_bytes = total_mb * kMiB;
+    state.free_bytes = free_mb * kMiB;
+    state.blocks_bytes = blocks_mb * kMiB;
+    return state;
+}
+
+bool Allocate(const std::string &path, int64_t bytes) {
+    const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = posix_fallocate(fd, 0, bytes) == 0;
+    close(fd);
+    return ok;
+}
+
+bool WriteIdMap(const char *file, const std::string &map) {
+    const int fd = open(file, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = write(fd, map.data(), map.size()) == static_cast<ssize_t>(map.size());
+    close(fd);
+    return ok;
+}
+
+// Mount a tmpfs of size_mb on dir, privately: in a new mount namespace, and
+// in a new user namespace as well when not running as root.
+bool MountPrivateTmpfs(const std::string &dir, int size_mb) {
+    if (unshare(CLONE_NEWNS) != 0) {
+        const uid_t uid = getuid();
+        const gid_t gid = getgid();
+        if (unshare(CLONE_NEWUSER | CLONE_NEWNS) != 0 ||
+            !WriteIdMap("/proc/self/setgroups", "deny") ||
+            !WriteIdMap("/proc/self/uid_map", "0 " + std::to_string(uid) + " 1") ||
+            !WriteIdMap("/proc/self/gid_map", "0 " + std::to_string(gid) + " 1")) {
+            return false;
+        }
+    }
+    mount("none", "/", nullptr, MS_REC | MS_PRIVATE, nullptr);
+    const std::string options = "size=" + std::to_string(size_mb) + "m";
+    return mount("tmpfs", dir.c_str(), "tmpfs", 0, options.c_str()) == 0;
+}
+
+} // namespace
+
+TEST(PruneTargetLeavesPruningAloneWhenUnknown) {
+    PrunePolicy policy;
+    CHECK_EQ(ChoosePruneTargetMb(policy, State(64000, 32000, 0)), 0);
+    policy.max_target_mb = 4000;
+    CHECK_EQ(ChoosePruneTargetMb(policy, StorageState()), 0);
+    StorageState no_total = State(0, 32000, 0);
+    CHECK_EQ(ChoosePruneTargetMb(policy, no_total), 0);
+}
+
+TEST(PruneTargetThresholds) {
+    PrunePolicy policy;
+    policy.max_target_mb = 4000;
+    policy.reserve_bytes = 1024 * kMiB;
+    policy.reserve_percent = 10;
+
+    // Roomy: the user's setting.
+    CHECK_EQ(ChoosePruneTargetMb(policy, State(64000, 32000, 0)), 4000);
+    // Reserve is 10% of 64000 MiB: 6400 + 4000 fits exactly, one less does not.
+    CHECK_EQ(ChoosePruneTargetMb(policy, State(64000, 10400, 0)), 4000);
+    CHECK_EQ(ChoosePruneTargetMb(policy, State(64000, 10399, 0)), 3999);
+    // Block files already on disk count as usable.
+    CHECK_EQ(ChoosePruneTargetMb(policy, State(64000, 6400, 3000)), 3000);
+    CHECK_EQ(ChoosePruneTargetMb(policy, State(64000, 8000, 1000)), 2600);
+    // On a small device the fixed reserve is the larger one.
+    CHECK_EQ(ChoosePruneTargetMb(policy, State(8000, 2000, 0)), 976);
+    // Never below what digibyted accepts, even when nothing fits.
+    CHECK_EQ(ChoosePruneTargetMb(policy, State(8000, 1500, 0)), kMinPruneTargetMb);
+    CHECK_EQ(ChoosePruneTargetMb(policy, State(8000, 0, 0)), kMinPruneTargetMb);
+    // A user setting below the floor is raised to it.
+    policy.max_target_mb = 100;
+    CHECK_EQ(ChoosePruneTargetMb(policy, State(64000, 32000, 0)), kMinPruneTargetMb);
+}
+
+// Against a real filesystem whose size is known: a private tmpfs.
+TEST(PruneTargetOnTmpfs) {
+    TempDir dir;
+    const pid_t child = fork();
+    if (child == 0) {
+        if (!MountPrivateTmpfs(dir.path(), 900)) {
+            _exit(77);
+        }
+        const std::string data_dir = dir.Join("digibyte");
+        mkdir(data_dir.c_str(), 0700);
+        mkdir((data_dir + "/blocks").c_str(), 0700);
+        mkdir((data_dir + "/testnet4").c_str(), 0700);
+        mkdir((data_dir + "/testnet4/blocks").c_str(), 0700);
+        CHECK(Allocate(data_dir + "/blocks/blk00000.dat", 32 * kMiB));
+        CHECK(Allocate(data_dir + "/blocks/rev00000.dat", 8 * kMiB));
+        CHECK(Allocate(data_dir + "/testnet4/blocks/blk00000.dat", 8 * kMiB));
+        CHECK(Allocate(data_dir + "/blocks/index.ldb", 4 * kMiB));  // not a block file
+
+        StorageState state;
+        CHECK(ReadStorageState(data_dir, &state));
+        CHECK_EQ(state.total_bytes, 900 * kMiB);
+        CHECK_EQ(state.blocks_bytes, 48 * kMiB);
+        CHECK_EQ(state.free_bytes, (900 - 52) * kMiB);
+
+        PrunePolicy policy;
+        policy.max_target_mb = 4000;
+        policy.reserve_bytes = 64 * kMiB;
+        policy.reserve_percent = 10;
+        // 48 MiB of block files + 848 free - 90 reserve.
+        CHECK_EQ(ChoosePruneTargetMb(policy, state), 806);
+
+        // Other data shrinks the target by its size ...
+        CHECK(Allocate(data_dir + "/chainstate.ldb", 128 * kMiB));
+        CHECK(ReadStorageState(data_dir, &state));
+        CHECK_EQ(ChoosePruneTargetMb(policy, state), 678);
+        // ... more block files do not: pruning can reuse their space.
+        CHECK(Allocate(data_dir + "/blocks/blk00001.dat", 64 * kMiB));
+        CHECK(ReadStorageState(data_dir, &state));
+        CHECK_EQ(ChoosePruneTargetMb(policy, state), 678);
+        _exit(FailureCount() == 0 ? 0 : 1);
+    }
+    int status = 0;
+    REQUIRE(waitpid(child, &status, 0) == child);
+    REQUIRE(WIFEXITED(status));
+    if (WEXITSTATUS(status) == 77) {
+        Skip("cannot mount a private tmpfs here");
+        return;
+    }
+    CHECK_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST(DiskCountersFromDiskstats) {
+    TempDir dir;
+    struct stat info {};
+    REQUIRE(stat(dir.path().c_str(), &info) == 0);
+    mkdir(dir.Join("proc").c_str(), 0700);
+    char line[256];
+    snprintf(line, sizeof(line),
+             "   7       0 loop0 5 0 10 1 0 0 0 0 0 1 1 0 0 0 0\n"
+             " %4u %7u dev 1200 30 9600 450 800 20 6400 550 0 900 1000 0 0 0 0\n",
+             major(info.st_dev), minor(info.st_dev));
+    REQUIRE(WriteFile(dir.Join("proc/diskstats"), line));
+    DiskCounters disk;
+    REQUIRE(ReadDiskCounters(dir.path(), &disk, dir.Join("proc")));
+    CHECK_EQ(disk.requests, 2000);
+    CHECK_EQ(disk.busy_ms, 1000);
+
+    REQUIRE(WriteFile(dir.Join("proc/diskstats"), "   7       0 loop0 5 0 10 1 0 0 0 0 0 1 1\n"));
+    CHECK(!ReadDiskCounters(dir.path(), &disk, dir.Join("proc")));
+}
+
+TEST(TokenBucketPacesToItsRate) {
+    TokenBucket bucket;
+    CHECK_EQ(bucket.Consume(1 << 30, 0), 0);  // disabled
+    bucket.SetRate(10 * kMiB, 0);
+    // One second of burst, then pauses to pay back the debt.
+    CHECK_EQ(bucket.Consume(10 * kMiB, 0), 0);
+    CHECK_EQ(bucket.Consume(5 * kMiB, 0), 500);
+    CHECK_EQ(bucket.Consume(0, 500), 0);
+    // Debt beyond two seconds is forgiven.
+    CHECK_EQ(bucket.Consume(100 * kMiB, 500), 2000);
+}
+
+namespace {
+
+// A daemon writing at daemon_rate whenever it is not paused. Its writes land
+// in the page cache and are written back at the device's capacity; latency of
+// everyone else's requests rises with how busy writeback keeps the device.
+// Mirrors the supervisor loop: a pause is taken, then the next sample
+// follows right away.
+struct SyntheticDevice {
+    int64_t daemon_rate;
+    int64_t capacity;
+    int64_t now_ms = 0;
+    int64_t written = 0;
+    int64_t dirty = 0;
+    DiskCounters disk{0, 0};
+    int64_t window_bytes = 0;
+    int64_t window_ms = 0;
+    int slow_samples = 0;
+
+    int Step(IoThrottle *throttle, int interval_ms) {
+        const int pause = throttle->Update(now_ms, written, disk);
+        int64_t bytes = 0;
+        int64_t elapsed = interval_ms;
+        if (pause > 0) {
+            throttle->NotePause(pause);
+            elapsed = pause;
+        } else {
+            bytes = daemon_rate * interval_ms / 1000;
+        }
+        const double can_drain = static_cast<double>(capacity) * elapsed / 1000.0;
+        const double drained = std::min(static_cast<double>(dirty + bytes), can_drain);
+        dirty += bytes - static_cast<int64_t>(drained);
+        const double busy = can_drain > 0 ? drained / can_drain : 1.0;
+        const int64_t latency_ms = 5 + static_cast<int64_t>(60 * busy * busy);
+        slow_samples += latency_ms > 40 ? 1 : 0;
+        now_ms += elapsed;
+        written += bytes;
+        // Foreground requests at a steady 400 per second.
+        disk.requests += elapsed * 400 / 1000;
+        disk.busy_ms += elapsed * 400 / 1000 * latency_ms;
+        window_bytes += bytes;
+        window_ms += elapsed;
+        return pause;
+    }
+
+    void ResetWindow() {
+        window_bytes = 0;
+        window_ms = 0;
+        slow_samples = 0;
+    }
+    int64_t window_rate() const { return window_ms > 0 ? window_bytes * 1000 / window_ms : 0; }
+};
+
+} // namespace
+
+// Additive increase, multiplicative decrease: a daemon writing several times
+// faster than the device keeps up with settles below the device's capacity,
+// with the limit probing around it, whatever the capacity is.
+TEST(ThrottleConvergesOnDeviceCapacity) {
+    IoThrottlePolicy policy;
+    policy.enabled = true;
+    policy.latency_threshold_ms = 40;
+    policy.min_write_bytes_per_s = 1 * kMiB;
+    for (int64_t capacity_mb : {8, 16, 24}) {
+        SyntheticDevice device{40 * kMiB, capacity_mb * kMiB};
+        IoThrottle throttle(policy);
+        for (int i = 0; i < 200; ++i) {
+            device.Step(&throttle, policy.sample_interval_ms);
+        }
+        device.ResetWindow();
+        int64_t max_limit = 0;
+        int64_t min_limit = INT64_MAX;
+        for (int i = 0; i < 400; ++i) {
+            device.Step(&throttle, policy.sample_interval_ms);
+            const int64_t limit = throttle.stats().rate_bytes_per_s;
+            max_limit = std::max(max_limit, limit);
+            min_limit = std::min(min_limit, limit);
+        }
+        const int64_t rate = device.window_rate();
+        fprintf(stderr, "  %lld MiB/s device: settled at %lld KiB/s (limit %lld..%lld KiB/s)\n",
+                static_cast<long long>(capacity_mb), static_cast<long long>(rate >> 10),
+                static_cast<long long>(min_limit >> 10), static_cast<long long>(max_limit >> 10));
+        CHECK(rate >= device.capacity / 2);
+        CHECK(rate <= device.capacity);
+        // Neither collapsing to the floor nor letting the daemon run free.
+        CHECK(min_limit >= device.capacity / 4);
+        CHECK(max_limit <= device.capacity * 5 / 4);
+        CHECK(throttle.stats().pauses > 0);
+    }
+}
+
+TEST(ThrottleReleasesOnceTheDeviceIsFast) {
+    IoThrottlePolicy policy;
+    policy.enabled = true;
+    SyntheticDevice device{40 * kMiB, 8 * kMiB};
+    IoThrottle throttle(policy);
+    for (int i = 0; i < 100; ++i) {
+        device.Step(&throttle, policy.sample_interval_ms);
+    }
+    CHECK(throttle.stats().rate_bytes_per_s > 0);
+    // The device catches up (e.g. the foreground app went idle).
+    device.capacity = 1ll << 40;
+    for (int i = 0; i < 100; ++i) {
+        device.Step(&throttle, policy.sample_interval_ms);
+    }
+    CHECK_EQ(throttle.stats().rate_bytes_per_s, 0);
+    device.ResetWindow();
+    for (int i = 0; i < 20; ++i) {
+        CHECK_EQ(device.Step(&throttle, policy.sample_interval_ms), 0);
+    }
+    CHECK_EQ(device.window_rate(), device.daemon_rate);
+}
+
+TEST(ThrottleHoldsTheCeilingAndFloor) {
+    IoThrottlePolicy policy;
+    policy.enabled = true;
+    policy.max_write_bytes_per_s = 4 * kMiB;
+    policy.min_write_bytes_per_s = 2 * kMiB;
+    SyntheticDevice device{12 * kMiB, 1ll << 40};
+    IoThrottle throttle(policy);
+    for (int i = 0; i < 200; ++i) {
+        device.Step(&throttle, policy.sample_interval_ms);
+        CHECK(throttle.stats().rate_bytes_per_s <= policy.max_write_bytes_per_s);
+    }
+    device.ResetWindow();
+    for (int i = 0; i < 200; ++i) {
+        device.Step(&throttle, policy.sample_interval_ms);
+    }
+    CHECK(device.window_rate() <= policy.max_write_bytes_per_s * 21 / 20);
+    CHECK(device.window_rate() >= policy.max_write_bytes_per_s * 9 / 10);
+
+    // A device that is always slow cuts the rate to the floor, not below.
+    device.capacity = 0;
+    for (int i = 0; i < 100; ++i) {
+        device.Step(&throttle, policy.sample_interval_ms);
+    }
+    CHECK_EQ(throttle.stats().rate_bytes_per_s, policy.min_write_bytes_per_s);
+    device.ResetWindow();
+    for (int i = 0; i < 200; ++i) {
+        device.Step(&throttle, policy.sample_interval_ms);
+    }
+    CHECK(device.window_rate() >= policy.min_write_bytes_per_s * 9 / 10);
+    CHECK(device.window_rate() <= policy.min_write_bytes_per_s * 21 / 20);
+}
+
+// A daemon that writes more in one sample than the longest pause pays for
+// runs over the limit: the excess debt is forgiven rather than stopping it
+// long enough to miss peer timeouts.
+TEST(ThrottlePausesStayBounded) {
+    IoThrottlePolicy policy;
+    policy.enabled = true;
+    policy.max_write_bytes_per_s = 4 * kMiB;
+    policy.max_pause_ms = 2000;
+    SyntheticDevice device{40 * kMiB, 1ll << 40};
+    IoThrottle throttle(policy);
+    for (int i = 0; i < 200; ++i) {
+        CHECK(device.Step(&throttle, policy.sample_interval_ms) <= policy.max_pause_ms);
+    }
+    device.ResetWindow();
+    for (int i = 0; i < 200; ++i) {
+        device.Step(&throttle, policy.sample_interval_ms);
+    }
+    // 10 MiB per 250 ms sample, then at most a 2 s pause.
+    const int64_t bound = device.daemon_rate / 4 * 1000 / (policy.sample_interval_ms + policy.max_pause_ms);
+    CHECK(device.window_rate() > policy.max_write_bytes_per_s);
+    CHECK(device.window_rate() <= bound * 21 / 20);
+}
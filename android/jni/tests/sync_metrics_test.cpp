@@ -0,0 +1,275 @@
+#include "sync_metrics.h"
+
+#include <deque>
+#include <mutex>
+
+#include "loopback_http_server.h"
+#include "rpc_client.h"
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+using Server = LoopbackHttpServer;
+
+namespace {
+
+struct Chain {
+    int64_t blocks = 100;
+    int64_t headers = 1000;
+    double progress = 0.5;
+    int64_t peers = 8;
+    int64_t mempool_tx = 3;
+    int64_t recv = 0;
+    int64_t sent = 0;
+};
+
+// A batch reply in the order and shape digibyted sends it, with the entries
+// shuffled so the poller has to go by id.
+std::string BatchReply(const Chain &chain) {
+    return "[{\"result\":{\"connections\":" + std::to_string(chain.peers) +
+           ",\"connections_in\":2,\"localservices\":\"0000000000000409\"},\"error\":null,\"id\":1},"
+           "{\"result\":{\"chain\":\"main\",\"blocks\":" + std::to_string(chain.blocks) +
+           ",\"headers\":" + std::to_string(chain.headers) +
+           ",\"bestblockhash\":\"00ab\",\"verificationprogress\":" + std::to_string(chain.progress) +
+           ",\"initialblockdownload\":true,\"softforks\":{\"csv\":{\"active\":true}},"
+           "\"warnings\":\"\"},\"error\":null,\"id\":0},"
+           "{\"result\":{\"loaded\":true,\"size\":" + std::to_string(chain.mempool_tx) +
+           ",\"bytes\":4096},\"error\":null,\"id\":2},"
+           "{\"result\":{\"totalbytesrecv\":" + std::to_string(chain.recv) +
+           ",\"totalbytessent\":" + std::to_string(chain.sent) +
+           ",\"timemillis\":1700000000000},\"error\":null,\"id\":3}]";
+}
+
+// digibyted on 127.0.0.1 answering each batch with the next scripted reply.
+class FakeNode {
+public:
+    FakeNode()
+        : server_([this](const Server::Request &request) {
+              std::lock_guard<std::mutex> lock(mutex_);
+              last_request_ = request.body;
+              std::string body = replies_.empty() ? std::string("[]") : replies_.front();
+              if (!replies_.empty()) {
+                  replies_.pop_front();
+              }
+              return Server::Response(status_, body);
+          }),
+          client_("127.0.0.1", server_.port(), "user", "pass") {}
+
+    void Reply(const std::string &body, int status = 200) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        replies_.push_back(body);
+        status_ = status;
+    }
+    std::string last_request() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_request_;
+    }
+
+    // The same call the JNI bridge hands to Poll().
+    SyncPollStatus Poll(SyncMetricsPoller *poller, int64_t now_ms, std::string *error) {
+        const auto call = [this](const std::vector<RpcRequest> &requests, std::string *body) {
+            RpcResponse response = client_.CallBatch(requests);
+            if (!response.transport_ok || response.body.empty()) {
+                return false;
+            }
+            *body = std::move(response.body);
+            return true;
+        };
+        return poller->Poll(call, now_ms, error);
+    }
+    SyncPollStatus Poll(SyncMetricsPoller *poller, int64_t now_ms, const Chain &chain) {
+        Reply(BatchReply(chain));
+        std::string error;
+        return Poll(poller, now_ms, &error);
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<std::string> replies_;
+    int status_ = 200;
+    std::string last_request_;
+    Server server_;
+    RpcClient client_;
+};
+
+} // namespace
+
+TEST(ReadsOneBatch) {
+    FakeNode node;
+    SyncMetricsPoller poller;
+    Chain chain;
+    CHECK_EQ(node.Poll(&poller, 1000, chain), SyncPollStatus::kChanged);
+    const std::string request = node.last_request();
+    for (const char *method : {"getblockchaininfo", "getnetworkinfo", "getmempoolinfo", "getnettotals"}) {
+        CHECK(request.find(std::string("\"method\":\"") + method + "\"") != std::string::npos);
+    }
+    const SyncMetrics &metrics = poller.metrics();
+    CHECK_EQ(metrics.blocks, static_cast<int64_t>(100));
+    CHECK_EQ(metrics.headers, static_cast<int64_t>(1000));
+    CHECK_EQ(metrics.verification_progress, 0.5);
+    CHECK_EQ(metrics.initial_block_download, 1);
+    CHECK_EQ(metrics.peers, static_cast<int64_t>(8));
+    CHECK_EQ(metrics.peers_inbound, static_cast<int64_t>(2));
+    CHECK_EQ(metrics.mempool_tx, static_cast<int64_t>(3));
+    CHECK_EQ(metrics.mempool_bytes, static_cast<int64_t>(4096));
+    CHECK_EQ(metrics.blocks_per_s, -1.0);
+    CHECK_EQ(metrics.eta_s, static_cast<int64_t>(-1));
+
+    // 90 blocks in 3 s: 30 blocks/s, 810 headers to go.
+    chain.blocks = 190;
+    CHECK_EQ(node.Poll(&poller, 4000, chain), SyncPollStatus::kChanged);
+    CHECK_EQ(poller.metrics().blocks_per_s, 30.0);
+    CHECK_EQ(poller.metrics().eta_s, static_cast<int64_t>(27));
+
+    // At the tip.
+    chain.blocks = chain.headers;
+    CHECK_EQ(node.Poll(&poller, 5000, chain), SyncPollStatus::kChanged);
+    CHECK_EQ(poller.metrics().eta_s, static_cast<int64_t>(0));
+}
+
+TEST(WholeBatchError) {
+    FakeNode node;
+    SyncMetricsPoller poller;
+    node.Reply("{\"result\":null,\"error\":{\"code\":-32600,\"message\":\"Invalid Request object\"},"
+               "\"id\":null}",
+               500);
+    std::string error;
+    CHECK_EQ(node.Poll(&poller, 1000, &error), SyncPollStatus::kRpcError);
+    CHECK_EQ(error, std::string("error code: -32600\nerror message:\nInvalid Request object"));
+
+    node.Reply("<html>Bad Gateway</html>", 502);
+    CHECK_EQ(node.Poll(&poller, 2000, &error), SyncPollStatus::kUnreachable);
+    CHECK_EQ(error, std::string("Malformed batch reply"));
+}
+
+// While the node warms up getblockchaininfo fails with -28 and the app shows
+// the message; the other calls answering does not make it a usable poll.
+TEST(WarmUp) {
+    FakeNode node;
+    SyncMetricsPoller poller;
+    node.Reply("[{\"result\":null,\"error\":{\"code\":-28,\"message\":\"Loading block index\\u2026\"},"
+               "\"id\":0},{\"result\":{\"connections\":0},\"error\":null,\"id\":1}]");
+    std::string error;
+    CHECK_EQ(node.Poll(&poller, 1000, &error), SyncPollStatus::kRpcError);
+    CHECK_EQ(error, std::string("error code: -28\nerror message:\nLoading block index\xe2\x80\xa6"));
+
+    node.Reply("[{\"result\":{\"connections\":0},\"error\":null,\"id\":1}]");
+    CHECK_EQ(node.Poll(&poller, 2000, &error), SyncPollStatus::kUnreachable);
+    CHECK_EQ(error, std::string("Missing getblockchaininfo reply"));
+
+    // Optional calls failing leave only their own fields unknown.
+    node.Reply("[{\"result\":{\"blocks\":5,\"headers\":9},\"error\":null,\"id\":0},"
+               "{\"result\":null,\"error\":{\"code\":-1,\"message\":\"x\"},\"id\":3}]");
+    CHECK_EQ(node.Poll(&poller, 3000, &error), SyncPollStatus::kChanged);
+    CHECK_EQ(poller.metrics().blocks, static_cast<int64_t>(5));
+    CHECK_EQ(poller.metrics().bytes_recv, static_cast<int64_t>(-1));
+    CHECK_EQ(poller.metrics().peers, static_cast<int64_t>(-1));
+}
+
+TEST(Unreachable) {
+    uint16_t port;
+    {
+        Server server([](const Server::Request &) { return Server::Reply(); });
+        port = server.port();
+    }
+    RpcClient client("127.0.0.1", port, "user", "pass");
+    client.SetTimeoutMs(2000);
+    SyncMetricsPoller poller;
+    std::string error;
+    const auto call = [&client](const std::vector<RpcRequest> &requests, std::string *body) {
+        RpcResponse response = client.CallBatch(requests);
+        *body = response.body;
+        return response.transport_ok;
+    };
+    CHECK_EQ(poller.Poll(call, 1000, &error), SyncPollStatus::kUnreachable);
+    CHECK_EQ(error, std::string("RPC batch failed"));
+}
+
+// getnettotals restarts from zero when the node does; that is an unknown
+// rate, never a negative one.
+TEST(CounterResetGivesNoNegativeRate) {
+    FakeNode node;
+    SyncMetricsPoller poller;
+    Chain chain;
+    chain.recv = 50000;
+    chain.sent = 20000;
+    node.Poll(&poller, 1000, chain);
+    chain.recv = 60000;
+    chain.sent = 21000;
+    node.Poll(&poller, 2000, chain);
+    CHECK_EQ(poller.metrics().recv_bytes_per_s, 10000.0);
+    CHECK_EQ(poller.metrics().sent_bytes_per_s, 1000.0);
+
+    chain.recv = 300;
+    chain.sent = 100;
+    CHECK_EQ(node.Poll(&poller, 3000, chain), SyncPollStatus::kChanged);
+    CHECK_EQ(poller.metrics().recv_bytes_per_s, -1.0);
+    CHECK_EQ(poller.metrics().sent_bytes_per_s, -1.0);
+
+    chain.recv = 2300;
+    chain.sent = 600;
+    node.Poll(&poller, 4000, chain);
+    CHECK_EQ(poller.metrics().recv_bytes_per_s, 2000.0);
+    CHECK_EQ(poller.metrics().sent_bytes_per_s, 500.0);
+}
+
+// Rates have to move by more than 10% and verification progress by more than
+// 1e-4 of the last reported poll before a poll counts as a change.
+TEST(ChangeThresholds) {
+    FakeNode node;
+    SyncMetricsPoller poller;
+    Chain chain;
+    CHECK_EQ(node.Poll(&poller, 0, chain), SyncPollStatus::kChanged);
+    CHECK_EQ(node.Poll(&poller, 1000, chain), SyncPollStatus::kChanged);  // rates now known
+    CHECK_EQ(node.Poll(&poller, 2000, chain), SyncPollStatus::kUnchanged);
+
+    // 1000 B/s reported...
+    chain.recv += 1000;
+    CHECK_EQ(node.Poll(&poller, 3000, chain), SyncPollStatus::kChanged);
+    // ...then 1090 B/s and 1000 B/s again: within 10%.
+    chain.recv += 1090;
+    CHECK_EQ(node.Poll(&poller, 4000, chain), SyncPollStatus::kUnchanged);
+    CHECK_EQ(poller.metrics().recv_bytes_per_s, 1090.0);
+    chain.recv += 1000;
+    CHECK_EQ(node.Poll(&poller, 5000, chain), SyncPollStatus::kUnchanged);
+    // 1200 B/s is 20% above the reported 1000.
+    chain.recv += 1200;
+    CHECK_EQ(node.Poll(&poller, 6000, chain), SyncPollStatus::kChanged);
+    // Byte totals and mempool bytes moving alone are no change.
+    chain.recv += 1200;
+    CHECK_EQ(node.Poll(&poller, 7000, chain), SyncPollStatus::kUnchanged);
+
+    chain.progress = 0.50005;
+    chain.recv += 1200;
+    CHECK_EQ(node.Poll(&poller, 8000, chain), SyncPollStatus::kUnchanged);
+    chain.progress = 0.50009;
+    chain.recv += 1200;
+    CHECK_EQ(node.Poll(&poller, 9000, chain), SyncPollStatus::kUnchanged);
+    chain.progress = 0.5002;
+    chain.recv += 1200;
+    CHECK_EQ(node.Poll(&poller, 10000, chain), SyncPollStatus::kChanged);
+    CHECK_EQ(poller.metrics().verification_progress, 0.5002);
+
+    // Counts change on any difference.
+    chain.peers = 9;
+    chain.recv += 1200;
+    CHECK_EQ(node.Poll(&poller, 11000, chain), SyncPollStatus::kChanged);
+    chain.mempool_tx = 4;
+    chain.recv += 1200;
+    CHECK_EQ(node.Poll(&poller, 12000, chain), SyncPollStatus::kChanged);
+}
+
+TEST(ResetForgetsThePreviousPoll) {
+    FakeNode node;
+    SyncMetricsPoller poller;
+    Chain chain;
+    node.Poll(&poller, 0, chain);
+    chain.blocks += 10;
+    node.Poll(&poller, 1000, chain);
+    CHECK_EQ(poller.metrics().blocks_per_s, 10.0);
+    poller.Reset();
+    CHECK_EQ(poller.metrics().blocks, static_cast<int64_t>(-1));
+    CHECK_EQ(node.Poll(&poller, 2000, chain), SyncPollStatus::kChanged);
+    CHECK_EQ(poller.metrics().blocks_per_s, -1.0);
+}
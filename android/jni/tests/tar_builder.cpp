@@ -0,0 +1,96 @@
+#include "tar_builder.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+
+namespace digimobile {
+namespace test {
+namespace {
+
+constexpr size_t kBlock = 512;
+
+void PutOctal(char *field, size_t length, unsigned long long value) {
+    snprintf(field, length, "%0*llo", static_cast<int>(length - 1), value);
+}
+
+void Pad(std::string *out) {
+    out->append((kBlock - out->size() % kBlock) % kBlock, '\0');
+}
+
+} // namespace
+
+void TarBuilder::AddEntry(const std::string &name, char type, const std::string &data, int mode,
+                          const std::string &link) {
+    char header[kBlock] = {};
+    strncpy(header, name.c_str(), 100);
+    PutOctal(header + 100, 8, static_cast<unsigned>(mode));
+    PutOctal(header + 108, 8, 0);
+    PutOctal(header + 116, 8, 0);
+    PutOctal(header + 124, 12, type == '0' || type == 'L' || type == 'x' ? data.size() : 0);
+    PutOctal(header + 136, 12, 0);
+    header[156] = type;
+    strncpy(header + 157, link.c_str(), 100);
+    memcpy(header + 257, "ustar", 6);
+    memcpy(header + 263, "00", 2);
+    memset(header + 148, ' ', 8);
+    unsigned sum = 0;
+    for (size_t i = 0; i < kBlock; ++i) {
+        sum += static_cast<unsigned char>(header[i]);
+    }
+    snprintf(header + 148, 8, "%06o", sum);
+    data_.append(header, kBlock);
+    if (type == '0' || type == 'L' || type == 'x') {
+        data_.append(data);
+        Pad(&data_);
+    }
+}
+
+void TarBuilder::AddFile(const std::string &name, const std::string &data, int mode) {
+    AddEntry(name, '0', data, mode);
+}
+
+void TarBuilder::AddDirectory(const std::string &name) {
+    AddEntry(name, '5', std::string(), 0755);
+}
+
+void TarBuilder::AddSymlink(const std::string &name, const std::string &target) {
+    AddEntry(name, '2', std::string(), 0777, target);
+}
+
+void TarBuilder::AddFileLongName(const std::string &name, const std::string &data) {
+    AddEntry("././@LongLink", 'L', name + '\0', 0644);
+    AddEntry(name.substr(0, 99), '0', data, 0644);
+}
+
+void TarBuilder::AddFilePaxPath(const std::string &name, const std::string &data) {
+    // "<len> path=<name>\n", where len counts its own digits.
+    const std::string body = " path=" + name + "\n";
+    size_t length = body.size() + 1;
+    while (std::to_string(length).size() + body.size() != length) {
+        ++length;
+    }
+    AddEntry("PaxHeaders/entry", 'x', std::to_string(length) + body, 0644);
+    AddEntry("placeholder", '0', data, 0644);
+}
+
+std::string TarBuilder::Finish() const {
+    return data_ + std::string(2 * kBlock, '\0');
+}
+
+std::string Gzip(const std::string &data, int level) {
+    z_stream stream {};
+    deflateInit2(&stream, level, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&stream, data.size()) + 32, '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+    deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return out;
+}
+
+} // namespace test
+} // namespace digimobile
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+
+namespace digimobile {
+namespace test {
+
+// Builds tar streams in memory for the extractor tests and benchmarks: ustar
+// entries, GNU long names and pax path records, the shapes snapshot
+// archives use.
+class TarBuilder {
+public:
+    void AddFile(const std::string &name, const std::string &data, int mode = 0644);
+    void AddDirectory(const std::string &name);
+    void AddSymlink(const std::string &name, const std::string &target);
+    // Name carried in a GNU 'L' record instead of the header.
+    void AddFileLongName(const std::string &name, const std::string &data);
+    // Name carried in a pax 'x' record instead of the header.
+    void AddFilePaxPath(const std::string &name, const std::string &data);
+
+    // The stream with its two terminating zero blocks.
+    std::string Finish() const;
+    const std::string &data() const { return data_; }
+
+private:
+    void AddEntry(const std::string &name, char type, const std::string &data, int mode,
+                  const std::string &link = std::string());
+
+    std::string data_;
+};
+
+// gzip member of data (windowBits 31); concatenated members form a valid
+// multi-member stream.
+std::string Gzip(const std::string &data, int level = 6);
+
+} // namespace test
+} // namespace digimobile
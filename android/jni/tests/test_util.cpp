@@ -0,0 +1,173 @@
+#include "test_util.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace digimobile {
+namespace test {
+namespace {
+
+struct TestCase {
+    const char *name;
+    TestFn fn;
+};
+
+std::vector<TestCase> &Registry() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+int g_failures = 0;
+bool g_skipped = false;
+
+} // namespace
+
+bool RegisterTest(const char *name, TestFn fn) {
+    Registry().push_back({name, fn});
+    return true;
+}
+
+void ReportFailure(const char *file, int line, const std::string &what) {
+    fprintf(stderr, "%s:%d: failed: %s\n", file, line, what.c_str());
+    ++g_failures;
+}
+
+void Skip(const std::string &reason) {
+    fprintf(stderr, "  skipped: %s\n", reason.c_str());
+    g_skipped = true;
+}
+
+int FailureCount() { return g_failures; }
+
+TempDir::TempDir() {
+    const char *base = getenv("TMPDIR");
+    std::string pattern = std::string(base != nullptr && *base != '\0' ? base : "/tmp") +
+                          "/digimobile-test.XXXXXX";
+    if (mkdtemp(&pattern[0]) == nullptr) {
+        fprintf(stderr, "mkdtemp %s: %s\n", pattern.c_str(), strerror(errno));
+        abort();
+    }
+    path_ = pattern;
+}
+
+TempDir::~TempDir() { RemoveTree(path_); }
+
+bool WriteFile(const std::string &path, const std::string &data) {
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && ok;
+}
+
+std::string ReadFile(const std::string &path) {
+    std::string data;
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return data;
+    }
+    char buffer[64 * 1024];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.append(buffer, n);
+    }
+    fclose(file);
+    return data;
+}
+
+bool PathExists(const std::string &path) {
+    struct stat info {};
+    return lstat(path.c_str(), &info) == 0;
+}
+
+void RemoveTree(const std::string &path) {
+    struct stat info {};
+    if (lstat(path.c_str(), &info) != 0) {
+        return;
+    }
+    if (S_ISDIR(info.st_mode)) {
+        chmod(path.c_str(), 0700);
+        if (DIR *dir = opendir(path.c_str())) {
+            while (dirent *entry = readdir(dir)) {
+                if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+                    RemoveTree(path + "/" + entry->d_name);
+                }
+            }
+            closedir(dir);
+        }
+        rmdir(path.c_str());
+    } else {
+        unlink(path.c_str());
+    }
+}
+
+std::string PseudoRandomBytes(size_t length, uint32_t seed) {
+    std::string out(length, '\0');
+    uint32_t state = seed * 2654435761u + 1;
+    for (size_t i = 0; i < length; ++i) {
+        // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        out[i] = static_cast<char>(state >> 24);
+    }
+    return out;
+}
+
+int64_t NowMicros() {
+    timespec ts {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+int64_t BenchBytes(int64_t default_mb) {
+    const char *env = getenv("DIGIMOBILE_BENCH_MB");
+    const long long mb = env != nullptr && *env != '\0' ? atoll(env) : 0;
+    return (mb > 0 ? mb : default_mb) << 20;
+}
+
+void ReportThroughput(const std::string &label, int64_t bytes, int64_t micros) {
+    const double seconds = static_cast<double>(std::max<int64_t>(micros, 1)) / 1e6;
+    fprintf(stderr, "  %-40s %8.1f MiB in %8.1f ms: %8.1f MiB/s\n", label.c_str(),
+            static_cast<double>(bytes) / (1 << 20), seconds * 1e3,
+            static_cast<double>(bytes) / (1 << 20) / seconds);
+}
+
+} // namespace test
+} // namespace digimobile
+
+int main(int argc, char **argv) {
+    using namespace digimobile::test;
+    const char *filter = argc > 1 ? argv[1] : nullptr;
+    int ran = 0;
+    int failed = 0;
+    for (const TestCase &test : Registry()) {
+        if (filter != nullptr && strstr(test.name, filter) == nullptr) {
+            continue;
+        }
+        fprintf(stderr, "[ RUN  ] %s\n", test.name);
+        const int before = g_failures;
+        g_skipped = false;
+        test.fn();
+        ++ran;
+        if (g_failures != before) {
+            ++failed;
+            fprintf(stderr, "[ FAIL ] %s\n", test.name);
+        } else {
+            fprintf(stderr, "[ %s ] %s\n", g_skipped ? "SKIP" : " OK ", test.name);
+        }
+    }
+    fprintf(stderr, "%d of %d test cases passed\n", ran - failed, ran);
+    return ran > 0 && failed == 0 ? 0 : 1;
+}
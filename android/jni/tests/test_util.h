@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Minimal harness for the host tests. Every *_test.cpp is its own executable
+// registered with ctest; TEST() cases register themselves and run in file
+// order (a substring argument runs only the matching ones). CHECK* records a
+// failure and carries on, REQUIRE stops the case.
+
+namespace digimobile {
+namespace test {
+
+using TestFn = void (*)();
+
+bool RegisterTest(const char *name, TestFn fn);
+void ReportFailure(const char *file, int line, const std::string &what);
+// Mark the running case as skipped, e.g. for a CPU feature the host lacks.
+void Skip(const std::string &reason);
+// Failures recorded so far in this process, for checks run in a forked child.
+int FailureCount();
+
+// Enums print as their value.
+template <typename T>
+auto Printable(const T &value) ->
+        typename std::enable_if<std::is_enum<T>::value, long long>::type {
+    return static_cast<long long>(value);
+}
+template <typename T>
+auto Printable(const T &value) ->
+        typename std::enable_if<!std::is_enum<T>::value, const T &>::type {
+    return value;
+}
+
+// Vectors print as {a, b, ...}.
+template <typename T>
+std::string Printable(const std::vector<T> &values) {
+    std::ostringstream out;
+    out << "{";
+    for (size_t i = 0; i < values.size(); ++i) {
+        out << (i ? ", " : "") << Printable(values[i]);
+    }
+    out << "}";
+    return out.str();
+}
+
+template <typename A, typename B>
+std::string DescribeMismatch(const char *a_text, const char *b_text, const A &a, const B &b) {
+    std::ostringstream out;
+    out << a_text << " == " << b_text << " (" << Printable(a) << " vs " << Printable(b) << ")";
+    return out.str();
+}
+
+// A fresh directory under $TMPDIR, removed with everything in it.
+class TempDir {
+public:
+    TempDir();
+    ~TempDir();
+    TempDir(const TempDir &) = delete;
+    TempDir &operator=(const TempDir &) = delete;
+
+    const std::string &path() const { return path_; }
+    std::string Join(const std::string &relative) const { return path_ + "/" + relative; }
+
+private:
+    std::string path_;
+};
+
+bool WriteFile(const std::string &path, const std::string &data);
+// Empty if the file cannot be read.
+std::string ReadFile(const std::string &path);
+bool PathExists(const std::string &path);
+void RemoveTree(const std::string &path);
+
+// Deterministic filler for test payloads.
+std::string PseudoRandomBytes(size_t length, uint32_t seed);
+
+int64_t NowMicros();
+
+// Payload size for a benchmark: $DIGIMOBILE_BENCH_MB MiB if set, else
+// default_mb, so ctest runs stay short and a real measurement is one
+// variable away.
+int64_t BenchBytes(int64_t default_mb);
+// One line of benchmark output: bytes over micros as MiB/s.
+void ReportThroughput(const std::string &label, int64_t bytes, int64_t micros);
+
+} // namespace test
+} // namespace digimobile
+
+#define TEST(name)                                                                 \
+    static void name();                                                            \
+    static const bool name##_registered = ::digimobile::test::RegisterTest(#name, name); \
+    static void name()
+
+#define CHECK(cond)                                                                \
+    do {                                                                           \
+        if (!(cond)) {                                                             \
+            ::digimobile::test::ReportFailure(__FILE__, __LINE__, "CHECK(" #cond ")"); \
+        }                                                                          \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                             \
+    do {                                                                           \
+        const auto &check_a_ = (a);                                                \
+        const auto &check_b_ = (b);                                                \
+        if (!(check_a_ == check_b_)) {                                             \
+            ::digimobile::test::ReportFailure(                                     \
+                    __FILE__, __LINE__,                                            \
+                    ::digimobile::test::DescribeMismatch(#a, #b, check_a_, check_b_)); \
+        }                                                                          \
+    } while (0)
+
+#define REQUIRE(cond)                                                              \
+    do {                                                                           \
+        if (!(cond)) {                                                             \
+            ::digimobile::test::ReportFailure(__FILE__, __LINE__, "REQUIRE(" #cond ")"); \
+            return;                                                                \
+        }                                                                          \
+    } while (0)
@@ -0,0 +1,218 @@
+#include "trace_recorder.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "test_util.h"
+
+using namespace digimobile;
+using namespace digimobile::test;
+
+namespace {
+
+size_t Count(const std::string &text, const std::string &needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos;
+         pos = text.find(needle, pos + needle.size())) {
+        ++count;
+    }
+    return count;
+}
+
+// Minimal JSON syntax check: enough to catch a torn or badly escaped dump.
+class JsonChecker {
+public:
+    explicit JsonChecker(const std::string &text) : text_(text) {}
+
+    bool Valid() {
+        return Value() && (Space(), pos_ == text_.size());
+    }
+
+private:
+    void Space() {
+        while (pos_ < text_.size() && strchr(" \t\r\n", text_[pos_]) != nullptr) {
+            ++pos_;
+        }
+    }
+    bool Eat(char c) {
+        Space();
+        if (pos_ < text_.size() && text_[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+    bool String() {
+        if (!Eat('"')) {
+            return false;
+        }
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            if (static_cast<unsigned char>(text_[pos_]) < 0x20) {
+                return false;
+            }
+            pos_ += text_[pos_] == '\\' ? 2 : 1;
+        }
+        return pos_++ < text_.size();
+    }
+    bool Number() {
+        const size_t start = pos_;
+        while (pos_ < text_.size() && strchr("-+.eE0123456789", text_[pos_]) != nullptr) {
+            ++pos_;
+        }
+        return pos_ > start;
+    }
+    bool Value() {
+        Space();
+        if (pos_ >= text_.size()) {
+            return false;
+        }
+        if (text_[pos_] == '"') {
+            return String();
+        }
+        if (Eat('{')) {
+            if (Eat('}')) {
+                return true;
+            }
+            do {
+                if (!String() || !Eat(':') || !Value()) {
+                    return false;
+                }
+            } while (Eat(','));
+            return Eat('}');
+        }
+        if (Eat('[')) {
+            if (Eat(']')) {
+                return true;
+            }
+            do {
+                if (!Value()) {
+                    return false;
+                }
+            } while (Eat(','));
+            return Eat(']');
+        }
+        return Number();
+    }
+
+    const std::string &text_;
+    size_t pos_ = 0;
+};
+
+} // namespace
+
+TEST(DisabledRecordsNothing) {
+    SetTraceEnabled(false);
+    ClearTrace();
+    {
+        TraceSpan span("test", "disabled span");
+    }
+    TraceInstant("test", "disabled instant");
+    const std::string json = TraceToJson();
+    CHECK(json.find("disabled") == std::string::npos);
+    CHECK(JsonChecker(json).Valid());
+}
+
+TEST(SpansAndInstants) {
+    ClearTrace();
+    SetTraceEnabled(true);
+    TraceSetThreadName("test \"main\"");
+    {
+        TraceSpan span("stage", "copy", 10, "a detail longer than twenty-three bytes");
+        usleep(2000);
+        span.set_arg(4096);
+    }
+    TraceInstant("node", "UpdateTip", 123);
+    TraceInstant("node", "quote\"and\\slash");
+    TraceComplete("rpc", "backwards", 2000, 1000);
+    SetTraceEnabled(false);
+
+    const std::string json = TraceToJson();
+    CHECK(JsonChecker(json).Valid());
+    CHECK(json.find("\"ph\":\"X\",\"cat\":\"stage\",\"name\":\"copy\"") != std::string::npos);
+    CHECK(json.find("\"args\":{\"value\":4096,\"detail\":\"a detail longer than tw\"}") !=
+          std::string::npos);
+    CHECK(json.find("\"ph\":\"i\",\"s\":\"t\",\"cat\":\"node\",\"name\":\"UpdateTip\"") !=
+          std::string::npos);
+    CHECK(json.find("\"args\":{\"value\":123}") != std::string::npos);
+    CHECK(json.find("quote\\\"and\\\\slash") != std::string::npos);
+    CHECK(json.find("\"name\":\"test \\\"main\\\"\"") != std::string::npos);
+    // A span never has a negative duration.
+    CHECK(json.find("\"name\":\"backwards\"") != std::string::npos);
+    CHECK(json.find("\"dur\":0.000") != std::string::npos);
+    CHECK(json.find("\"dur\":-") == std::string::npos);
+
+    ClearTrace();
+    CHECK_EQ(Count(TraceToJson(), "\"ph\":\"X\""), static_cast<size_t>(0));
+}
+
+// Each thread keeps only its newest kTraceEventsPerThread events, and a
+// thread's events survive its exit.
+TEST(RingsKeepTheNewestEventsPerThread) {
+    ClearTrace();
+    SetTraceEnabled(true);
+    const int total = static_cast<int>(kTraceEventsPerThread) + 500;
+    std::thread worker([total] {
+        TraceSetThreadName("worker");
+        for (int i = 0; i < total; ++i) {
+            TraceInstant("test", "ring", i);
+        }
+    });
+    worker.join();
+    TraceInstant("test", "main");
+    SetTraceEnabled(false);
+
+    const std::string json = TraceToJson();
+    CHECK_EQ(Count(json, "\"name\":\"ring\""), kTraceEventsPerThread);
+    CHECK(json.find("\"value\":499}") == std::string::npos);
+    CHECK(json.find("\"value\":500}") != std::string::npos);
+    CHECK(json.find("\"value\":" + std::to_string(total - 1) + "}") != std::string::npos);
+    CHECK_EQ(Count(json, "\"name\":\"main\""), static_cast<size_t>(1));
+    ClearTrace();
+}
+
+// Dumps taken while several threads record are always well-formed and never
+// contain a torn event.
+TEST(DumpWhileRecording) {
+    ClearTrace();
+    SetTraceEnabled(true);
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&stop] {
+            for (int64_t i = 0; !stop.load(); ++i) {
+                TraceSpan span("test", "busy", i, "detail");
+            }
+        });
+    }
+    for (int i = 0; i < 50; ++i) {
+        const std::string json = TraceToJson();
+        REQUIRE(JsonChecker(json).Valid());
+        CHECK_EQ(Count(json, "\"name\":\"busy\""), Count(json, "\"detail\":\"detail\"}"));
+    }
+    stop = true;
+    for (std::thread &writer : writers) {
+        writer.join();
+    }
+    SetTraceEnabled(false);
+    ClearTrace();
+}
+
+TEST(WriteTraceJson) {
+    ClearTrace();
+    SetTraceEnabled(true);
+    TraceInstant("test", "written");
+    SetTraceEnabled(false);
+    TempDir dir;
+    std::string error;
+    REQUIRE(WriteTraceJson(dir.Join("trace.json"), &error));
+    const std::string json = ReadFile(dir.Join("trace.json"));
+    CHECK(JsonChecker(json).Valid());
+    CHECK_EQ(Count(json, "\"name\":\"written\""), static_cast<size_t>(1));
+    CHECK(!WriteTraceJson(dir.Join("missing/trace.json"), &error));
+    CHECK(error.rfind("open ", 0) == 0);
+    ClearTrace();
+}
@@ -0,0 +1,370 @@
+// Host tool: export a stretch of the chain from a running node as a block
+// bundle (see block_bundle.h), and check or feed one the way the app does.
+//
+//   block_bundle make [--rpc-host HOST] [--rpc-port PORT] [--rpc-user USER
+//                     --rpc-password PASS] [--batch N] [--magic HEX]
+//                     <network-datadir> <start-height> <end-height> <output>
+//   block_bundle verify [--headers-sha256 HEX] [--prev-hash HEX] <bundle>
+//   block_bundle feed [--headers-sha256 HEX] [--prev-hash HEX] <bundle> <pipe>
+//
+// make reads blocks over RPC, authenticating with <network-datadir>/.cookie
+// unless a user is given, and takes the network magic from the node's first
+// block file. It writes <output> and <output>.headers and prints the headers
+// SHA-256 and the hash the bundle extends. feed creates <pipe>, for a daemon
+// started with -loadblock=<pipe>, and returns once the daemon has read every
+// block. scripts/make-block-bundle.sh wraps make.
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "block_bundle.h"
+#include "json_scan.h"
+#include "rpc_client.h"
+#include "sha256.h"
+
+namespace {
+
+struct Options {
+    std::string command;
+    std::string rpc_host = "127.0.0.1";
+    int rpc_port = 14022;
+    std::string rpc_user;
+    std::string rpc_password;
+    int batch = 50;
+    std::string magic;
+    std::string headers_sha256;
+    std::string prev_hash;
+    std::vector<std::string> positional;
+};
+
+[[noreturn]] void Die(const std::string &message) {
+    fprintf(stderr, "block_bundle: %s\n", message.c_str());
+    exit(1);
+}
+
+[[noreturn]] void Usage() {
+    Die("usage:\n"
+        "  block_bundle make [--rpc-host HOST] [--rpc-port PORT] [--rpc-user USER "
+        "--rpc-password PASS]\n"
+        "                    [--batch N] [--magic HEX] <network-datadir> <start-height> "
+        "<end-height> <output>\n"
+        "  block_bundle verify [--headers-sha256 HEX] [--prev-hash HEX] <bundle>\n"
+        "  block_bundle feed [--headers-sha256 HEX] [--prev-hash HEX] <bundle> <pipe>");
+}
+
+Options ParseArgs(int argc, char **argv) {
+    Options options;
+    if (argc < 2) {
+        Usage();
+    }
+    options.command = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            options.positional.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            Die(arg + " needs a value");
+        }
+        const char *value = argv[++i];
+        if (arg == "--rpc-host") {
+            options.rpc_host = value;
+        } else if (arg == "--rpc-port") {
+            options.rpc_port = static_cast<int>(strtol(value, nullptr, 10));
+        } else if (arg == "--rpc-user") {
+            options.rpc_user = value;
+        } else if (arg == "--rpc-password") {
+            options.rpc_password = value;
+        } else if (arg == "--batch") {
+            const long batch = strtol(value, nullptr, 10);
+            options.batch = static_cast<int>(std::min(std::max(batch, 1l), 1000l));
+        } else if (arg == "--magic") {
+            options.magic = value;
+        } else if (arg == "--headers-sha256") {
+            options.headers_sha256 = value;
+        } else if (arg == "--prev-hash") {
+            options.prev_hash = value;
+        } else {
+            Die("unknown option " + arg);
+        }
+    }
+    return options;
+}
+
+bool DecodeHex(std::string_view hex, std::string *out) {
+    if (hex.size() % 2 != 0) {
+        return false;
+    }
+    out->resize(hex.size() / 2);
+    for (size_t i = 0; i < out->size(); ++i) {
+        unsigned value = 0;
+        for (size_t j = 0; j < 2; ++j) {
+            const char c = hex[2 * i + j];
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= static_cast<unsigned>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                value |= static_cast<unsigned>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                value |= static_cast<unsigned>(c - 'A' + 10);
+            } else {
+                return false;
+            }
+        }
+        (*out)[i] = static_cast<char>(value);
+    }
+    return true;
+}
+
+std::string ReadSmallFile(const std::string &path) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file) {
+        Die("open " + path + ": " + strerror(errno));
+    }
+    std::string contents;
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.append(buffer, n);
+    }
+    fclose(file);
+    return contents;
+}
+
+void WriteAll(FILE *file, const void *data, size_t length, const std::string &path) {
+    if (fwrite(data, 1, length, file) != length) {
+        Die("write " + path + ": " + strerror(errno));
+    }
+}
+
+// Network magic as the node writes it at the start of every block file record.
+void ReadNetworkMagic(const Options &options, const std::string &datadir, unsigned char out[4]) {
+    std::string magic;
+    if (!options.magic.empty()) {
+        if (!DecodeHex(options.magic, &magic) || magic.size() != 4) {
+            Die("--magic must be 8 hex digits");
+        }
+    } else {
+        const std::string path = datadir + "/blocks/blk00000.dat";
+        FILE *file = fopen(path.c_str(), "rb");
+        magic.resize(4);
+        if (!file || fread(&magic[0], 1, 4, file) != 4) {
+            Die("read the network magic from " + path + " (or pass --magic)");
+        }
+        fclose(file);
+    }
+    memcpy(out, magic.data(), 4);
+}
+
+// Results of a batch reply in request order; dies on any error.
+std::vector<std::string_view> BatchResults(const digimobile::RpcResponse &response, size_t count) {
+    if (!response.transport_ok) {
+        Die("RPC: " + response.error);
+    }
+    std::vector<std::string_view> results(count);
+    const bool ok = digimobile::ForEachJsonElement(response.body, [&](std::string_view reply) {
+        std::string_view id;
+        std::string_view result;
+        std::string_view error;
+        digimobile::FindJsonMember(reply, "id", &id);
+        digimobile::FindJsonMember(reply, "result", &result);
+        if (digimobile::FindJsonMember(reply, "error", &error) && !digimobile::JsonIsNull(error)) {
+            Die("RPC error: " + std::string(error));
+        }
+        int64_t index = -1;
+        if (digimobile::JsonToInt64(id, &index) && index >= 0 &&
+            static_cast<size_t>(index) < count) {
+            results[index] = result;
+        }
+        return true;
+    });
+    if (!ok) {
+        Die("RPC: HTTP " + std::to_string(response.http_status) + ": " +
+            response.body.substr(0, 200));
+    }
+    for (const std::string_view &result : results) {
+        if (result.empty()) {
+            Die("RPC: incomplete batch reply");
+        }
+    }
+    return results;
+}
+
+int Make(const Options &options) {
+    if (options.positional.size() != 4) {
+        Usage();
+    }
+    const std::string &datadir = options.positional[0];
+    const long long start = strtoll(options.positional[1].c_str(), nullptr, 10);
+    const long long end = strtoll(options.positional[2].c_str(), nullptr, 10);
+    const std::string &output = options.positional[3];
+    if (start < 0 || end < start || end - start >= (1ll << 31)) {
+        Die("bad height range");
+    }
+
+    std::string user = options.rpc_user;
+    std::string password = options.rpc_password;
+    if (user.empty()) {
+        const std::string cookie = ReadSmallFile(datadir + "/.cookie");
+        const size_t colon = cookie.find(':');
+        if (colon == std::string::npos) {
+            Die("malformed " + datadir + "/.cookie");
+        }
+        user = cookie.substr(0, colon);
+        password = cookie.substr(colon + 1);
+        while (!password.empty() && (password.back() == '\n' || password.back() == '\r')) {
+            password.pop_back();
+        }
+    }
+    digimobile::RpcClient rpc(options.rpc_host, static_cast<uint16_t>(options.rpc_port), user,
+                              password);
+    rpc.SetTimeoutMs(120000);
+
+    digimobile::BundleHeadersInfo info;
+    ReadNetworkMagic(options, datadir, info.network_magic);
+    info.start_height = static_cast<uint32_t>(start);
+    info.count = static_cast<uint32_t>(end - start + 1);
+
+    const std::string blocks_tmp = output + ".tmp";
+    const std::string headers_path = output + ".headers";
+    const std::string headers_tmp = headers_path + ".tmp";
+    FILE *blocks = fopen(blocks_tmp.c_str(), "wb");
+    if (!blocks) {
+        Die("create " + blocks_tmp + ": " + strerror(errno));
+    }
+    std::string headers;
+    headers.reserve(static_cast<size_t>(info.count) * digimobile::kBlockHeaderSize);
+
+    unsigned long long block_bytes = 0;
+    std::string block;
+    for (long long height = start; height <= end; height += options.batch) {
+        const long long last = std::min(end, height + options.batch - 1);
+        std::vector<digimobile::RpcRequest> requests;
+        for (long long h = height; h <= last; ++h) {
+            requests.push_back({"getblockhash", "[" + std::to_string(h) + "]"});
+        }
+        const digimobile::RpcResponse hash_reply = rpc.CallBatch(requests);
+        std::vector<std::string> hashes;
+        for (const std::string_view &result : BatchResults(hash_reply, requests.size())) {
+            std::string hash;
+            if (!digimobile::JsonToString(result, &hash)) {
+                Die("malformed getblockhash reply");
+            }
+            hashes.push_back(hash);
+        }
+
+        requests.clear();
+        for (const std::string &hash : hashes) {
+            requests.push_back({"getblock", "[\"" + hash + "\", 0]"});
+        }
+        const digimobile::RpcResponse block_reply = rpc.CallBatch(requests);
+        const std::vector<std::string_view> results = BatchResults(block_reply, requests.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            std::string_view hex = results[i];
+            if (hex.size() < 2 || hex.front() != '"' || hex.back() != '"' ||
+                !DecodeHex(hex.substr(1, hex.size() - 2), &block) ||
+                block.size() < digimobile::kBlockHeaderSize ||
+                block.size() > digimobile::kMaxBundleBlockSize) {
+                Die("malformed getblock reply for " + hashes[i]);
+            }
+            const auto *header = reinterpret_cast<const unsigned char *>(block.data());
+            unsigned char hash[32];
+            digimobile::BlockHeaderHash(header, hash);
+            if (digimobile::BlockHashToHex(hash) != hashes[i]) {
+                Die("block " + hashes[i] + " does not hash to its id");
+            }
+            if (height + static_cast<long long>(i) == start) {
+                memcpy(info.prev_hash, header + 4, sizeof(info.prev_hash));
+            }
+            unsigned char prefix[8];
+            memcpy(prefix, info.network_magic, 4);
+            for (int b = 0; b < 4; ++b) {
+                prefix[4 + b] = static_cast<unsigned char>(block.size() >> (8 * b));
+            }
+            WriteAll(blocks, prefix, sizeof(prefix), blocks_tmp);
+            WriteAll(blocks, block.data(), block.size(), blocks_tmp);
+            headers.append(block.data(), digimobile::kBlockHeaderSize);
+            block_bytes += sizeof(prefix) + block.size();
+        }
+        fprintf(stderr, "\rblock_bundle: %lld/%lld", last, end);
+    }
+    fprintf(stderr, "\n");
+    if (fflush(blocks) != 0 || fclose(blocks) != 0) {
+        Die("flush " + blocks_tmp + ": " + strerror(errno));
+    }
+
+    const std::string preamble = digimobile::SerializeHeadersPreamble(info);
+    FILE *headers_file = fopen(headers_tmp.c_str(), "wb");
+    if (!headers_file) {
+        Die("create " + headers_tmp + ": " + strerror(errno));
+    }
+    WriteAll(headers_file, preamble.data(), preamble.size(), headers_tmp);
+    WriteAll(headers_file, headers.data(), headers.size(), headers_tmp);
+    if (fflush(headers_file) != 0 || fclose(headers_file) != 0) {
+        Die("flush " + headers_tmp + ": " + strerror(errno));
+    }
+    digimobile::Sha256 hasher;
+    hasher.Update(preamble.data(), preamble.size());
+    hasher.Update(headers.data(), headers.size());
+
+    if (rename(blocks_tmp.c_str(), output.c_str()) != 0 ||
+        rename(headers_tmp.c_str(), headers_path.c_str()) != 0) {
+        Die("rename " + output + ": " + strerror(errno));
+    }
+    printf("start_height=%u count=%u bundle_bytes=%llu\n", info.start_height, info.count,
+           block_bytes);
+    printf("prev_hash=%s\n", digimobile::BlockHashToHex(info.prev_hash).c_str());
+    printf("headers_sha256=%s\n", hasher.FinishHex().c_str());
+    return 0;
+}
+
+int VerifyOrFeed(const Options &options) {
+    const bool feed = options.command == "feed";
+    if (options.positional.size() != (feed ? 2u : 1u)) {
+        Usage();
+    }
+    const std::string &bundle = options.positional[0];
+    digimobile::BlockBundleFeeder feeder(bundle, bundle + ".headers");
+    std::string error;
+    if (!feeder.Verify(options.headers_sha256, options.prev_hash, &error)) {
+        Die(bundle + ": " + error);
+    }
+    const digimobile::BundleHeadersInfo &info = feeder.info();
+    printf("start_height=%u count=%u prev_hash=%s\n", info.start_height, info.count,
+           digimobile::BlockHashToHex(info.prev_hash).c_str());
+    if (!feed) {
+        return 0;
+    }
+    if (!feeder.OpenPipe(options.positional[1], &error)) {
+        Die(error);
+    }
+    printf("pipe ready: %s\n", options.positional[1].c_str());
+    fflush(stdout);
+    if (!feeder.Feed(&error)) {
+        Die("fed " + std::to_string(feeder.fed_blocks()) + " blocks, then: " + error);
+    }
+    printf("fed_blocks=%llu fed_bytes=%llu\n",
+           static_cast<unsigned long long>(feeder.fed_blocks()),
+           static_cast<unsigned long long>(feeder.fed_bytes()));
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const Options options = ParseArgs(argc, argv);
+    if (options.command == "make") {
+        return Make(options);
+    }
+    if (options.command == "verify" || options.command == "feed") {
+        return VerifyOrFeed(options);
+    }
+    Usage();
+}
@@ -0,0 +1,280 @@
+// Host tool: pack datadir subdirectories (chainstate/, blocks/) into a
+// DGBSNAP1 snapshot container (see snapshot_container.h).
+//
+//   make_snapshot_container [--chunk-size BYTES] [--level 0-9] [--threads N]
+//                           <datadir> <output> [subdir...]
+//
+// Prints the index SHA-256, which the app pins to accept the snapshot.
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sha256.h"
+#include "snapshot_container.h"
+
+using digimobile::ChunkCompression;
+using digimobile::ContainerChunk;
+using digimobile::ContainerFile;
+using digimobile::ContainerIndex;
+
+namespace {
+
+struct Options {
+    uint32_t chunk_size = 4u << 20;
+    int level = 6;
+    int threads = 0;
+    std::string datadir;
+    std::string output;
+    std::vector<std::string> subdirs;
+};
+
+struct Packed {
+    std::vector<unsigned char> stored;
+    ChunkCompression compression = ChunkCompression::kStored;
+    unsigned char sha256[32] = {};
+};
+
+[[noreturn]] void Die(const std::string &message) {
+    fprintf(stderr, "make_snapshot_container: %s\n", message.c_str());
+    exit(1);
+}
+
+void Walk(const std::string &root, const std::string &relative, std::vector<ContainerFile> *files) {
+    const std::string dir_path = root + "/" + relative;
+    DIR *dir = opendir(dir_path.c_str());
+    if (!dir) {
+        Die("opendir " + dir_path + ": " + strerror(errno));
+    }
+    std::vector<std::string> names;
+    while (dirent *entry = readdir(dir)) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+            names.emplace_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+
+    for (const std::string &name : names) {
+        const std::string child = relative + "/" + name;
+        struct stat st {};
+        if (lstat((root + "/" + child).c_str(), &st) != 0) {
+            Die("stat " + child + ": " + strerror(errno));
+        }
+        if (S_ISDIR(st.st_mode)) {
+            Walk(root, child, files);
+        } else if (S_ISREG(st.st_mode)) {
+            if (name == "LOCK" || name == ".lock") {
+                continue;  // leveldb/Core lock files are recreated on start
+            }
+            ContainerFile file;
+            file.path = child;
+            file.mode = static_cast<uint32_t>(st.st_mode & 0777);
+            file.size = static_cast<uint64_t>(st.st_size);
+            files->push_back(file);
+        }
+    }
+}
+
+Packed PackChunk(const Options &options, const ContainerFile &file, const ContainerChunk &chunk) {
+    std::vector<unsigned char> raw(chunk.raw_size);
+    const std::string path = options.datadir + "/" + file.path;
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || pread(fd, raw.data(), raw.size(), static_cast<off_t>(chunk.file_offset)) !=
+                          static_cast<ssize_t>(raw.size())) {
+        Die("read " + path + ": " + strerror(errno));
+    }
+    close(fd);
+
+    Packed packed;
+    if (options.level > 0) {
+        z_stream stream{};
+        if (deflateInit2(&stream, options.level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            Die("deflateInit2 failed");
+        }
+        packed.stored.resize(deflateBound(&stream, raw.size()));
+        stream.next_in = raw.data();
+        stream.avail_in = static_cast<uInt>(raw.size());
+        stream.next_out = packed.stored.data();
+        stream.avail_out = static_cast<uInt>(packed.stored.size());
+        if (deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+            Die("deflate failed");
+        }
+        packed.stored.resize(stream.total_out);
+        deflateEnd(&stream);
+        packed.compression = ChunkCompression::kDeflate;
+    }
+    // Block files barely compress; storing them keeps the consumer's hot path a plain copy.
+    if (options.level == 0 || packed.stored.size() >= raw.size()) {
+        packed.stored.swap(raw);
+        packed.compression = ChunkCompression::kStored;
+    }
+    digimobile::Sha256 hasher;
+    hasher.Update(packed.stored.data(), packed.stored.size());
+    hasher.Finish(packed.sha256);
+    return packed;
+}
+
+void WriteAll(FILE *out, const void *data, size_t length, const std::string &what) {
+    if (fwrite(data, 1, length, out) != length) {
+        Die("write " + what + ": " + strerror(errno));
+    }
+}
+
+Options ParseArgs(int argc, char **argv) {
+    Options options;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "--chunk-size" || arg == "--level" || arg == "--threads") && i + 1 < argc) {
+            const long value = strtol(argv[++i], nullptr, 10);
+            if (arg == "--chunk-size") {
+                if (value < 4096 || value > (64l << 20)) {
+                    Die("--chunk-size must be between 4 KiB and 64 MiB");
+                }
+                options.chunk_size = static_cast<uint32_t>(value);
+            } else if (arg == "--level") {
+                options.level = static_cast<int>(std::min(std::max(value, 0l), 9l));
+            } else {
+                options.threads = static_cast<int>(value);
+            }
+        } else if (arg.compare(0, 2, "--") == 0) {
+            Die("unknown option " + arg);
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() < 2) {
+        Die("usage: make_snapshot_container [--chunk-size BYTES] [--level 0-9] [--threads N] "
+            "<datadir> <output> [subdir...]");
+    }
+    options.datadir = positional[0];
+    options.output = positional[1];
+    options.subdirs.assign(positional.begin() + 2, positional.end());
+    if (options.subdirs.empty()) {
+        options.subdirs = {"chainstate", "blocks"};
+    }
+    if (options.threads <= 0) {
+        options.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const Options options = ParseArgs(argc, argv);
+
+    ContainerIndex index;
+    for (const std::string &subdir : options.subdirs) {
+        Walk(options.datadir, subdir, &index.files);
+    }
+    for (uint32_t f = 0; f < index.files.size(); ++f) {
+        for (uint64_t offset = 0; offset < index.files[f].size; offset += options.chunk_size) {
+            ContainerChunk chunk;
+            chunk.file = f;
+            chunk.file_offset = offset;
+            chunk.raw_size = static_cast<uint32_t>(
+                    std::min<uint64_t>(options.chunk_size, index.files[f].size - offset));
+            index.chunks.push_back(chunk);
+        }
+    }
+
+    // Every index field has a fixed width, so its size is known before the
+    // offsets are; chunk data starts right after it.
+    const uint64_t data_start = digimobile::kContainerPreambleSize +
+                                digimobile::SerializeContainerIndex(index).size() +
+                                digimobile::Sha256::kDigestSize;
+
+    const std::string data_path = options.output + ".data.tmp";
+    FILE *data = fopen(data_path.c_str(), "w+b");
+    if (!data) {
+        Die("create " + data_path + ": " + strerror(errno));
+    }
+
+    // Compress a window of chunks in parallel, then append them in order.
+    uint64_t offset = data_start;
+    uint64_t raw_total = 0;
+    const size_t window = static_cast<size_t>(options.threads) * 4;
+    std::vector<Packed> packed(window);
+    for (size_t base = 0; base < index.chunks.size(); base += window) {
+        const size_t count = std::min(window, index.chunks.size() - base);
+        std::atomic<size_t> next{0};
+        auto worker = [&] {
+            for (size_t i = next++; i < count; i = next++) {
+                const ContainerChunk &chunk = index.chunks[base + i];
+                packed[i] = PackChunk(options, index.files[chunk.file], chunk);
+            }
+        };
+        std::vector<std::thread> workers;
+        for (int t = 1; t < options.threads; ++t) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (std::thread &t : workers) {
+            t.join();
+        }
+        for (size_t i = 0; i < count; ++i) {
+            ContainerChunk &chunk = index.chunks[base + i];
+            chunk.offset = offset;
+            chunk.stored_size = static_cast<uint32_t>(packed[i].stored.size());
+            chunk.compression = packed[i].compression;
+            memcpy(chunk.sha256, packed[i].sha256, sizeof(chunk.sha256));
+            WriteAll(data, packed[i].stored.data(), packed[i].stored.size(), data_path);
+            offset += chunk.stored_size;
+            raw_total += chunk.raw_size;
+        }
+    }
+
+    const std::string serialized = digimobile::SerializeContainerIndex(index);
+    unsigned char digest[digimobile::Sha256::kDigestSize];
+    digimobile::Sha256 hasher;
+    hasher.Update(serialized.data(), serialized.size());
+    hasher.Finish(digest);
+
+    const std::string tmp_path = options.output + ".tmp";
+    FILE *out = fopen(tmp_path.c_str(), "wb");
+    if (!out) {
+        Die("create " + tmp_path + ": " + strerror(errno));
+    }
+    unsigned char size_le[4];
+    for (int i = 0; i < 4; ++i) {
+        size_le[i] = static_cast<unsigned char>(serialized.size() >> (8 * i));
+    }
+    WriteAll(out, digimobile::kContainerMagic, sizeof(digimobile::kContainerMagic), tmp_path);
+    WriteAll(out, size_le, sizeof(size_le), tmp_path);
+    WriteAll(out, serialized.data(), serialized.size(), tmp_path);
+    WriteAll(out, digest, sizeof(digest), tmp_path);
+
+    rewind(data);
+    std::vector<unsigned char> buffer(1 << 20);
+    size_t n;
+    while ((n = fread(buffer.data(), 1, buffer.size(), data)) > 0) {
+        WriteAll(out, buffer.data(), n, tmp_path);
+    }
+    fclose(data);
+    unlink(data_path.c_str());
+    if (fflush(out) != 0 || fsync(fileno(out)) != 0 || fclose(out) != 0) {
+        Die("flush " + tmp_path + ": " + strerror(errno));
+    }
+    if (rename(tmp_path.c_str(), options.output.c_str()) != 0) {
+        Die("rename " + tmp_path + ": " + strerror(errno));
+    }
+
+    printf("files=%zu chunks=%zu raw_bytes=%llu container_bytes=%llu\n", index.files.size(),
+           index.chunks.size(), static_cast<unsigned long long>(raw_total),
+           static_cast<unsigned long long>(offset));
+    printf("index_sha256=%s\n", digimobile::HexDigest(digest, sizeof(digest)).c_str());
+    return 0;
+}
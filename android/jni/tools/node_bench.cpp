@@ -0,0 +1,422 @@
+// Host tool: time the node lifecycle the app drives through the JNI layer,
+// using the same NodeController, staging, extraction, RPC and debug.log code,
+// against a regtest digibyted. Prints one JSON object for trend tracking.
+//
+//   node_bench --daemon PATH [--cli PATH] --workdir DIR --snapshot FILE.tar.gz
+//              --connect HOST:PORT --target-height N
+//              [--rpc-port PORT] [--timeout SECONDS] [--trace FILE.json]
+//
+// Phases, in NodeState order:
+//   stage    copy digibyted and digibyte-cli into workdir/bin, then re-stage
+//            them unchanged
+//   extract  unpack the snapshot into workdir/node (PreparingEnvironment)
+//   start    NodeController::Start until RPC answers and warm-up ends
+//            (StartingDaemon); the binaries are directory-backed assets
+//   peers    until the node has a peer (ConnectingToPeers)
+//   sync     UpdateTip events until --target-height (Syncing -> Ready)
+//   stop     SIGTERM until the daemon has exited
+//   restart  start the synced node again with its databases evicted from the
+//            page cache, until RPC answers: once with full verification
+//            (cold), once as a warm restart after the clean stop
+// scripts/bench-node.sh prepares the regtest chain, snapshot and peer. With
+// --trace, the native spans of the run are also written as Chrome trace JSON.
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asset_stager.h"
+#include "datadir_cache.h"
+#include "debug_log_tailer.h"
+#include "node_controller.h"
+#include "platform.h"
+#include "rpc_client.h"
+#include "snapshot_extractor.h"
+#include "trace_recorder.h"
+
+namespace {
+
+constexpr const char *kRpcUser = "bench";
+constexpr const char *kRpcPassword = "bench";
+constexpr const char *kStageVersion = "bench";
+constexpr int kPollMs = 100;
+
+struct Options {
+    std::string daemon;  // absolute, so it can be opened as an asset
+    std::string cli;
+    std::string workdir;
+    std::string snapshot;
+    std::string connect;
+    std::string trace;
+    int64_t target_height = -1;
+    int rpc_port = 18543;
+    int timeout_s = 600;
+};
+
+[[noreturn]] void Die(const std::string &message) {
+    fprintf(stderr, "node_bench: %s\n", message.c_str());
+    exit(1);
+}
+
+double ElapsedMs(int64_t since_ms) {
+    return static_cast<double>(digimobile::MonotonicMillis() - since_ms);
+}
+
+void MakeDirs(const std::string &path) {
+    for (size_t slash = path.find('/', 1);; slash = path.find('/', slash + 1)) {
+        const std::string prefix = path.substr(0, slash);
+        if (mkdir(prefix.c_str(), 0700) != 0 && errno != EEXIST) {
+            Die("mkdir " + prefix + ": " + strerror(errno));
+        }
+        if (slash == std::string::npos) {
+            return;
+        }
+    }
+}
+
+// Value of a numeric field in a JSON-RPC reply, or -1.
+int64_t JsonNumber(const std::string &body, const char *key) {
+    const std::string needle = std::string("\"") + key + "\":";
+    const size_t pos = body.find(needle);
+    if (pos == std::string::npos) {
+        return -1;
+    }
+    return strtoll(body.c_str() + pos + needle.size(), nullptr, 10);
+}
+
+// True once the node answers RPC with a result rather than the -28 warm-up error.
+bool RpcReady(digimobile::RpcClient *rpc, const char *method, std::string *body) {
+    const digimobile::RpcResponse response = rpc->Call(method);
+    if (!response.transport_ok || response.http_status != 200) {
+        return false;
+    }
+    *body = response.body;
+    return true;
+}
+
+Options ParseArgs(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        const char *value = argv[i + 1];
+        if (arg == "--daemon") {
+            options.daemon = value;
+        } else if (arg == "--cli") {
+            options.cli = value;
+        } else if (arg == "--workdir") {
+            options.workdir = value;
+        } else if (arg == "--snapshot") {
+            options.snapshot = value;
+        } else if (arg == "--connect") {
+            options.connect = value;
+        } else if (arg == "--target-height") {
+            options.target_height = strtoll(value, nullptr, 10);
+        } else if (arg == "--rpc-port") {
+            options.rpc_port = static_cast<int>(strtol(value, nullptr, 10));
+        } else if (arg == "--timeout") {
+            options.timeout_s = static_cast<int>(strtol(value, nullptr, 10));
+        } else if (arg == "--trace") {
+            options.trace = value;
+        } else {
+            Die("unknown option " + arg);
+        }
+    }
+    if (options.daemon.empty() || options.workdir.empty() || options.snapshot.empty() ||
+        options.connect.empty() || options.target_height < 0) {
+        Die("usage: node_bench --daemon PATH --workdir DIR --snapshot FILE.tar.gz "
+            "--connect HOST:PORT --target-height N [--cli PATH] [--rpc-port PORT] "
+            "[--timeout SECONDS] [--trace FILE.json]");
+    }
+    if (options.cli.empty()) {
+        options.cli = options.daemon.substr(0, options.daemon.rfind('/') + 1) + "digibyte-cli";
+    }
+    for (std::string *path : {&options.daemon, &options.cli}) {
+        char resolved[PATH_MAX];
+        if (!realpath(path->c_str(), resolved)) {
+            Die(*path + ": " + strerror(errno));
+        }
+        *path = resolved;
+    }
+    return options;
+}
+
+// Stage each binary into an empty bin/ (first launch after install), then
+// again with the same version stamp (every later launch).
+std::string Stage(const Options &options, const std::string &bin_dir) {
+    const std::pair<std::string, std::string> binaries[] = {
+            {options.daemon, bin_dir + "/digibyted"},
+            {options.cli, bin_dir + "/digibyte-cli"},
+    };
+    int64_t bytes = 0;
+    double cold_ms = 0;
+    double warm_ms = 0;
+    for (const auto &binary : binaries) {
+        const int fd = open(binary.first.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st {};
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            Die("open " + binary.first + ": " + strerror(errno));
+        }
+        digimobile::StageSource source;
+        source.fd = fd;
+        source.length = st.st_size;
+        bytes += st.st_size;
+        const std::string &dest = binary.second;
+        std::string error;
+
+        unlink(dest.c_str());
+        unlink((dest + ".stamp").c_str());
+        int64_t start = digimobile::MonotonicMillis();
+        if (digimobile::StageFile(source, dest, kStageVersion, &error) !=
+            digimobile::StageResult::kCopied) {
+            Die("stage " + dest + ": " + error);
+        }
+        cold_ms += ElapsedMs(start);
+        start = digimobile::MonotonicMillis();
+        if (digimobile::StageFile(source, dest, kStageVersion, &error) !=
+            digimobile::StageResult::kUpToDate) {
+            Die("re-stage " + dest + ": " + error);
+        }
+        warm_ms += ElapsedMs(start);
+        close(fd);
+    }
+
+    char json[256];
+    snprintf(json, sizeof(json), "{\"bytes\": %lld, \"cold_ms\": %.1f, \"warm_ms\": %.1f}",
+             static_cast<long long>(bytes), cold_ms, warm_ms);
+    return json;
+}
+
+std::string Extract(const Options &options, const std::string &datadir) {
+    struct stat st {};
+    if (stat(options.snapshot.c_str(), &st) != 0) {
+        Die("stat " + options.snapshot + ": " + strerror(errno));
+    }
+    digimobile::ExtractStats stats;
+    std::string error;
+    const int64_t start = digimobile::MonotonicMillis();
+    if (!digimobile::ExtractTarGz(options.snapshot, datadir, digimobile::ExtractOptions(), nullptr,
+                                  &stats, &error)) {
+        Die("extract " + options.snapshot + ": " + error);
+    }
+    const double ms = std::max(ElapsedMs(start), 1.0);
+    char json[320];
+    snprintf(json, sizeof(json),
+             "{\"archive_bytes\": %lld, \"bytes_written\": %lld, \"files\": %lld, \"ms\": %.1f, "
+             "\"archive_mb_per_s\": %.2f, \"written_mb_per_s\": %.2f}",
+             static_cast<long long>(st.st_size), static_cast<long long>(stats.bytes_written),
+             static_cast<long long>(stats.files), ms, st.st_size / ms / 1000.0,
+             stats.bytes_written / ms / 1000.0);
+    return json;
+}
+
+void WriteConfig(const Options &options, const std::string &datadir) {
+    const std::string path = datadir + "/digibyte.conf";
+    FILE *conf = fopen(path.c_str(), "w");
+    if (!conf) {
+        Die("create " + path + ": " + strerror(errno));
+    }
+    // Only the peer the script set up, and no listening socket of our own.
+    fprintf(conf,
+            "regtest=1\nserver=1\nlisten=0\ndnsseed=0\nprinttoconsole=0\n"
+            "[regtest]\nconnect=%s\nrpcuser=%s\nrpcpassword=%s\nrpcport=%d\n"
+            "rpcbind=127.0.0.1\nrpcallowip=127.0.0.1\n",
+            options.connect.c_str(), kRpcUser, kRpcPassword, options.rpc_port);
+    fclose(conf);
+}
+
+// Start the stopped node from a cold page cache and time it until RPC
+// answers, then stop it cleanly again for the next run.
+std::string Restart(digimobile::NodeController *node, digimobile::AssetProvider *assets,
+                    const digimobile::StartRequest &request, digimobile::RpcClient *rpc,
+                    bool warm, int64_t deadline) {
+    const int64_t evicted = digimobile::EvictDatadir(request.data_dir);
+    digimobile::WarmRestartPolicy policy;
+    policy.enabled = warm;
+    node->SetWarmRestart(policy);
+
+    const int64_t start = digimobile::MonotonicMillis();
+    node->Start(assets, request);
+    if (node->status() != digimobile::NodeStatus::RUNNING) {
+        Die(std::string("restart failed: ") + node->StatusString());
+    }
+    std::string body;
+    while (!RpcReady(rpc, "getblockchaininfo", &body)) {
+        if (digimobile::MonotonicMillis() > deadline) {
+            node->Stop(10000);
+            Die("timed out waiting for the restarted node");
+        }
+        if (node->supervisor().phase() != digimobile::NodePhase::RUNNING) {
+            Die("digibyted exited during a restart; see " + request.data_dir + "/regtest/debug.log");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(kPollMs));
+    }
+    const double ready_ms = ElapsedMs(start);
+    const digimobile::LaunchInfo launch = node->last_launch();
+
+    node->Stop(60000);
+    const digimobile::NodeSnapshot exit = node->Snapshot();
+    if (exit.exit_code != 0 || exit.exit_signal != 0) {
+        Die("digibyted did not shut down cleanly after a restart");
+    }
+
+    char json[256];
+    snprintf(json, sizeof(json),
+             "{\"warm\": %s, \"evicted_mb\": %.1f, \"prewarm_files\": %d, "
+             "\"prewarm_mb\": %.1f, \"prewarm_ms\": %lld, \"rpc_ready_ms\": %.1f}",
+             launch.warm ? "true" : "false", evicted / 1048576.0, launch.prewarm.files,
+             launch.prewarm.bytes / 1048576.0, static_cast<long long>(launch.prewarm.elapsed_ms),
+             ready_ms);
+    return json;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const Options options = ParseArgs(argc, argv);
+    digimobile::SetTraceEnabled(!options.trace.empty());
+    const std::string bin_dir = options.workdir + "/bin";
+    const std::string datadir = options.workdir + "/node";
+    MakeDirs(bin_dir);
+    MakeDirs(datadir);
+
+    const std::string stage_json = Stage(options, bin_dir);
+    const std::string extract_json = Extract(options, datadir);
+    WriteConfig(options, datadir);
+
+    // Follow debug.log before the daemon exists, as NodeManager does.
+    digimobile::DebugLogTailer tailer(4096);
+    std::string error;
+    MakeDirs(datadir + "/regtest");
+    if (!tailer.Start(datadir + "/regtest/debug.log", &error)) {
+        Die("tail debug.log: " + error);
+    }
+
+    // As nativeStartNode does, with the host binaries as assets; the paths
+    // are absolute, so the provider's root is empty.
+    digimobile::DirectoryAssetProvider assets("");
+    digimobile::StartRequest request;
+    request.config_path = datadir + "/digibyte.conf";
+    request.data_dir = datadir;
+    request.files_dir = options.workdir;
+    request.asset_stamp = kStageVersion;
+    request.daemon_asset = options.daemon;
+    request.cli_asset = options.cli;
+    request.embedded_library.clear();
+    digimobile::NodeController node;
+    const int64_t start = digimobile::MonotonicMillis();
+    const int64_t deadline = start + static_cast<int64_t>(options.timeout_s) * 1000;
+    node.Start(&assets, request);
+    if (node.status() != digimobile::NodeStatus::RUNNING) {
+        Die(std::string("start failed: ") + node.StatusString());
+    }
+
+    digimobile::RpcClient rpc("127.0.0.1", static_cast<uint16_t>(options.rpc_port), kRpcUser,
+                              kRpcPassword);
+    rpc.SetTimeoutMs(2000);
+    double rpc_ready_ms = -1;
+    double first_peer_ms = -1;
+    double tip_ms = -1;
+    int64_t start_height = -1;
+    int64_t height = -1;
+    int64_t first_tip_ms = -1;
+    int64_t last_tip_ms = -1;
+    int64_t tip_events = 0;
+    std::vector<digimobile::TipEvent> events(256);
+    std::string body;
+
+    while (tip_ms < 0) {
+        if (digimobile::MonotonicMillis() > deadline) {
+            node.Stop(10000);
+            Die("timed out at height " + std::to_string(height) + " of " +
+                std::to_string(options.target_height));
+        }
+        if (node.supervisor().phase() != digimobile::NodePhase::RUNNING) {
+            Die("digibyted exited during the benchmark; see " + datadir + "/regtest/debug.log");
+        }
+
+        const size_t count = tailer.PollTipEvents(events.data(), events.size(), kPollMs);
+        for (size_t i = 0; i < count; ++i) {
+            if (start_height >= 0 && events[i].height > start_height) {
+                ++tip_events;
+                if (first_tip_ms < 0) {
+                    first_tip_ms = digimobile::MonotonicMillis();
+                }
+                last_tip_ms = digimobile::MonotonicMillis();
+            }
+        }
+
+        if (rpc_ready_ms < 0) {
+            if (!RpcReady(&rpc, "getblockchaininfo", &body)) {
+                continue;
+            }
+            rpc_ready_ms = ElapsedMs(start);
+            start_height = JsonNumber(body, "blocks");
+        }
+        if (first_peer_ms < 0 && RpcReady(&rpc, "getconnectioncount", &body) &&
+            JsonNumber(body, "result") > 0) {
+            first_peer_ms = ElapsedMs(start);
+        }
+        if (RpcReady(&rpc, "getblockcount", &body)) {
+            height = JsonNumber(body, "result");
+            if (height >= options.target_height) {
+                tip_ms = ElapsedMs(start);
+            }
+        }
+    }
+
+    const int64_t stop_start = digimobile::MonotonicMillis();
+    node.Stop(60000);
+    const double stop_ms = ElapsedMs(stop_start);
+    const digimobile::NodeSnapshot exit = node.Snapshot();
+    tailer.Stop();
+
+    // The cold run also leaves the clean-shutdown marker the warm run needs,
+    // whether or not the stop above exited cleanly.
+    const int64_t restart_deadline =
+            digimobile::MonotonicMillis() + static_cast<int64_t>(options.timeout_s) * 1000;
+    const std::string cold_json = Restart(&node, &assets, request, &rpc, false, restart_deadline);
+    const std::string warm_json = Restart(&node, &assets, request, &rpc, true, restart_deadline);
+
+    std::string trace_error;
+    if (!options.trace.empty() && !digimobile::WriteTraceJson(options.trace, &trace_error)) {
+        fprintf(stderr, "node_bench: %s\n", trace_error.c_str());
+    }
+
+    const int64_t synced = options.target_height - std::max<int64_t>(start_height, 0);
+    const double sync_window_ms =
+            first_tip_ms >= 0 ? std::max<double>(static_cast<double>(last_tip_ms - first_tip_ms), 1.0)
+                              : 0.0;
+    time_t now = time(nullptr);
+    char timestamp[32];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    printf("{\n");
+    printf("  \"schema\": 1,\n");
+    printf("  \"timestamp\": \"%s\",\n", timestamp);
+    printf("  \"cpus\": %u,\n", std::thread::hardware_concurrency());
+    printf("  \"stage\": %s,\n", stage_json.c_str());
+    printf("  \"extract\": %s,\n", extract_json.c_str());
+    printf("  \"start\": {\"rpc_ready_ms\": %.1f, \"snapshot_height\": %lld},\n", rpc_ready_ms,
+           static_cast<long long>(start_height));
+    printf("  \"peers\": {\"first_peer_ms\": %.1f},\n", first_peer_ms);
+    printf("  \"sync\": {\"blocks\": %lld, \"tip_events\": %lld, \"time_to_tip_ms\": %.1f, "
+           "\"blocks_per_s\": %.1f},\n",
+           static_cast<long long>(synced), static_cast<long long>(tip_events), tip_ms,
+           sync_window_ms > 0 ? synced * 1000.0 / sync_window_ms : 0.0);
+    printf("  \"stop\": {\"ms\": %.1f, \"exit_code\": %d, \"signal\": %d},\n", stop_ms,
+           exit.exit_code, exit.exit_signal);
+    printf("  \"restart\": {\"cold\": %s, \"warm\": %s}\n", cold_json.c_str(), warm_json.c_str());
+    printf("}\n");
+    return 0;
+}
@@ -0,0 +1,282 @@
+#include "trace_recorder.h"
+
+#include <errno.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace digimobile {
+
+std::atomic<bool> g_trace_enabled{false};
+
+namespace {
+
+constexpr int64_t kInstant = -1;  // dur_ns of an instant event
+constexpr size_t kDetailWords = 3;
+
+// One event, guarded by a sequence number: odd while its owner rewrites it,
+// so a concurrent dump can tell a torn copy from a complete one.
+struct Slot {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<const char *> category{nullptr};
+    std::atomic<const char *> name{nullptr};
+    std::atomic<int64_t> start_ns{0};
+    std::atomic<int64_t> dur_ns{0};
+    std::atomic<int64_t> arg{0};
+    std::atomic<int32_t> tid{0};
+    std::atomic<uint64_t> detail[kDetailWords] = {};
+};
+
+struct Ring {
+    std::atomic<uint64_t> head{0};   // events ever written; only the owner stores
+    std::atomic<uint64_t> floor{0};  // events below this were cleared
+    std::atomic<bool> owned{true};
+    Slot slots[kTraceEventsPerThread];
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Ring>> rings;  // never freed: a dump may be reading them
+    std::map<int32_t, std::string> thread_names;
+};
+
+Registry &GetRegistry() {
+    static Registry *registry = new Registry;  // outlives thread_local destructors
+    return *registry;
+}
+
+// Hands the ring back for reuse when its thread exits.
+struct ThreadRing {
+    Ring *ring = nullptr;
+    int32_t tid = 0;
+    ~ThreadRing() {
+        if (ring) {
+            ring->owned.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadRing t_ring;
+
+int32_t CurrentTid() {
+    if (t_ring.tid == 0) {
+        t_ring.tid = static_cast<int32_t>(syscall(SYS_gettid));
+    }
+    return t_ring.tid;
+}
+
+Ring *CurrentRing() {
+    if (t_ring.ring) {
+        return t_ring.ring;
+    }
+    Registry &registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto &ring : registry.rings) {
+        bool owned = false;
+        if (ring->owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) {
+            t_ring.ring = ring.get();
+            return t_ring.ring;
+        }
+    }
+    registry.rings.push_back(std::make_unique<Ring>());
+    t_ring.ring = registry.rings.back().get();
+    return t_ring.ring;
+}
+
+void Record(const char *category, const char *name, int64_t start_ns, int64_t dur_ns,
+            int64_t arg, const char *detail) {
+    Ring *ring = CurrentRing();
+    const uint64_t n = ring->head.load(std::memory_order_relaxed);
+    Slot &slot = ring->slots[n % kTraceEventsPerThread];
+    uint64_t words[kDetailWords] = {};
+    if (detail) {
+        memcpy(words, detail, strnlen(detail, sizeof(words) - 1));
+    }
+
+    slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.category.store(category, std::memory_order_relaxed);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start_ns.store(start_ns, std::memory_order_relaxed);
+    slot.dur_ns.store(dur_ns, std::memory_order_relaxed);
+    slot.arg.store(arg, std::memory_order_relaxed);
+    slot.tid.store(CurrentTid(), std::memory_order_relaxed);
+    for (size_t i = 0; i < kDetailWords; ++i) {
+        slot.detail[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.seq.store(2 * n + 2, std::memory_order_release);
+    ring->head.store(n + 1, std::memory_order_release);
+}
+
+void AppendEscaped(const char *text, std::string *out) {
+    for (const char *p = text; *p; ++p) {
+        const unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\') {
+            out->push_back('\\');
+            out->push_back(static_cast<char>(c));
+        } else if (c < 0x20 || c >= 0x7f) {
+            out->push_back('?');
+        } else {
+            out->push_back(static_cast<char>(c));
+        }
+    }
+}
+
+// Microseconds with nanosecond precision, as the trace format expects.
+void AppendMicros(int64_t ns, std::string *out) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%lld.%03lld", static_cast<long long>(ns / 1000),
+             static_cast<long long>(ns % 1000));
+    out->append(buf);
+}
+
+} // namespace
+
+void SetTraceEnabled(bool enabled) { g_trace_enabled.store(enabled, std::memory_order_relaxed); }
+
+int64_t TraceNowNanos() {
+    timespec ts {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void TraceComplete(const char *category, const char *name, int64_t start_ns, int64_t end_ns,
+                   int64_t arg, const char *detail) {
+    if (TraceEnabled()) {
+        Record(category, name, start_ns, std::max<int64_t>(end_ns - start_ns, 0), arg, detail);
+    }
+}
+
+void TraceInstant(const char *category, const char *name, int64_t arg, const char *detail) {
+    if (TraceEnabled()) {
+        Record(category, name, TraceNowNanos(), kInstant, arg, detail);
+    }
+}
+
+void TraceSetThreadName(const char *name) {
+    const int32_t tid = CurrentTid();
+    Registry &registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.thread_names[tid] = name;
+}
+
+void ClearTrace() {
+    Registry &registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto &ring : registry.rings) {
+        ring->floor.store(ring->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+std::string TraceToJson() {
+    const long long pid = getpid();
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto begin_event = [&out, &first] {
+        if (!first) {
+            out.push_back(',');
+        }
+        first = false;
+        out.append("\n{");
+    };
+
+    Registry &registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    char buf[96];
+    for (const auto &entry : registry.thread_names) {
+        begin_event();
+        snprintf(buf, sizeof(buf), "\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%lld,\"tid\":%d,",
+                 pid, entry.first);
+        out.append(buf);
+        out.append("\"args\":{\"name\":\"");
+        AppendEscaped(entry.second.c_str(), &out);
+        out.append("\"}}");
+    }
+
+    for (const auto &ring : registry.rings) {
+        const uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t n = std::max(ring->floor.load(std::memory_order_relaxed),
+                              head > kTraceEventsPerThread ? head - kTraceEventsPerThread : 0);
+        for (; n < head; ++n) {
+            const Slot &slot = ring->slots[n % kTraceEventsPerThread];
+            const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq != 2 * n + 2) {
+                continue;  // overwritten since head was read
+            }
+            const char *category = slot.category.load(std::memory_order_relaxed);
+            const char *name = slot.name.load(std::memory_order_relaxed);
+            const int64_t start_ns = slot.start_ns.load(std::memory_order_relaxed);
+            const int64_t dur_ns = slot.dur_ns.load(std::memory_order_relaxed);
+            const int64_t arg = slot.arg.load(std::memory_order_relaxed);
+            const int32_t tid = slot.tid.load(std::memory_order_relaxed);
+            uint64_t words[kDetailWords];
+            for (size_t i = 0; i < kDetailWords; ++i) {
+                words[i] = slot.detail[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != seq) {
+                continue;
+            }
+
+            begin_event();
+            out.append("\"ph\":\"");
+            out.append(dur_ns == kInstant ? "i\",\"s\":\"t" : "X");
+            out.append("\",\"cat\":\"");
+            AppendEscaped(category, &out);
+            out.append("\",\"name\":\"");
+            AppendEscaped(name, &out);
+            snprintf(buf, sizeof(buf), "\",\"pid\":%lld,\"tid\":%d,\"ts\":", pid, tid);
+            out.append(buf);
+            AppendMicros(start_ns, &out);
+            if (dur_ns != kInstant) {
+                out.append(",\"dur\":");
+                AppendMicros(dur_ns, &out);
+            }
+            char detail[sizeof(words)];
+            memcpy(detail, words, sizeof(words));
+            detail[sizeof(detail) - 1] = '\0';
+            if (arg != kTraceNoArg || detail[0] != '\0') {
+                out.append(",\"args\":{");
+                if (arg != kTraceNoArg) {
+                    snprintf(buf, sizeof(buf), "\"value\":%lld", static_cast<long long>(arg));
+                    out.append(buf);
+                }
+                if (detail[0] != '\0') {
+                    out.append(arg != kTraceNoArg ? ",\"detail\":\"" : "\"detail\":\"");
+                    AppendEscaped(detail, &out);
+                    out.push_back('"');
+                }
+                out.push_back('}');
+            }
+            out.push_back('}');
+        }
+    }
+    out.append("\n]}\n");
+    return out;
+}
+
+bool WriteTraceJson(const std::string &path, std::string *error) {
+    const std::string json = TraceToJson();
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file) {
+        *error = "open " + path + ": " + strerror(errno);
+        return false;
+    }
+    const bool written = fwrite(json.data(), 1, json.size(), file) == json.size();
+    const int saved_errno = errno;
+    if (fclose(file) != 0 || !written) {
+        *error = "write " + path + ": " + strerror(written ? errno : saved_errno);
+        return false;
+    }
+    return true;
+}
+
+} // namespace digimobile
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace digimobile {
+
+// Timestamped spans of the node lifecycle and bridge calls (asset staging,
+// fork/exec, RPC round trips, extraction blocks, child exits), dumped on demand
+// as Chrome trace / Perfetto JSON.
+//
+// Each thread records into its own ring of the most recent kTraceEventsPerThread
+// events without taking a lock; only the first event on a thread registers its
+// ring. Recording is off by default, and a disabled TraceSpan costs one relaxed
+// load. Category and name must be string literals: only the pointers are kept.
+
+constexpr size_t kTraceEventsPerThread = 1024;
+constexpr int64_t kTraceNoArg = INT64_MIN;
+
+extern std::atomic<bool> g_trace_enabled;
+
+inline bool TraceEnabled() { return g_trace_enabled.load(std::memory_order_relaxed); }
+
+// Events already recorded are kept when tracing is turned off.
+void SetTraceEnabled(bool enabled);
+
+// CLOCK_MONOTONIC, the clock MonotonicMillis() and the tailer use.
+int64_t TraceNowNanos();
+
+// A finished span. detail is copied (truncated to 23 bytes) and may be null.
+void TraceComplete(const char *category, const char *name, int64_t start_ns, int64_t end_ns,
+                   int64_t arg = kTraceNoArg, const char *detail = nullptr);
+void TraceInstant(const char *category, const char *name, int64_t arg = kTraceNoArg,
+                  const char *detail = nullptr);
+
+// Label the calling thread in the dump ("supervisor", "extract inflate", ...).
+void TraceSetThreadName(const char *name);
+
+// Drop every recorded event; rings stay allocated for their threads.
+void ClearTrace();
+
+// {"traceEvents": [...]} with one "X" event per span, "i" per instant and "M"
+// thread names. Events still being written while this runs are skipped.
+std::string TraceToJson();
+bool WriteTraceJson(const std::string &path, std::string *error);
+
+// Records the enclosing scope as one span. The clock is read only if tracing
+// was enabled when the span began.
+class TraceSpan {
+public:
+    TraceSpan(const char *category, const char *name, int64_t arg = kTraceNoArg,
+              const char *detail = nullptr)
+        : category_(category), name_(name), detail_(detail), arg_(arg),
+          start_ns_(TraceEnabled() ? TraceNowNanos() : -1) {}
+    ~TraceSpan() {
+        if (start_ns_ >= 0) {
+            TraceComplete(category_, name_, start_ns_, TraceNowNanos(), arg_, detail_);
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    // A value only known at the end (bytes read, the child's PID, ...).
+    void set_arg(int64_t arg) { arg_ = arg; }
+
+private:
+    const char *category_;
+    const char *name_;
+    const char *detail_;  // must outlive the span
+    int64_t arg_;
+    int64_t start_ns_;
+};
+
+} // namespace digimobile
@@ -11,9 +11,12 @@
 #include <util/time.h>
 #include <version.h>
 
+#include <array>
 #include <memory>
 
-std::vector<uint8_t> ConstructPubKeyBytes(FuzzedDataProvider& fuzzed_data_provider, Span<const uint8_t> byte_data, const bool compressed) noexcept
+namespace {
+// Fills pk_data in place so callers generating many keys can reuse one buffer.
+void AssignPubKeyBytes(FuzzedDataProvider& fuzzed_data_provider, Span<const uint8_t> byte_data, const bool compressed, std::vector<uint8_t>& pk_data) noexcept
 {
     uint8_t pk_type;
     if (compressed) {
@@ -21,8 +24,15 @@ std::vector<uint8_t> ConstructPubKeyBytes(FuzzedDataProvider& fuzzed_data_provid
     } else {
         pk_type = fuzzed_data_provider.PickValueInArray({0x04, 0x06, 0x07});
     }
-    std::vector<uint8_t> pk_data{byte_data.begin(), byte_data.begin() + (compressed ? CPubKey::COMPRESSED_SIZE : CPubKey::SIZE)};
+    pk_data.assign(byte_data.begin(), byte_data.begin() + (compressed ? CPubKey::COMPRESSED_SIZE : CPubKey::SIZE));
     pk_data[0] = pk_type;
+}
+} // namespace
+
+std::vector<uint8_t> ConstructPubKeyBytes(FuzzedDataProvider& fuzzed_data_provider, Span<const uint8_t> byte_data, const bool compressed) noexcept
+{
+    std::vector<uint8_t> pk_data;
+    AssignPubKeyBytes(fuzzed_data_provider, byte_data, compressed, pk_data);
     return pk_data;
 }
 
@@ -49,33 +59,32 @@ CMutableTransaction ConsumeTransaction(FuzzedDataProvider& fuzzed_data_provider,
     tx_mut.nLockTime = fuzzed_data_provider.ConsumeIntegral<uint32_t>();
     const auto num_in = fuzzed_data_provider.ConsumeIntegralInRange<int>(0, max_num_in);
     const auto num_out = fuzzed_data_provider.ConsumeIntegralInRange<int>(0, max_num_out);
+    tx_mut.vin.reserve(num_in);
+    tx_mut.vout.reserve(num_out);
     for (int i = 0; i < num_in; ++i) {
         const auto& txid_prev = prevout_txids ?
                                     PickValue(fuzzed_data_provider, *prevout_txids) :
                                     ConsumeUInt256(fuzzed_data_provider);
         const auto index_out = fuzzed_data_provider.ConsumeIntegralInRange<uint32_t>(0, max_num_out);
         const auto sequence = ConsumeSequence(fuzzed_data_provider);
-        const auto script_sig = p2wsh_op_true ? CScript{} : ConsumeScript(fuzzed_data_provider);
+        auto script_sig = p2wsh_op_true ? CScript{} : ConsumeScript(fuzzed_data_provider);
         CScriptWitness script_wit;
         if (p2wsh_op_true) {
-            script_wit.stack = std::vector<std::vector<uint8_t>>{WITNESS_STACK_ELEM_OP_TRUE};
+            script_wit.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
         } else {
             script_wit = ConsumeScriptWitness(fuzzed_data_provider);
         }
-        CTxIn in;
-        in.prevout = COutPoint{txid_prev, index_out};
-        in.nSequence = sequence;
-        in.scriptSig = script_sig;
-        in.scriptWitness = script_wit;
-
-        tx_mut.vin.push_back(in);
+        // Move the generated scripts into place; they can be large and this
+        // runs for every input of every transaction a target consumes.
+        CTxIn& in = tx_mut.vin.emplace_back(COutPoint{txid_prev, index_out}, std::move(script_sig), sequence);
+        in.scriptWitness = std::move(script_wit);
     }
     for (int i = 0; i < num_out; ++i) {
         const auto amount = fuzzed_data_provider.ConsumeIntegralInRange<CAmount>(-10, 50 * COIN + 10);
-        const auto script_pk = p2wsh_op_true ?
-                                   P2WSH_OP_TRUE :
-                                   ConsumeScript(fuzzed_data_provider, /*maybe_p2wsh=*/true);
-        tx_mut.vout.emplace_back(amount, script_pk);
+        auto script_pk = p2wsh_op_true ?
+                             P2WSH_OP_TRUE :
+                             ConsumeScript(fuzzed_data_provider, /*maybe_p2wsh=*/true);
+        tx_mut.vout.emplace_back(amount, std::move(script_pk));
     }
     return tx_mut;
 }
@@ -84,6 +93,7 @@ CScriptWitness ConsumeScriptWitness(FuzzedDataProvider& fuzzed_data_provider, co
 {
     CScriptWitness ret;
     const auto n_elements = fuzzed_data_provider.ConsumeIntegralInRange<size_t>(0, max_stack_elem_size);
+    ret.stack.reserve(n_elements);
     for (size_t i = 0; i < n_elements; ++i) {
         ret.stack.push_back(ConsumeRandomLengthByteVector(fuzzed_data_provider));
     }
@@ -97,7 +107,12 @@ CScript ConsumeScript(FuzzedDataProvider& fuzzed_data_provider, const bool maybe
         // Keep a buffer of bytes to allow the fuzz engine to produce smaller
         // inputs to generate CScripts with repeated data.
         static constexpr unsigned MAX_BUFFER_SZ{128};
-        std::vector<uint8_t> buffer(MAX_BUFFER_SZ, uint8_t{'a'});
+        std::array<uint8_t, MAX_BUFFER_SZ> buffer;
+        buffer.fill(uint8_t{'a'});
+        // Scratch vectors for pushes, reused so a long script does not
+        // allocate once per element.
+        std::vector<uint8_t> push_bytes;
+        std::vector<uint8_t> pubkey_bytes;
         while (fuzzed_data_provider.ConsumeBool()) {
             CallOneOf(
                 fuzzed_data_provider,
@@ -107,7 +122,8 @@ CScript ConsumeScript(FuzzedDataProvider& fuzzed_data_provider, const bool maybe
                 },
                 [&] {
                     // Push a byte vector from the buffer
-                    r_script << std::vector<uint8_t>{buffer.begin(), buffer.begin() + fuzzed_data_provider.ConsumeIntegralInRange(0U, MAX_BUFFER_SZ)};
+                    push_bytes.assign(buffer.begin(), buffer.begin() + fuzzed_data_provider.ConsumeIntegralInRange(0U, MAX_BUFFER_SZ));
+                    r_script << push_bytes;
                 },
                 [&] {
                     // Push multisig
@@ -116,7 +132,7 @@ CScript ConsumeScript(FuzzedDataProvider& fuzzed_data_provider, const bool maybe
                     r_script << fuzzed_data_provider.ConsumeIntegralInRange<int64_t>(0, 22);
                     int num_data{fuzzed_data_provider.ConsumeIntegralInRange(1, 22)};
                     while (num_data--) {
-                        auto pubkey_bytes{ConstructPubKeyBytes(fuzzed_data_provider, buffer, fuzzed_data_provider.ConsumeBool())};
+                        AssignPubKeyBytes(fuzzed_data_provider, buffer, fuzzed_data_provider.ConsumeBool(), pubkey_bytes);
                         if (fuzzed_data_provider.ConsumeBool()) {
                             pubkey_bytes.back() = num_data; // Make each pubkey different
                         }
@@ -227,14 +243,31 @@ bool ContainsSpentInput(const CTransaction& tx, const CCoinsViewCache& inputs) n
     return false;
 }
 
-#if ((defined(__GLIBC__) && defined(_GNU_SOURCE)) || defined(__FreeBSD__)) && !defined(__ANDROID__) && !defined(__BIONIC__) && !defined(ANDROID)
+#if defined(__BIONIC__) || defined(__APPLE__)
+// funopen() hooks use int sizes and a different seek signature; they forward
+// to the fopencookie() hooks so both paths consume fuzzer input identically.
+static int FuzzedFileRead(void* cookie, char* buf, int size)
+{
+    return (int)FuzzedFileProvider::read(cookie, buf, size < 0 ? 0 : (size_t)size);
+}
+
+static int FuzzedFileWrite(void* cookie, const char* buf, int size)
+{
+    return (int)FuzzedFileProvider::write(cookie, buf, size < 0 ? 0 : (size_t)size);
+}
+
+static fpos_t FuzzedFileSeek(void* cookie, fpos_t offset, int whence)
+{
+    int64_t new_offset = offset;
+    if (FuzzedFileProvider::seek(cookie, &new_offset, whence) != 0) {
+        return -1;
+    }
+    return (fpos_t)new_offset;
+}
+#endif
+
 FILE* FuzzedFileProvider::open()
 {
-#if defined(__ANDROID__)
-    // Android's bionic libc lacks cookie_io_functions_t / fopencookie.
-    // This fuzz-only helper simply opts out when targeting Android.
-    return nullptr;
-#else
     SetFuzzedErrNo(m_fuzzed_data_provider);
     if (m_fuzzed_data_provider.ConsumeBool()) {
         return nullptr;
@@ -260,9 +293,16 @@ FILE* FuzzedFileProvider::open()
         [&] {
             mode = "a+";
         });
-    // cookie_io_functions_t / fopencookie are glibc and FreeBSD extensions
-    // and are not available in Android's bionic libc.
-#if defined _GNU_SOURCE && (defined(__linux__) || defined(__FreeBSD__))
+#if defined(__BIONIC__) || defined(__APPLE__)
+    // Android's bionic and Darwin lack fopencookie(); funopen() gives the same
+    // in-memory stream, with the mode expressed by which hooks are set.
+    const bool update = mode.size() > 1;
+    return funopen(this,
+                   mode[0] == 'r' || update ? FuzzedFileRead : nullptr,
+                   mode[0] != 'r' || update ? FuzzedFileWrite : nullptr,
+                   FuzzedFileSeek,
+                   FuzzedFileProvider::close);
+#elif defined _GNU_SOURCE && (defined(__linux__) || defined(__FreeBSD__))
     const cookie_io_functions_t io_hooks = {
         FuzzedFileProvider::read,
         FuzzedFileProvider::write,
@@ -274,7 +314,6 @@ FILE* FuzzedFileProvider::open()
     (void)mode;
     return nullptr;
 #endif
-#endif // defined(__ANDROID__)
 }
 
 ssize_t FuzzedFileProvider::read(void* cookie, char* buf, size_t size)
@@ -342,39 +381,3 @@ int FuzzedFileProvider::close(void* cookie)
     SetFuzzedErrNo(fuzzed_file->m_fuzzed_data_provider);
     return fuzzed_file->m_fuzzed_data_provider.ConsumeIntegralInRange<int>(-1, 0);
 }
-#else
-FILE* FuzzedFileProvider::open()
-{
-    return tmpfile();
-}
-
-ssize_t FuzzedFileProvider::read(void* cookie, char* buf, size_t size)
-{
-    (void)cookie;
-    (void)buf;
-    (void)size;
-    return -1;
-}
-
-ssize_t FuzzedFileProvider::write(void* cookie, const char* buf, size_t size)
-{
-    (void)cookie;
-    (void)buf;
-    (void)size;
-    return 0;
-}
-
-int FuzzedFileProvider::seek(void* cookie, int64_t* offset, int whence)
-{
-    (void)cookie;
-    (void)offset;
-    (void)whence;
-    return -1;
-}
-
-int FuzzedFileProvider::close(void* cookie)
-{
-    (void)cookie;
-    return 0;
-}
-#endif
@@ -0,0 +1,132 @@
+#!/usr/bin/env bash
+# Compare the default and perf DigiByte Core build profiles on the host.
+#
+# Usage: scripts/bench-core-profile.sh [output.json]
+#
+# Builds both profiles with scripts/build-core-host.sh (perf with PGO when
+# build-host/pgo/digibyted.profdata exists, see scripts/pgo-train-core.sh),
+# runs scripts/bench-node.sh against each, and times a -reindex of
+# REINDEX_BLOCKS (default 2000) regtest blocks with each binary on a copy of
+# the same datadir. The JSON result is printed and written to build-host/bench/
+# unless an output path is given; the per-profile bench-node results are kept
+# next to it as core-<profile>.json.
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+BENCH_DIR="${ROOT_DIR}/build-host/bench"
+REINDEX_BLOCKS="${REINDEX_BLOCKS:-2000}"
+RPC_PORT="${RPC_PORT:-18563}"
+
+log() {
+  echo "[bench-core-profile] $*" >&2
+}
+
+die() {
+  echo "[bench-core-profile] ERROR: $*" >&2
+  exit 1
+}
+
+PERF_PGO=off
+if [[ -f "${DGB_PGO_PROFILE:-${ROOT_DIR}/build-host/pgo/digibyted.profdata}" ]]; then
+  PERF_PGO=use
+fi
+
+log "Building the default profile"
+DGB_BUILD_PROFILE=default DGB_PGO=off "${ROOT_DIR}/scripts/build-core-host.sh" >&2
+log "Building the perf profile (PGO ${PERF_PGO})"
+DGB_BUILD_PROFILE=perf DGB_PGO="${PERF_PGO}" "${ROOT_DIR}/scripts/build-core-host.sh" >&2
+
+PERF_TAG=perf
+[[ "${PERF_PGO}" == "use" ]] && PERF_TAG=perf-pgo
+PROFILES=(default "${PERF_TAG}")
+
+mkdir -p "${BENCH_DIR}"
+OUTPUT="${1:-${BENCH_DIR}/core-profile-$(date +%Y%m%d-%H%M%S).json}"
+
+WORK_DIR="$(mktemp -d "${TMPDIR:-/tmp}/bench-core-profile.XXXXXX")"
+SEED_DIR="${WORK_DIR}/seed"
+RUN_DIR="${WORK_DIR}/run"
+mkdir -p "${SEED_DIR}"
+
+cli() {
+  local bin_dir="$1" data_dir="$2"
+  shift 2
+  "${bin_dir}/digibyte-cli" -regtest -datadir="${data_dir}" -rpcport="${RPC_PORT}" "$@"
+}
+
+stop_node() {
+  local bin_dir="$1" data_dir="$2"
+  cli "${bin_dir}" "${data_dir}" stop >/dev/null 2>&1 || true
+  while [[ -f "${data_dir}/regtest/digibyted.pid" ]]; do
+    sleep 0.2
+  done
+}
+
+start_node() {
+  local bin_dir="$1" data_dir="$2"
+  shift 2
+  "${bin_dir}/digibyted" -regtest -daemon -datadir="${data_dir}" -rpcport="${RPC_PORT}" \
+    -listen=0 -dnsseed=0 -fallbackfee=0.0001 "$@" >/dev/null
+  cli "${bin_dir}" "${data_dir}" -rpcwait getblockcount >/dev/null
+}
+
+now_ms() {
+  echo $(( $(date +%s%N) / 1000000 ))
+}
+
+cleanup() {
+  local profile
+  for profile in "${PROFILES[@]}"; do
+    stop_node "${ROOT_DIR}/build-host/bin/${profile}" "${RUN_DIR}"
+  done
+  stop_node "${ROOT_DIR}/build-host/bin/default" "${SEED_DIR}"
+  rm -rf "${WORK_DIR}"
+}
+trap cleanup EXIT
+
+SEED_BIN="${ROOT_DIR}/build-host/bin/default"
+log "Mining ${REINDEX_BLOCKS} regtest blocks for the reindex run"
+start_node "${SEED_BIN}" "${SEED_DIR}"
+cli "${SEED_BIN}" "${SEED_DIR}" createwallet bench >/dev/null
+address="$(cli "${SEED_BIN}" "${SEED_DIR}" getnewaddress)"
+left="${REINDEX_BLOCKS}"
+while (( left > 0 )); do
+  batch=$(( left < 500 ? left : 500 ))
+  cli "${SEED_BIN}" "${SEED_DIR}" generatetoaddress "${batch}" "${address}" >/dev/null
+  left=$(( left - batch ))
+done
+stop_node "${SEED_BIN}" "${SEED_DIR}"
+
+declare -A REINDEX_MS
+for profile in "${PROFILES[@]}"; do
+  bin_dir="${ROOT_DIR}/build-host/bin/${profile}"
+  log "bench-node with the ${profile} build"
+  DIGIBYTED="${bin_dir}/digibyted" DIGIBYTE_CLI="${bin_dir}/digibyte-cli" \
+    "${ROOT_DIR}/scripts/bench-node.sh" "${BENCH_DIR}/core-${profile}.json" >/dev/null
+
+  log "Reindex with the ${profile} build"
+  rm -rf "${RUN_DIR}"
+  cp -a "${SEED_DIR}" "${RUN_DIR}"
+  started="$(now_ms)"
+  start_node "${bin_dir}" "${RUN_DIR}" -reindex
+  while [[ "$(cli "${bin_dir}" "${RUN_DIR}" getblockcount)" -lt "${REINDEX_BLOCKS}" ]]; do
+    sleep 0.1
+  done
+  REINDEX_MS[${profile}]=$(( $(now_ms) - started ))
+  stop_node "${bin_dir}" "${RUN_DIR}"
+done
+
+{
+  printf '{\n  "reindex_blocks": %s,\n  "profiles": {\n' "${REINDEX_BLOCKS}"
+  sep=""
+  for profile in "${PROFILES[@]}"; do
+    printf '%s    "%s": {"reindex_ms": %s, "bench_node": ' "${sep}" "${profile}" "${REINDEX_MS[${profile}]}"
+    tr -d '\n' < "${BENCH_DIR}/core-${profile}.json"
+    printf '}'
+    sep=$',\n'
+  done
+  printf '\n  }\n}\n'
+} > "${OUTPUT}"
+
+cat "${OUTPUT}"
+log "Wrote ${OUTPUT}"
@@ -0,0 +1,158 @@
+#!/usr/bin/env bash
+# Compare fuzz throughput (exec/s) with and without
+# android/patches/0004-fuzz-util-allocation-free-generators.patch.
+#
+# Usage: scripts/bench-fuzz.sh [output.json]
+#
+# Builds DigiByte Core's fuzz binary (no libFuzzer, no sanitizers) twice, in
+# git worktrees of core/ at its pinned commit: "baseline" with every patch
+# except 0004, "patched" with all of them. Both binaries then replay the same
+# inputs for each target in FUZZ_TARGETS, FUZZ_REPEAT times, so the two runs
+# execute identical work (0004 consumes the fuzzer input exactly as before).
+#
+#   FUZZ_TARGETS  targets that generate transactions and scripts
+#                 (default: "policy_estimator rbf tx_pool_standard")
+#   FUZZ_CORPUS   a directory of inputs, e.g. a qa-assets fuzz_seed_corpus
+#                 checkout; otherwise FUZZ_INPUTS random inputs are generated
+#   FUZZ_INPUTS   number of generated inputs (default 2000, 64..4096 bytes)
+#   FUZZ_REPEAT   passes over the inputs per target (default 5)
+#
+# The JSON result is printed and written to build-host/bench/ unless an
+# output path is given.
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+CORE_DIR="${ROOT_DIR}/core"
+PATCH_DIR="${ROOT_DIR}/android/patches"
+BENCH_DIR="${ROOT_DIR}/build-host/bench"
+WORKTREE_DIR="${ROOT_DIR}/build-host/fuzz-bench"
+FUZZ_TARGETS="${FUZZ_TARGETS:-policy_estimator rbf tx_pool_standard}"
+FUZZ_INPUTS="${FUZZ_INPUTS:-2000}"
+FUZZ_REPEAT="${FUZZ_REPEAT:-5}"
+CHANGE_PATCH="0004-fuzz-util-allocation-free-generators.patch"
+
+log() {
+  echo "[bench-fuzz] $*" >&2
+}
+
+die() {
+  echo "[bench-fuzz] ERROR: $*" >&2
+  exit 1
+}
+
+[[ "$(uname -s)" == "Linux" ]] || die "the fuzz benchmark only runs on a Linux host"
+[[ -f "${PATCH_DIR}/${CHANGE_PATCH}" ]] || die "missing ${PATCH_DIR}/${CHANGE_PATCH}"
+for tool in git make autoconf automake libtool pkg-config; do
+  command -v "${tool}" >/dev/null 2>&1 || die "${tool} is required to build DigiByte Core"
+done
+
+log "Ensuring DigiByte Core repository is present via setup-core.sh"
+"${ROOT_DIR}/scripts/setup-core.sh" >&2
+git -C "${CORE_DIR}" rev-parse --verify HEAD >/dev/null 2>&1 \
+  || die "core/ is not a git checkout; run ./init-core-and-patch.sh first"
+CORE_COMMIT="$(git -C "${CORE_DIR}" rev-parse HEAD)"
+
+if command -v clang >/dev/null 2>&1 && command -v clang++ >/dev/null 2>&1; then
+  export CC="${CC:-clang}" CXX="${CXX:-clang++}"
+fi
+
+# $1: variant name; remaining arguments: patches to apply.
+build_variant() {
+  local variant="$1"
+  shift
+  local tree="${WORKTREE_DIR}/${variant}"
+  if [[ ! -d "${tree}" ]]; then
+    log "Creating the ${variant} worktree at ${CORE_COMMIT:0:12}"
+    git -C "${CORE_DIR}" worktree add --detach "${tree}" "${CORE_COMMIT}" >&2
+    local patch
+    for patch in "$@"; do
+      git -C "${tree}" apply "${patch}" || die "failed to apply $(basename "${patch}") to ${variant}"
+    done
+    (cd "${tree}" && ./autogen.sh >&2)
+    mkdir -p "${tree}/build"
+    (cd "${tree}/build" && ../configure \
+      --without-gui \
+      --disable-wallet \
+      --disable-tests \
+      --disable-bench \
+      --enable-fuzz-binary \
+      --disable-man \
+      --disable-zmq \
+      --with-miniupnpc=no \
+      CXXFLAGS="-O2 -g0" >&2)
+  fi
+  log "Building the ${variant} fuzz binary"
+  make -j"$(nproc)" -C "${tree}/build/src" test/fuzz/fuzz >&2
+}
+
+BASELINE_PATCHES=()
+ALL_PATCHES=()
+for patch in "${PATCH_DIR}"/*.patch; do
+  ALL_PATCHES+=("${patch}")
+  [[ "$(basename "${patch}")" == "${CHANGE_PATCH}" ]] || BASELINE_PATCHES+=("${patch}")
+done
+VARIANTS=(baseline patched)
+build_variant baseline "${BASELINE_PATCHES[@]}"
+build_variant patched "${ALL_PATCHES[@]}"
+
+INPUT_DIR="$(mktemp -d "${TMPDIR:-/tmp}/bench-fuzz.XXXXXX")"
+trap 'rm -rf "${INPUT_DIR}"' EXIT
+if [[ -n "${FUZZ_CORPUS:-}" ]]; then
+  [[ -d "${FUZZ_CORPUS}" ]] || die "FUZZ_CORPUS=${FUZZ_CORPUS} is not a directory"
+else
+  log "Generating ${FUZZ_INPUTS} random inputs"
+  for (( i = 0; i < FUZZ_INPUTS; ++i )); do
+    head -c $(( 64 + RANDOM % 4033 )) /dev/urandom > "${INPUT_DIR}/input-${i}"
+  done
+fi
+
+now_ns() {
+  date +%s%N
+}
+
+# $1: fuzz binary, $2: target, $3: inputs. Prints exec/s.
+measure() {
+  local binary="$1" target="$2" inputs="$3"
+  local count started elapsed pass
+  count="$(find "${inputs}" -type f | wc -l)"
+  (( count > 0 )) || die "no inputs in ${inputs}"
+  # Warm the page cache and fail early on a broken target.
+  FUZZ="${target}" "${binary}" "${inputs}" >/dev/null 2>&1 || die "${target} failed under ${binary}"
+  started="$(now_ns)"
+  for (( pass = 0; pass < FUZZ_REPEAT; ++pass )); do
+    FUZZ="${target}" "${binary}" "${inputs}" >/dev/null 2>&1
+  done
+  elapsed=$(( $(now_ns) - started ))
+  echo $(( count * FUZZ_REPEAT * 1000000000 / (elapsed > 0 ? elapsed : 1) ))
+}
+
+mkdir -p "${BENCH_DIR}"
+OUTPUT="${1:-${BENCH_DIR}/fuzz-$(date +%Y%m%d-%H%M%S).json}"
+
+known_targets="$(PRINT_ALL_FUZZ_TARGETS_AND_ABORT=1 "${WORKTREE_DIR}/patched/build/src/test/fuzz/fuzz" 2>&1 || true)"
+{
+  printf '{\n  "core": "%s",\n  "repeat": %s,\n  "targets": {\n' "${CORE_COMMIT}" "${FUZZ_REPEAT}"
+  sep=""
+  for target in ${FUZZ_TARGETS}; do
+    grep -qx "${target}" <<<"${known_targets}" || die "unknown fuzz target ${target}"
+    inputs="${INPUT_DIR}"
+    if [[ -n "${FUZZ_CORPUS:-}" ]]; then
+      inputs="${FUZZ_CORPUS}"
+      [[ -d "${FUZZ_CORPUS}/${target}" ]] && inputs="${FUZZ_CORPUS}/${target}"
+    fi
+    printf '%s    "%s": {' "${sep}" "${target}"
+    vsep=""
+    for variant in "${VARIANTS[@]}"; do
+      log "${target}: ${variant}"
+      rate="$(measure "${WORKTREE_DIR}/${variant}/build/src/test/fuzz/fuzz" "${target}" "${inputs}")"
+      printf '%s"%s_exec_per_s": %s' "${vsep}" "${variant}" "${rate}"
+      vsep=", "
+    done
+    printf '}'
+    sep=$',\n'
+  done
+  printf '\n  }\n}\n'
+} > "${OUTPUT}"
+
+cat "${OUTPUT}"
+log "Wrote ${OUTPUT}"
@@ -0,0 +1,97 @@
+#!/usr/bin/env bash
+# Benchmark node cold start, snapshot apply, time-to-tip and restarts on the host with
+# the same native code the app uses (android/jni/tools/node_bench.cpp).
+#
+# Usage: scripts/bench-node.sh [output.json]
+#
+# Needs a host build of digibyted and digibyte-cli (default core/src/, override
+# with DIGIBYTED / DIGIBYTE_CLI). A source regtest node mines SNAPSHOT_BLOCKS
+# (default 200), which are packed into a snapshot; it then mines SYNC_BLOCKS
+# more (default 1000) for the benchmarked node to sync from it. The JSON result
+# is printed and written to build-host/bench/ unless an output path is given.
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+JNI_DIR="${ROOT_DIR}/android/jni"
+BUILD_DIR="${ROOT_DIR}/build-host/jni"
+TOOL="${BUILD_DIR}/node_bench"
+BENCH_DIR="${ROOT_DIR}/build-host/bench"
+DIGIBYTED="${DIGIBYTED:-${ROOT_DIR}/core/src/digibyted}"
+DIGIBYTE_CLI="${DIGIBYTE_CLI:-${ROOT_DIR}/core/src/digibyte-cli}"
+SNAPSHOT_BLOCKS="${SNAPSHOT_BLOCKS:-200}"
+SYNC_BLOCKS="${SYNC_BLOCKS:-1000}"
+SOURCE_P2P_PORT="${SOURCE_P2P_PORT:-18544}"
+SOURCE_RPC_PORT="${SOURCE_RPC_PORT:-18545}"
+BENCH_RPC_PORT="${BENCH_RPC_PORT:-18543}"
+
+log() {
+  echo "[bench-node] $*" >&2
+}
+
+die() {
+  echo "[bench-node] ERROR: $*" >&2
+  exit 1
+}
+
+[[ -x "${DIGIBYTED}" ]] || die "digibyted missing at ${DIGIBYTED} (override with DIGIBYTED)"
+[[ -x "${DIGIBYTE_CLI}" ]] || die "digibyte-cli missing at ${DIGIBYTE_CLI} (override with DIGIBYTE_CLI)"
+command -v cmake >/dev/null 2>&1 || die "cmake is required to build ${TOOL}"
+
+mkdir -p "${BENCH_DIR}"
+log "Building ${TOOL}"
+cmake -S "${JNI_DIR}" -B "${BUILD_DIR}" -DCMAKE_BUILD_TYPE=Release >/dev/null
+cmake --build "${BUILD_DIR}" --target node_bench >/dev/null
+
+WORK_DIR="$(mktemp -d "${TMPDIR:-/tmp}/bench-node.XXXXXX")"
+SOURCE_DIR="${WORK_DIR}/source"
+mkdir -p "${SOURCE_DIR}"
+CLI=("${DIGIBYTE_CLI}" -regtest -datadir="${SOURCE_DIR}" -rpcport="${SOURCE_RPC_PORT}")
+
+start_source() {
+  "${DIGIBYTED}" -regtest -daemon -datadir="${SOURCE_DIR}" -port="${SOURCE_P2P_PORT}" \
+    -rpcport="${SOURCE_RPC_PORT}" -listen=1 -bind=127.0.0.1 -dnsseed=0 -fallbackfee=0.0001 >/dev/null
+  "${CLI[@]}" -rpcwait getblockcount >/dev/null
+}
+
+stop_source() {
+  "${CLI[@]}" stop >/dev/null 2>&1 || true
+  while [[ -f "${SOURCE_DIR}/regtest/digibyted.pid" ]]; do
+    sleep 0.2
+  done
+}
+
+mine() {
+  "${CLI[@]}" createwallet bench >/dev/null 2>&1 || "${CLI[@]}" loadwallet bench >/dev/null 2>&1 || true
+  local address
+  address="$("${CLI[@]}" getnewaddress)"
+  local left="$1"
+  while (( left > 0 )); do
+    local batch=$(( left < 500 ? left : 500 ))
+    "${CLI[@]}" generatetoaddress "${batch}" "${address}" >/dev/null
+    left=$(( left - batch ))
+  done
+}
+
+cleanup() {
+  stop_source
+  rm -rf "${WORK_DIR}"
+}
+trap cleanup EXIT
+
+log "Mining ${SNAPSHOT_BLOCKS} regtest blocks for the snapshot"
+start_source
+mine "${SNAPSHOT_BLOCKS}"
+stop_source
+tar czf "${WORK_DIR}/snapshot.tar.gz" -C "${SOURCE_DIR}" regtest/blocks regtest/chainstate
+
+log "Mining ${SYNC_BLOCKS} more blocks to sync"
+start_source
+mine "${SYNC_BLOCKS}"
+TARGET_HEIGHT="$("${CLI[@]}" getblockcount)"
+
+OUTPUT="${1:-${BENCH_DIR}/node-bench-$(date -u +%Y%m%d-%H%M%S).json}"
+log "Benchmarking against height ${TARGET_HEIGHT}"
+"${TOOL}" --daemon "${DIGIBYTED}" --cli "${DIGIBYTE_CLI}" --workdir "${WORK_DIR}/bench" \
+  --snapshot "${WORK_DIR}/snapshot.tar.gz" --connect "127.0.0.1:${SOURCE_P2P_PORT}" \
+  --target-height "${TARGET_HEIGHT}" --rpc-port "${BENCH_RPC_PORT}" | tee "${OUTPUT}"
+log "Wrote ${OUTPUT}"
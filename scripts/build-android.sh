@@ -16,6 +16,11 @@ ENV_SETUP_SCRIPT="${ROOT_DIR}/android/toolchain/env-setup.sh"
 CMAKE_BUILD_ROOT="${ROOT_DIR}/android/build"
 JNI_LIBS_DIR="${ROOT_DIR}/android/app/src/main/jniLibs"
 CMAKE_GENERATOR="Ninja"
+# Set DGB_BUILD_EMBEDDED_NODE=1 to also link libdigibyted.so so the app can run
+# the node in-process (the JNI bridge falls back to the digibyted asset).
+DGB_BUILD_EMBEDDED_NODE="${DGB_BUILD_EMBEDDED_NODE:-0}"
+# Set DGB_BUILD_PROFILE=perf (optionally with DGB_PGO=use) for a ThinLTO/PGO
+# build of DigiByte Core; see scripts/core-build-profile.sh.
 EXPECTED_ABI="arm64-v8a"
 
 verify_arm64_artifact() {
@@ -42,10 +47,16 @@ die() {
 source "${VERSIONS_FILE}"
 # shellcheck source=/dev/null
 source "${ENV_SETUP_SCRIPT}"
+# shellcheck source=core-build-profile.sh
+source "${SCRIPT_DIR}/core-build-profile.sh"
 
 build_digibyte_for_abi() {
   local ABI="$1"
+  core_build_profile "${ROOT_DIR}" "${CMAKE_BUILD_ROOT}/lto-cache-${ABI}"
   local CMAKE_BUILD_DIR="${CMAKE_BUILD_ROOT}/${ABI}"
+  if [[ "${CORE_PROFILE_TAG}" != "default" ]]; then
+    CMAKE_BUILD_DIR+="-${CORE_PROFILE_TAG}"
+  fi
   local ANDROID_PREFIX="${CMAKE_BUILD_DIR}/android-prefix/${ABI}"
   local BIN_DIR="${ANDROID_PREFIX}/bin"
   local LIB_DIR="${ANDROID_PREFIX}/lib"
@@ -166,11 +177,22 @@ EOF
     -DCMAKE_CXX_COMPILER="${CXX}" \
     -DCMAKE_AR="${AR}" \
     -DCMAKE_RANLIB="${RANLIB}" \
-    -DCMAKE_LINKER="${LD}"
+    -DCMAKE_LINKER="${LD}" \
+    -DDGB_BUILD_EMBEDDED_NODE="$([[ "${DGB_BUILD_EMBEDDED_NODE}" == "1" ]] && echo ON || echo OFF)" \
+    -DDGB_EXTRA_CFLAGS="${CORE_PROFILE_CFLAGS}" \
+    -DDGB_EXTRA_LDFLAGS="${CORE_PROFILE_LDFLAGS}"
+
+  core_report_dispatch "${CMAKE_BUILD_DIR}/core-build-${ABI}" ENABLE_ARM_SHANI ENABLE_ARM_CRC
 
-  log "Building digibyted for Android (${ABI})"
+  log "Building digibyted for Android (${ABI}, ${CORE_PROFILE_TAG} profile)"
   cmake --build "${CMAKE_BUILD_DIR}" --target digibyted
 
+  if [[ "${DGB_BUILD_EMBEDDED_NODE}" == "1" ]]; then
+    log "Building in-process node library (libdigibyted.so)"
+    cmake --build "${CMAKE_BUILD_DIR}" --target digibyted_embedded
+    [[ -f "${LIB_DIR}/libdigibyted.so" ]] || die "libdigibyted.so missing at ${LIB_DIR}; embedded build may have failed."
+  fi
+
   log "Building JNI bridge (libdigimobile_jni.so)"
   cmake --build "${CMAKE_BUILD_DIR}" --target digimobile_jni
 
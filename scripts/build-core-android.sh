@@ -4,11 +4,13 @@
 # This script is intentionally focused on producing the digibyted binary for
 # embedding inside the Digi-Mobile Android APK. It does not modify consensus
 # logic. Only the daemon is built (no GUI, tests, or benchmarks).
+#
+# DGB_BUILD_PROFILE=perf builds with ThinLTO and, with DGB_PGO=use, a recorded
+# profile; see scripts/core-build-profile.sh.
 set -euo pipefail
 
 ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
 CORE_DIR="${ROOT_DIR}/core"
-ANDROID_BUILD_DIR="${CORE_DIR}/build-android-arm64"
 OUTPUT_DIR="${ROOT_DIR}/build-android/bin/arm64-v8a"
 API_LEVEL="${API_LEVEL:-24}"
 
@@ -33,6 +35,14 @@ resolve_ndk() {
   fi
 }
 
+# shellcheck source=core-build-profile.sh
+source "${ROOT_DIR}/scripts/core-build-profile.sh"
+core_build_profile "${ROOT_DIR}" "${CORE_DIR}/build-android-arm64-lto-cache"
+ANDROID_BUILD_DIR="${CORE_DIR}/build-android-arm64"
+if [[ "${CORE_PROFILE_TAG}" != "default" ]]; then
+  ANDROID_BUILD_DIR+="-${CORE_PROFILE_TAG}"
+fi
+
 log "Ensuring DigiByte Core repository is present via setup-core.sh"
 "${ROOT_DIR}/scripts/setup-core.sh"
 
@@ -56,6 +66,14 @@ export CC="${TOOLCHAIN}/bin/aarch64-linux-android${API_LEVEL}-clang"
 export CXX="${TOOLCHAIN}/bin/aarch64-linux-android${API_LEVEL}-clang++"
 export LD="${TOOLCHAIN}/bin/ld"
 export STRIP="${TOOLCHAIN}/bin/llvm-strip"
+# libtool reads symbols out of the archives, which hold LLVM bitcode under LTO.
+export NM="${TOOLCHAIN}/bin/llvm-nm"
+export RANLIB="${TOOLCHAIN}/bin/llvm-ranlib"
+
+PROFILE_ARGS=(CXXFLAGS="-fPIC ${CORE_PROFILE_CFLAGS}")
+if [[ -n "${CORE_PROFILE_CFLAGS}" ]]; then
+  PROFILE_ARGS+=(CFLAGS="${CORE_PROFILE_CFLAGS}" LDFLAGS="${CORE_PROFILE_LDFLAGS}")
+fi
 
 pushd "${ANDROID_BUILD_DIR}" >/dev/null
 # We only need the headless daemon for Android; GUI, tests, and benches are disabled.
@@ -65,9 +83,10 @@ pushd "${ANDROID_BUILD_DIR}" >/dev/null
   --disable-tests \
   --disable-bench \
   --with-daemon \
-  CXXFLAGS="-fPIC"
+  "${PROFILE_ARGS[@]}"
+core_report_dispatch "${ANDROID_BUILD_DIR}" ENABLE_ARM_SHANI ENABLE_ARM_CRC
 
-log "Building DigiByte Core for Android (this may take a while)"
+log "Building DigiByte Core for Android, ${CORE_PROFILE_TAG} profile (this may take a while)"
 make -j"$(nproc)"
 
 BIN_SOURCE="src/digibyted"
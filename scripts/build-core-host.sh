@@ -0,0 +1,82 @@
+#!/usr/bin/env bash
+# Build digibyted and digibyte-cli for the Linux host with a Core build profile
+# (see scripts/core-build-profile.sh), for PGO training and for comparing
+# profiles with scripts/bench-core-profile.sh.
+#
+#   DGB_BUILD_PROFILE=perf DGB_PGO=use scripts/build-core-host.sh
+#
+# Each profile builds in core/build-host-<profile> and installs its binaries
+# to build-host/bin/<profile>/, so profiles never share objects.
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT_DIR="$(cd "${SCRIPT_DIR}/.." && pwd)"
+CORE_DIR="${ROOT_DIR}/core"
+
+log() {
+  echo "[build-core-host] $*"
+}
+
+die() {
+  echo "[build-core-host] ERROR: $*" >&2
+  exit 1
+}
+
+# shellcheck source=core-build-profile.sh
+source "${SCRIPT_DIR}/core-build-profile.sh"
+
+[[ "$(uname -s)" == "Linux" ]] || die "host build is only supported on Linux"
+
+HOST_BUILD_DIR="${CORE_DIR}/build-host-${DGB_BUILD_PROFILE}"
+core_build_profile "${ROOT_DIR}" "${HOST_BUILD_DIR}-lto-cache"
+HOST_BUILD_DIR="${CORE_DIR}/build-host-${CORE_PROFILE_TAG}"
+OUTPUT_DIR="${ROOT_DIR}/build-host/bin/${CORE_PROFILE_TAG}"
+
+if [[ "${DGB_BUILD_PROFILE}" == "perf" ]]; then
+  # ThinLTO and the .profraw/.profdata formats are clang's, so the whole
+  # toolchain has to be LLVM: archives of bitcode need llvm-ar and llvm-nm.
+  for tool in clang clang++ ld.lld llvm-ar llvm-nm llvm-ranlib; do
+    command -v "${tool}" >/dev/null 2>&1 || die "${tool} is required for DGB_BUILD_PROFILE=perf"
+  done
+  export CC=clang CXX=clang++ AR=llvm-ar NM=llvm-nm RANLIB=llvm-ranlib
+elif command -v clang >/dev/null 2>&1 && command -v clang++ >/dev/null 2>&1; then
+  # Same compiler for both profiles, so a benchmark compares flags only.
+  export CC="${CC:-clang}" CXX="${CXX:-clang++}"
+fi
+
+log "Ensuring DigiByte Core repository is present via setup-core.sh"
+"${ROOT_DIR}/scripts/setup-core.sh"
+
+if [[ ! -x "${CORE_DIR}/configure" ]]; then
+  log "Preparing DigiByte Core build system (autogen)"
+  (cd "${CORE_DIR}" && ./autogen.sh)
+fi
+
+mkdir -p "${HOST_BUILD_DIR}" "${OUTPUT_DIR}"
+
+PROFILE_ARGS=(CXXFLAGS="-fPIC ${CORE_PROFILE_CFLAGS}")
+if [[ -n "${CORE_PROFILE_CFLAGS}" ]]; then
+  PROFILE_ARGS+=(CFLAGS="${CORE_PROFILE_CFLAGS}" LDFLAGS="${CORE_PROFILE_LDFLAGS}")
+fi
+
+log "Configuring DigiByte Core for the host (${CORE_PROFILE_TAG} profile)"
+pushd "${HOST_BUILD_DIR}" >/dev/null
+../configure \
+  --without-gui \
+  --disable-tests \
+  --disable-bench \
+  --disable-fuzz \
+  --disable-man \
+  --disable-zmq \
+  --with-miniupnpc=no \
+  "${PROFILE_ARGS[@]}"
+
+core_report_dispatch "${HOST_BUILD_DIR}" \
+  ENABLE_SSE41 ENABLE_AVX2 ENABLE_X86_SHANI ENABLE_ARM_SHANI ENABLE_ARM_CRC
+
+log "Building digibyted and digibyte-cli (this may take a while)"
+make -j"$(nproc)" -C src digibyted digibyte-cli
+popd >/dev/null
+
+install -m 0755 "${HOST_BUILD_DIR}/src/digibyted" "${HOST_BUILD_DIR}/src/digibyte-cli" "${OUTPUT_DIR}/"
+log "Installed ${OUTPUT_DIR}/digibyted and ${OUTPUT_DIR}/digibyte-cli"
@@ -0,0 +1,68 @@
+#!/usr/bin/env bash
+# Build libdigibyted.so (DigiByte Core linked as an in-process library, see
+# android/embed/digibyted_api.h) for the Linux host.
+#
+# The host library exercises the same init/shutdown/RPC entry points the app
+# uses on device, so start-up and in-process RPC can be checked on a
+# workstation (e.g. against -regtest) without an emulator. Consensus code is
+# untouched; only the daemon's libraries are built.
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+CORE_DIR="${ROOT_DIR}/core"
+HOST_BUILD_DIR="${CORE_DIR}/build-host"
+EMBED_BUILD_DIR="${ROOT_DIR}/build-host/embed"
+OUTPUT_DIR="${ROOT_DIR}/build-host/lib"
+
+log() {
+  echo "[build-embedded-node-host] $*"
+}
+
+die() {
+  echo "[build-embedded-node-host] ERROR: $*" >&2
+  exit 1
+}
+
+[[ "$(uname -s)" == "Linux" ]] || die "host build is only supported on Linux"
+command -v cmake >/dev/null 2>&1 || die "cmake is required"
+
+log "Ensuring DigiByte Core repository is present via setup-core.sh"
+"${ROOT_DIR}/scripts/setup-core.sh"
+
+if [[ ! -x "${CORE_DIR}/configure" ]]; then
+  log "Preparing DigiByte Core build system (autogen)"
+  (cd "${CORE_DIR}" && ./autogen.sh)
+fi
+
+mkdir -p "${HOST_BUILD_DIR}" "${EMBED_BUILD_DIR}" "${OUTPUT_DIR}"
+
+log "Configuring DigiByte Core for the host (position-independent, no GUI/tests/bench)"
+pushd "${HOST_BUILD_DIR}" >/dev/null
+../configure \
+  --without-gui \
+  --disable-tests \
+  --disable-bench \
+  --disable-fuzz \
+  --disable-man \
+  --disable-zmq \
+  --with-miniupnpc=no \
+  --without-bdb \
+  --enable-reduce-exports \
+  CFLAGS="-O2 -fPIC" \
+  CXXFLAGS="-O2 -fPIC"
+
+log "Building DigiByte Core libraries (this may take a while)"
+make -j"$(nproc)"
+popd >/dev/null
+
+log "Linking libdigibyted.so"
+cmake -S "${ROOT_DIR}/android/embed" -B "${EMBED_BUILD_DIR}" \
+  -DCMAKE_BUILD_TYPE=Release \
+  -DCMAKE_INSTALL_PREFIX="${ROOT_DIR}/build-host" \
+  -DDIGIBYTE_CORE_SOURCE_DIR="${CORE_DIR}" \
+  -DDIGIBYTE_CORE_BUILD_DIR="${HOST_BUILD_DIR}"
+cmake --build "${EMBED_BUILD_DIR}" -j"$(nproc)"
+cmake --install "${EMBED_BUILD_DIR}"
+
+[[ -f "${OUTPUT_DIR}/libdigibyted.so" ]] || die "libdigibyted.so not produced under ${OUTPUT_DIR}"
+log "Success: build-host/lib/libdigibyted.so and build-host/include/digibyted_api.h"
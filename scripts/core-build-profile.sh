@@ -0,0 +1,86 @@
+#!/usr/bin/env bash
+# DigiByte Core build profiles, sourced by build-android.sh,
+# build-core-android.sh and build-core-host.sh so every Core build applies
+# the same flags. The sourcing script provides log() and die().
+#
+#   DGB_BUILD_PROFILE=default  the flags the scripts have always used
+#   DGB_BUILD_PROFILE=perf     -O2 and ThinLTO (clang and lld)
+#   DGB_PGO=generate           perf, instrumented: runs write LLVM_PROFILE_FILE
+#   DGB_PGO=use                perf, optimized with DGB_PGO_PROFILE (default
+#                              build-host/pgo/digibyted.profdata, recorded by
+#                              scripts/pgo-train-core.sh)
+#
+# SHA-256 and CRC32C kernels for the CPU extensions (ARMv8 SHA2/CRC, SSE4.1,
+# AVX2, SHA-NI) are compiled by Core's configure whenever the compiler
+# supports them and picked at runtime after checking the CPU, so no profile
+# sets -march: the binary still runs on cores without the extensions.
+
+DGB_BUILD_PROFILE="${DGB_BUILD_PROFILE:-default}"
+DGB_PGO="${DGB_PGO:-off}"
+
+# Sets CORE_PROFILE_TAG (names build and output directories, so profiles never
+# share objects), CORE_PROFILE_CFLAGS and CORE_PROFILE_LDFLAGS, which callers
+# append after their own flags so the optimization level here wins.
+#   $1  repository root
+#   $2  ThinLTO cache directory, reused across incremental links
+core_build_profile() {
+  local root_dir="$1"
+  local lto_cache_dir="$2"
+  CORE_PROFILE_TAG="${DGB_BUILD_PROFILE}"
+  CORE_PROFILE_CFLAGS=""
+  CORE_PROFILE_LDFLAGS=""
+
+  case "${DGB_BUILD_PROFILE}" in
+    default)
+      [[ "${DGB_PGO}" == "off" ]] || die "DGB_PGO=${DGB_PGO} needs DGB_BUILD_PROFILE=perf"
+      return 0
+      ;;
+    perf) ;;
+    *) die "Unknown DGB_BUILD_PROFILE '${DGB_BUILD_PROFILE}' (expected default or perf)" ;;
+  esac
+
+  CORE_PROFILE_CFLAGS="-O2 -flto=thin"
+  CORE_PROFILE_LDFLAGS="-O2 -flto=thin -fuse-ld=lld -Wl,--thinlto-cache-dir=${lto_cache_dir}"
+
+  case "${DGB_PGO}" in
+    off) ;;
+    generate)
+      CORE_PROFILE_TAG="perf-pgo-generate"
+      CORE_PROFILE_CFLAGS+=" -fprofile-generate"
+      CORE_PROFILE_LDFLAGS+=" -fprofile-generate"
+      ;;
+    use)
+      local profile="${DGB_PGO_PROFILE:-${root_dir}/build-host/pgo/digibyted.profdata}"
+      [[ -f "${profile}" ]] || die "PGO profile ${profile} missing; record one with scripts/pgo-train-core.sh"
+      CORE_PROFILE_TAG="perf-pgo"
+      # Functions the workload never reached, or code that changed since it was
+      # recorded, fall back to the static heuristics instead of failing.
+      CORE_PROFILE_CFLAGS+=" -fprofile-use=${profile} -Wno-profile-instr-unprofiled"
+      CORE_PROFILE_CFLAGS+=" -Wno-profile-instr-out-of-date -Wno-backend-plugin"
+      CORE_PROFILE_LDFLAGS+=" -fprofile-use=${profile}"
+      ;;
+    *) die "Unknown DGB_PGO '${DGB_PGO}' (expected off, generate or use)" ;;
+  esac
+}
+
+# Log which runtime-dispatched kernels Core's configure enabled.
+#   $1     Core build directory
+#   $2...  config defines to report, e.g. ENABLE_ARM_SHANI
+core_report_dispatch() {
+  local build_dir="$1"
+  shift
+  local config_h
+  config_h="$(ls "${build_dir}"/src/config/*-config.h 2>/dev/null | head -n1 || true)"
+  if [[ -z "${config_h}" ]]; then
+    log "No config header under ${build_dir}/src/config; cannot report CPU kernels"
+    return 0
+  fi
+  local define
+  for define in "$@"; do
+    if grep -q "^#define ${define} 1" "${config_h}"; then
+      log "CPU kernel ${define}: enabled"
+    else
+      log "CPU kernel ${define}: not built (compiler lacks the target flags?)"
+    fi
+  done
+}
@@ -0,0 +1,48 @@
+#!/usr/bin/env bash
+# Export blocks from a synced node as a block bundle (android/jni/block_bundle.h)
+# that the app imports instead of downloading those blocks from peers.
+#
+# Usage: scripts/make-block-bundle.sh <network-datadir> <start-height> <end-height> <output> [tool options]
+#   e.g. scripts/make-block-bundle.sh ~/.digibyte 0 1000000 dgb-mainnet-0-1000000.dgbblocks
+#
+# <network-datadir> is where the node keeps blocks/ and .cookie (~/.digibyte
+# for mainnet, ~/.digibyte/regtest for regtest); the node must be running.
+# Tool options (--rpc-host, --rpc-port, --rpc-user, --rpc-password, --batch,
+# --magic) are passed through. Copy <output> and <output>.headers to the
+# device's Android/data/<package>/files/ directory; the app imports the
+# bundle at its next node start. The bundle has to start at most one block
+# past the device's tip, e.g. at height 0 on a fresh node.
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+JNI_DIR="${ROOT_DIR}/android/jni"
+BUILD_DIR="${ROOT_DIR}/build-host/jni"
+TOOL="${BUILD_DIR}/block_bundle"
+
+log() {
+  echo "[make-block-bundle] $*"
+}
+
+die() {
+  echo "[make-block-bundle] ERROR: $*" >&2
+  exit 1
+}
+
+[[ $# -ge 4 ]] || die "usage: $0 <network-datadir> <start-height> <end-height> <output> [tool options]"
+command -v cmake >/dev/null 2>&1 || die "cmake is required to build ${TOOL}"
+
+log "Building ${TOOL}"
+cmake -S "${JNI_DIR}" -B "${BUILD_DIR}" -DCMAKE_BUILD_TYPE=Release >/dev/null
+cmake --build "${BUILD_DIR}" --target block_bundle >/dev/null
+
+DATADIR="$1"
+START="$2"
+END="$3"
+OUTPUT="$4"
+shift 4
+[[ -d "${DATADIR}/blocks" ]] || die "${DATADIR} has no blocks/"
+[[ "${OUTPUT}" == *.dgbblocks ]] || log "The app only picks up bundles named *.dgbblocks"
+
+log "Exporting blocks ${START}-${END} from ${DATADIR} into ${OUTPUT}"
+"${TOOL}" make "$@" "${DATADIR}" "${START}" "${END}" "${OUTPUT}"
+log "Wrote ${OUTPUT} and ${OUTPUT}.headers"
@@ -0,0 +1,38 @@
+#!/usr/bin/env bash
+# Write <archive>.chunks, the per-chunk SHA-256 list the app's ranged snapshot
+# downloader (SnapshotDownloader.kt) checks each chunk against. Publish it next
+# to the archive, i.e. at "<snapshot URL>.chunks".
+#
+# Format: the chunk size in bytes on the first line, then one lowercase hex
+# SHA-256 per chunk in file order. The chunk size must match the app's
+# SnapshotDownloader.DEFAULT_CHUNK_SIZE or the manifest is ignored.
+set -euo pipefail
+
+CHUNK_SIZE_DEFAULT=$((16 * 1024 * 1024))
+
+log() {
+  echo "[make-snapshot-chunk-manifest] $*"
+}
+
+die() {
+  echo "[make-snapshot-chunk-manifest] ERROR: $*" >&2
+  exit 1
+}
+
+[[ $# -ge 1 && $# -le 2 ]] || die "usage: $0 <archive> [chunk-size-bytes]"
+ARCHIVE="$1"
+CHUNK_SIZE="${2:-${CHUNK_SIZE_DEFAULT}}"
+[[ -f "${ARCHIVE}" ]] || die "archive not found: ${ARCHIVE}"
+[[ "${CHUNK_SIZE}" =~ ^[0-9]+$ && "${CHUNK_SIZE}" -gt 0 ]] || die "invalid chunk size: ${CHUNK_SIZE}"
+split --version >/dev/null 2>&1 || die "GNU coreutils split is required"
+
+OUTPUT="${ARCHIVE}.chunks"
+log "Hashing ${ARCHIVE} in ${CHUNK_SIZE}-byte chunks"
+{
+  echo "${CHUNK_SIZE}"
+  split -b "${CHUNK_SIZE}" --filter='sha256sum | cut -d" " -f1' "${ARCHIVE}"
+} > "${OUTPUT}.tmp"
+mv "${OUTPUT}.tmp" "${OUTPUT}"
+
+log "Wrote $(($(wc -l < "${OUTPUT}") - 1)) chunk hashes to ${OUTPUT}"
+log "Whole-file SHA-256 (SNAPSHOT_SHA256): $(sha256sum "${ARCHIVE}" | cut -d' ' -f1)"
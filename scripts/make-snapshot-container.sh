@@ -0,0 +1,43 @@
+#!/usr/bin/env bash
+# Pack a synced datadir's chainstate/ and blocks/ into a seekable DGBSNAP1
+# snapshot container (android/jni/snapshot_container.h), which the app can
+# apply while it downloads.
+#
+# Usage: scripts/make-snapshot-container.sh <datadir> <output> [tool options]
+#   e.g. scripts/make-snapshot-container.sh ~/.digibyte dgb-chainstate-mainnet-h<height>.dgbsnap
+#
+# Stop digibyted first so the chainstate is consistent. Tool options
+# (--chunk-size, --level, --threads) are passed through. Publish the output
+# and set CONTAINER_URL, CONTAINER_FILENAME and CONTAINER_INDEX_SHA256 (printed
+# below) in ChainstateBootstrapper.kt.
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+JNI_DIR="${ROOT_DIR}/android/jni"
+BUILD_DIR="${ROOT_DIR}/build-host/jni"
+TOOL="${BUILD_DIR}/make_snapshot_container"
+
+log() {
+  echo "[make-snapshot-container] $*"
+}
+
+die() {
+  echo "[make-snapshot-container] ERROR: $*" >&2
+  exit 1
+}
+
+[[ $# -ge 2 ]] || die "usage: $0 <datadir> <output> [--chunk-size BYTES] [--level 0-9] [--threads N]"
+command -v cmake >/dev/null 2>&1 || die "cmake is required to build ${TOOL}"
+
+log "Building ${TOOL}"
+cmake -S "${JNI_DIR}" -B "${BUILD_DIR}" -DCMAKE_BUILD_TYPE=Release >/dev/null
+cmake --build "${BUILD_DIR}" --target make_snapshot_container >/dev/null
+
+DATADIR="$1"
+OUTPUT="$2"
+shift 2
+[[ -d "${DATADIR}/chainstate" && -d "${DATADIR}/blocks" ]] || die "${DATADIR} has no chainstate/ and blocks/"
+
+log "Packing ${DATADIR} into ${OUTPUT}"
+"${TOOL}" "$@" "${DATADIR}" "${OUTPUT}"
+log "Set CONTAINER_INDEX_SHA256 to the index_sha256 above"
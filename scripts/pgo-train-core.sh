@@ -0,0 +1,127 @@
+#!/usr/bin/env bash
+# Record the PGO profile for DGB_PGO=use (see scripts/core-build-profile.sh).
+#
+# Usage: scripts/pgo-train-core.sh
+#
+# Builds an instrumented host digibyted (DGB_BUILD_PROFILE=perf DGB_PGO=generate)
+# and runs it through the work a phone spends its time on: initial block
+# download and a -reindex. A source regtest node mines TRAIN_BLOCKS (default
+# 2000), cycling through ALGOS so every PoW hash is exercised; the trainee syncs
+# them from it, then reindexes. Only the trainee's runs are recorded, merged
+# into build-host/pgo/digibyted.profdata.
+#
+# The Android build reuses the host profile: the hot paths (validation,
+# hashing, LevelDB, script checks) are the same code. The NDK's clang must be
+# at least as new as the llvm-profdata that merged the profile (override with
+# LLVM_PROFDATA), or it cannot read it.
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+PGO_DIR="${ROOT_DIR}/build-host/pgo"
+RAW_DIR="${PGO_DIR}/raw"
+PROFDATA="${PGO_DIR}/digibyted.profdata"
+BIN_DIR="${ROOT_DIR}/build-host/bin/perf-pgo-generate"
+DIGIBYTED="${BIN_DIR}/digibyted"
+DIGIBYTE_CLI="${BIN_DIR}/digibyte-cli"
+LLVM_PROFDATA="${LLVM_PROFDATA:-llvm-profdata}"
+TRAIN_BLOCKS="${TRAIN_BLOCKS:-2000}"
+ALGOS="${ALGOS:-sha256d scrypt skein qubit odo}"
+SOURCE_P2P_PORT="${SOURCE_P2P_PORT:-18554}"
+SOURCE_RPC_PORT="${SOURCE_RPC_PORT:-18555}"
+TRAIN_RPC_PORT="${TRAIN_RPC_PORT:-18553}"
+
+log() {
+  echo "[pgo-train-core] $*" >&2
+}
+
+die() {
+  echo "[pgo-train-core] ERROR: $*" >&2
+  exit 1
+}
+
+command -v "${LLVM_PROFDATA}" >/dev/null 2>&1 || die "${LLVM_PROFDATA} is required (override with LLVM_PROFDATA)"
+
+log "Building the instrumented digibyted"
+DGB_BUILD_PROFILE=perf DGB_PGO=generate "${ROOT_DIR}/scripts/build-core-host.sh" >&2
+
+rm -rf "${RAW_DIR}"
+mkdir -p "${RAW_DIR}"
+
+WORK_DIR="$(mktemp -d "${TMPDIR:-/tmp}/pgo-train-core.XXXXXX")"
+SOURCE_DIR="${WORK_DIR}/source"
+TRAIN_DIR="${WORK_DIR}/train"
+mkdir -p "${SOURCE_DIR}" "${TRAIN_DIR}"
+SOURCE_CLI=("${DIGIBYTE_CLI}" -regtest -datadir="${SOURCE_DIR}" -rpcport="${SOURCE_RPC_PORT}")
+TRAIN_CLI=("${DIGIBYTE_CLI}" -regtest -datadir="${TRAIN_DIR}" -rpcport="${TRAIN_RPC_PORT}")
+
+wait_stopped() {
+  while [[ -f "$1/regtest/digibyted.pid" ]]; do
+    sleep 0.2
+  done
+}
+
+stop_nodes() {
+  "${TRAIN_CLI[@]}" stop >/dev/null 2>&1 || true
+  "${SOURCE_CLI[@]}" stop >/dev/null 2>&1 || true
+  wait_stopped "${TRAIN_DIR}"
+  wait_stopped "${SOURCE_DIR}"
+}
+
+cleanup() {
+  stop_nodes
+  rm -rf "${WORK_DIR}"
+}
+trap cleanup EXIT
+
+# The source node is instrumented too; its mining is not the workload, so its
+# profile is discarded.
+LLVM_PROFILE_FILE=/dev/null "${DIGIBYTED}" -regtest -daemon -datadir="${SOURCE_DIR}" \
+  -port="${SOURCE_P2P_PORT}" -rpcport="${SOURCE_RPC_PORT}" -listen=1 -bind=127.0.0.1 \
+  -dnsseed=0 -fallbackfee=0.0001 >/dev/null
+"${SOURCE_CLI[@]}" -rpcwait getblockcount >/dev/null
+
+log "Mining ${TRAIN_BLOCKS} regtest blocks (${ALGOS})"
+"${SOURCE_CLI[@]}" createwallet pgo >/dev/null
+address="$("${SOURCE_CLI[@]}" getnewaddress)"
+read -r -a algos <<< "${ALGOS}"
+left="${TRAIN_BLOCKS}"
+i=0
+while (( left > 0 )); do
+  batch=$(( left < 100 ? left : 100 ))
+  algo="${algos[$(( i % ${#algos[@]} ))]}"
+  if ! "${SOURCE_CLI[@]}" generatetoaddress "${batch}" "${address}" 1000000 "${algo}" >/dev/null 2>&1; then
+    log "Mining with ${algo} failed; using the default algorithm for this batch"
+    "${SOURCE_CLI[@]}" generatetoaddress "${batch}" "${address}" >/dev/null
+  fi
+  left=$(( left - batch ))
+  i=$(( i + 1 ))
+done
+tip="$("${SOURCE_CLI[@]}" getblockcount)"
+
+# %p keeps concurrent writers apart, %m merges runs of the same binary.
+export LLVM_PROFILE_FILE="${RAW_DIR}/digibyted-%p-%m.profraw"
+
+start_trainee() {
+  "${DIGIBYTED}" -regtest -daemon -datadir="${TRAIN_DIR}" -rpcport="${TRAIN_RPC_PORT}" \
+    -listen=0 -dnsseed=0 -connect=127.0.0.1:"${SOURCE_P2P_PORT}" "$@" >/dev/null
+  "${TRAIN_CLI[@]}" -rpcwait getblockcount >/dev/null
+  while [[ "$("${TRAIN_CLI[@]}" getblockcount)" -lt "${tip}" ]]; do
+    sleep 0.5
+  done
+  "${TRAIN_CLI[@]}" stop >/dev/null
+  wait_stopped "${TRAIN_DIR}"
+}
+
+log "Recording initial block download to height ${tip}"
+start_trainee
+log "Recording -reindex"
+start_trainee -reindex
+
+stop_nodes
+shopt -s nullglob
+raw=("${RAW_DIR}"/*.profraw)
+(( ${#raw[@]} > 0 )) || die "No profiles written to ${RAW_DIR}"
+
+log "Merging ${#raw[@]} raw profiles"
+"${LLVM_PROFDATA}" merge -output="${PROFDATA}" "${raw[@]}"
+log "Wrote ${PROFDATA}; build with DGB_BUILD_PROFILE=perf DGB_PGO=use"